@@ -0,0 +1,38 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace lpr::bench {
+
+struct Case {
+    std::string name;
+    std::function<void()> fn;
+};
+
+std::vector<Case>& registry();
+
+struct Register {
+    Register(std::string name, std::function<void()> fn) {
+        registry().push_back({std::move(name), std::move(fn)});
+    }
+};
+
+// Wall-clock milliseconds for one call of f.
+template <typename F>
+double time_ms(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+} // namespace lpr::bench
+
+// Define and register a benchmark case: LPR_BENCH(name) { ... }
+#define LPR_BENCH(name)                                              \
+    static void name();                                              \
+    static ::lpr::bench::Register name##_registration(#name, name);  \
+    static void name()
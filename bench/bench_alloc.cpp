@@ -0,0 +1,59 @@
+#include "bench.hpp"
+#include "core/context.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+using namespace lpr;
+
+// Every operator new in the bench binary goes through here, so a case can
+// count the heap allocations one exec makes. The counter is a relaxed atomic
+// add, which is noise next to malloc itself.
+namespace {
+std::atomic<unsigned long long> g_allocations{0};
+std::atomic<unsigned long long> g_bytes{0};
+} // namespace
+
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+void row(const char* label, const std::string& setup, const std::string& input) {
+    Context ctx(nullptr);
+    ctx.exec(setup);
+    ctx.exec(input); // warm caches
+    ctx.exec("CLEAR");
+    unsigned long long allocs = g_allocations.load(), bytes = g_bytes.load();
+    double ms = bench::time_ms([&] { ctx.exec(input); });
+    allocs = g_allocations.load() - allocs;
+    bytes = g_bytes.load() - bytes;
+    std::printf("%-12s %12llu %12llu %10.2f\n", label, allocs, bytes / 1024, ms);
+}
+
+} // namespace
+
+// Heap allocations made by a single Context::exec
+LPR_BENCH(alloc_per_exec) {
+    std::printf("%-12s %12s %12s %10s\n", "input", "allocations", "KiB", "ms");
+    row("arith", "", "1 2 + 3 * 4 - DROP");
+    row("program", "",
+        "<< -> N << 0 1 N FOR I IF I 2 MOD THEN I + ELSE I - END NEXT >> >> DROP");
+    row("for_if", "",
+        "0 1 200 FOR I IF I 3 MOD 0 == THEN I + ELSE 1 + END NEXT DROP");
+    row("while", "", "0 WHILE DUP 200 < REPEAT 1 + END DROP");
+    row("locals", "", "1 200 FOR I I -> X << X X * DROP >> NEXT");
+    row("expr_eval", "2 'A' STO 3 'B' STO",
+        "1 200 FOR X 'A*X*X+B*X' EVAL DROP NEXT");
+}
@@ -0,0 +1,89 @@
+#include "bench.hpp"
+#include "core/numeric.hpp"
+#include <cstdio>
+#include <functional>
+
+using namespace lpr;
+
+namespace {
+
+// The promote-and-switch path + - * / used before the type-pair table
+int old_rank(const Object& obj) {
+    if (holds_alternative<Integer>(obj))  return 0;
+    if (holds_alternative<Rational>(obj)) return 1;
+    if (holds_alternative<Real>(obj))     return 2;
+    if (holds_alternative<Complex>(obj))  return 3;
+    return -1;
+}
+
+Object old_promote(const Object& obj, int target_rank) {
+    int rank = old_rank(obj);
+    if (rank == target_rank) return obj;
+    Object cur = obj;
+    int cur_rank = rank;
+    while (cur_rank < target_rank) {
+        if (cur_rank == 0) {
+            cur = Rational(get<Integer>(cur), Integer(1));
+            cur_rank = 1;
+        } else if (cur_rank == 1) {
+            cur = Real(get<Rational>(cur));
+            cur_rank = 2;
+        } else {
+            cur = Complex{get<Real>(cur), Real(0)};
+            cur_rank = 3;
+        }
+    }
+    return cur;
+}
+
+Object old_add(const Object& a, const Object& b) {
+    std::function<Integer(const Integer&, const Integer&)> iop = [](auto& x, auto& y) { return Integer(x + y); };
+    std::function<Rational(const Rational&, const Rational&)> rop = [](auto& x, auto& y) { return Rational(x + y); };
+    std::function<Real(const Real&, const Real&)> reop = [](auto& x, auto& y) { return Real(x + y); };
+    std::function<Complex(const Complex&, const Complex&)> cop = [](auto& x, auto& y) {
+        return Complex{x.first + y.first, x.second + y.second};
+    };
+    int target = std::max(old_rank(a), old_rank(b));
+    Object pa = old_promote(a, target);
+    Object pb = old_promote(b, target);
+    switch (target) {
+        case 0: return iop(get<Integer>(pa), get<Integer>(pb));
+        case 1: return rop(get<Rational>(pa), get<Rational>(pb));
+        case 2: return reop(get<Real>(pa), get<Real>(pb));
+        default: return cop(get<Complex>(pa), get<Complex>(pb));
+    }
+}
+
+constexpr int kReps = 200000;
+
+// Nanoseconds per addition. Operands are copied into fresh Objects each time,
+// as popping them off the stack does, in every column.
+template <typename F>
+double ns_per_op(const Object& a, const Object& b, F f) {
+    Object sink;
+    double ms = bench::time_ms([&] {
+        for (int i = 0; i < kReps; ++i) sink = f(Object(a), b);
+    });
+    return ms * 1e6 / kReps;
+}
+
+void row(const char* label, const Object& a, const Object& b) {
+    double old_ns = ns_per_op(a, b, [](Object x, const Object& y) { return old_add(x, y); });
+    double new_ns = ns_per_op(a, b, [](Object x, const Object& y) {
+        return numeric_dispatch(std::move(x), y, NumericAdd{}, [] { return Object(Integer(0)); });
+    });
+    std::printf("%-18s %10.1f %10.1f\n", label, old_ns, new_ns);
+}
+
+} // namespace
+
+LPR_BENCH(arithmetic) {
+    std::printf("%-18s %10s %10s   (ns per +)\n", "operands", "promote", "dispatch");
+    row("Integer Integer", Integer(123456789), Integer(987654321));
+    row("Integer Integer*", Integer(1) << 300, Integer(3) << 200);
+    row("Real Real", Real("1.25"), Real("2.5"));
+    row("Integer Real", Integer(7), Real("2.5"));
+    row("Rational Rational", Rational(1, 3), Rational(2, 7));
+    row("Complex Real", Complex{Real(1), Real(2)}, Real("2.5"));
+    std::printf("  (* 300-bit operands)\n");
+}
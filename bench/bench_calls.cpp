@@ -0,0 +1,43 @@
+#include "bench.hpp"
+#include "core/context.hpp"
+#include <cstdio>
+#include <string>
+
+using namespace lpr;
+
+namespace {
+
+int64_t stat(Context& ctx, const std::string& name) {
+    for (const auto& [key, value] : ctx.perf_stats()) {
+        if (key == name) return value;
+    }
+    return -1;
+}
+
+struct Recursion {
+    const char* label;
+    const char* program;  // stored as F, called as n F
+};
+
+} // namespace
+
+// Recursive programs at growing depth: time per call and the deepest the
+// continuation stack got. Tail calls should stay at a few frames.
+LPR_BENCH(calls) {
+    const Recursion programs[] = {
+        {"tail",      "\xC2\xAB IF DUP 0 > THEN 1 - F END \xC2\xBB"},
+        {"tail_eval", "\xC2\xAB IF DUP 0 > THEN 1 - 'F' EVAL END \xC2\xBB"},
+        {"sum",       "\xC2\xAB \xE2\x86\x92 n \xC2\xAB IF n 0 == THEN 0 ELSE n 1 - F n + END \xC2\xBB \xC2\xBB"},
+    };
+    std::printf("%-10s %8s %12s %12s\n", "program", "depth", "us/call", "peak frames");
+    for (const auto& p : programs) {
+        for (int depth : {1000, 10000}) {
+            Context ctx(nullptr);
+            ctx.exec(std::string(p.program) + " 'F' STO");
+            std::string call = std::to_string(depth) + " F";
+            double ms = bench::time_ms([&] { ctx.exec(call); });
+            std::printf("%-10s %8d %12.1f %12lld\n", p.label, depth, ms * 1e3 / depth,
+                        static_cast<long long>(stat(ctx, "call_frames_peak")));
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#include "bench.hpp"
+#include "core/combinatorics.hpp"
+#include <cstdio>
+
+using namespace lpr;
+
+namespace {
+
+// The loops !, COMB and PERM used before the prime-factorization kernels
+Integer loop_factorial(const Integer& n) {
+    Integer result = 1;
+    for (Integer i = 2; i <= n; ++i) result *= i;
+    return result;
+}
+
+Integer loop_comb(const Integer& n, Integer k) {
+    if (k > n - k) k = n - k;
+    Integer result = 1;
+    for (Integer i = 0; i < k; ++i) result = result * (n - i) / (i + 1);
+    return result;
+}
+
+Integer loop_perm(const Integer& n, const Integer& k) {
+    Integer result = 1;
+    for (Integer i = 0; i < k; ++i) result *= (n - i);
+    return result;
+}
+
+// The loops are quadratic; past this they take minutes and are skipped
+constexpr int kLoopLimit = 100000;
+
+template <typename Fast, typename Slow>
+void compare(const char* label, int n, Fast fast, Slow slow) {
+    Integer a, b;
+    double fast_ms = bench::time_ms([&] { a = fast(); });
+    if (n > kLoopLimit) {
+        std::printf("%-6s %-10d %12s %12.1f\n", label, n, "-", fast_ms);
+        return;
+    }
+    double slow_ms = bench::time_ms([&] { b = slow(); });
+    std::printf("%-6s %-10d %12.1f %12.1f %8.1fx%s\n", label, n, slow_ms, fast_ms,
+                slow_ms / fast_ms, a == b ? "" : "   MISMATCH");
+}
+
+} // namespace
+
+LPR_BENCH(combinatorics) {
+    std::printf("%-6s %-10s %12s %12s\n", "op", "n", "loop ms", "kernel ms");
+    for (int n : {1000, 10000, 100000, 1000000}) {
+        compare("n!", n, [&] { return factorial(n); }, [&] { return loop_factorial(n); });
+    }
+    for (int n : {1000, 10000, 100000, 1000000}) {
+        Integer nn = n, k = n / 2;
+        compare("COMB", n, [&] { return binomial(nn, k); }, [&] { return loop_comb(nn, k); });
+    }
+    for (int n : {1000, 10000, 100000, 1000000}) {
+        Integer nn = n, k = n / 2;
+        compare("PERM", n, [&] { return falling_factorial(nn, k); }, [&] { return loop_perm(nn, k); });
+    }
+}
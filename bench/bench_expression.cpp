@@ -0,0 +1,46 @@
+#include "bench.hpp"
+#include "core/context.hpp"
+#include "core/expression.hpp"
+#include "core/expr_tree.hpp"
+#include "core/lambdify.hpp"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace lpr;
+
+// Symbol EVAL inside a FOR loop, with and without the compiled-expression
+// cache (capacity 0 recompiles every time).
+LPR_BENCH(expression_eval_loop) {
+    const int n = 20000;
+    const std::string loop = "1 " + std::to_string(n) + " FOR X 'A*X*X+B*X+C' EVAL DROP NEXT";
+    std::printf("%-10s %12s %10s %10s\n", "cache", "ms", "hits", "misses");
+    for (size_t capacity : {size_t(0), size_t(512)}) {
+        Context ctx(nullptr);
+        ctx.expr_cache() = ExprCache(capacity);
+        ctx.exec("2 'A' STO 3 'B' STO 5 'C' STO");
+        double ms = bench::time_ms([&] { ctx.exec(loop); });
+        std::printf("%-10zu %12.1f %10llu %10llu\n", capacity, ms,
+                    static_cast<unsigned long long>(ctx.expr_cache().hits()),
+                    static_cast<unsigned long long>(ctx.expr_cache().misses()));
+    }
+}
+
+// The same polynomial compiled once to a double evaluator and run over a
+// million points, against EVAL per point on a smaller run.
+LPR_BENCH(expression_lambdify) {
+    Context ctx(nullptr);
+    ctx.exec("2 'A' STO 3 'B' STO 5 'C' STO");
+    NumericFunction fn = lambdify(parse_expr_tree("A*X*X+B*X+C"), {"X"}, ctx);
+    const size_t n = 1000000;
+    std::vector<double> xs(n), out(n);
+    for (size_t i = 0; i < n; ++i) xs[i] = static_cast<double>(i) / n;
+    double ms = bench::time_ms([&] { fn.evaluate(xs.data(), n, out.data()); });
+    std::printf("lambdify: %zu points in %.2f ms (%.1f ns/point)\n", n, ms, ms * 1e6 / n);
+
+    const int m = 20000;
+    double eval_ms = bench::time_ms([&] {
+        ctx.exec("1 " + std::to_string(m) + " FOR X 'A*X*X+B*X+C' EVAL DROP NEXT");
+    });
+    std::printf("EVAL:     %d points in %.1f ms (%.1f ns/point)\n", m, eval_ms, eval_ms * 1e6 / m);
+}
@@ -0,0 +1,48 @@
+#include "bench.hpp"
+#include "core/context.hpp"
+#include <cstdio>
+#include <string>
+
+using namespace lpr;
+
+namespace {
+
+constexpr int kIterations = 2000;
+
+struct CorpusEntry {
+    const char* label;
+    std::string text;
+    int body_tokens;  // tokens run per loop pass
+};
+
+double run_ms(const CorpusEntry& p, bool fusion) {
+    Context ctx(nullptr);
+    ctx.set_fusion_enabled(fusion);
+    ctx.exec(p.text); // warm the parse cache
+    ctx.exec("CLEAR");
+    return bench::time_ms([&] { ctx.exec(p.text); });
+}
+
+} // namespace
+
+// Loop-heavy programs built from the common short sequences, with fusion
+// off and on: ns per token the loop body runs
+LPR_BENCH(fusion) {
+    std::string n = std::to_string(kIterations);
+    const CorpusEntry corpus[] = {
+        {"sumsq",  "0 1 " + n + " FOR I I DUP * + NEXT", 4},
+        {"horner", "1 " + n + " FOR X X DUP 3 * 2 + * 1 + DROP NEXT", 10},
+        {"count",  "0 WHILE DUP " + n + " < REPEAT 1 + END", 5},
+        {"fib",    "0 1 1 " + n + " START DUP ROT + NEXT", 3},
+        {"mod_eq", "0 1 " + n + " FOR I I 3 MOD 0 == + NEXT", 6},
+        {"diff",   "0 1 " + n + " FOR I I 2 OVER - SWAP - + NEXT", 7},
+    };
+    std::printf("%-8s %12s %12s %8s\n", "program", "ns/token", "fused", "speedup");
+    for (const auto& p : corpus) {
+        double plain = run_ms(p, false);
+        double fused = run_ms(p, true);
+        double tokens = double(kIterations) * p.body_tokens;
+        std::printf("%-8s %12.0f %12.0f %7.2fx\n", p.label, plain * 1e6 / tokens,
+                    fused * 1e6 / tokens, plain / fused);
+    }
+}
@@ -0,0 +1,40 @@
+#include "bench.hpp"
+#include "core/context.hpp"
+#include <cstdio>
+#include <string>
+
+using namespace lpr;
+
+// UNION / INTERSECT / DIFFERENCE on two overlapping numeric lists.
+LPR_BENCH(set_operations) {
+    std::printf("%-8s %12s %12s %12s\n", "n", "UNION ms", "INTERSECT", "DIFFERENCE");
+    for (int n : {1000, 5000, 10000}) {
+        std::string build = "1 1 " + std::to_string(n) + " << >> SEQ " +
+                            std::to_string(n / 2) + " 1 " + std::to_string(n) + " << >> SEQ";
+        double ms[3];
+        const char* ops[] = {"UNION", "INTERSECT", "DIFFERENCE"};
+        for (int k = 0; k < 3; ++k) {
+            Context ctx(nullptr);
+            ctx.exec(build);
+            ms[k] = bench::time_ms([&] { ctx.exec(ops[k]); });
+        }
+        std::printf("%-8d %12.1f %12.1f %12.1f\n", n, ms[0], ms[1], ms[2]);
+    }
+}
+
+// SORT on a shuffled Integer list. SORT includes the list's round trip
+// through the stack store; REVLIST does the same round trip with O(n) work,
+// so the difference is the sort itself.
+LPR_BENCH(sort_integers) {
+    std::printf("%-10s %12s %12s\n", "n", "SORT ms", "REVLIST ms");
+    for (int n : {10000, 100000, 1000000}) {
+        Context ctx(nullptr);
+        List list;
+        list.items.reserve(n);
+        for (int i = 0; i < n; ++i) list.items.push_back(Integer((i * 7919LL) % n));
+        ctx.store().push(std::move(list));
+        double sort_ms = bench::time_ms([&] { ctx.exec("SORT"); });
+        double rev_ms = bench::time_ms([&] { ctx.exec("REVLIST"); });
+        std::printf("%-10d %12.1f %12.1f\n", n, sort_ms, rev_ms);
+    }
+}
@@ -0,0 +1,64 @@
+#include "bench.hpp"
+#include "core/number_theory.hpp"
+#include <cstdio>
+
+using namespace lpr;
+
+namespace {
+
+// Trial division and plain Euclid, for scale
+bool trial_prime(const Integer& n) {
+    if (n < 2) return false;
+    for (Integer d = 2; d * d <= n; ++d) {
+        if (n % d == 0) return false;
+    }
+    return true;
+}
+
+Integer euclid_gcd(Integer a, Integer b) {
+    while (b != 0) {
+        Integer r = a % b;
+        a = std::move(b);
+        b = std::move(r);
+    }
+    return a;
+}
+
+template <typename F>
+void row(const char* op, const char* size, int reps, F f) {
+    double ms = bench::time_ms([&] {
+        for (int i = 0; i < reps; ++i) f();
+    });
+    std::printf("%-10s %-8s %12.4f\n", op, size, ms / reps);
+}
+
+} // namespace
+
+LPR_BENCH(number_theory) {
+    // 2^64-59, the largest 64-bit prime, and a 64-bit semiprime
+    const Integer p64("18446744073709551557");
+    const Integer semi64("18446743979220271189");
+    // A 256-bit prime (2^256-189) and a 256-bit number with a 40-bit factor
+    const Integer p256 = (Integer(1) << 256) - 189;
+    const Integer semi256 = Integer("1099511627689") * next_prime(Integer(1) << 215);
+    // Powers of small primes: 256-bit operands with long quotient sequences
+    const Integer a256 = pow(Integer(3), 161), b256 = pow(Integer(7), 91);
+
+    std::printf("%-10s %-8s %12s\n", "op", "bits", "ms per op");
+    row("ISPRIME?", "32", 1, [] { trial_prime(Integer(4294967291u)); });
+    std::printf("  (trial division above, for scale)\n");
+    row("ISPRIME?", "64", 1000, [&] { is_probable_prime(p64); });
+    row("ISPRIME?", "256", 100, [&] { is_probable_prime(p256); });
+    row("NEXTPRIME", "64", 100, [&] { next_prime(p64); });
+    row("NEXTPRIME", "256", 10, [&] { next_prime(p256); });
+    row("FACTORS", "64", 10, [&] { factorize(semi64); });
+    row("FACTORS", "256", 1, [&] { factorize(semi256); });
+    row("GCD", "64", 100000, [&] { gcd_binary(p64, semi64); });
+    row("GCD", "256", 100000, [&] { gcd_binary(a256, b256); });
+    row("euclid", "64", 100000, [&] { euclid_gcd(p64, semi64); });
+    row("euclid", "256", 100000, [&] { euclid_gcd(a256, b256); });
+    row("POWMOD", "64", 10000, [&] { pow_mod(semi64, p64, p64); });
+    row("POWMOD", "256", 1000, [&] { pow_mod(a256, b256, p256); });
+    row("INVMOD", "64", 10000, [&] { inv_mod(semi64, p64); });
+    row("INVMOD", "256", 10000, [&] { inv_mod(a256, p256); });
+}
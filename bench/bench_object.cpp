@@ -0,0 +1,56 @@
+#include "bench.hpp"
+#include "core/object.hpp"
+#include <cstdio>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+using namespace lpr;
+
+namespace {
+
+constexpr size_t kItems = 1000000;
+
+// Bytes currently allocated from the heap, or 0 where the C library can't say
+size_t heap_in_use() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+// Heap held by a kItems-element List built from make(i), and the time to
+// build it and then copy it once
+template <typename F>
+void row(const char* label, F make) {
+    size_t before = heap_in_use();
+    List list;
+    double build_ms = bench::time_ms([&] {
+        list.items.reserve(kItems);
+        for (size_t i = 0; i < kItems; ++i) list.items.push_back(make(i));
+    });
+    size_t bytes = heap_in_use() - before;
+    List copy;
+    double copy_ms = bench::time_ms([&] { copy = list; });
+    std::printf("%-14s %10.1f %10.1f %10.1f %10.1f\n", label, bytes / 1048576.0,
+                static_cast<double>(bytes) / kItems, build_ms, copy_ms);
+}
+
+} // namespace
+
+LPR_BENCH(object) {
+    std::printf("sizeof(Object) %zu  sizeof(Token) %zu\n", sizeof(Object), sizeof(Token));
+    std::printf("Integer %zu Real %zu Rational %zu Complex %zu String %zu Program %zu Error %zu\n\n",
+                sizeof(Integer), sizeof(Real), sizeof(Rational), sizeof(Complex), sizeof(String),
+                sizeof(Program), sizeof(Error));
+
+    std::printf("1M-element List %4s %10s %10s %10s %10s\n", "", "MiB", "B/item", "build ms",
+                "copy ms");
+    row("Integer", [](size_t i) { return Object(Integer(i)); });
+    row("Real", [](size_t i) { return Object(Real(i)); });
+    row("Rational", [](size_t i) { return Object(Rational(Integer(i), Integer(7))); });
+    row("Complex", [](size_t i) { return Object(Complex{Real(i), Real(1)}); });
+    row("String", [](size_t i) { return Object(String{"s"}); });
+}
@@ -0,0 +1,26 @@
+#include "bench.hpp"
+#include "core/context.hpp"
+#include <cstdio>
+#include <string>
+#include <thread>
+
+using namespace lpr;
+
+// PMAP over a numeric list at 1..N workers; 1 worker is the serial MAP path.
+LPR_BENCH(parallel_map) {
+    const int n = 4000;
+    const std::string prog = "<< DUP * 1 + SQRT LN >>";
+    unsigned max_workers = std::thread::hardware_concurrency();
+    if (max_workers < 2) max_workers = 2;
+
+    double base = 0;
+    std::printf("%-8s %12s %8s\n", "workers", "ms", "speedup");
+    for (unsigned w = 1; w <= max_workers; ++w) {
+        Context ctx(nullptr);
+        ctx.exec("1 1 " + std::to_string(n) + " << >> SEQ");
+        ctx.exec(std::to_string(w) + " PWORKERS");
+        double ms = bench::time_ms([&] { ctx.exec(prog + " PMAP"); });
+        if (w == 1) base = ms;
+        std::printf("%-8u %12.1f %7.2fx\n", w, ms, base / ms);
+    }
+}
@@ -0,0 +1,94 @@
+#include "bench.hpp"
+#include "core/parser.hpp"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace lpr;
+
+namespace {
+
+constexpr size_t kInputBytes = 10 * 1024 * 1024;
+
+// One program whose body repeats chunk until the input is kInputBytes long
+std::string generate(const std::string& chunk) {
+    std::string s = "<< ";
+    s.reserve(kInputBytes + chunk.size() + 8);
+    while (s.size() < kInputBytes) s += chunk;
+    s += ">>";
+    return s;
+}
+
+std::string nested_chunk(int depth) {
+    std::string s;
+    for (int d = 0; d < depth; ++d) s += "<< " + std::to_string(d) + " DUP ";
+    for (int d = 0; d < depth; ++d) s += ">> ";
+    return s;
+}
+
+void print(const char* label, double ms, size_t bytes) {
+    std::printf("%-10s %10.1f %12.1f\n", label, ms, bytes / 1048576.0 / (ms / 1000.0));
+}
+
+// Returns the number of top-level tokens in the program body
+size_t row(const char* label, const std::string& input) {
+    // Freeing the result is not part of parsing
+    std::vector<Token> tokens;
+    double ms = bench::time_ms([&] { tokens = parse(input); });
+    print(label, ms, input.size());
+    const auto& body = get<Program>(tokens.at(0).literal).tokens;
+    return body.size();
+}
+
+} // namespace
+
+// Parse throughput on 10 MB programs, next to a plain copy of the same bytes
+LPR_BENCH(parser) {
+    std::printf("%-10s %10s %12s\n", "input", "ms", "MB/s");
+
+    std::string flat = generate("1 2.5 DUP SWAP 'X' \"text\" { 1 2 } + STO ");
+    std::vector<char> dst(flat.size());
+    print("memcpy", bench::time_ms([&] { std::memcpy(dst.data(), flat.data(), flat.size()); }),
+          flat.size());
+
+    row("flat", flat);
+    row("nested8", generate(nested_chunk(8)));
+    row("nested64", generate(nested_chunk(64)));
+    std::string names = generate("alpha beta gamma delta epsilon zeta eta theta ");
+    size_t count = row("names", names);
+
+    // Floor for the names row: appending the same number of ready-made
+    // tokens, without reading any input
+    std::vector<Token> tokens;
+    Token word = Token::make_command("alpha");
+    print("push only", bench::time_ms([&] {
+        for (size_t i = 0; i < count; ++i) tokens.push_back(word);
+    }), names.size());
+}
+
+// Repeated short inputs and a stored program's text: parsing each time
+// against a ParseCache lookup (ns per call)
+LPR_BENCH(parse_cache) {
+    constexpr int kCalls = 200000;
+    const std::pair<const char*, std::string> inputs[] = {
+        {"+", "+"},
+        {"DUP", "DUP"},
+        {"1 2 +", "1 2 +"},
+        {"program", "<< -> N << 0 1 N FOR I IF I 2 MOD THEN I + ELSE I - END NEXT >> >>"},
+    };
+    std::printf("%-10s %10s %10s\n", "input", "parse", "cached");
+    for (const auto& [label, text] : inputs) {
+        size_t sink = 0;
+        double parse_ms = bench::time_ms([&] {
+            for (int i = 0; i < kCalls; ++i) sink += parse(text).size();
+        });
+        ParseCache cache;
+        double cached_ms = bench::time_ms([&] {
+            for (int i = 0; i < kCalls; ++i) sink += cache.get(text)->size();
+        });
+        std::printf("%-10s %10.1f %10.1f\n", label, parse_ms * 1e6 / kCalls,
+                    cached_ms * 1e6 / kCalls);
+        if (sink == 0) std::printf("(empty)\n");
+    }
+}
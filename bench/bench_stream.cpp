@@ -0,0 +1,78 @@
+#include "bench.hpp"
+#include "core/context.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+using namespace lpr;
+
+namespace {
+
+constexpr size_t kInputBytes = 1024 * 1024;
+const std::string kLine = "1 2 + DROP\n";
+
+size_t heap_in_use() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+// Runs f while a second thread samples the heap every millisecond, and
+// prints the time and the highest heap seen above the starting level
+template <typename F>
+void row(const char* label, F f) {
+    size_t base = heap_in_use();
+    std::atomic<bool> done{false};
+    std::atomic<size_t> peak{base};
+    std::thread sampler([&] {
+        while (!done) {
+            size_t now = heap_in_use();
+            if (now > peak) peak = now;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    double ms = bench::time_ms(f);
+    done = true;
+    sampler.join();
+    std::printf("%-14s %10.1f %14zu\n", label, ms, (peak - base) / 1024);
+}
+
+} // namespace
+
+// A 1 MiB script of short top-level lines, run whole by exec and streamed by
+// exec_stream; peak heap includes the input string for exec only
+LPR_BENCH(exec_stream) {
+    std::printf("%-14s %10s %14s\n", "mode", "ms", "peak heap KiB");
+    {
+        Context ctx(nullptr);
+        row("exec", [&] {
+            std::string input;
+            while (input.size() < kInputBytes) input += kLine;
+            ctx.exec(input);
+        });
+    }
+    for (size_t checkpoint : {size_t(0), size_t(64 * 1024)}) {
+        Context ctx(nullptr);
+        size_t produced = 0, offset = 0;
+        auto read = [&](char* buf, size_t cap) -> long {
+            size_t n = std::min(cap, kInputBytes - produced);
+            for (size_t i = 0; i < n; ++i) {
+                buf[i] = kLine[offset];
+                offset = (offset + 1) % kLine.size();
+            }
+            produced += n;
+            return static_cast<long>(n);
+        };
+        row(checkpoint ? "stream, 64K" : "stream", [&] { ctx.exec_stream(read, checkpoint); });
+    }
+}
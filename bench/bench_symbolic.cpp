@@ -0,0 +1,47 @@
+#include "bench.hpp"
+#include "core/context.hpp"
+#include "core/expr_tree.hpp"
+#include <cstdio>
+#include <string>
+
+using namespace lpr;
+
+// Growing a Symbol one term at a time. Each step only adds a node; the text
+// is rendered once at the end.
+LPR_BENCH(symbolic_build_loop) {
+    std::printf("%-10s %12s %12s\n", "terms", "build ms", "render ms");
+    for (int n : {1000, 10000, 100000}) {
+        Object acc = Name{"X"};
+        double build = bench::time_ms([&] {
+            for (int i = 1; i <= n; ++i) {
+                acc = symbolic_binary(acc, Integer(i), i % 2 ? "+" : "*");
+            }
+        });
+        size_t len = 0;
+        double render = bench::time_ms([&] { len = get<Symbol>(acc).value().size(); });
+        std::printf("%-10d %12.1f %12.1f   (%zu chars)\n", n, build, render, len);
+    }
+}
+
+// The same through the stack, where every step stores the Symbol and reads
+// it back. Time per step should stay flat apart from rendering the text.
+LPR_BENCH(symbolic_build_stack) {
+    std::printf("%-10s %12s %12s\n", "terms", "ms", "us/step");
+    for (int n : {1000, 2000, 4000, 8000}) {
+        Context ctx(nullptr);
+        std::string loop = "'X' 1 " + std::to_string(n) + " FOR I 'X' * I + NEXT";
+        double ms = bench::time_ms([&] { ctx.exec(loop); });
+        std::printf("%-10d %12.1f %12.1f\n", n, ms, ms * 1e3 / n);
+    }
+}
+
+// SUBST on a large expression: one pass over the tree, untouched subtrees
+// shared.
+LPR_BENCH(symbolic_subst) {
+    ExprPtr e = make_name("X");
+    for (int i = 1; i <= 50000; ++i) e = make_binary("+", e, make_binary("*", make_name("Y"), make_number(std::to_string(i))));
+    double ms = bench::time_ms([&] {
+        for (int k = 0; k < 10; ++k) expr_substitute(e, "X", make_name("Z"));
+    });
+    std::printf("10 x SUBST on 100k nodes: %.1f ms\n", ms);
+}
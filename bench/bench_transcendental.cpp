@@ -0,0 +1,62 @@
+#include "bench.hpp"
+#include "core/transcendental.hpp"
+#include <cstdio>
+#include <vector>
+
+using namespace lpr;
+
+namespace {
+
+constexpr int kPoints = 2000;
+
+std::vector<Real> sample(const char* lo, const char* hi) {
+    Real a(lo), b(hi);
+    std::vector<Real> xs;
+    for (int i = 0; i < kPoints; ++i) xs.push_back(a + (b - a) * i / kPoints);
+    return xs;
+}
+
+// Results per millisecond over the sample
+template <typename F>
+double throughput(const std::vector<Real>& xs, F f) {
+    Real sink = 0;
+    double ms = bench::time_ms([&] {
+        for (const Real& x : xs) sink += f(x);
+    });
+    return xs.size() / ms;
+}
+
+template <typename Kernel, typename Generic>
+void row(const char* name, const std::vector<Real>& xs, Kernel kernel, Generic generic) {
+    std::printf("%-6s", name);
+    for (int digits : {kFastPrecision, 30, kMaxPrecision}) {
+        std::printf(" %10.0f", throughput(xs, [&](const Real& x) { return kernel(x, digits); }));
+    }
+    std::printf(" %10.0f\n", throughput(xs, generic));
+}
+
+} // namespace
+
+LPR_BENCH(transcendental) {
+    auto angles = sample("-10", "10");
+    auto positive = sample("0.001", "1000");
+    auto unit = sample("-0.999", "0.999");
+
+    // Last column: Boost.Multiprecision's generic functions at 50 digits
+    std::printf("%-6s %10s %10s %10s %10s   (results per ms)\n", "fn", "PREC 16", "PREC 30",
+                "PREC 50", "boost 50");
+    row("SIN", angles, [](const Real& x, int d) { return sin_real(x, d); },
+        [](const Real& x) { return Real(sin(x)); });
+    row("COS", angles, [](const Real& x, int d) { return cos_real(x, d); },
+        [](const Real& x) { return Real(cos(x)); });
+    row("TAN", angles, [](const Real& x, int d) { return tan_real(x, d); },
+        [](const Real& x) { return Real(tan(x)); });
+    row("EXP", angles, [](const Real& x, int d) { return exp_real(x, d); },
+        [](const Real& x) { return Real(exp(x)); });
+    row("LN", positive, [](const Real& x, int d) { return ln_real(x, d); },
+        [](const Real& x) { return Real(log(x)); });
+    row("ATAN", angles, [](const Real& x, int d) { return atan_real(x, d); },
+        [](const Real& x) { return Real(atan(x)); });
+    row("ASIN", unit, [](const Real& x, int d) { return asin_real(x, d); },
+        [](const Real& x) { return Real(asin(x)); });
+}
@@ -0,0 +1,36 @@
+#include "bench.hpp"
+#include <cstring>
+#include <iostream>
+
+namespace lpr::bench {
+
+std::vector<Case>& registry() {
+    static std::vector<Case> cases;
+    return cases;
+}
+
+} // namespace lpr::bench
+
+// Usage: lpr-bench [name-substring ...]
+// Runs every registered case whose name contains one of the arguments,
+// or all cases when none are given.
+int main(int argc, char* argv[]) {
+    int ran = 0;
+    for (const auto& c : lpr::bench::registry()) {
+        bool selected = (argc < 2);
+        for (int i = 1; i < argc && !selected; ++i) {
+            selected = c.name.find(argv[i]) != std::string::npos;
+        }
+        if (!selected) continue;
+        std::cout << "== " << c.name << " ==\n";
+        c.fn();
+        std::cout << "\n";
+        ++ran;
+    }
+    if (ran == 0) {
+        std::cerr << "No benchmark matched. Available:\n";
+        for (const auto& c : lpr::bench::registry()) std::cerr << "  " << c.name << "\n";
+        return 1;
+    }
+    return 0;
+}
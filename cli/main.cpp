@@ -2,6 +2,7 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <cerrno>
 #include <cstring>
 #include <csignal>
 #include <unistd.h>
@@ -33,11 +34,30 @@ static void display_error(lpr_ctx* ctx) {
 }
 
 static void print_usage() {
-    std::cout << "Usage: lpr-cli [-e expression]... [database.lpr]\n"
+    std::cout << "Usage: lpr-cli [-e expression | -f file]... [database.lpr]\n"
               << "  -e expr   Execute expression and exit\n"
+              << "  -f file   Execute a file as it is read (- for stdin) and exit\n"
               << "  -h        Show this help\n";
 }
 
+// A batch step from the command line: -e text or -f path, in order
+struct BatchItem {
+    bool is_file;
+    const char* arg;
+};
+
+static bool run_file(lpr_ctx* ctx, const char* path) {
+    int fd = std::strcmp(path, "-") == 0 ? STDIN_FILENO : open(path, O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Cannot open " << path << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+    lpr_result r = lpr_exec_fd(ctx, fd, 1 << 20);
+    if (fd != STDIN_FILENO) close(fd);
+    if (!r.ok) display_error(ctx);
+    return r.ok != 0;
+}
+
 // --- Full-screen display rendering (FTXUI DOM only) ---
 
 #include <ftxui/dom/elements.hpp>
@@ -264,14 +284,15 @@ static void run_tui(lpr_ctx* ctx) {
 
 int main(int argc, char* argv[]) {
     const char* db_path = nullptr;
-    std::vector<const char*> expressions;
+    std::vector<BatchItem> batch;
 
     for (int i = 1; i < argc; i++) {
-        if (std::strcmp(argv[i], "-e") == 0) {
+        if (std::strcmp(argv[i], "-e") == 0 || std::strcmp(argv[i], "-f") == 0) {
             if (i + 1 < argc) {
-                expressions.push_back(argv[++i]);
+                bool is_file = argv[i][1] == 'f';
+                batch.push_back({is_file, argv[++i]});
             } else {
-                std::cerr << "Option -e requires an argument\n";
+                std::cerr << "Option " << argv[i] << " requires an argument\n";
                 print_usage();
                 return 1;
             }
@@ -293,13 +314,18 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    // Non-interactive mode: execute -e expressions and exit
-    if (!expressions.empty()) {
+    // Non-interactive mode: execute -e expressions and -f files, then exit
+    if (!batch.empty()) {
         int exit_code = 0;
-        for (const char* expr : expressions) {
-            lpr_result r = lpr_exec(ctx, expr);
-            if (!r.ok) {
-                display_error(ctx);
+        for (const BatchItem& item : batch) {
+            bool ok;
+            if (item.is_file) {
+                ok = run_file(ctx, item.arg);
+            } else {
+                ok = lpr_exec(ctx, item.arg).ok != 0;
+                if (!ok) display_error(ctx);
+            }
+            if (!ok) {
                 exit_code = 1;
                 break;
             }
@@ -1,6 +1,8 @@
 #ifndef LPR_H
 #define LPR_H
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -16,9 +18,16 @@ typedef struct {
     int redo_levels;
 } lpr_state;
 
+/* Input source for lpr_exec_stream: read up to cap bytes into buf and return
+   the count, 0 at end of input, or -1 on error. */
+typedef long (*lpr_read_fn)(void* user, char* buf, size_t cap);
+
 lpr_ctx*   lpr_open(const char* db_path);
 void       lpr_close(lpr_ctx* ctx);
 lpr_result lpr_exec(lpr_ctx* ctx, const char* input);
+lpr_result lpr_exec_stream(lpr_ctx* ctx, lpr_read_fn read, void* user,
+                           size_t checkpoint_bytes);
+lpr_result lpr_exec_fd(lpr_ctx* ctx, int fd, size_t checkpoint_bytes);
 int        lpr_depth(lpr_ctx* ctx);
 char*      lpr_repr(lpr_ctx* ctx, int level);
 int        lpr_undo(lpr_ctx* ctx);
@@ -29,6 +38,8 @@ char*      lpr_path(lpr_ctx* ctx);
 char*      lpr_dir_contents(lpr_ctx* ctx);
 int        lpr_history_count(lpr_ctx* ctx);
 char*      lpr_history_entry(lpr_ctx* ctx, int index);
+double*    lpr_plot_data(lpr_ctx* ctx, const char* fn, const char* var,
+                         double xmin, double xmax, int max_points, int* count);
 void       lpr_free(void* ptr);
 
 #ifdef __cplusplus
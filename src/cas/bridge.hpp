@@ -1,10 +1,15 @@
 #pragma once
 
 #include "../core/object.hpp"
+#include <cstdint>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace lpr {
 
+enum class CASOp { Diff, Integrate, Solve, Simplify, Expand, Factor };
+
 class CASBridge {
 public:
     virtual ~CASBridge() = default;
@@ -15,6 +20,41 @@ public:
     virtual Object simplify(const Object& expr) = 0;
     virtual Object expand(const Object& expr) = 0;
     virtual Object factor(const Object& expr) = 0;
+
+    // Apply `op` to every expression in one call. Operations that take a
+    // variable run once per (expression, variable) pair, results ordered by
+    // expression then variable; the others ignore `vars`. The default loops
+    // over the single-expression methods; bridges override it to share
+    // conversion work across the batch.
+    virtual std::vector<Object> apply_batch(CASOp op, const std::vector<Object>& exprs,
+                                            const std::vector<std::string>& vars) {
+        std::vector<Object> out;
+        for (const auto& expr : exprs) {
+            switch (op) {
+                case CASOp::Diff:
+                    for (const auto& v : vars) out.push_back(differentiate(expr, v));
+                    break;
+                case CASOp::Integrate:
+                    for (const auto& v : vars) out.push_back(integrate(expr, v));
+                    break;
+                case CASOp::Solve:
+                    for (const auto& v : vars) out.push_back(solve(expr, v));
+                    break;
+                case CASOp::Simplify: out.push_back(simplify(expr)); break;
+                case CASOp::Expand:   out.push_back(expand(expr)); break;
+                case CASOp::Factor:   out.push_back(factor(expr)); break;
+            }
+        }
+        return out;
+    }
+
+    // True for the operations that take a variable
+    static bool takes_var(CASOp op) {
+        return op == CASOp::Diff || op == CASOp::Integrate || op == CASOp::Solve;
+    }
+
+    // Named counters for PERFSTATS; plain bridges have none.
+    virtual std::vector<std::pair<std::string, int64_t>> stats() const { return {}; }
 };
 
 } // namespace lpr
@@ -0,0 +1,187 @@
+#include "caching_bridge.hpp"
+#include "core/expr_tree.hpp"
+#include "core/store.hpp"
+#include <chrono>
+#include <stdexcept>
+
+namespace lpr {
+
+namespace {
+
+int64_t elapsed_us(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+// Rough heap footprint of a cached result, for the size bound.
+size_t approx_bytes(const Object& obj) {
+    if (holds_alternative<Symbol>(obj)) return get<Symbol>(obj).value().size() + 64;
+    if (holds_alternative<List>(obj)) {
+        size_t n = 32;
+        for (const auto& item : get<List>(obj).items) n += approx_bytes(item);
+        return n;
+    }
+    return 64;
+}
+
+} // namespace
+
+CachingCASBridge::CachingCASBridge(std::unique_ptr<CASBridge> inner, Store& store,
+                                   size_t max_bytes)
+    : inner_(std::move(inner)), store_(store), max_bytes_(max_bytes) {}
+
+Object CachingCASBridge::differentiate(const Object& expr, const std::string& var) {
+    return cached("DIFF", expr, var, [&] { return inner_->differentiate(expr, var); });
+}
+
+Object CachingCASBridge::integrate(const Object& expr, const std::string& var) {
+    return cached("INTEGRATE", expr, var, [&] { return inner_->integrate(expr, var); });
+}
+
+Object CachingCASBridge::solve(const Object& expr, const std::string& var) {
+    return cached("SOLVE", expr, var, [&] { return inner_->solve(expr, var); });
+}
+
+Object CachingCASBridge::simplify(const Object& expr) {
+    return cached("SIMPLIFY", expr, "", [&] { return inner_->simplify(expr); });
+}
+
+Object CachingCASBridge::expand(const Object& expr) {
+    return cached("EXPAND", expr, "", [&] { return inner_->expand(expr); });
+}
+
+Object CachingCASBridge::factor(const Object& expr) {
+    return cached("FACTOR", expr, "", [&] { return inner_->factor(expr); });
+}
+
+Object CachingCASBridge::cached(const char* op, const Object& expr, const std::string& var,
+                                const std::function<Object()>& compute) {
+    // Only Symbols are cached; anything else goes through for its error.
+    if (!holds_alternative<Symbol>(expr)) return compute();
+
+    std::string key = make_key(op, expr, var);
+    if (auto hit = lookup(key)) return *hit;
+
+    ++misses_;
+    auto start = std::chrono::steady_clock::now();
+    Object result = compute();
+    save(std::move(key), result, elapsed_us(start));
+    return result;
+}
+
+std::vector<Object> CachingCASBridge::apply_batch(CASOp op, const std::vector<Object>& exprs,
+                                                  const std::vector<std::string>& vars) {
+    static const char* const kNames[] = {"DIFF", "INTEGRATE", "SOLVE", "SIMPLIFY", "EXPAND", "FACTOR"};
+    const char* name = kNames[static_cast<int>(op)];
+    const std::vector<std::string> no_var{""};
+    const auto& keyed_vars = takes_var(op) ? vars : no_var;
+    size_t per_expr = keyed_vars.size();
+
+    // Answer what the cache can; send the rest to the inner bridge as one
+    // smaller batch.
+    std::vector<Object> out(exprs.size() * per_expr);
+    std::vector<std::string> keys(out.size());
+    std::vector<size_t> missing;
+    std::vector<Object> missing_exprs;
+    for (size_t e = 0; e < exprs.size(); ++e) {
+        bool complete = holds_alternative<Symbol>(exprs[e]);
+        for (size_t v = 0; v < per_expr && complete; ++v) {
+            keys[e * per_expr + v] = make_key(name, exprs[e], keyed_vars[v]);
+            auto hit = lookup(keys[e * per_expr + v]);
+            if (hit) out[e * per_expr + v] = std::move(*hit);
+            else complete = false;
+        }
+        if (!complete) {
+            missing.push_back(e);
+            missing_exprs.push_back(exprs[e]);
+        }
+    }
+    if (missing.empty()) return out;
+
+    misses_ += missing.size() * per_expr;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Object> computed = inner_->apply_batch(op, missing_exprs, vars);
+    if (computed.size() != missing.size() * per_expr)
+        throw std::runtime_error(std::string(name) + ": bad batch result");
+    int64_t cost_us = elapsed_us(start) / static_cast<int64_t>(computed.size());
+    for (size_t m = 0; m < missing.size(); ++m) {
+        size_t e = missing[m];
+        for (size_t v = 0; v < per_expr; ++v) {
+            Object& result = computed[m * per_expr + v];
+            if (holds_alternative<Symbol>(exprs[e])) {
+                if (keys[e * per_expr + v].empty())
+                    keys[e * per_expr + v] = make_key(name, exprs[e], keyed_vars[v]);
+                save(keys[e * per_expr + v], result, cost_us);
+            }
+            out[e * per_expr + v] = std::move(result);
+        }
+    }
+    return out;
+}
+
+std::string CachingCASBridge::make_key(const char* op, const Object& expr, const std::string& var) {
+    // The rendered tree is whitespace-insensitive: 'X^2 + 1' and 'X^2+1'
+    // share an entry.
+    return std::string(op) + '\x1f' + render_expr(get<Symbol>(expr).tree()) + '\x1f' + var;
+}
+
+std::optional<Object> CachingCASBridge::lookup(const std::string& key) {
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second);
+        ++hits_;
+        saved_us_ += it->second->cost_us;
+        return it->second->result;
+    }
+    if (store_.get_meta("cas_cache_persist") == "1") {
+        if (auto row = store_.cas_cache_get(key)) {
+            const auto& [tag, data, cost_us] = *row;
+            Object result = deserialize(static_cast<TypeTag>(tag), data);
+            ++hits_;
+            ++disk_hits_;
+            saved_us_ += cost_us;
+            insert(key, result, cost_us);
+            return result;
+        }
+    }
+    return std::nullopt;
+}
+
+void CachingCASBridge::save(std::string key, const Object& result, int64_t cost_us) {
+    if (store_.get_meta("cas_cache_persist") == "1") {
+        store_.cas_cache_put(key, static_cast<int>(type_tag(result)), serialize(result),
+                             cost_us, kMaxPersistedRows);
+    }
+    insert(std::move(key), result, cost_us);
+}
+
+void CachingCASBridge::insert(std::string key, Object result, int64_t cost_us) {
+    size_t bytes = key.size() + approx_bytes(result);
+    if (bytes > max_bytes_) return; // larger than the whole cache
+    lru_.push_front({std::move(key), std::move(result), bytes, cost_us});
+    index_[lru_.front().key] = lru_.begin();
+    bytes_ += bytes;
+    while (bytes_ > max_bytes_) {
+        bytes_ -= lru_.back().bytes;
+        index_.erase(lru_.back().key);
+        lru_.pop_back();
+        ++evictions_;
+    }
+}
+
+std::vector<std::pair<std::string, int64_t>> CachingCASBridge::stats() const {
+    auto n = [](auto v) { return static_cast<int64_t>(v); };
+    std::vector<std::pair<std::string, int64_t>> out = {
+        {"cas_cache_hits",      n(hits_)},
+        {"cas_cache_misses",    n(misses_)},
+        {"cas_cache_disk_hits", n(disk_hits_)},
+        {"cas_cache_evictions", n(evictions_)},
+        {"cas_cache_size",      n(index_.size())},
+        {"cas_cache_bytes",     n(bytes_)},
+        {"cas_cache_saved_us",  n(saved_us_)},
+    };
+    for (auto& stat : inner_->stats()) out.push_back(std::move(stat));
+    return out;
+}
+
+} // namespace lpr
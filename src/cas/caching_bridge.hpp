@@ -0,0 +1,74 @@
+#pragma once
+
+#include "bridge.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace lpr {
+
+class Store;
+
+// Memoizing decorator over another CASBridge. Results are keyed by
+// (operation, canonical expression text, variable) and kept in an LRU bounded
+// by approximate size. With the "cas_cache_persist" meta setting on
+// (CASCACHE), misses also consult and fill the store's cas_cache table, so
+// results survive restarts.
+class CachingCASBridge : public CASBridge {
+public:
+    static constexpr size_t kDefaultMaxBytes = size_t(4) << 20;
+    static constexpr int kMaxPersistedRows = 10000;
+
+    CachingCASBridge(std::unique_ptr<CASBridge> inner, Store& store,
+                     size_t max_bytes = kDefaultMaxBytes);
+
+    Object differentiate(const Object& expr, const std::string& var) override;
+    Object integrate(const Object& expr, const std::string& var) override;
+    Object solve(const Object& expr, const std::string& var) override;
+    Object simplify(const Object& expr) override;
+    Object expand(const Object& expr) override;
+    Object factor(const Object& expr) override;
+    std::vector<Object> apply_batch(CASOp op, const std::vector<Object>& exprs,
+                                    const std::vector<std::string>& vars) override;
+
+    std::vector<std::pair<std::string, int64_t>> stats() const override;
+
+    size_t size() const { return index_.size(); }
+    size_t bytes() const { return bytes_; }
+    uint64_t hits() const { return hits_; }
+    uint64_t misses() const { return misses_; }
+
+private:
+    struct Entry {
+        std::string key;
+        Object result;
+        size_t bytes;
+        int64_t cost_us; // time the computation took
+    };
+
+    Object cached(const char* op, const Object& expr, const std::string& var,
+                  const std::function<Object()>& compute);
+    static std::string make_key(const char* op, const Object& expr, const std::string& var);
+    std::optional<Object> lookup(const std::string& key); // memory, then disk
+    void save(std::string key, const Object& result, int64_t cost_us);
+    void insert(std::string key, Object result, int64_t cost_us);
+
+    std::unique_ptr<CASBridge> inner_;
+    Store& store_;
+    size_t max_bytes_;
+    size_t bytes_ = 0;
+    std::list<Entry> lru_; // most recent first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t disk_hits_ = 0;
+    uint64_t evictions_ = 0;
+    int64_t saved_us_ = 0;
+};
+
+} // namespace lpr
@@ -0,0 +1,258 @@
+#include "guarded_bridge.hpp"
+#include "core/expr_tree.hpp"
+#include "core/store.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace lpr {
+
+namespace {
+
+const char* const kOpNames[] = {"DIFF", "INTEGRATE", "SOLVE", "SIMPLIFY", "EXPAND", "FACTOR"};
+const char* const kStatNames[] = {"diff", "integrate", "solve", "simplify", "expand", "factor"};
+
+int64_t meta_int(Store& store, const char* key, int64_t default_val) {
+    std::string setting = store.get_meta(key);
+    if (setting.empty()) return default_val;
+    try { return std::stoll(setting); } catch (...) { return default_val; }
+}
+
+// Expression tree nodes across every Symbol in obj, counting shared
+// subtrees each time they are reached. Stops early once past `limit`.
+int64_t expr_size(const Object& obj, int64_t limit) {
+    int64_t count = 0;
+    std::vector<const ExprNode*> work;
+    std::vector<const Object*> objects{&obj};
+    while (!objects.empty() && count <= limit) {
+        const Object* o = objects.back();
+        objects.pop_back();
+        if (holds_alternative<List>(*o)) {
+            for (const auto& item : get<List>(*o).items) objects.push_back(&item);
+        } else if (holds_alternative<Matrix>(*o)) {
+            for (const auto& row : get<Matrix>(*o).rows)
+                for (const auto& item : row) objects.push_back(&item);
+        } else if (holds_alternative<Symbol>(*o)) {
+            work.push_back(get<Symbol>(*o).tree().get());
+            while (!work.empty() && count <= limit) {
+                const ExprNode* node = work.back();
+                work.pop_back();
+                ++count;
+                for (const auto& kid : node->kids) work.push_back(kid.get());
+            }
+            work.clear();
+        }
+    }
+    return count;
+}
+
+} // namespace
+
+struct GuardedCASBridge::Worker {
+    std::unique_ptr<CASBridge> bridge;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::function<void()> job;
+    bool stop = false;
+    bool abandoned = false;
+    std::thread thread;
+};
+
+void GuardedCASBridge::Latency::add(int64_t v) {
+    if (us.size() < kWindow) {
+        us.push_back(v);
+    } else {
+        us[next] = v;
+        next = (next + 1) % kWindow;
+    }
+    ++calls;
+}
+
+int64_t GuardedCASBridge::Latency::percentile(double p) const {
+    if (us.empty()) return 0;
+    std::vector<int64_t> sorted = us;
+    size_t k = std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()));
+    std::nth_element(sorted.begin(), sorted.begin() + k, sorted.end());
+    return sorted[k];
+}
+
+GuardedCASBridge::GuardedCASBridge(Factory factory, Store& store)
+    : factory_(std::move(factory)), store_(store),
+      abandoned_(std::make_shared<std::atomic<int>>(0)) {}
+
+GuardedCASBridge::~GuardedCASBridge() {
+    if (!worker_ || !worker_->thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(worker_->mtx);
+        worker_->stop = true;
+    }
+    worker_->cv.notify_one();
+    worker_->thread.join();
+}
+
+std::shared_ptr<GuardedCASBridge::Worker> GuardedCASBridge::worker() {
+    if (!worker_) {
+        worker_ = std::make_shared<Worker>();
+        worker_->bridge = factory_();
+    }
+    return worker_;
+}
+
+void GuardedCASBridge::check_size(OpIndex op, const Object* exprs, size_t n) {
+    int64_t max_nodes = meta_int(store_, "cas_max_nodes", kDefaultMaxNodes);
+    if (max_nodes <= 0) return;
+    for (size_t i = 0; i < n; ++i) {
+        if (expr_size(exprs[i], max_nodes) > max_nodes) {
+            ++rejected_;
+            throw std::runtime_error(std::string(kOpNames[op]) + ": expression too complex");
+        }
+    }
+}
+
+Object GuardedCASBridge::run(OpIndex op, const std::function<Object(CASBridge&)>& call) {
+    const std::string name = kOpNames[op];
+
+    int64_t timeout_ms = meta_int(store_, "cas_timeout_ms", kDefaultTimeoutMs);
+    auto start = std::chrono::steady_clock::now();
+    auto record = [&] {
+        latency_[op].add(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    };
+
+    if (timeout_ms <= 0) {
+        Object result;
+        try {
+            result = call(*worker()->bridge);
+        } catch (...) {
+            record();
+            throw;
+        }
+        record();
+        return result;
+    }
+
+    if (abandoned_->load() >= kMaxAbandoned)
+        throw std::runtime_error(name + ": CAS busy with timed-out calls");
+
+    std::shared_ptr<Worker> w = worker();
+    if (!w->thread.joinable()) {
+        // The thread keeps its worker and the abandoned-count alive, so it
+        // can outlive this bridge after a timeout.
+        w->thread = std::thread([w, abandoned = abandoned_] {
+            for (;;) {
+                std::function<void()> job;
+                {
+                    std::unique_lock<std::mutex> lock(w->mtx);
+                    w->cv.wait(lock, [&] { return w->stop || w->job; });
+                    if (!w->job) {
+                        if (w->abandoned) --*abandoned;
+                        return;
+                    }
+                    job = std::move(w->job);
+                    w->job = nullptr;
+                }
+                job();
+            }
+        });
+    }
+
+    // The task owns copies of its inputs; an abandoned worker may run it
+    // after the caller has gone.
+    auto task = std::make_shared<std::packaged_task<Object()>>([w, call] { return call(*w->bridge); });
+    auto result = task->get_future();
+    {
+        std::lock_guard<std::mutex> lock(w->mtx);
+        w->job = [task] { (*task)(); };
+    }
+    w->cv.notify_one();
+
+    if (result.wait_for(std::chrono::milliseconds(timeout_ms)) == std::future_status::timeout) {
+        ++timeouts_;
+        ++*abandoned_;
+        {
+            std::lock_guard<std::mutex> lock(w->mtx);
+            w->stop = true;
+            w->abandoned = true;
+        }
+        w->thread.detach();
+        worker_.reset();
+        throw std::runtime_error(name + ": timed out after " + std::to_string(timeout_ms) + " ms");
+    }
+    try {
+        Object value = result.get();
+        record();
+        return value;
+    } catch (...) {
+        record();
+        throw;
+    }
+}
+
+Object GuardedCASBridge::differentiate(const Object& expr, const std::string& var) {
+    check_size(DIFF, &expr, 1);
+    return run(DIFF, [expr, var](CASBridge& b) { return b.differentiate(expr, var); });
+}
+
+Object GuardedCASBridge::integrate(const Object& expr, const std::string& var) {
+    check_size(INTEGRATE, &expr, 1);
+    return run(INTEGRATE, [expr, var](CASBridge& b) { return b.integrate(expr, var); });
+}
+
+Object GuardedCASBridge::solve(const Object& expr, const std::string& var) {
+    check_size(SOLVE, &expr, 1);
+    return run(SOLVE, [expr, var](CASBridge& b) { return b.solve(expr, var); });
+}
+
+Object GuardedCASBridge::simplify(const Object& expr) {
+    check_size(SIMPLIFY, &expr, 1);
+    return run(SIMPLIFY, [expr](CASBridge& b) { return b.simplify(expr); });
+}
+
+Object GuardedCASBridge::expand(const Object& expr) {
+    check_size(EXPAND, &expr, 1);
+    return run(EXPAND, [expr](CASBridge& b) { return b.expand(expr); });
+}
+
+Object GuardedCASBridge::factor(const Object& expr) {
+    check_size(FACTOR, &expr, 1);
+    return run(FACTOR, [expr](CASBridge& b) { return b.factor(expr); });
+}
+
+std::vector<Object> GuardedCASBridge::apply_batch(CASOp op, const std::vector<Object>& exprs,
+                                                  const std::vector<std::string>& vars) {
+    // The whole batch is one call with one time budget; the size limit
+    // applies to each expression, as it would one at a time
+    OpIndex index = static_cast<OpIndex>(op);
+    check_size(index, exprs.data(), exprs.size());
+    Object batch = List{exprs};
+    Object result = run(index, [batch, op, vars](CASBridge& b) -> Object {
+        return List{b.apply_batch(op, get<List>(batch).items, vars)};
+    });
+    return std::move(get<List>(result).items);
+}
+
+std::vector<std::pair<std::string, int64_t>> GuardedCASBridge::stats() const {
+    std::vector<std::pair<std::string, int64_t>> out = {
+        {"cas_timeouts", static_cast<int64_t>(timeouts_)},
+        {"cas_rejected", static_cast<int64_t>(rejected_)},
+    };
+    for (int op = 0; op < kOpCount; ++op) {
+        const Latency& lat = latency_[op];
+        if (lat.calls == 0) continue;
+        std::string prefix = std::string("cas_") + kStatNames[op];
+        out.push_back({prefix + "_calls", static_cast<int64_t>(lat.calls)});
+        out.push_back({prefix + "_p50_us", lat.percentile(0.50)});
+        out.push_back({prefix + "_p90_us", lat.percentile(0.90)});
+        out.push_back({prefix + "_p99_us", lat.percentile(0.99)});
+    }
+    if (worker_ && worker_->bridge) {
+        for (auto& stat : worker_->bridge->stats()) out.push_back(std::move(stat));
+    }
+    return out;
+}
+
+} // namespace lpr
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "bridge.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lpr {
+
+class Store;
+
+// Runs another CASBridge under a time and size budget. Calls go to a worker
+// thread and the caller waits at most "cas_timeout_ms" (meta, default 10000;
+// 0 runs inline with no limit). A call that overruns fails with an error,
+// so the command rolls back as usual. SymEngine cannot be interrupted, so the
+// worker is abandoned to finish on its own, with the bridge it was using, and
+// a fresh bridge from the factory serves the next call. Inputs whose
+// expression trees exceed "cas_max_nodes" (default 20000; 0 = no limit) are
+// refused before any work starts. Both settings come from CASLIMIT.
+class GuardedCASBridge : public CASBridge {
+public:
+    using Factory = std::function<std::unique_ptr<CASBridge>()>;
+
+    static constexpr int64_t kDefaultTimeoutMs = 10000;
+    static constexpr int64_t kDefaultMaxNodes = 20000;
+    static constexpr int kMaxAbandoned = 4; // overrunning workers allowed at once
+
+    GuardedCASBridge(Factory factory, Store& store);
+    ~GuardedCASBridge() override;
+
+    Object differentiate(const Object& expr, const std::string& var) override;
+    Object integrate(const Object& expr, const std::string& var) override;
+    Object solve(const Object& expr, const std::string& var) override;
+    Object simplify(const Object& expr) override;
+    Object expand(const Object& expr) override;
+    Object factor(const Object& expr) override;
+    std::vector<Object> apply_batch(CASOp op, const std::vector<Object>& exprs,
+                                    const std::vector<std::string>& vars) override;
+
+    std::vector<std::pair<std::string, int64_t>> stats() const override;
+
+    uint64_t timeouts() const { return timeouts_; }
+
+private:
+    enum OpIndex { DIFF, INTEGRATE, SOLVE, SIMPLIFY, EXPAND, FACTOR, kOpCount }; // CASOp order
+
+    struct Worker;
+
+    // Latencies of the most recent calls, for percentiles
+    struct Latency {
+        static constexpr size_t kWindow = 256;
+        std::vector<int64_t> us;
+        size_t next = 0;
+        uint64_t calls = 0;
+        void add(int64_t v);
+        int64_t percentile(double p) const;
+    };
+
+    // Refuses the call if any of the n inputs exceeds "cas_max_nodes"
+    void check_size(OpIndex op, const Object* exprs, size_t n);
+    Object run(OpIndex op, const std::function<Object(CASBridge&)>& call);
+    std::shared_ptr<Worker> worker();
+
+    Factory factory_;
+    Store& store_;
+    std::shared_ptr<Worker> worker_;
+    std::shared_ptr<std::atomic<int>> abandoned_;
+    std::array<Latency, kOpCount> latency_;
+    uint64_t timeouts_ = 0;
+    uint64_t rejected_ = 0;
+};
+
+} // namespace lpr
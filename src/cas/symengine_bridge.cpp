@@ -1,4 +1,5 @@
 #include "symengine_bridge.hpp"
+#include "core/expr_tree.hpp"
 
 #include <symengine/parser.h>
 #include <symengine/symbol.h>
@@ -13,14 +14,70 @@
 #include <symengine/constants.h>
 #include <symengine/sets.h>
 #include <symengine/visitor.h>
+#include <symengine/real_double.h>
+#include <symengine/printers/strprinter.h>
 
 #include <sstream>
-#include <regex>
 #include <algorithm>
 #include <cctype>
 
 namespace lpr {
 
+namespace {
+
+std::string to_lower(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(),
+        [](unsigned char c) { return std::tolower(c); });
+    return s;
+}
+
+std::string to_upper(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(),
+        [](unsigned char c) { return std::toupper(c); });
+    return s;
+}
+
+// SymEngine's string printer with RPL spelling: upper-case symbols,
+// constants and function names, ^ for powers.
+class RplPrinter : public SymEngine::BaseVisitor<RplPrinter, SymEngine::StrPrinter> {
+public:
+    explicit RplPrinter(const std::unordered_map<std::string, std::string>& rpl_names)
+        : rpl_names_(rpl_names) {}
+
+    using SymEngine::StrPrinter::apply;
+    using SymEngine::StrPrinter::bvisit;
+
+    void bvisit(const SymEngine::Symbol& x) { str_ = to_upper(x.get_name()); }
+    void bvisit(const SymEngine::Constant& x) { str_ = to_upper(x.get_name()); }
+
+    void bvisit(const SymEngine::Function& x) {
+        SymEngine::StrPrinter::bvisit(x);
+        size_t paren = str_.find('(');
+        if (paren == std::string::npos) return;
+        std::string head = str_.substr(0, paren);
+        auto it = rpl_names_.find(head);
+        str_ = (it != rpl_names_.end() ? it->second : to_upper(head)) + str_.substr(paren);
+    }
+
+protected:
+    void _print_pow(std::ostringstream& o, const SymEngine::RCP<const SymEngine::Basic>& a,
+                    const SymEngine::RCP<const SymEngine::Basic>& b) override {
+        if (SymEngine::eq(*a, *SymEngine::E)) {
+            o << "EXP(" << apply(b) << ")";
+        } else if (SymEngine::eq(*b, *SymEngine::rational(1, 2))) {
+            o << "SQRT(" << apply(a) << ")";
+        } else {
+            o << parenthesizeLE(a, SymEngine::PrecedenceEnum::Pow) << "^"
+              << parenthesizeLE(b, SymEngine::PrecedenceEnum::Pow);
+        }
+    }
+
+private:
+    const std::unordered_map<std::string, std::string>& rpl_names_;
+};
+
+} // namespace
+
 SymEngineBridge::SymEngineBridge() {
     // RPL uppercase → SymEngine lowercase function names
     rpl_to_symengine_ = {
@@ -41,13 +98,146 @@ SymEngineBridge::SymEngineBridge() {
     for (auto& [rpl, se] : rpl_to_symengine_) {
         symengine_to_rpl_[se] = rpl;
     }
+    symengine_to_rpl_["abs"] = "ABS";
 }
 
-std::string SymEngineBridge::extract_symbol_string(const Object& obj, const std::string& cmd) {
-    if (!std::holds_alternative<Symbol>(obj)) {
+// --- Conversion cache ---
+
+SymEngine::RCP<const SymEngine::Basic> SymEngineBridge::to_basic(const Object& obj, const std::string& cmd) {
+    if (!holds_alternative<Symbol>(obj)) {
         throw std::runtime_error(cmd + " requires a symbolic expression");
     }
-    return std::get<Symbol>(obj).value;
+    const Symbol& sym = get<Symbol>(obj);
+    if (auto handle = sym.cas_handle()) return handle->expr;
+
+    const std::string& text = sym.value();
+    auto it = conv_index_.find(text);
+    SymEngine::RCP<const SymEngine::Basic> expr;
+    if (it != conv_index_.end()) {
+        conv_lru_.splice(conv_lru_.begin(), conv_lru_, it->second);
+        expr = it->second->second;
+    } else {
+        expr = tree_to_symengine(*sym.tree());
+        remember(text, expr);
+    }
+    sym.set_cas_handle(std::make_shared<CasHandle>(CasHandle{expr}));
+    return expr;
+}
+
+Object SymEngineBridge::to_object(const SymEngine::RCP<const SymEngine::Basic>& expr) {
+    Symbol sym{from_symengine(expr)};
+    sym.set_cas_handle(std::make_shared<CasHandle>(CasHandle{expr}));
+    remember(sym.value(), expr);
+    return sym;
+}
+
+void SymEngineBridge::remember(const std::string& text,
+                               const SymEngine::RCP<const SymEngine::Basic>& expr) {
+    auto it = conv_index_.find(text);
+    if (it != conv_index_.end()) {
+        it->second->second = expr;
+        conv_lru_.splice(conv_lru_.begin(), conv_lru_, it->second);
+        return;
+    }
+    conv_lru_.emplace_front(text, expr);
+    conv_index_[text] = conv_lru_.begin();
+    if (conv_lru_.size() > kConvCacheCapacity) {
+        conv_index_.erase(conv_lru_.back().first);
+        conv_lru_.pop_back();
+    }
+}
+
+SymEngine::RCP<const SymEngine::Symbol> SymEngineBridge::symbol_for(const std::string& name) {
+    auto it = symbols_.find(name);
+    if (it != symbols_.end()) return it->second;
+    if (symbols_.size() >= 4096) symbols_.clear(); // names are few; bound it anyway
+    auto sym = SymEngine::symbol(to_lower(name));
+    symbols_.emplace(name, sym);
+    return sym;
+}
+
+SymEngine::RCP<const SymEngine::Basic> SymEngineBridge::tree_to_symengine(const ExprNode& node) {
+    if (!batch_memo_) return convert_node(node);
+    auto it = batch_memo_->find(&node);
+    if (it != batch_memo_->end()) return it->second;
+    auto expr = convert_node(node);
+    batch_memo_->emplace(&node, expr);
+    return expr;
+}
+
+// Convert an expression tree to SymEngine directly, without printing and
+// re-parsing. Variable names are lowered, as on the text path.
+SymEngine::RCP<const SymEngine::Basic> SymEngineBridge::convert_node(const ExprNode& node) {
+    using Kind = ExprNode::Kind;
+    switch (node.kind) {
+        case Kind::Number:
+            if (node.text.find_first_of(".eE") != std::string::npos) {
+                return SymEngine::real_double(std::stod(node.text));
+            }
+            return SymEngine::integer(SymEngine::integer_class(node.text.c_str()));
+        case Kind::Name:
+            return symbol_for(node.text);
+        case Kind::Opaque:
+            return to_symengine(node.text);
+        case Kind::Group:
+            return tree_to_symengine(*node.kids[0]);
+        case Kind::Neg:
+            return SymEngine::mul(SymEngine::integer(-1), tree_to_symengine(*node.kids[0]));
+        case Kind::Add:
+            return SymEngine::add(tree_to_symengine(*node.kids[0]), tree_to_symengine(*node.kids[1]));
+        case Kind::Sub:
+            return SymEngine::sub(tree_to_symengine(*node.kids[0]), tree_to_symengine(*node.kids[1]));
+        case Kind::Mul:
+            return SymEngine::mul(tree_to_symengine(*node.kids[0]), tree_to_symengine(*node.kids[1]));
+        case Kind::Div:
+            return SymEngine::div(tree_to_symengine(*node.kids[0]), tree_to_symengine(*node.kids[1]));
+        case Kind::Pow: {
+            // An ungrouped negative base only comes from source text such as
+            // '-X^2', which the CAS has always read as -(X^2)
+            const ExprNode& base = *node.kids[0];
+            auto exponent = tree_to_symengine(*node.kids[1]);
+            if (base.kind == Kind::Neg) {
+                return SymEngine::mul(SymEngine::integer(-1),
+                                      SymEngine::pow(tree_to_symengine(*base.kids[0]), exponent));
+            }
+            if (base.kind == Kind::Number && !base.text.empty() && base.text[0] == '-') {
+                return SymEngine::mul(SymEngine::integer(-1),
+                                      SymEngine::pow(tree_to_symengine(*make_number(base.text.substr(1))),
+                                                     exponent));
+            }
+            return SymEngine::pow(tree_to_symengine(base), exponent);
+        }
+        case Kind::Call:
+            break;
+    }
+
+    SymEngine::vec_basic args;
+    for (const auto& kid : node.kids) args.push_back(tree_to_symengine(*kid));
+    std::string name = to_upper(node.text);
+    auto unary = [&](auto fn) {
+        if (args.size() != 1) throw std::runtime_error("Wrong number of arguments: " + name);
+        return fn(args[0]);
+    };
+
+    if (name == "SQ")   return unary([](const auto& x) { return SymEngine::pow(x, SymEngine::integer(2)); });
+    if (name == "LOG")  return unary([](const auto& x) {
+        return SymEngine::div(SymEngine::log(x), SymEngine::log(SymEngine::integer(10)));
+    });
+    if (name == "SIN")  return unary([](const auto& x) { return SymEngine::sin(x); });
+    if (name == "COS")  return unary([](const auto& x) { return SymEngine::cos(x); });
+    if (name == "TAN")  return unary([](const auto& x) { return SymEngine::tan(x); });
+    if (name == "ASIN") return unary([](const auto& x) { return SymEngine::asin(x); });
+    if (name == "ACOS") return unary([](const auto& x) { return SymEngine::acos(x); });
+    if (name == "ATAN") return unary([](const auto& x) { return SymEngine::atan(x); });
+    if (name == "EXP")  return unary([](const auto& x) { return SymEngine::exp(x); });
+    if (name == "LN")   return unary([](const auto& x) { return SymEngine::log(x); });
+    if (name == "SQRT") return unary([](const auto& x) { return SymEngine::sqrt(x); });
+    if (name == "ABS")  return unary([](const auto& x) { return SymEngine::abs(x); });
+    if (name == "ATAN2") {
+        if (args.size() != 2) throw std::runtime_error("Wrong number of arguments: ATAN2");
+        return SymEngine::atan2(args[0], args[1]);
+    }
+    return SymEngine::function_symbol(to_lower(node.text), args);
 }
 
 // Convert an RPL expression string to a SymEngine expression tree.
@@ -148,77 +338,24 @@ SymEngine::RCP<const SymEngine::Basic> SymEngineBridge::to_symengine(const std::
 }
 
 // Convert a SymEngine expression back to an RPL string.
-// Maps lowercase function names back to uppercase, ** → ^, variable names to uppercase.
+// Prints with SymEngine's layout, spelled the RPL way (see RplPrinter).
 std::string SymEngineBridge::from_symengine(const SymEngine::RCP<const SymEngine::Basic>& expr) {
-    std::ostringstream oss;
-    oss << *expr;
-    std::string result = oss.str();
-
-    // Replace ** with ^
-    std::string out;
-    out.reserve(result.size());
-    for (size_t i = 0; i < result.size(); ++i) {
-        if (i + 1 < result.size() && result[i] == '*' && result[i + 1] == '*') {
-            out += '^';
-            i++; // skip second *
-        } else {
-            out += result[i];
-        }
-    }
-    result = out;
-
-    // Map SymEngine function names back to RPL names AND uppercase variables
-    std::string final;
-    final.reserve(result.size());
-    size_t i = 0;
-    while (i < result.size()) {
-        if (std::isalpha(static_cast<unsigned char>(result[i])) || result[i] == '_') {
-            std::string ident;
-            while (i < result.size() && (std::isalnum(static_cast<unsigned char>(result[i])) || result[i] == '_')) {
-                ident += result[i++];
-            }
-
-            // Check known SymEngine function names
-            auto it = symengine_to_rpl_.find(ident);
-            if (it != symengine_to_rpl_.end()) {
-                final += it->second;
-            } else {
-                // Variable or unknown — uppercase it
-                std::string upper = ident;
-                std::transform(upper.begin(), upper.end(), upper.begin(),
-                    [](unsigned char c) { return std::toupper(c); });
-                final += upper;
-            }
-        } else {
-            final += result[i++];
-        }
-    }
-
-    return final;
+    RplPrinter printer(symengine_to_rpl_);
+    return printer.apply(*expr);
 }
 
 // --- Bridge operations ---
 
 Object SymEngineBridge::differentiate(const Object& expr, const std::string& var) {
-    std::string expr_str = extract_symbol_string(expr, "DIFF");
-    std::string var_lower = var;
-    std::transform(var_lower.begin(), var_lower.end(), var_lower.begin(),
-        [](unsigned char c) { return std::tolower(c); });
-
-    auto se_expr = to_symengine(expr_str);
-    auto se_var = SymEngine::symbol(var_lower);
+    auto se_expr = to_basic(expr, "DIFF");
+    auto se_var = symbol_for(var);
     auto se_result = se_expr->diff(se_var);
-    return Symbol{from_symengine(se_result)};
+    return to_object(se_result);
 }
 
 Object SymEngineBridge::integrate(const Object& expr, const std::string& var) {
-    std::string expr_str = extract_symbol_string(expr, "INTEGRATE");
-    std::string var_lower = var;
-    std::transform(var_lower.begin(), var_lower.end(), var_lower.begin(),
-        [](unsigned char c) { return std::tolower(c); });
-
-    auto se_expr = to_symengine(expr_str);
-    auto se_var = SymEngine::symbol(var_lower);
+    auto se_expr = to_basic(expr, "INTEGRATE");
+    auto se_var = symbol_for(var);
 
     // SymEngine doesn't have a top-level integrate() function.
     // We implement term-by-term integration for polynomials + elementary functions.
@@ -226,7 +363,7 @@ Object SymEngineBridge::integrate(const Object& expr, const std::string& var) {
 
     try {
         auto result = integrate_term(expanded, se_var);
-        return Symbol{from_symengine(result)};
+        return to_object(result);
     } catch (const std::runtime_error&) {
         throw;
     } catch (const std::exception&) {
@@ -316,13 +453,8 @@ SymEngine::RCP<const SymEngine::Basic> SymEngineBridge::integrate_term(
 }
 
 Object SymEngineBridge::solve(const Object& expr, const std::string& var) {
-    std::string expr_str = extract_symbol_string(expr, "SOLVE");
-    std::string var_lower = var;
-    std::transform(var_lower.begin(), var_lower.end(), var_lower.begin(),
-        [](unsigned char c) { return std::tolower(c); });
-
-    auto se_expr = to_symengine(expr_str);
-    auto se_var = SymEngine::symbol(var_lower);
+    auto se_expr = to_basic(expr, "SOLVE");
+    auto se_var = symbol_for(var);
 
     auto solution_set = SymEngine::solve(se_expr, se_var);
 
@@ -342,7 +474,7 @@ Object SymEngineBridge::solve(const Object& expr, const std::string& var) {
                 result.items.push_back(r);
             } else {
                 // Symbolic solution
-                result.items.push_back(Symbol{from_symengine(sol)});
+                result.items.push_back(to_object(sol));
             }
         }
     } else if (SymEngine::is_a<SymEngine::EmptySet>(*solution_set)) {
@@ -354,22 +486,19 @@ Object SymEngineBridge::solve(const Object& expr, const std::string& var) {
 }
 
 Object SymEngineBridge::simplify(const Object& expr) {
-    std::string expr_str = extract_symbol_string(expr, "SIMPLIFY");
-    auto se_expr = to_symengine(expr_str);
+    auto se_expr = to_basic(expr, "SIMPLIFY");
     auto se_result = SymEngine::simplify(se_expr);
-    return Symbol{from_symengine(se_result)};
+    return to_object(se_result);
 }
 
 Object SymEngineBridge::expand(const Object& expr) {
-    std::string expr_str = extract_symbol_string(expr, "EXPAND");
-    auto se_expr = to_symengine(expr_str);
+    auto se_expr = to_basic(expr, "EXPAND");
     auto se_result = SymEngine::expand(se_expr);
-    return Symbol{from_symengine(se_result)};
+    return to_object(se_result);
 }
 
 Object SymEngineBridge::factor(const Object& expr) {
-    std::string expr_str = extract_symbol_string(expr, "FACTOR");
-    auto se_expr = to_symengine(expr_str);
+    auto se_expr = to_basic(expr, "FACTOR");
     auto expanded = SymEngine::expand(se_expr);
 
     // Use solve to find roots, then determine multiplicity via successive derivatives
@@ -424,13 +553,48 @@ Object SymEngineBridge::factor(const Object& expr) {
                     }
                 }
 
-                return Symbol{from_symengine(factored)};
+                return to_object(factored);
             }
         }
     }
 
     // If factoring fails, return the original expression
-    return Symbol{from_symengine(se_expr)};
+    return to_object(se_expr);
+}
+
+std::vector<Object> SymEngineBridge::apply_batch(CASOp op, const std::vector<Object>& exprs,
+                                                 const std::vector<std::string>& vars) {
+    const char* cmd = op == CASOp::Diff ? "DIFF"
+                    : op == CASOp::Simplify ? "SIMPLIFY"
+                    : op == CASOp::Expand ? "EXPAND" : nullptr;
+    if (!cmd) return CASBridge::apply_batch(op, exprs, vars);
+
+    std::unordered_map<const ExprNode*, SymEngine::RCP<const SymEngine::Basic>> memo;
+    batch_memo_ = &memo;
+    SymEngine::vec_basic inputs;
+    try {
+        for (const auto& expr : exprs) inputs.push_back(to_basic(expr, cmd));
+    } catch (...) {
+        batch_memo_ = nullptr;
+        throw;
+    }
+    batch_memo_ = nullptr;
+
+    std::vector<Object> out;
+    out.reserve(op == CASOp::Diff ? inputs.size() * vars.size() : inputs.size());
+    if (op == CASOp::Diff) {
+        std::vector<SymEngine::RCP<const SymEngine::Symbol>> syms;
+        for (const auto& v : vars) syms.push_back(symbol_for(v));
+        for (const auto& in : inputs) {
+            for (const auto& sym : syms) out.push_back(to_object(in->diff(sym)));
+        }
+    } else {
+        for (const auto& in : inputs) {
+            out.push_back(to_object(op == CASOp::Simplify ? SymEngine::simplify(in)
+                                                          : SymEngine::expand(in)));
+        }
+    }
+    return out;
 }
 
 } // namespace lpr
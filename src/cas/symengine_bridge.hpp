@@ -2,11 +2,17 @@
 
 #include "bridge.hpp"
 #include <symengine/basic.h>
+#include <list>
 #include <string>
 #include <unordered_map>
 
 namespace lpr {
 
+// SymEngine form of a Symbol, attached to it by the bridge.
+struct CasHandle {
+    SymEngine::RCP<const SymEngine::Basic> expr;
+};
+
 class SymEngineBridge : public CASBridge {
 public:
     SymEngineBridge();
@@ -18,12 +24,44 @@ public:
     Object expand(const Object& expr) override;
     Object factor(const Object& expr) override;
 
+    // DIFF, SIMPLIFY and EXPAND convert the whole batch in one pass, so
+    // subtrees shared between expressions are converted once.
+    std::vector<Object> apply_batch(CASOp op, const std::vector<Object>& exprs,
+                                    const std::vector<std::string>& vars) override;
+
 private:
     // Bidirectional function name mapping
     std::unordered_map<std::string, std::string> rpl_to_symengine_;
     std::unordered_map<std::string, std::string> symengine_to_rpl_;
 
-    // Convert between RPL expression strings and SymEngine expressions
+    // Recently converted expressions by RPL text, most recent first, so a
+    // chain such as EXPAND SIMPLIFY DIFF reuses the previous result directly.
+    using ConvEntry = std::pair<std::string, SymEngine::RCP<const SymEngine::Basic>>;
+    static constexpr size_t kConvCacheCapacity = 64;
+    std::list<ConvEntry> conv_lru_;
+    std::unordered_map<std::string, std::list<ConvEntry>::iterator> conv_index_;
+
+    // Symbol Object → SymEngine, via the attached handle, the conversion
+    // cache, or a walk over the Symbol's expression tree. Throws if obj is not
+    // a Symbol.
+    SymEngine::RCP<const SymEngine::Basic> to_basic(const Object& obj, const std::string& cmd);
+    // SymEngine → Symbol Object with the handle attached and cached.
+    Object to_object(const SymEngine::RCP<const SymEngine::Basic>& expr);
+    void remember(const std::string& text, const SymEngine::RCP<const SymEngine::Basic>& expr);
+
+    // Interned SymEngine symbols by RPL name
+    std::unordered_map<std::string, SymEngine::RCP<const SymEngine::Symbol>> symbols_;
+    SymEngine::RCP<const SymEngine::Symbol> symbol_for(const std::string& name);
+
+    // Conversions of the current batch by tree node; null outside a batch
+    std::unordered_map<const ExprNode*, SymEngine::RCP<const SymEngine::Basic>>* batch_memo_ = nullptr;
+
+    // Convert an expression tree node to SymEngine
+    SymEngine::RCP<const SymEngine::Basic> tree_to_symengine(const ExprNode& node);
+    SymEngine::RCP<const SymEngine::Basic> convert_node(const ExprNode& node);
+
+    // Convert between RPL expression strings and SymEngine expressions. The
+    // text path is only used for text outside the expression grammar.
     SymEngine::RCP<const SymEngine::Basic> to_symengine(const std::string& expr);
     std::string from_symengine(const SymEngine::RCP<const SymEngine::Basic>& expr);
 
@@ -31,9 +69,6 @@ private:
     SymEngine::RCP<const SymEngine::Basic> integrate_term(
         const SymEngine::RCP<const SymEngine::Basic>& term,
         const SymEngine::RCP<const SymEngine::Symbol>& var);
-
-    // Extract the string value from a Symbol Object, or throw
-    std::string extract_symbol_string(const Object& obj, const std::string& cmd);
 };
 
 } // namespace lpr
@@ -0,0 +1,57 @@
+#include "core/arena.hpp"
+
+namespace lpr {
+
+namespace {
+
+size_t round_up(size_t bytes) {
+    return (bytes + ExecArena::kAlign - 1) & ~(ExecArena::kAlign - 1);
+}
+
+} // namespace
+
+ExecArena::~ExecArena() = default;
+
+void* ExecArena::allocate(size_t bytes) {
+    ++allocations_;
+    size_t size = round_up(bytes ? bytes : 1);
+    if (size > kMaxPooled) return ::operator new(size);
+
+    FreeNode*& head = free_[size / kAlign];
+    if (head) {
+        FreeNode* node = head;
+        head = node->next;
+        return node;
+    }
+    if (static_cast<size_t>(limit_ - cursor_) < size) {
+        // The tail of the current block is abandoned until reset
+        blocks_.emplace_back(new char[kBlockSize]);
+        cursor_ = blocks_.back().get();
+        limit_ = cursor_ + kBlockSize;
+    }
+    void* p = cursor_;
+    cursor_ += size;
+    return p;
+}
+
+void ExecArena::deallocate(void* p, size_t bytes) noexcept {
+    if (!p) return;
+    size_t size = round_up(bytes ? bytes : 1);
+    if (size > kMaxPooled) {
+        ::operator delete(p);
+        return;
+    }
+    FreeNode*& head = free_[size / kAlign];
+    head = new (p) FreeNode{head};
+}
+
+void ExecArena::reset() noexcept {
+    ++resets_;
+    for (auto& head : free_) head = nullptr;
+    if (blocks_.empty()) return;
+    blocks_.resize(1);
+    cursor_ = blocks_.front().get();
+    limit_ = cursor_ + kBlockSize;
+}
+
+} // namespace lpr
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace lpr {
+
+// Scratch memory for temporaries that die within one Context::exec, such as
+// native-function argument lists and the expression evaluator's stacks.
+// Allocation bumps a pointer through fixed-size blocks. Freed memory goes
+// onto a free list per 16-byte size class, so a long loop keeps reusing the
+// same few blocks instead of growing. reset() at the end of the outermost
+// exec drops everything at once: it keeps the first block and releases the
+// rest, so it is O(1) unless that exec overflowed into more blocks.
+//
+// Not thread-safe. Each Context, including every PARALLEL worker's, owns
+// its own arena.
+class ExecArena {
+public:
+    ExecArena() = default;
+    ~ExecArena();
+
+    ExecArena(const ExecArena&) = delete;
+    ExecArena& operator=(const ExecArena&) = delete;
+
+    // bytes rounded up to a multiple of kAlign, aligned to kAlign
+    void* allocate(size_t bytes);
+    void  deallocate(void* p, size_t bytes) noexcept;
+
+    // Everything allocated so far becomes invalid
+    void reset() noexcept;
+
+    // Counters for PERFSTATS
+    uint64_t allocations() const { return allocations_; }
+    uint64_t resets() const { return resets_; }
+    size_t   blocks() const { return blocks_.size(); }
+
+    static constexpr size_t kAlign = 16;
+    static constexpr size_t kBlockSize = 64 * 1024;
+    // Larger requests go straight to operator new
+    static constexpr size_t kMaxPooled = 4096;
+
+private:
+    struct FreeNode { FreeNode* next; };
+
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    char* cursor_ = nullptr;
+    char* limit_ = nullptr;
+    FreeNode* free_[kMaxPooled / kAlign + 1] = {};
+    uint64_t allocations_ = 0;
+    uint64_t resets_ = 0;
+};
+
+// Standard allocator over an ExecArena. A default-constructed one has no
+// arena and uses the global heap, so arena-typed containers still work
+// outside an exec. Copies of a container get the global heap too, so a copy
+// that is kept past the exec stays valid.
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    ArenaAllocator() noexcept = default;
+    explicit ArenaAllocator(ExecArena* arena) noexcept : arena_(arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(other.arena()) {}
+
+    T* allocate(size_t n) {
+        static_assert(alignof(T) <= ExecArena::kAlign, "over-aligned type in ExecArena");
+        if (!arena_) return static_cast<T*>(::operator new(n * sizeof(T)));
+        return static_cast<T*>(arena_->allocate(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t n) noexcept {
+        if (!arena_) ::operator delete(p);
+        else arena_->deallocate(p, n * sizeof(T));
+    }
+
+    ArenaAllocator select_on_container_copy_construction() const { return ArenaAllocator(); }
+
+    ExecArena* arena() const noexcept { return arena_; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept { return arena_ == other.arena(); }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const noexcept { return arena_ != other.arena(); }
+
+private:
+    ExecArena* arena_ = nullptr;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+} // namespace lpr
@@ -0,0 +1,80 @@
+#include "core/atom.hpp"
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace lpr {
+
+namespace {
+
+// Keys view the interned strings themselves, so they stay valid as long as
+// the table does
+using AtomTable = std::unordered_map<std::string_view, const std::string*>;
+
+std::shared_mutex& table_mutex() {
+    static std::shared_mutex m;
+    return m;
+}
+
+// Deliberately leaked: Atoms inside static objects may outlive any
+// destruction order we could pick
+AtomTable& shared_table() {
+    static AtomTable* table = new AtomTable;
+    return *table;
+}
+
+// Hits only, so it is bounded by the table
+thread_local AtomTable cache;
+
+} // anonymous namespace
+
+Atom::Atom(std::string_view s) : str_(&empty_string()) {
+    if (s.empty()) return;
+    if (const std::string* interned = find(s)) {
+        str_ = interned;
+    } else {
+        str_ = new std::string(s);
+        owned_ = true;
+    }
+}
+
+const std::string& Atom::empty_string() {
+    static const std::string* s = new std::string;
+    return *s;
+}
+
+const std::string* Atom::find(std::string_view s) {
+    auto it = cache.find(s);
+    if (it != cache.end()) return it->second;
+
+    const std::string* interned;
+    {
+        std::shared_lock<std::shared_mutex> lock(table_mutex());
+        const AtomTable& table = shared_table();
+        auto found = table.find(s);
+        if (found == table.end()) return nullptr;
+        interned = found->second;
+    }
+    cache.emplace(*interned, interned);
+    return interned;
+}
+
+Atom Atom::intern(std::string_view s) {
+    if (s.empty()) return Atom();
+    if (find(s) == nullptr) {
+        std::unique_lock<std::shared_mutex> lock(table_mutex());
+        AtomTable& table = shared_table();
+        if (table.find(s) == table.end()) {
+            auto* owned = new std::string(s);
+            table.emplace(*owned, owned);
+        }
+    }
+    return Atom(s);
+}
+
+size_t Atom::table_size() {
+    std::shared_lock<std::shared_mutex> lock(table_mutex());
+    return shared_table().size();
+}
+
+} // namespace lpr
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace lpr {
+
+// A command word. Registered command names and control keywords are interned:
+// every Atom with such a spelling points at one shared, immutable copy in a
+// process-wide table, so copying it is a pointer copy and comparing two of
+// them is a pointer compare. A program that says DUP a thousand times holds
+// one "DUP". Any other word (variable names, typos) owns its own copy and
+// frees it with the Atom, so arbitrary input never grows the table.
+//
+// Interned strings are never freed; the table holds the command set only.
+// Safe to use from any thread: lookups hit a per-thread cache before the
+// shared table.
+class Atom {
+public:
+    Atom() : str_(&empty_string()) {}
+    explicit Atom(std::string_view s);
+    Atom(const Atom& o) : str_(o.owned_ ? new std::string(*o.str_) : o.str_), owned_(o.owned_) {}
+    Atom(Atom&& o) noexcept : str_(o.str_), owned_(o.owned_) {
+        o.str_ = &empty_string();
+        o.owned_ = false;
+    }
+    Atom& operator=(Atom o) noexcept {
+        std::swap(str_, o.str_);
+        std::swap(owned_, o.owned_);
+        return *this;
+    }
+    ~Atom() { if (owned_) delete str_; }
+
+    // Adds s to the table; called for every registered command and keyword
+    static Atom intern(std::string_view s);
+
+    const std::string& str() const { return *str_; }
+    operator const std::string&() const { return *str_; }
+    std::string_view view() const { return *str_; }
+
+    size_t size() const { return str_->size(); }
+    bool empty() const { return str_->empty(); }
+    const char* c_str() const { return str_->c_str(); }
+
+    friend bool operator==(const Atom& a, const Atom& b) {
+        return a.str_ == b.str_ || ((a.owned_ || b.owned_) && *a.str_ == *b.str_);
+    }
+    friend bool operator!=(const Atom& a, const Atom& b) { return !(a == b); }
+    friend bool operator==(const Atom& a, std::string_view b) { return a.view() == b; }
+    friend bool operator!=(const Atom& a, std::string_view b) { return a.view() != b; }
+    friend bool operator==(std::string_view a, const Atom& b) { return a == b.view(); }
+    friend bool operator!=(std::string_view a, const Atom& b) { return a != b.view(); }
+
+    // Number of distinct strings interned so far (PERFSTATS)
+    static size_t table_size();
+
+private:
+    static const std::string& empty_string();
+    // The interned copy of s, or nullptr
+    static const std::string* find(std::string_view s);
+
+    const std::string* str_;
+    bool owned_ = false;
+};
+
+} // namespace lpr
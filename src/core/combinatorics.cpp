@@ -0,0 +1,190 @@
+#include "core/combinatorics.hpp"
+#include <boost/math/special_functions/gamma.hpp>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace lpr {
+
+namespace {
+
+// Odd primes up to n; 2 is applied separately as a shift
+std::vector<uint32_t> odd_primes_upto(uint64_t n) {
+    std::vector<uint32_t> primes;
+    if (n < 3) return primes;
+    // composite[i] is for the odd number 2i+1
+    size_t half = static_cast<size_t>((n - 1) / 2);
+    std::vector<bool> composite(half + 1, false);
+    for (uint64_t i = 1;; ++i) {
+        uint64_t p = 2 * i + 1;
+        if (p * p > n) break;
+        if (composite[i]) continue;
+        for (uint64_t j = (p * p - 1) / 2; j <= half; j += p) composite[j] = true;
+    }
+    for (size_t i = 1; i <= half; ++i) {
+        if (!composite[i]) primes.push_back(static_cast<uint32_t>(2 * i + 1));
+    }
+    return primes;
+}
+
+// Exponent of p in n! (Legendre)
+uint64_t legendre(uint64_t n, uint64_t p) {
+    uint64_t e = 0;
+    while (n) {
+        n /= p;
+        e += n;
+    }
+    return e;
+}
+
+// Multiplies factors into machine words, then the words pairwise in a
+// balanced tree.
+class WordProduct {
+public:
+    void add(uint64_t f) {
+        if (acc_ > std::numeric_limits<uint64_t>::max() / f) {
+            words_.push_back(acc_);
+            acc_ = f;
+        } else {
+            acc_ *= f;
+        }
+    }
+
+    Integer result() {
+        if (acc_ != 1) words_.push_back(acc_);
+        acc_ = 1;
+        if (words_.empty()) return 1;
+        return tree(0, words_.size());
+    }
+
+private:
+    Integer tree(size_t lo, size_t hi) const {
+        if (hi - lo <= 4) {
+            Integer r = words_[lo];
+            for (size_t i = lo + 1; i < hi; ++i) r *= words_[i];
+            return r;
+        }
+        size_t mid = lo + (hi - lo) / 2;
+        return tree(lo, mid) * tree(mid, hi);
+    }
+
+    uint64_t acc_ = 1;
+    std::vector<uint64_t> words_;
+};
+
+// Product of primes[i]^exps[i] times 2^twos. Squares once per exponent bit
+// from the top, multiplying in the primes whose exponent has that bit set,
+// so each prime enters about log2(e) times instead of e times.
+Integer from_factorization(const std::vector<uint32_t>& primes,
+                           const std::vector<uint64_t>& exps, uint64_t twos) {
+    uint64_t bits = 0;
+    for (uint64_t e : exps) bits |= e;
+    Integer result = 1;
+    for (int bit = 63; bit >= 0; --bit) {
+        if ((bits >> bit) == 0) continue;
+        if (result != 1) result *= result;
+        WordProduct wp;
+        for (size_t i = 0; i < primes.size(); ++i) {
+            if ((exps[i] >> bit) & 1) wp.add(primes[i]);
+        }
+        result *= wp.result();
+    }
+    return result << static_cast<unsigned>(twos);
+}
+
+uint64_t checked_u64(const Integer& v) {
+    if (v < 0 || v > kMaxCombinatoricN) throw std::runtime_error("Bad argument value");
+    return v.convert_to<uint64_t>();
+}
+
+Integer range_product_big(const Integer& lo, uint64_t count) {
+    if (count <= 8) {
+        Integer r = 1;
+        for (uint64_t i = 0; i < count; ++i) r *= lo + i;
+        return r;
+    }
+    uint64_t half = count / 2;
+    return range_product_big(lo, half) * range_product_big(lo + half, count - half);
+}
+
+} // namespace
+
+Integer factorial(uint64_t n) {
+    if (n > kMaxCombinatoricN) throw std::runtime_error("Bad argument value");
+    if (n <= 20) {
+        uint64_t r = 1;
+        for (uint64_t i = 2; i <= n; ++i) r *= i;
+        return r;
+    }
+    std::vector<uint32_t> primes = odd_primes_upto(n);
+    std::vector<uint64_t> exps(primes.size());
+    for (size_t i = 0; i < primes.size(); ++i) exps[i] = legendre(n, primes[i]);
+    return from_factorization(primes, exps, legendre(n, 2));
+}
+
+Integer binomial(const Integer& n, const Integer& k) {
+    if (k < 0 || k > n) return 0;
+    Integer kk = std::min(k, Integer(n - k));
+    if (kk == 0) return 1;
+    if (kk <= 32 || n > kMaxCombinatoricN) {
+        // A short falling product: exact division by the small k!
+        uint64_t count = checked_u64(kk);
+        return range_product(n - kk + 1, count) / factorial(count);
+    }
+    uint64_t nn = n.convert_to<uint64_t>();
+    uint64_t k1 = kk.convert_to<uint64_t>(), k2 = nn - k1;
+    std::vector<uint32_t> primes = odd_primes_upto(nn);
+    std::vector<uint64_t> exps(primes.size());
+    for (size_t i = 0; i < primes.size(); ++i)
+        exps[i] = legendre(nn, primes[i]) - legendre(k1, primes[i]) - legendre(k2, primes[i]);
+    return from_factorization(primes, exps, legendre(nn, 2) - legendre(k1, 2) - legendre(k2, 2));
+}
+
+Integer falling_factorial(const Integer& n, const Integer& k) {
+    if (k < 0 || k > n) return 0;
+    return range_product(n - k + 1, checked_u64(k));
+}
+
+Integer multinomial(const std::vector<uint64_t>& ks) {
+    uint64_t total = 0;
+    for (uint64_t k : ks) {
+        if (k > kMaxCombinatoricN - total) throw std::runtime_error("Bad argument value");
+        total += k;
+    }
+    std::vector<uint32_t> primes = odd_primes_upto(total);
+    std::vector<uint64_t> exps(primes.size());
+    for (size_t i = 0; i < primes.size(); ++i) {
+        exps[i] = legendre(total, primes[i]);
+        for (uint64_t k : ks) exps[i] -= legendre(k, primes[i]);
+    }
+    uint64_t twos = legendre(total, 2);
+    for (uint64_t k : ks) twos -= legendre(k, 2);
+    return from_factorization(primes, exps, twos);
+}
+
+Integer range_product(const Integer& lo, uint64_t count) {
+    if (count == 0) return 1;
+    if (lo <= 0) {
+        // Crosses zero: the product is 0; otherwise an all-negative range
+        if (lo + (count - 1) >= 0) return 0;
+        Integer r = range_product(-(lo + (count - 1)), count);
+        return count % 2 ? Integer(-r) : r;
+    }
+    Integer hi = lo + (count - 1);
+    if (hi > std::numeric_limits<uint64_t>::max()) return range_product_big(lo, count);
+    uint64_t first = lo.convert_to<uint64_t>();
+    WordProduct wp;
+    for (uint64_t i = 0; i < count; ++i) wp.add(first + i);
+    return wp.result();
+}
+
+Real gamma_real(const Real& x) {
+    if (x <= 0 && x == boost::multiprecision::floor(x)) throw std::runtime_error("Bad argument value");
+    try {
+        return boost::math::tgamma(x);
+    } catch (const std::exception&) {
+        throw std::runtime_error("Bad argument value");
+    }
+}
+
+} // namespace lpr
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "core/object.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace lpr {
+
+// Exact combinatorial functions. Results are assembled from their prime
+// factorization, or by binary splitting for short ranges, so every big
+// multiplication has balanced operands and no big division is needed.
+
+// Largest n accepted where a prime sieve up to n is involved
+constexpr uint64_t kMaxCombinatoricN = uint64_t(1) << 32;
+
+// n!. Throws "Bad argument value" above kMaxCombinatoricN.
+Integer factorial(uint64_t n);
+
+// n!/(k!(n-k)!), 0 when k > n. Any n: short products when k is small or n
+// is beyond the sieve, prime factorization otherwise.
+Integer binomial(const Integer& n, const Integer& k);
+
+// n!/(n-k)!, 0 when k > n
+Integer falling_factorial(const Integer& n, const Integer& k);
+
+// (k1+k2+...)!/(k1! k2! ...)
+Integer multinomial(const std::vector<uint64_t>& ks);
+
+// Product lo * (lo+1) * ... * (lo+count-1), 1 when count is 0
+Integer range_product(const Integer& lo, uint64_t count);
+
+// Gamma function at Real precision. Throws "Bad argument value" at the
+// poles 0, -1, -2, ...
+Real gamma_real(const Real& x);
+
+} // namespace lpr
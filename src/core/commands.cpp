@@ -1,9 +1,26 @@
 #include "core/commands.hpp"
+#include "core/combinatorics.hpp"
 #include "core/context.hpp"
 #include "core/parser.hpp"
 #include "core/expression.hpp"
+#include "core/expr_tree.hpp"
+#include "core/lambdify.hpp"
+#include "core/numeric.hpp"
+#include "core/number_theory.hpp"
+#include "core/optimizer.hpp"
+#include "core/parallel.hpp"
+#include "core/plot.hpp"
+#include "core/poly.hpp"
+#include "core/transcendental.hpp"
+#include <cctype>
 #include <cmath>
 #include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <unordered_set>
 
 namespace lpr {
 
@@ -13,10 +30,10 @@ namespace {
 
 // Returns the "rank" in the numeric tower
 int numeric_rank(const Object& obj) {
-    if (std::holds_alternative<Integer>(obj))  return 0;
-    if (std::holds_alternative<Rational>(obj)) return 1;
-    if (std::holds_alternative<Real>(obj))     return 2;
-    if (std::holds_alternative<Complex>(obj))  return 3;
+    if (holds_alternative<Integer>(obj))  return 0;
+    if (holds_alternative<Rational>(obj)) return 1;
+    if (holds_alternative<Real>(obj))     return 2;
+    if (holds_alternative<Complex>(obj))  return 3;
     return -1;
 }
 
@@ -36,18 +53,18 @@ Object promote(const Object& obj, int target_rank) {
     while (cur_rank < target_rank) {
         if (cur_rank == 0) {
             // Integer -> Rational
-            auto& v = std::get<Integer>(cur);
+            auto& v = get<Integer>(cur);
             cur = Rational(v, Integer(1));
             cur_rank = 1;
         } else if (cur_rank == 1) {
             // Rational -> Real
-            auto& v = std::get<Rational>(cur);
+            auto& v = get<Rational>(cur);
             Real result(v);
             cur = result;
             cur_rank = 2;
         } else if (cur_rank == 2) {
             // Real -> Complex
-            auto& v = std::get<Real>(cur);
+            auto& v = get<Real>(cur);
             cur = Complex{v, Real(0)};
             cur_rank = 3;
         }
@@ -55,81 +72,30 @@ Object promote(const Object& obj, int target_rank) {
     return cur;
 }
 
-// Helper to do binary numeric ops
-using IntOp  = std::function<Integer(const Integer&, const Integer&)>;
-using RatOp  = std::function<Rational(const Rational&, const Rational&)>;
-using RealOp = std::function<Real(const Real&, const Real&)>;
-using CmplOp = std::function<Complex(const Complex&, const Complex&)>;
-
-Object binary_numeric(const Object& a, const Object& b,
-                      IntOp iop, RatOp rop, RealOp reop, CmplOp cop,
-                      bool int_div_to_rational = false) {
-    int ra = numeric_rank(a);
-    int rb = numeric_rank(b);
-    if (ra < 0 || rb < 0) return Error{10, "Bad argument type"};
-
-    int target = std::max(ra, rb);
-    if (int_div_to_rational && target == 0) target = 1;
-
-    Object pa = promote(a, target);
-    Object pb = promote(b, target);
-
-    switch (target) {
-        case 0: return iop(std::get<Integer>(pa), std::get<Integer>(pb));
-        case 1: return rop(std::get<Rational>(pa), std::get<Rational>(pb));
-        case 2: return reop(std::get<Real>(pa), std::get<Real>(pb));
-        case 3: return cop(std::get<Complex>(pa), std::get<Complex>(pb));
-    }
-    return Error{10, "Bad argument type"};
-}
-
-bool is_right_assoc(const std::string& op) {
-    return op == "^" || op == "NEG";
-}
+// The value arithmetic on a non-numeric pair leaves on the stack
+Object bad_argument_type() { return Error{10, "Bad argument type"}; }
 
 // Check if an object is symbolic (Name or Symbol)
 bool is_symbolic(const Object& obj) {
-    return std::holds_alternative<Name>(obj) || std::holds_alternative<Symbol>(obj);
+    return holds_alternative<Name>(obj) || holds_alternative<Symbol>(obj);
 }
 
-// Convert an object to its expression string form for building symbolic expressions
-std::string to_expr_string(const Object& obj) {
-    if (std::holds_alternative<Name>(obj))   return std::get<Name>(obj).value;
-    if (std::holds_alternative<Symbol>(obj)) return std::get<Symbol>(obj).value;
-    return repr(obj);
-}
+// Hash set over existing objects (no copies) using structural equality.
+using ObjectRefSet = std::unordered_set<std::reference_wrapper<const Object>,
+                                        ObjectHash, ObjectEqual>;
 
-// Build a symbolic function call: Symbol{"FUNC(a, b, ...)"} for any arity
-Object symbolic_func(const std::string& func, const std::vector<Object>& args) {
-    std::string result = func + "(";
-    for (size_t i = 0; i < args.size(); ++i) {
-        if (i > 0) result += ", ";
-        result += to_expr_string(args[i]);
-    }
-    result += ")";
-    return Symbol{result};
-}
-
-// Build a symbolic expression from a binary operation
-Object symbolic_binary(const Object& a, const Object& b, const std::string& op) {
-    std::string sa = to_expr_string(a);
-    std::string sb = to_expr_string(b);
-
-    // Add parens based on operator precedence
-    int prec = (op == "+" || op == "-") ? 1 : 2;  // * and / are 2
-    if (needs_parens(sa, prec)) sa = "(" + sa + ")";
-    if (needs_parens(sb, prec)) sb = "(" + sb + ")";
-
-    return Symbol{sa + op + sb};
+// A popped Program's tokens, for Context::run_program
+SharedTokens program_tokens(Object prog) {
+    return std::make_shared<const std::vector<Token>>(std::move(get<Program>(prog).tokens));
 }
 
 // Check if an object is "truthy" (non-zero numeric)
 bool is_truthy(const Object& obj) {
-    if (std::holds_alternative<Integer>(obj))  return std::get<Integer>(obj) != 0;
-    if (std::holds_alternative<Real>(obj))     return std::get<Real>(obj) != 0;
-    if (std::holds_alternative<Rational>(obj)) return std::get<Rational>(obj) != 0;
-    if (std::holds_alternative<Complex>(obj)) {
-        auto& c = std::get<Complex>(obj);
+    if (holds_alternative<Integer>(obj))  return get<Integer>(obj) != 0;
+    if (holds_alternative<Real>(obj))     return get<Real>(obj) != 0;
+    if (holds_alternative<Rational>(obj)) return get<Rational>(obj) != 0;
+    if (holds_alternative<Complex>(obj)) {
+        auto& c = get<Complex>(obj);
         return c.first != 0 || c.second != 0;
     }
     return false;
@@ -137,19 +103,140 @@ bool is_truthy(const Object& obj) {
 
 // Extract a Real from a numeric Object (Integer, Rational, or Real)
 Real to_real_value(const Object& obj) {
-    if (std::holds_alternative<Integer>(obj)) return Real(std::get<Integer>(obj));
-    if (std::holds_alternative<Rational>(obj)) return Real(std::get<Rational>(obj));
-    if (std::holds_alternative<Real>(obj)) return std::get<Real>(obj);
+    if (holds_alternative<Integer>(obj)) return Real(get<Integer>(obj));
+    if (holds_alternative<Rational>(obj)) return Real(get<Rational>(obj));
+    if (holds_alternative<Real>(obj)) return get<Real>(obj);
     throw std::runtime_error("Bad argument type");
 }
 
 double to_double_value(const Object& obj) {
-    if (std::holds_alternative<Integer>(obj)) return std::get<Integer>(obj).convert_to<double>();
-    if (std::holds_alternative<Rational>(obj)) return std::get<Rational>(obj).convert_to<double>();
-    if (std::holds_alternative<Real>(obj)) return std::get<Real>(obj).convert_to<double>();
+    if (holds_alternative<Integer>(obj)) return get<Integer>(obj).convert_to<double>();
+    if (holds_alternative<Rational>(obj)) return get<Rational>(obj).convert_to<double>();
+    if (holds_alternative<Real>(obj)) return get<Real>(obj).convert_to<double>();
     throw std::runtime_error("Bad argument type");
 }
 
+// ---- SORT keys ----
+// Computed once per element, then compared O(n log n) times. Numbers sort
+// before strings, strings before everything else (by type, then repr).
+// Integer/Rational keys stay exact. When a list mixes them with Reals, the
+// Reals are converted to their exact value too, so every numeric comparison
+// is exact and the order is a strict weak ordering.
+// Keys are small PODs; big values live in side tables indexed by `slot`.
+
+struct SortKey {
+    enum Rank : uint8_t { Number = 0, Text = 1, Other = 2 };
+    Rank rank = Other;
+    bool exact = false;   // compared through `exact` (Integer/Rational, or a mixed list's Real)
+    bool small = false;   // exact integer that fits i64
+    int8_t inf = 0;       // -1/+1 for an infinite Real
+    int64_t i64 = 0;
+    uint32_t slot = 0;    // index into SortKeys side tables
+    uint32_t type = 0;    // variant index for Other
+    size_t index = 0;     // position in the input list
+};
+
+struct SortKeys {
+    std::vector<SortKey> keys;
+    std::vector<Rational> exact;      // big exact values
+    std::vector<Real> real;           // Real values of an all-Real list
+    std::vector<std::string> text;    // String values / reprs
+
+    const Real& real_of(const SortKey& k) const { return real[k.slot]; }
+    Rational exact_of(const SortKey& k) const {
+        return k.small ? Rational(k.i64) : exact[k.slot];
+    }
+};
+
+// The exact value of a finite Real, from all of its stored digits
+Rational exact_real(const Real& r) {
+    std::string t = r.str(0, std::ios_base::scientific);
+    size_t e = t.find('e');
+    std::string digits;
+    for (size_t i = 0; i < e; ++i) {
+        if (std::isdigit(static_cast<unsigned char>(t[i]))) digits += t[i];
+    }
+    long exp = std::stol(t.substr(e + 1)) - static_cast<long>(digits.size() - 1);
+    Integer m(digits);
+    if (t[0] == '-') m = -m;
+    Integer scale = boost::multiprecision::pow(Integer(10), static_cast<unsigned>(exp < 0 ? -exp : exp));
+    return exp >= 0 ? Rational(m * scale) : Rational(m, scale);
+}
+
+SortKeys make_sort_keys(const std::vector<Object>& items) {
+    bool any_exact = false, any_real = false;
+    for (const auto& item : items) {
+        if (holds_alternative<Real>(item)) any_real = true;
+        else if (holds_alternative<Integer>(item) ||
+                 holds_alternative<Rational>(item)) any_exact = true;
+    }
+    // Mixed exact/inexact lists compare everything exactly
+    bool mixed = any_exact && any_real;
+
+    SortKeys sk;
+    sk.keys.reserve(items.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+        const Object& obj = items[i];
+        SortKey k;
+        k.index = i;
+        if (holds_alternative<Integer>(obj) || holds_alternative<Rational>(obj)) {
+            k.rank = SortKey::Number;
+            k.exact = true;
+            const Integer* iv = get_if<Integer>(&obj);
+            if (iv && *iv >= std::numeric_limits<int64_t>::min() &&
+                *iv <= std::numeric_limits<int64_t>::max()) {
+                k.small = true;
+                k.i64 = iv->convert_to<int64_t>();
+            } else {
+                k.slot = static_cast<uint32_t>(sk.exact.size());
+                sk.exact.push_back(iv ? Rational(*iv) : get<Rational>(obj));
+            }
+        } else if (holds_alternative<Real>(obj)) {
+            k.rank = SortKey::Number;
+            const Real& r = get<Real>(obj);
+            if (boost::multiprecision::isinf(r)) {
+                k.inf = r > 0 ? 1 : -1;
+            } else if (mixed) {
+                k.exact = true;
+                k.slot = static_cast<uint32_t>(sk.exact.size());
+                sk.exact.push_back(exact_real(r));
+            } else {
+                k.slot = static_cast<uint32_t>(sk.real.size());
+                sk.real.push_back(r);
+            }
+        } else if (holds_alternative<String>(obj)) {
+            k.rank = SortKey::Text;
+            k.slot = static_cast<uint32_t>(sk.text.size());
+            sk.text.push_back(get<String>(obj).value);
+        } else {
+            k.type = static_cast<uint32_t>(obj.index());
+            k.slot = static_cast<uint32_t>(sk.text.size());
+            sk.text.push_back(repr(obj));
+        }
+        sk.keys.push_back(k);
+    }
+    return sk;
+}
+
+bool sort_key_less(const SortKeys& sk, const SortKey& a, const SortKey& b) {
+    if (a.rank != b.rank) return a.rank < b.rank;
+    switch (a.rank) {
+        case SortKey::Number:
+            if (a.inf || b.inf) return a.inf < b.inf;
+            if (a.exact && b.exact) {
+                if (a.small && b.small) return a.i64 < b.i64;
+                return sk.exact_of(a) < sk.exact_of(b);
+            }
+            return sk.real_of(a) < sk.real_of(b);
+        case SortKey::Text:
+            return sk.text[a.slot] < sk.text[b.slot];
+        case SortKey::Other:
+            if (a.type != b.type) return a.type < b.type;
+            return sk.text[a.slot] < sk.text[b.slot];
+    }
+    return false;
+}
+
 } // anonymous namespace
 
 // ---- Command Registry ----
@@ -163,17 +250,25 @@ CommandRegistry::CommandRegistry() {
     register_program_commands();
     register_logic_commands();
     register_transcendental_commands();
+    register_number_theory_commands();
     register_string_commands();
     register_symbolic_commands();
+    register_polynomial_commands();
     register_list_commands();
     register_matrix_commands();
     register_display_commands();
     register_flag_commands();
     register_conversion_commands();
     register_cas_commands();
+    // Parsed as command words too, but handled by the interpreter
+    for (const char* word : {"IF", "THEN", "ELSE", "END", "CASE", "FOR", "NEXT", "STEP",
+                             "START", "WHILE", "REPEAT", "DO", "UNTIL", "->", "\xe2\x86\x92"}) {
+        Atom::intern(word);
+    }
 }
 
 void CommandRegistry::register_command(const std::string& name, CommandFn fn) {
+    Atom::intern(name);
     commands_[name] = std::move(fn);
 }
 
@@ -184,6 +279,21 @@ bool CommandRegistry::has(const std::string& name) const {
     return commands_.count(upper) > 0;
 }
 
+void CommandRegistry::register_function(const std::string& name, int arity, NativeFn fn) {
+    register_command(name, [arity, fn](Store& s, Context& ctx) {
+        if (s.depth() < arity) throw std::runtime_error("Too few arguments");
+        Args args(arity, ArenaAllocator<Object>(&ctx.arena()));
+        for (int i = arity - 1; i >= 0; --i) args[i] = s.pop();
+        s.push(fn(args, ctx));
+    });
+    functions_[name] = NativeFunction{arity, std::move(fn)};
+}
+
+const NativeFunction* CommandRegistry::find_function(const std::string& upper_name) const {
+    auto it = functions_.find(upper_name);
+    return it == functions_.end() ? nullptr : &it->second;
+}
+
 void CommandRegistry::execute(const std::string& name, Store& store, Context& ctx) const {
     std::string upper = name;
     std::transform(upper.begin(), upper.end(), upper.begin(),
@@ -270,9 +380,9 @@ void CommandRegistry::register_stack_commands() {
     register_command("DUPN", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object n_obj = s.pop();
-        if (!std::holds_alternative<Integer>(n_obj))
+        if (!holds_alternative<Integer>(n_obj))
             throw std::runtime_error("Bad argument type");
-        int n = static_cast<int>(std::get<Integer>(n_obj));
+        int n = static_cast<int>(get<Integer>(n_obj));
         if (n < 0 || s.depth() < n) throw std::runtime_error("Too few arguments");
         // Collect items from top n levels (deepest first)
         std::vector<Object> items;
@@ -298,9 +408,9 @@ void CommandRegistry::register_stack_commands() {
     register_command("DROPN", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object n_obj = s.pop();
-        if (!std::holds_alternative<Integer>(n_obj))
+        if (!holds_alternative<Integer>(n_obj))
             throw std::runtime_error("Bad argument type");
-        int n = static_cast<int>(std::get<Integer>(n_obj));
+        int n = static_cast<int>(get<Integer>(n_obj));
         if (n < 0 || s.depth() < n) throw std::runtime_error("Too few arguments");
         for (int i = 0; i < n; i++) {
             s.pop();
@@ -312,9 +422,9 @@ void CommandRegistry::register_stack_commands() {
     register_command("PICK", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object n_obj = s.pop();
-        if (!std::holds_alternative<Integer>(n_obj))
+        if (!holds_alternative<Integer>(n_obj))
             throw std::runtime_error("Bad argument type");
-        int n = static_cast<int>(std::get<Integer>(n_obj));
+        int n = static_cast<int>(get<Integer>(n_obj));
         if (n < 1 || s.depth() < n) throw std::runtime_error("Too few arguments");
         Object picked = s.peek(n);
         s.push(picked);
@@ -325,9 +435,9 @@ void CommandRegistry::register_stack_commands() {
     register_command("ROLL", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object n_obj = s.pop();
-        if (!std::holds_alternative<Integer>(n_obj))
+        if (!holds_alternative<Integer>(n_obj))
             throw std::runtime_error("Bad argument type");
-        int n = static_cast<int>(std::get<Integer>(n_obj));
+        int n = static_cast<int>(get<Integer>(n_obj));
         if (n < 1 || s.depth() < n) throw std::runtime_error("Too few arguments");
         if (n == 1) return; // no-op
         // Pop top n-1 items
@@ -350,9 +460,9 @@ void CommandRegistry::register_stack_commands() {
     register_command("ROLLD", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object n_obj = s.pop();
-        if (!std::holds_alternative<Integer>(n_obj))
+        if (!holds_alternative<Integer>(n_obj))
             throw std::runtime_error("Bad argument type");
-        int n = static_cast<int>(std::get<Integer>(n_obj));
+        int n = static_cast<int>(get<Integer>(n_obj));
         if (n < 1 || s.depth() < n) throw std::runtime_error("Too few arguments");
         if (n == 1) return; // no-op
         // Pop top item
@@ -375,9 +485,9 @@ void CommandRegistry::register_stack_commands() {
     register_command("UNPICK", [](Store& s, Context&) {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object n_obj = s.pop();
-        if (!std::holds_alternative<Integer>(n_obj))
+        if (!holds_alternative<Integer>(n_obj))
             throw std::runtime_error("Bad argument type");
-        int n = static_cast<int>(std::get<Integer>(n_obj));
+        int n = static_cast<int>(get<Integer>(n_obj));
         Object obj = s.pop();
         if (n < 1 || s.depth() < n) throw std::runtime_error("Too few arguments");
         // Pop top n-1 items
@@ -473,30 +583,30 @@ void CommandRegistry::register_arithmetic_commands() {
         Object b = s.pop();
         Object a = s.pop();
         // List + List (element-wise)
-        if (std::holds_alternative<List>(a) && std::holds_alternative<List>(b)) {
-            list_elementwise(s, ctx, std::get<List>(a), std::get<List>(b), "+", *this);
+        if (holds_alternative<List>(a) && holds_alternative<List>(b)) {
+            list_elementwise(s, ctx, get<List>(a), get<List>(b), "+", *this);
             return;
         }
         // Scalar + List / List + Scalar
-        if (std::holds_alternative<List>(a) && !std::holds_alternative<List>(b)) {
-            list_scalar_op(s, ctx, std::get<List>(a), b, "+", false, *this);
+        if (holds_alternative<List>(a) && !holds_alternative<List>(b)) {
+            list_scalar_op(s, ctx, get<List>(a), b, "+", false, *this);
             return;
         }
-        if (!std::holds_alternative<List>(a) && std::holds_alternative<List>(b)) {
-            list_scalar_op(s, ctx, std::get<List>(b), a, "+", true, *this);
+        if (!holds_alternative<List>(a) && holds_alternative<List>(b)) {
+            list_scalar_op(s, ctx, get<List>(b), a, "+", true, *this);
             return;
         }
         // Matrix + Matrix (element-wise)
-        if (std::holds_alternative<Matrix>(a) && std::holds_alternative<Matrix>(b)) {
-            matrix_elementwise(s, ctx, std::get<Matrix>(a), std::get<Matrix>(b), "+", *this);
+        if (holds_alternative<Matrix>(a) && holds_alternative<Matrix>(b)) {
+            matrix_elementwise(s, ctx, get<Matrix>(a), get<Matrix>(b), "+", *this);
             return;
         }
         // String concatenation
-        if (std::holds_alternative<String>(a) && std::holds_alternative<String>(b)) {
-            s.push(String{std::get<String>(a).value + std::get<String>(b).value});
+        if (holds_alternative<String>(a) && holds_alternative<String>(b)) {
+            s.push(String{get<String>(a).value + get<String>(b).value});
             return;
         }
-        if (std::holds_alternative<String>(a) || std::holds_alternative<String>(b)) {
+        if (holds_alternative<String>(a) || holds_alternative<String>(b)) {
             s.push(a); s.push(b);
             throw std::runtime_error("Bad argument type");
         }
@@ -504,14 +614,7 @@ void CommandRegistry::register_arithmetic_commands() {
             s.push(symbolic_binary(a, b, "+"));
             return;
         }
-        Object result = binary_numeric(a, b,
-            [](const Integer& x, const Integer& y) -> Integer { return x + y; },
-            [](const Rational& x, const Rational& y) -> Rational { return x + y; },
-            [](const Real& x, const Real& y) -> Real { return x + y; },
-            [](const Complex& x, const Complex& y) -> Complex {
-                return {x.first + y.first, x.second + y.second};
-            });
-        s.push(result);
+        s.push(numeric_dispatch(std::move(a), b, NumericAdd{}, bad_argument_type));
     });
 
     // -
@@ -520,36 +623,29 @@ void CommandRegistry::register_arithmetic_commands() {
         Object b = s.pop(); // level 1
         Object a = s.pop(); // level 2
         // List - List (element-wise)
-        if (std::holds_alternative<List>(a) && std::holds_alternative<List>(b)) {
-            list_elementwise(s, ctx, std::get<List>(a), std::get<List>(b), "-", *this);
+        if (holds_alternative<List>(a) && holds_alternative<List>(b)) {
+            list_elementwise(s, ctx, get<List>(a), get<List>(b), "-", *this);
             return;
         }
         // Scalar - List / List - Scalar
-        if (std::holds_alternative<List>(a) && !std::holds_alternative<List>(b)) {
-            list_scalar_op(s, ctx, std::get<List>(a), b, "-", false, *this);
+        if (holds_alternative<List>(a) && !holds_alternative<List>(b)) {
+            list_scalar_op(s, ctx, get<List>(a), b, "-", false, *this);
             return;
         }
-        if (!std::holds_alternative<List>(a) && std::holds_alternative<List>(b)) {
-            list_scalar_op(s, ctx, std::get<List>(b), a, "-", true, *this);
+        if (!holds_alternative<List>(a) && holds_alternative<List>(b)) {
+            list_scalar_op(s, ctx, get<List>(b), a, "-", true, *this);
             return;
         }
         // Matrix - Matrix (element-wise)
-        if (std::holds_alternative<Matrix>(a) && std::holds_alternative<Matrix>(b)) {
-            matrix_elementwise(s, ctx, std::get<Matrix>(a), std::get<Matrix>(b), "-", *this);
+        if (holds_alternative<Matrix>(a) && holds_alternative<Matrix>(b)) {
+            matrix_elementwise(s, ctx, get<Matrix>(a), get<Matrix>(b), "-", *this);
             return;
         }
         if (is_symbolic(a) || is_symbolic(b)) {
             s.push(symbolic_binary(a, b, "-"));
             return;
         }
-        Object result = binary_numeric(a, b,
-            [](const Integer& x, const Integer& y) -> Integer { return x - y; },
-            [](const Rational& x, const Rational& y) -> Rational { return x - y; },
-            [](const Real& x, const Real& y) -> Real { return x - y; },
-            [](const Complex& x, const Complex& y) -> Complex {
-                return {x.first - y.first, x.second - y.second};
-            });
-        s.push(result);
+        s.push(numeric_dispatch(std::move(a), b, NumericSub{}, bad_argument_type));
     });
 
     // *
@@ -558,23 +654,23 @@ void CommandRegistry::register_arithmetic_commands() {
         Object b = s.pop();
         Object a = s.pop();
         // List * List (element-wise)
-        if (std::holds_alternative<List>(a) && std::holds_alternative<List>(b)) {
-            list_elementwise(s, ctx, std::get<List>(a), std::get<List>(b), "*", *this);
+        if (holds_alternative<List>(a) && holds_alternative<List>(b)) {
+            list_elementwise(s, ctx, get<List>(a), get<List>(b), "*", *this);
             return;
         }
         // Scalar * List / List * Scalar
-        if (std::holds_alternative<List>(a) && !std::holds_alternative<List>(b)) {
-            list_scalar_op(s, ctx, std::get<List>(a), b, "*", false, *this);
+        if (holds_alternative<List>(a) && !holds_alternative<List>(b)) {
+            list_scalar_op(s, ctx, get<List>(a), b, "*", false, *this);
             return;
         }
-        if (!std::holds_alternative<List>(a) && std::holds_alternative<List>(b)) {
-            list_scalar_op(s, ctx, std::get<List>(b), a, "*", true, *this);
+        if (!holds_alternative<List>(a) && holds_alternative<List>(b)) {
+            list_scalar_op(s, ctx, get<List>(b), a, "*", true, *this);
             return;
         }
         // Matrix * Matrix (true matrix multiplication)
-        if (std::holds_alternative<Matrix>(a) && std::holds_alternative<Matrix>(b)) {
-            auto& ar = std::get<Matrix>(a).rows;
-            auto& br = std::get<Matrix>(b).rows;
+        if (holds_alternative<Matrix>(a) && holds_alternative<Matrix>(b)) {
+            auto& ar = get<Matrix>(a).rows;
+            auto& br = get<Matrix>(b).rows;
             // Check if b is a vector (1-row) and a is a matrix — treat as matrix*vector
             int a_rows = static_cast<int>(ar.size());
             int a_cols = ar.empty() ? 0 : static_cast<int>(ar[0].size());
@@ -623,27 +719,19 @@ void CommandRegistry::register_arithmetic_commands() {
             return;
         }
         // Scalar * Matrix / Matrix * Scalar
-        if (std::holds_alternative<Matrix>(a) && !std::holds_alternative<Matrix>(b)) {
-            matrix_scalar_op(s, ctx, std::get<Matrix>(a), b, "*", false, *this);
+        if (holds_alternative<Matrix>(a) && !holds_alternative<Matrix>(b)) {
+            matrix_scalar_op(s, ctx, get<Matrix>(a), b, "*", false, *this);
             return;
         }
-        if (!std::holds_alternative<Matrix>(a) && std::holds_alternative<Matrix>(b)) {
-            matrix_scalar_op(s, ctx, std::get<Matrix>(b), a, "*", true, *this);
+        if (!holds_alternative<Matrix>(a) && holds_alternative<Matrix>(b)) {
+            matrix_scalar_op(s, ctx, get<Matrix>(b), a, "*", true, *this);
             return;
         }
         if (is_symbolic(a) || is_symbolic(b)) {
             s.push(symbolic_binary(a, b, "*"));
             return;
         }
-        Object result = binary_numeric(a, b,
-            [](const Integer& x, const Integer& y) -> Integer { return x * y; },
-            [](const Rational& x, const Rational& y) -> Rational { return x * y; },
-            [](const Real& x, const Real& y) -> Real { return x * y; },
-            [](const Complex& x, const Complex& y) -> Complex {
-                return {x.first * y.first - x.second * y.second,
-                        x.first * y.second + x.second * y.first};
-            });
-        s.push(result);
+        s.push(numeric_dispatch(std::move(a), b, NumericMul{}, bad_argument_type));
     });
 
     // /
@@ -653,13 +741,13 @@ void CommandRegistry::register_arithmetic_commands() {
         Object a = s.pop(); // dividend (level 2)
 
         // List / List (element-wise)
-        if (std::holds_alternative<List>(a) && std::holds_alternative<List>(b)) {
-            list_elementwise(s, ctx, std::get<List>(a), std::get<List>(b), "/", *this);
+        if (holds_alternative<List>(a) && holds_alternative<List>(b)) {
+            list_elementwise(s, ctx, get<List>(a), get<List>(b), "/", *this);
             return;
         }
         // List / Scalar
-        if (std::holds_alternative<List>(a) && !std::holds_alternative<List>(b)) {
-            list_scalar_op(s, ctx, std::get<List>(a), b, "/", false, *this);
+        if (holds_alternative<List>(a) && !holds_alternative<List>(b)) {
+            list_scalar_op(s, ctx, get<List>(a), b, "/", false, *this);
             return;
         }
         if (is_symbolic(a) || is_symbolic(b)) {
@@ -668,26 +756,16 @@ void CommandRegistry::register_arithmetic_commands() {
         }
 
         // Check for division by zero
-        if ((std::holds_alternative<Integer>(b) && std::get<Integer>(b) == 0) ||
-            (std::holds_alternative<Real>(b) && std::get<Real>(b) == 0) ||
-            (std::holds_alternative<Rational>(b) && std::get<Rational>(b) == 0)) {
+        if ((holds_alternative<Integer>(b) && get<Integer>(b) == 0) ||
+            (holds_alternative<Real>(b) && get<Real>(b) == 0) ||
+            (holds_alternative<Rational>(b) && get<Rational>(b) == 0)) {
             s.push(a);
             s.push(b);
             throw std::runtime_error("Division by zero");
         }
 
-        Object result = binary_numeric(a, b,
-            // Integer / Integer -> Rational
-            [](const Integer& x, const Integer& y) -> Integer { return x / y; }, // won't be called
-            [](const Rational& x, const Rational& y) -> Rational { return x / y; },
-            [](const Real& x, const Real& y) -> Real { return x / y; },
-            [](const Complex& x, const Complex& y) -> Complex {
-                Real denom = y.first * y.first + y.second * y.second;
-                return {(x.first * y.first + x.second * y.second) / denom,
-                        (x.second * y.first - x.first * y.second) / denom};
-            },
-            true); // int_div_to_rational
-        s.push(result);
+        // Integer / Integer -> Rational
+        s.push(numeric_dispatch(std::move(a), b, NumericDiv{}, bad_argument_type));
     });
 
     // NEG
@@ -695,9 +773,9 @@ void CommandRegistry::register_arithmetic_commands() {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object a = s.pop();
         // NEG on list: negate each element
-        if (std::holds_alternative<List>(a)) {
+        if (holds_alternative<List>(a)) {
             List result;
-            for (auto& item : std::get<List>(a).items) {
+            for (auto& item : get<List>(a).items) {
                 s.push(item);
                 this->execute("NEG", s, ctx);
                 result.items.push_back(s.pop());
@@ -706,9 +784,9 @@ void CommandRegistry::register_arithmetic_commands() {
             return;
         }
         // NEG on matrix: negate each element
-        if (std::holds_alternative<Matrix>(a)) {
+        if (holds_alternative<Matrix>(a)) {
             Matrix result;
-            for (auto& row : std::get<Matrix>(a).rows) {
+            for (auto& row : get<Matrix>(a).rows) {
                 std::vector<Object> rrow;
                 for (auto& elem : row) {
                     s.push(elem);
@@ -721,11 +799,10 @@ void CommandRegistry::register_arithmetic_commands() {
             return;
         }
         if (is_symbolic(a)) {
-            std::string sa = to_expr_string(a);
-            s.push(Symbol{"-("+sa+")"});
+            s.push(Symbol{make_neg(make_group(object_expr_tree(a)))});
             return;
         }
-        std::visit([&s](auto&& v) {
+        visit_object([&s](auto&& v) {
             using T = std::decay_t<decltype(v)>;
             if constexpr (std::is_same_v<T, Integer>) {
                 s.push(Integer(-v));
@@ -739,7 +816,7 @@ void CommandRegistry::register_arithmetic_commands() {
                 s.push(Error{10, "Bad argument type"});
                 throw std::runtime_error("Bad argument type");
             }
-        }, a.as_variant());
+        }, a);
     });
 
     // INV (1/x or matrix inverse)
@@ -747,8 +824,8 @@ void CommandRegistry::register_arithmetic_commands() {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object a = s.pop();
         // Matrix inverse
-        if (std::holds_alternative<Matrix>(a)) {
-            auto& rows = std::get<Matrix>(a).rows;
+        if (holds_alternative<Matrix>(a)) {
+            auto& rows = get<Matrix>(a).rows;
             int n = static_cast<int>(rows.size());
             if (n == 0 || static_cast<int>(rows[0].size()) != n) {
                 s.push(a);
@@ -797,33 +874,33 @@ void CommandRegistry::register_arithmetic_commands() {
             return;
         }
         if (is_symbolic(a)) {
-            s.push(symbolic_func("INV", {a}));
+            s.push(symbolic_call("INV", {a}));
             return;
         }
-        if (std::holds_alternative<Integer>(a)) {
-            auto& v = std::get<Integer>(a);
+        if (holds_alternative<Integer>(a)) {
+            auto& v = get<Integer>(a);
             if (v == 0) {
                 s.push(a);
                 throw std::runtime_error("Division by zero");
             }
             s.push(Rational(Integer(1), v));
-        } else if (std::holds_alternative<Rational>(a)) {
-            auto& v = std::get<Rational>(a);
+        } else if (holds_alternative<Rational>(a)) {
+            auto& v = get<Rational>(a);
             if (v == 0) {
                 s.push(a);
                 throw std::runtime_error("Division by zero");
             }
             s.push(Rational(boost::multiprecision::denominator(v),
                             boost::multiprecision::numerator(v)));
-        } else if (std::holds_alternative<Real>(a)) {
-            auto& v = std::get<Real>(a);
+        } else if (holds_alternative<Real>(a)) {
+            auto& v = get<Real>(a);
             if (v == 0) {
                 s.push(a);
                 throw std::runtime_error("Division by zero");
             }
             s.push(Real(Real(1) / v));
-        } else if (std::holds_alternative<Complex>(a)) {
-            auto& v = std::get<Complex>(a);
+        } else if (holds_alternative<Complex>(a)) {
+            auto& v = get<Complex>(a);
             Real denom = v.first * v.first + v.second * v.second;
             if (denom == 0) {
                 s.push(a);
@@ -837,12 +914,11 @@ void CommandRegistry::register_arithmetic_commands() {
     });
 
     // ABS
-    register_command("ABS", [this](Store& s, Context& ctx) {
-        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
-        Object a = s.pop();
+    register_function("ABS", 1, [](const Args& args, Context&) -> Object {
+        const Object& a = args[0];
         // ABS on vector: Euclidean norm (numeric only)
-        if (std::holds_alternative<Matrix>(a)) {
-            auto& rows = std::get<Matrix>(a).rows;
+        if (holds_alternative<Matrix>(a)) {
+            auto& rows = get<Matrix>(a).rows;
             if (rows.size() != 1)
                 throw std::runtime_error("ABS requires a vector (1-row matrix)");
             for (auto& elem : rows[0])
@@ -853,50 +929,39 @@ void CommandRegistry::register_arithmetic_commands() {
                 Real v = to_real_value(elem);
                 sum += v * v;
             }
-            s.push(boost::multiprecision::sqrt(sum));
-            return;
+            return Real(boost::multiprecision::sqrt(sum));
         }
         if (is_symbolic(a)) {
-            s.push(symbolic_func("ABS", {a}));
-            return;
-        }
-        if (std::holds_alternative<Integer>(a)) {
-            auto& v = std::get<Integer>(a);
-            s.push(v < 0 ? Integer(-v) : v);
-        } else if (std::holds_alternative<Rational>(a)) {
-            auto& v = std::get<Rational>(a);
-            s.push(v < 0 ? Rational(-v) : v);
-        } else if (std::holds_alternative<Real>(a)) {
-            auto& v = std::get<Real>(a);
-            s.push(v < 0 ? Real(-v) : v);
-        } else if (std::holds_alternative<Complex>(a)) {
-            auto& v = std::get<Complex>(a);
+            return symbolic_call("ABS", {a});
+        }
+        if (holds_alternative<Integer>(a)) {
+            auto& v = get<Integer>(a);
+            return v < 0 ? Integer(-v) : v;
+        } else if (holds_alternative<Rational>(a)) {
+            auto& v = get<Rational>(a);
+            return v < 0 ? Rational(-v) : v;
+        } else if (holds_alternative<Real>(a)) {
+            auto& v = get<Real>(a);
+            return v < 0 ? Real(-v) : v;
+        } else if (holds_alternative<Complex>(a)) {
+            auto& v = get<Complex>(a);
             // |z| = sqrt(re^2 + im^2)
-            Real mag = boost::multiprecision::sqrt(v.first * v.first + v.second * v.second);
-            s.push(mag);
+            return Real(boost::multiprecision::sqrt(v.first * v.first + v.second * v.second));
         } else {
-            s.push(a);
             throw std::runtime_error("Bad argument type");
         }
     });
 
     // MOD
-    register_command("MOD", [](Store& s, Context&) {
-        if (s.depth() < 2) throw std::runtime_error("Too few arguments");
-        Object b = s.pop();
-        Object a = s.pop();
-        if (std::holds_alternative<Integer>(a) && std::holds_alternative<Integer>(b)) {
-            auto& va = std::get<Integer>(a);
-            auto& vb = std::get<Integer>(b);
-            if (vb == 0) {
-                s.push(a);
-                s.push(b);
-                throw std::runtime_error("Division by zero");
-            }
-            s.push(Integer(va % vb));
+    register_function("MOD", 2, [](const Args& args, Context&) -> Object {
+        const Object& a = args[0];
+        const Object& b = args[1];
+        if (holds_alternative<Integer>(a) && holds_alternative<Integer>(b)) {
+            auto& va = get<Integer>(a);
+            auto& vb = get<Integer>(b);
+            if (vb == 0) throw std::runtime_error("Division by zero");
+            return Integer(va % vb);
         } else {
-            s.push(a);
-            s.push(b);
             throw std::runtime_error("Bad argument type");
         }
     });
@@ -915,14 +980,14 @@ void CommandRegistry::register_arithmetic_commands() {
         // Helper: extract integer exponent from any exact numeric type
         auto get_int_exp = [](const Object& obj, bool& ok) -> long long {
             ok = false;
-            if (std::holds_alternative<Integer>(obj)) {
-                auto& v = std::get<Integer>(obj);
+            if (holds_alternative<Integer>(obj)) {
+                auto& v = get<Integer>(obj);
                 if (v >= -1000000 && v <= 1000000) {
                     ok = true;
                     return v.convert_to<long long>();
                 }
-            } else if (std::holds_alternative<Rational>(obj)) {
-                auto& v = std::get<Rational>(obj);
+            } else if (holds_alternative<Rational>(obj)) {
+                auto& v = get<Rational>(obj);
                 if (boost::multiprecision::denominator(v) == 1) {
                     auto num = boost::multiprecision::numerator(v);
                     if (num >= -1000000 && num <= 1000000) {
@@ -937,8 +1002,8 @@ void CommandRegistry::register_arithmetic_commands() {
         bool has_int_exp = false;
         long long iexp = get_int_exp(b, has_int_exp);
 
-        if (std::holds_alternative<Integer>(a) && has_int_exp) {
-            auto& base = std::get<Integer>(a);
+        if (holds_alternative<Integer>(a) && has_int_exp) {
+            auto& base = get<Integer>(a);
             if (iexp >= 0) {
                 s.push(Integer(boost::multiprecision::pow(base, static_cast<unsigned>(iexp))));
             } else {
@@ -946,8 +1011,8 @@ void CommandRegistry::register_arithmetic_commands() {
                 if (denom == 0) throw std::runtime_error("Division by zero");
                 s.push(Rational(Integer(1), denom));
             }
-        } else if (std::holds_alternative<Rational>(a) && has_int_exp) {
-            auto& base = std::get<Rational>(a);
+        } else if (holds_alternative<Rational>(a) && has_int_exp) {
+            auto& base = get<Rational>(a);
             Integer num = boost::multiprecision::numerator(base);
             Integer den = boost::multiprecision::denominator(base);
             if (iexp >= 0) {
@@ -964,20 +1029,20 @@ void CommandRegistry::register_arithmetic_commands() {
         } else {
             // Promote to Real
             Real rbase, rexp;
-            if (std::holds_alternative<Integer>(a))
-                rbase = Real(std::get<Integer>(a));
-            else if (std::holds_alternative<Rational>(a))
-                rbase = Real(std::get<Rational>(a));
-            else if (std::holds_alternative<Real>(a))
-                rbase = std::get<Real>(a);
+            if (holds_alternative<Integer>(a))
+                rbase = Real(get<Integer>(a));
+            else if (holds_alternative<Rational>(a))
+                rbase = Real(get<Rational>(a));
+            else if (holds_alternative<Real>(a))
+                rbase = get<Real>(a);
             else { s.push(a); s.push(b); throw std::runtime_error("Bad argument type"); }
 
-            if (std::holds_alternative<Integer>(b))
-                rexp = Real(std::get<Integer>(b));
-            else if (std::holds_alternative<Rational>(b))
-                rexp = Real(std::get<Rational>(b));
-            else if (std::holds_alternative<Real>(b))
-                rexp = std::get<Real>(b);
+            if (holds_alternative<Integer>(b))
+                rexp = Real(get<Integer>(b));
+            else if (holds_alternative<Rational>(b))
+                rexp = Real(get<Rational>(b));
+            else if (holds_alternative<Real>(b))
+                rexp = get<Real>(b);
             else { s.push(a); s.push(b); throw std::runtime_error("Bad argument type"); }
 
             if (rbase < 0) throw std::runtime_error("Bad argument value");
@@ -994,32 +1059,14 @@ void CommandRegistry::register_comparison_commands() {
         Object b = s.pop(); // level 1
         Object a = s.pop(); // level 2
 
-        int ra = numeric_rank(a);
-        int rb = numeric_rank(b);
-        if (ra < 0 || rb < 0) {
+        // For complex, only == and != are meaningful; the kernel compares
+        // real parts (simplified)
+        Object result = numeric_dispatch(std::move(a), b, numeric_compare(pred), [&]() -> Object {
             s.push(a);
             s.push(b);
             throw std::runtime_error("Bad argument type");
-        }
-
-        int target = std::max(ra, rb);
-        Object pa = promote(a, target);
-        Object pb = promote(b, target);
-
-        bool result = false;
-        switch (target) {
-            case 0: result = pred(std::get<Integer>(pa), std::get<Integer>(pb)); break;
-            case 1: result = pred(std::get<Rational>(pa), std::get<Rational>(pb)); break;
-            case 2: result = pred(std::get<Real>(pa), std::get<Real>(pb)); break;
-            case 3: {
-                // For complex, only == and != are meaningful
-                auto& ca = std::get<Complex>(pa);
-                auto& cb = std::get<Complex>(pb);
-                result = pred(ca.first, cb.first); // simplified
-                break;
-            }
-        }
-        s.push(Integer(result ? 1 : 0));
+        });
+        s.push(std::move(result));
     };
 
     register_command("==", [compare](Store& s, Context&) {
@@ -1055,22 +1102,22 @@ void CommandRegistry::register_type_commands() {
     auto to_num = [](Store& s, Context& ctx) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object a = s.pop();
-        if (std::holds_alternative<Symbol>(a)) {
+        if (holds_alternative<Symbol>(a)) {
             // Evaluate the symbolic expression numerically
-            Object result = eval_expression_numeric(std::get<Symbol>(a).value, ctx);
+            Object result = eval_expression_numeric(get<Symbol>(a).value(), ctx);
             // Ensure result is Real
-            if (std::holds_alternative<Integer>(result)) {
-                s.push(Real(std::get<Integer>(result)));
-            } else if (std::holds_alternative<Rational>(result)) {
-                s.push(Real(std::get<Rational>(result)));
+            if (holds_alternative<Integer>(result)) {
+                s.push(Real(get<Integer>(result)));
+            } else if (holds_alternative<Rational>(result)) {
+                s.push(Real(get<Rational>(result)));
             } else {
                 s.push(result);
             }
-        } else if (std::holds_alternative<Integer>(a)) {
-            s.push(Real(std::get<Integer>(a)));
-        } else if (std::holds_alternative<Rational>(a)) {
-            s.push(Real(std::get<Rational>(a)));
-        } else if (std::holds_alternative<Real>(a)) {
+        } else if (holds_alternative<Integer>(a)) {
+            s.push(Real(get<Integer>(a)));
+        } else if (holds_alternative<Rational>(a)) {
+            s.push(Real(get<Rational>(a)));
+        } else if (holds_alternative<Real>(a)) {
             s.push(a); // already real
         } else {
             s.push(a);
@@ -1093,12 +1140,11 @@ void CommandRegistry::register_type_commands() {
     auto str_eval = [](Store& s, Context& ctx) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object a = s.pop();
-        if (!std::holds_alternative<String>(a)) {
+        if (!holds_alternative<String>(a)) {
             s.push(a);
             throw std::runtime_error("Bad argument type");
         }
-        auto& str = std::get<String>(a).value;
-        ctx.execute_tokens(parse(str));
+        ctx.run_program(ctx.parse_cache().get(get<String>(a).value));
     };
     register_command("STR\xe2\x86\x92", str_eval);
     register_command("STR->", str_eval);
@@ -1107,29 +1153,32 @@ void CommandRegistry::register_type_commands() {
 // ---- Filesystem Commands ----
 
 void CommandRegistry::register_filesystem_commands() {
-    register_command("STO", [](Store& s, Context&) {
+    register_command("STO", [](Store& s, Context& ctx) {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object name_obj = s.pop(); // level 1
         Object value = s.pop();    // level 2
-        if (!std::holds_alternative<Name>(name_obj)) {
+        if (!holds_alternative<Name>(name_obj)) {
             s.push(value);
             s.push(name_obj);
             throw std::runtime_error("Expected a name");
         }
-        auto& name = std::get<Name>(name_obj).value;
+        auto& name = get<Name>(name_obj).value;
+        if (holds_alternative<Program>(value) && optimizer_enabled(s)) {
+            value = Program{optimize_tokens(get<Program>(value).tokens, ctx)};
+        }
         s.store_variable(s.current_dir(), name, value);
     });
 
     register_command("RCL", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object name_obj = s.pop();
-        if (!std::holds_alternative<Name>(name_obj)) {
+        if (!holds_alternative<Name>(name_obj)) {
             s.push(name_obj);
             throw std::runtime_error("Expected a name");
         }
-        auto& name = std::get<Name>(name_obj).value;
+        auto& name = get<Name>(name_obj).value;
         Object val = s.recall_variable(s.current_dir(), name);
-        if (std::holds_alternative<Error>(val)) {
+        if (holds_alternative<Error>(val)) {
             throw std::runtime_error("Undefined Name");
         }
         s.push(val);
@@ -1138,11 +1187,11 @@ void CommandRegistry::register_filesystem_commands() {
     register_command("PURGE", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object name_obj = s.pop();
-        if (!std::holds_alternative<Name>(name_obj)) {
+        if (!holds_alternative<Name>(name_obj)) {
             s.push(name_obj);
             throw std::runtime_error("Expected a name");
         }
-        auto& name = std::get<Name>(name_obj).value;
+        auto& name = get<Name>(name_obj).value;
         s.purge_variable(s.current_dir(), name);
     });
 
@@ -1157,22 +1206,22 @@ void CommandRegistry::register_filesystem_commands() {
     register_command("CRDIR", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object name_obj = s.pop();
-        if (!std::holds_alternative<Name>(name_obj)) {
+        if (!holds_alternative<Name>(name_obj)) {
             s.push(name_obj);
             throw std::runtime_error("Expected a name");
         }
-        auto& name = std::get<Name>(name_obj).value;
+        auto& name = get<Name>(name_obj).value;
         s.create_directory(s.current_dir(), name);
     });
 
     register_command("CD", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object name_obj = s.pop();
-        if (!std::holds_alternative<Name>(name_obj)) {
+        if (!holds_alternative<Name>(name_obj)) {
             s.push(name_obj);
             throw std::runtime_error("Expected a name");
         }
-        auto& name = std::get<Name>(name_obj).value;
+        auto& name = get<Name>(name_obj).value;
         int dir_id = s.find_directory(s.current_dir(), name);
         if (dir_id < 0) {
             s.push(name_obj);
@@ -1191,11 +1240,11 @@ void CommandRegistry::register_filesystem_commands() {
     register_command("PGDIR", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object name_obj = s.pop();
-        if (!std::holds_alternative<Name>(name_obj)) {
+        if (!holds_alternative<Name>(name_obj)) {
             s.push(name_obj);
             throw std::runtime_error("Expected a name");
         }
-        auto& name = std::get<Name>(name_obj).value;
+        auto& name = get<Name>(name_obj).value;
         int dir_id = s.find_directory(s.current_dir(), name);
         if (dir_id < 0) {
             s.push(name_obj);
@@ -1224,22 +1273,21 @@ void CommandRegistry::register_program_commands() {
     register_command("EVAL", [](Store& s, Context& ctx) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object a = s.pop();
-        if (std::holds_alternative<Program>(a)) {
-            ctx.execute_tokens(std::get<Program>(a).tokens);
-        } else if (std::holds_alternative<Name>(a)) {
-            auto& name = std::get<Name>(a).value;
-            Object val = s.recall_variable(s.current_dir(), name);
-            if (std::holds_alternative<Error>(val)) {
+        if (holds_alternative<Program>(a)) {
+            ctx.run_program(program_tokens(std::move(a)));
+        } else if (holds_alternative<Name>(a)) {
+            auto& name = get<Name>(a).value;
+            SharedTokens program;
+            Object val = s.recall_variable(s.current_dir(), name, &program);
+            if (program) {
+                ctx.run_program(std::move(program));
+            } else if (holds_alternative<Error>(val)) {
                 s.push(Name{name});
-                return;
-            }
-            if (std::holds_alternative<Program>(val)) {
-                ctx.execute_tokens(std::get<Program>(val).tokens);
             } else {
                 s.push(val);
             }
-        } else if (std::holds_alternative<Symbol>(a)) {
-            auto& expr = std::get<Symbol>(a).value;
+        } else if (holds_alternative<Symbol>(a)) {
+            const auto& expr = get<Symbol>(a).value();
             Object result = eval_expression(expr, ctx);
             s.push(result);
         } else {
@@ -1252,12 +1300,12 @@ void CommandRegistry::register_program_commands() {
         Object cond = s.pop();      // level 1
         Object then_prog = s.pop(); // level 2
         if (is_symbolic(cond) || is_symbolic(then_prog)) {
-            s.push(symbolic_func("IFT", {then_prog, cond}));
+            s.push(symbolic_call("IFT", {then_prog, cond}));
             return;
         }
         if (is_truthy(cond)) {
-            if (std::holds_alternative<Program>(then_prog)) {
-                ctx.execute_tokens(std::get<Program>(then_prog).tokens);
+            if (holds_alternative<Program>(then_prog)) {
+                ctx.run_program(program_tokens(std::move(then_prog)));
             } else {
                 s.push(then_prog);
             }
@@ -1270,16 +1318,38 @@ void CommandRegistry::register_program_commands() {
         Object then_prog = s.pop(); // level 2
         Object else_prog = s.pop(); // level 3
         if (is_symbolic(cond) || is_symbolic(then_prog) || is_symbolic(else_prog)) {
-            s.push(symbolic_func("IFTE", {else_prog, then_prog, cond}));
+            s.push(symbolic_call("IFTE", {else_prog, then_prog, cond}));
             return;
         }
         Object& chosen = is_truthy(cond) ? then_prog : else_prog;
-        if (std::holds_alternative<Program>(chosen)) {
-            ctx.execute_tokens(std::get<Program>(chosen).tokens);
+        if (holds_alternative<Program>(chosen)) {
+            ctx.run_program(program_tokens(std::move(chosen)));
         } else {
             s.push(chosen);
         }
     });
+
+    // CALLMEM : ( kib -- ) memory budget for nested calls, control
+    // structures and local variables
+    register_command("CALLMEM", [](Store& s, Context& ctx) {
+        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
+        Object n_obj = s.pop();
+        if (!holds_alternative<Integer>(n_obj))
+            throw std::runtime_error("Bad argument type");
+        const auto& n = get<Integer>(n_obj);
+        if (n < 1 || n > (Integer(1) << 30)) throw std::runtime_error("Bad argument value");
+        s.set_meta(Context::kCallMemoryKey, n.str());
+        ctx.set_call_memory(static_cast<size_t>(n) << 10);
+    });
+
+    // PERFSTATS : ( -- { { "name" value } ... } ) runtime cache counters
+    register_command("PERFSTATS", [](Store& s, Context& ctx) {
+        List stats;
+        for (const auto& [name, value] : ctx.perf_stats()) {
+            stats.items.push_back(List{{String{name}, Integer(value)}});
+        }
+        s.push(std::move(stats));
+    });
 }
 
 // ---- Logic & Bitwise Commands ----
@@ -1290,10 +1360,10 @@ void CommandRegistry::register_logic_commands() {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object b = s.pop();
         Object a = s.pop();
-        if (!std::holds_alternative<Integer>(a) || !std::holds_alternative<Integer>(b))
+        if (!holds_alternative<Integer>(a) || !holds_alternative<Integer>(b))
             throw std::runtime_error("Bad argument type");
-        bool ba = std::get<Integer>(a) != 0;
-        bool bb = std::get<Integer>(b) != 0;
+        bool ba = get<Integer>(a) != 0;
+        bool bb = get<Integer>(b) != 0;
         s.push(Integer(ba && bb ? 1 : 0));
     });
 
@@ -1301,29 +1371,29 @@ void CommandRegistry::register_logic_commands() {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object b = s.pop();
         Object a = s.pop();
-        if (!std::holds_alternative<Integer>(a) || !std::holds_alternative<Integer>(b))
+        if (!holds_alternative<Integer>(a) || !holds_alternative<Integer>(b))
             throw std::runtime_error("Bad argument type");
-        bool ba = std::get<Integer>(a) != 0;
-        bool bb = std::get<Integer>(b) != 0;
+        bool ba = get<Integer>(a) != 0;
+        bool bb = get<Integer>(b) != 0;
         s.push(Integer(ba || bb ? 1 : 0));
     });
 
     register_command("NOT", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object a = s.pop();
-        if (!std::holds_alternative<Integer>(a))
+        if (!holds_alternative<Integer>(a))
             throw std::runtime_error("Bad argument type");
-        s.push(Integer(std::get<Integer>(a) == 0 ? 1 : 0));
+        s.push(Integer(get<Integer>(a) == 0 ? 1 : 0));
     });
 
     register_command("XOR", [](Store& s, Context&) {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object b = s.pop();
         Object a = s.pop();
-        if (!std::holds_alternative<Integer>(a) || !std::holds_alternative<Integer>(b))
+        if (!holds_alternative<Integer>(a) || !holds_alternative<Integer>(b))
             throw std::runtime_error("Bad argument type");
-        bool ba = std::get<Integer>(a) != 0;
-        bool bb = std::get<Integer>(b) != 0;
+        bool ba = get<Integer>(a) != 0;
+        bool bb = get<Integer>(b) != 0;
         s.push(Integer(ba != bb ? 1 : 0));
     });
 
@@ -1332,66 +1402,66 @@ void CommandRegistry::register_logic_commands() {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object b = s.pop();
         Object a = s.pop();
-        if (!std::holds_alternative<Integer>(a) || !std::holds_alternative<Integer>(b))
+        if (!holds_alternative<Integer>(a) || !holds_alternative<Integer>(b))
             throw std::runtime_error("Bad argument type");
-        s.push(Integer(std::get<Integer>(a) & std::get<Integer>(b)));
+        s.push(Integer(get<Integer>(a) & get<Integer>(b)));
     });
 
     register_command("BOR", [](Store& s, Context&) {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object b = s.pop();
         Object a = s.pop();
-        if (!std::holds_alternative<Integer>(a) || !std::holds_alternative<Integer>(b))
+        if (!holds_alternative<Integer>(a) || !holds_alternative<Integer>(b))
             throw std::runtime_error("Bad argument type");
-        s.push(Integer(std::get<Integer>(a) | std::get<Integer>(b)));
+        s.push(Integer(get<Integer>(a) | get<Integer>(b)));
     });
 
     register_command("BXOR", [](Store& s, Context&) {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object b = s.pop();
         Object a = s.pop();
-        if (!std::holds_alternative<Integer>(a) || !std::holds_alternative<Integer>(b))
+        if (!holds_alternative<Integer>(a) || !holds_alternative<Integer>(b))
             throw std::runtime_error("Bad argument type");
-        s.push(Integer(std::get<Integer>(a) ^ std::get<Integer>(b)));
+        s.push(Integer(get<Integer>(a) ^ get<Integer>(b)));
     });
 
     register_command("BNOT", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object a = s.pop();
-        if (!std::holds_alternative<Integer>(a))
+        if (!holds_alternative<Integer>(a))
             throw std::runtime_error("Bad argument type");
-        s.push(Integer(~std::get<Integer>(a)));
+        s.push(Integer(~get<Integer>(a)));
     });
 
     register_command("SL", [](Store& s, Context&) {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object b = s.pop();
         Object a = s.pop();
-        if (!std::holds_alternative<Integer>(a) || !std::holds_alternative<Integer>(b))
+        if (!holds_alternative<Integer>(a) || !holds_alternative<Integer>(b))
             throw std::runtime_error("Bad argument type");
-        auto shift = static_cast<int>(std::get<Integer>(b));
-        s.push(Integer(std::get<Integer>(a) << shift));
+        auto shift = static_cast<int>(get<Integer>(b));
+        s.push(Integer(get<Integer>(a) << shift));
     });
 
     register_command("SR", [](Store& s, Context&) {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object b = s.pop();
         Object a = s.pop();
-        if (!std::holds_alternative<Integer>(a) || !std::holds_alternative<Integer>(b))
+        if (!holds_alternative<Integer>(a) || !holds_alternative<Integer>(b))
             throw std::runtime_error("Bad argument type");
-        auto shift = static_cast<int>(std::get<Integer>(b));
-        s.push(Integer(std::get<Integer>(a) >> shift));
+        auto shift = static_cast<int>(get<Integer>(b));
+        s.push(Integer(get<Integer>(a) >> shift));
     });
 
     register_command("ASR", [](Store& s, Context&) {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object b = s.pop();
         Object a = s.pop();
-        if (!std::holds_alternative<Integer>(a) || !std::holds_alternative<Integer>(b))
+        if (!holds_alternative<Integer>(a) || !holds_alternative<Integer>(b))
             throw std::runtime_error("Bad argument type");
         // Arithmetic shift right is the same as >> for cpp_int (sign-extending)
-        auto shift = static_cast<int>(std::get<Integer>(b));
-        s.push(Integer(std::get<Integer>(a) >> shift));
+        auto shift = static_cast<int>(get<Integer>(b));
+        s.push(Integer(get<Integer>(a) >> shift));
     });
 
     // SAME: deep structural equality (same type AND same value)
@@ -1399,31 +1469,7 @@ void CommandRegistry::register_logic_commands() {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object b = s.pop();
         Object a = s.pop();
-        bool same = false;
-        if (a.index() == b.index()) {
-            // Same variant index — compare values
-            std::visit([&same, &b](auto&& va) {
-                using T = std::decay_t<decltype(va)>;
-                auto& vb = std::get<T>(b);
-                if constexpr (std::is_same_v<T, Integer> || std::is_same_v<T, Real> ||
-                              std::is_same_v<T, Rational>) {
-                    same = (va == vb);
-                } else if constexpr (std::is_same_v<T, Complex>) {
-                    same = (va.first == vb.first && va.second == vb.second);
-                } else if constexpr (std::is_same_v<T, String>) {
-                    same = (va.value == vb.value);
-                } else if constexpr (std::is_same_v<T, Name>) {
-                    same = (va.value == vb.value);
-                } else if constexpr (std::is_same_v<T, Symbol>) {
-                    same = (va.value == vb.value);
-                } else if constexpr (std::is_same_v<T, Error>) {
-                    same = (va.code == vb.code && va.message == vb.message);
-                } else if constexpr (std::is_same_v<T, Program>) {
-                    // Programs are same if their repr matches
-                    same = (repr(Object(va)) == repr(Object(vb)));
-                }
-            }, a.as_variant());
-        }
+        bool same = objects_equal(a, b);
         s.push(Integer(same ? 1 : 0));
     });
 }
@@ -1442,152 +1488,151 @@ void CommandRegistry::register_transcendental_commands() {
         s.set_meta("angle_mode", "GRAD");
     });
 
+    // PREC: ( n -- ) working precision of the transcendental functions, in
+    // significant digits. 16 or fewer runs on hardware double.
+    register_command("PREC", [](Store& s, Context&) {
+        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
+        Object n = s.pop();
+        if (!holds_alternative<Integer>(n)) throw std::runtime_error("Bad argument type");
+        const Integer& digits = get<Integer>(n);
+        if (digits < 1 || digits > kMaxPrecision) throw std::runtime_error("Bad argument value");
+        s.set_meta("precision", digits.str());
+    });
+
+    auto precision = [](Store& s) -> int {
+        return std::stoi(s.get_meta("precision", std::to_string(kMaxPrecision)));
+    };
+
     // Helper lambdas for angle conversion
     // to_radians: convert from current angle mode to radians
-    auto to_rad = [](const Real& val, Store& s) -> double {
+    auto to_rad = [](const Real& val, Store& s) -> Real {
         std::string mode = s.get_meta("angle_mode", "RAD");
-        double v = val.convert_to<double>();
-        if (mode == "DEG") return v * 3.14159265358979323846 / 180.0;
-        if (mode == "GRAD") return v * 3.14159265358979323846 / 200.0;
-        return v; // RAD
+        if (mode == "DEG") return val * pi_real() / 180;
+        if (mode == "GRAD") return val * pi_real() / 200;
+        return val; // RAD
     };
     // from_radians: convert radians to current angle mode
-    auto from_rad = [](double val, Store& s) -> Real {
+    auto from_rad = [](const Real& val, Store& s) -> Real {
         std::string mode = s.get_meta("angle_mode", "RAD");
-        if (mode == "DEG") return Real(val * 180.0 / 3.14159265358979323846);
-        if (mode == "GRAD") return Real(val * 200.0 / 3.14159265358979323846);
-        return Real(val);
+        if (mode == "DEG") return val * 180 / pi_real();
+        if (mode == "GRAD") return val * 200 / pi_real();
+        return val;
     };
 
     // Trig functions (angle-mode-aware)
-    register_command("SIN", [to_rad](Store& s, Context&) {
-        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
-        Object a = s.pop();
-        if (is_symbolic(a)) { s.push(symbolic_func("SIN", {a})); return; }
-        s.push(Real(std::sin(to_rad(to_real_value(a), s))));
+    register_function("SIN", 1, [=](const Args& args, Context& ctx) -> Object {
+        const Object& a = args[0];
+        if (is_symbolic(a)) return symbolic_call("SIN", {a});
+        int digits = precision(ctx.store());
+        return round_digits(sin_real(to_rad(to_real_value(a), ctx.store()), digits), digits);
     });
 
-    register_command("COS", [to_rad](Store& s, Context&) {
-        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
-        Object a = s.pop();
-        if (is_symbolic(a)) { s.push(symbolic_func("COS", {a})); return; }
-        s.push(Real(std::cos(to_rad(to_real_value(a), s))));
+    register_function("COS", 1, [=](const Args& args, Context& ctx) -> Object {
+        const Object& a = args[0];
+        if (is_symbolic(a)) return symbolic_call("COS", {a});
+        int digits = precision(ctx.store());
+        return round_digits(cos_real(to_rad(to_real_value(a), ctx.store()), digits), digits);
     });
 
-    register_command("TAN", [to_rad](Store& s, Context&) {
-        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
-        Object a = s.pop();
-        if (is_symbolic(a)) { s.push(symbolic_func("TAN", {a})); return; }
-        s.push(Real(std::tan(to_rad(to_real_value(a), s))));
+    register_function("TAN", 1, [=](const Args& args, Context& ctx) -> Object {
+        const Object& a = args[0];
+        if (is_symbolic(a)) return symbolic_call("TAN", {a});
+        int digits = precision(ctx.store());
+        return round_digits(tan_real(to_rad(to_real_value(a), ctx.store()), digits), digits);
     });
 
-    register_command("ASIN", [from_rad](Store& s, Context&) {
-        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
-        Object a = s.pop();
-        if (is_symbolic(a)) { s.push(symbolic_func("ASIN", {a})); return; }
-        s.push(from_rad(std::asin(to_double_value(a)), s));
+    register_function("ASIN", 1, [=](const Args& args, Context& ctx) -> Object {
+        const Object& a = args[0];
+        if (is_symbolic(a)) return symbolic_call("ASIN", {a});
+        int digits = precision(ctx.store());
+        return round_digits(from_rad(asin_real(to_real_value(a), digits), ctx.store()), digits);
     });
 
-    register_command("ACOS", [from_rad](Store& s, Context&) {
-        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
-        Object a = s.pop();
-        if (is_symbolic(a)) { s.push(symbolic_func("ACOS", {a})); return; }
-        s.push(from_rad(std::acos(to_double_value(a)), s));
+    register_function("ACOS", 1, [=](const Args& args, Context& ctx) -> Object {
+        const Object& a = args[0];
+        if (is_symbolic(a)) return symbolic_call("ACOS", {a});
+        int digits = precision(ctx.store());
+        return round_digits(from_rad(acos_real(to_real_value(a), digits), ctx.store()), digits);
     });
 
-    register_command("ATAN", [from_rad](Store& s, Context&) {
-        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
-        Object a = s.pop();
-        if (is_symbolic(a)) { s.push(symbolic_func("ATAN", {a})); return; }
-        s.push(from_rad(std::atan(to_double_value(a)), s));
+    register_function("ATAN", 1, [=](const Args& args, Context& ctx) -> Object {
+        const Object& a = args[0];
+        if (is_symbolic(a)) return symbolic_call("ATAN", {a});
+        int digits = precision(ctx.store());
+        return round_digits(from_rad(atan_real(to_real_value(a), digits), ctx.store()), digits);
     });
 
-    register_command("ATAN2", [from_rad](Store& s, Context&) {
-        if (s.depth() < 2) throw std::runtime_error("Too few arguments");
-        Object b = s.pop(); // x
-        Object a = s.pop(); // y
-        s.push(from_rad(std::atan2(to_double_value(a), to_double_value(b)), s));
+    register_function("ATAN2", 2, [=](const Args& args, Context& ctx) -> Object {
+        const Object& a = args[0]; // y
+        const Object& b = args[1]; // x
+        int digits = precision(ctx.store());
+        return round_digits(from_rad(atan2_real(to_real_value(a), to_real_value(b), digits), ctx.store()),
+                            digits);
     });
 
     // Exponential / logarithmic
-    register_command("EXP", [](Store& s, Context&) {
-        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
-        Object a = s.pop();
-        if (is_symbolic(a)) { s.push(symbolic_func("EXP", {a})); return; }
-        s.push(Real(std::exp(to_double_value(a))));
+    register_function("EXP", 1, [=](const Args& args, Context& ctx) -> Object {
+        const Object& a = args[0];
+        if (is_symbolic(a)) return symbolic_call("EXP", {a});
+        int digits = precision(ctx.store());
+        return round_digits(exp_real(to_real_value(a), digits), digits);
     });
 
-    register_command("LN", [](Store& s, Context&) {
-        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
-        Object a = s.pop();
-        if (is_symbolic(a)) { s.push(symbolic_func("LN", {a})); return; }
-        double v = to_double_value(a);
-        if (v <= 0) throw std::runtime_error("Bad argument value");
-        s.push(Real(std::log(v)));
+    register_function("LN", 1, [=](const Args& args, Context& ctx) -> Object {
+        const Object& a = args[0];
+        if (is_symbolic(a)) return symbolic_call("LN", {a});
+        int digits = precision(ctx.store());
+        return round_digits(ln_real(to_real_value(a), digits), digits);
     });
 
-    register_command("LOG", [](Store& s, Context&) {
-        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
-        Object a = s.pop();
-        double v = to_double_value(a);
-        if (v <= 0) throw std::runtime_error("Bad argument value");
-        s.push(Real(std::log10(v)));
+    register_function("LOG", 1, [=](const Args& args, Context& ctx) -> Object {
+        int digits = precision(ctx.store());
+        return round_digits(log10_real(to_real_value(args[0]), digits), digits);
     });
 
-    register_command("ALOG", [](Store& s, Context&) {
-        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
-        Object a = s.pop();
-        s.push(Real(std::pow(10.0, to_double_value(a))));
+    register_function("ALOG", 1, [=](const Args& args, Context& ctx) -> Object {
+        int digits = precision(ctx.store());
+        return round_digits(alog_real(to_real_value(args[0]), digits), digits);
     });
 
     // SQRT, SQ
-    register_command("SQRT", [](Store& s, Context&) {
-        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
-        Object a = s.pop();
-        if (is_symbolic(a)) { s.push(symbolic_func("SQRT", {a})); return; }
-        if (std::holds_alternative<Integer>(a)) {
-            auto& v = std::get<Integer>(a);
+    register_function("SQRT", 1, [](const Args& args, Context&) -> Object {
+        const Object& a = args[0];
+        if (is_symbolic(a)) return symbolic_call("SQRT", {a});
+        if (holds_alternative<Integer>(a)) {
+            auto& v = get<Integer>(a);
             if (v < 0) throw std::runtime_error("Bad argument value");
             Integer isqrt = boost::multiprecision::sqrt(v);
             if (isqrt * isqrt == v) {
-                s.push(isqrt);
+                return isqrt;
             } else {
-                s.push(Real(boost::multiprecision::sqrt(Real(v))));
+                return Real(boost::multiprecision::sqrt(Real(v)));
             }
-        } else if (std::holds_alternative<Real>(a)) {
-            auto& v = std::get<Real>(a);
+        } else if (holds_alternative<Real>(a)) {
+            auto& v = get<Real>(a);
             if (v < 0) throw std::runtime_error("Bad argument value");
-            s.push(Real(boost::multiprecision::sqrt(v)));
-        } else if (std::holds_alternative<Rational>(a)) {
-            auto& v = std::get<Rational>(a);
+            return Real(boost::multiprecision::sqrt(v));
+        } else if (holds_alternative<Rational>(a)) {
+            auto& v = get<Rational>(a);
             if (v < 0) throw std::runtime_error("Bad argument value");
             Integer num = boost::multiprecision::numerator(v);
             Integer den = boost::multiprecision::denominator(v);
             Integer isqrt_num = boost::multiprecision::sqrt(num);
             Integer isqrt_den = boost::multiprecision::sqrt(den);
             if (isqrt_num * isqrt_num == num && isqrt_den * isqrt_den == den) {
-                s.push(Rational(isqrt_num, isqrt_den));
+                return Rational(isqrt_num, isqrt_den);
             } else {
-                s.push(Real(boost::multiprecision::sqrt(Real(v))));
+                return Real(boost::multiprecision::sqrt(Real(v)));
             }
         } else {
             throw std::runtime_error("Bad argument type");
         }
     });
 
-    register_command("SQ", [](Store& s, Context&) {
-        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
-        Object a = s.pop();
-        if (is_symbolic(a)) { s.push(symbolic_binary(a, Integer(2), "^")); return; }
-        Object result = binary_numeric(a, a,
-            [](const Integer& x, const Integer& y) -> Integer { return x * y; },
-            [](const Rational& x, const Rational& y) -> Rational { return x * y; },
-            [](const Real& x, const Real& y) -> Real { return x * y; },
-            [](const Complex& x, const Complex& y) -> Complex {
-                return {x.first * y.first - x.second * y.second,
-                        x.first * y.second + x.second * y.first};
-            });
-        s.push(result);
+    register_function("SQ", 1, [](const Args& args, Context&) -> Object {
+        const Object& a = args[0];
+        if (is_symbolic(a)) return symbolic_binary(a, Integer(2), "^");
+        return numeric_dispatch(Object(a), a, NumericMul{}, bad_argument_type);
     });
 
     // Constants
@@ -1600,210 +1645,265 @@ void CommandRegistry::register_transcendental_commands() {
     });
 
     // Rounding
-    register_command("FLOOR", [](Store& s, Context&) {
-        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
-        Object a = s.pop();
-        if (std::holds_alternative<Integer>(a)) {
-            s.push(a);
-        } else if (std::holds_alternative<Real>(a)) {
-            auto& v = std::get<Real>(a);
-            s.push(Integer(static_cast<long long>(boost::multiprecision::floor(v))));
-        } else if (std::holds_alternative<Rational>(a)) {
-            Real r(std::get<Rational>(a));
-            s.push(Integer(static_cast<long long>(boost::multiprecision::floor(r))));
+    register_function("FLOOR", 1, [](const Args& args, Context&) -> Object {
+        const Object& a = args[0];
+        if (holds_alternative<Integer>(a)) {
+            return a;
+        } else if (holds_alternative<Real>(a)) {
+            auto& v = get<Real>(a);
+            return Integer(static_cast<long long>(boost::multiprecision::floor(v)));
+        } else if (holds_alternative<Rational>(a)) {
+            Real r(get<Rational>(a));
+            return Integer(static_cast<long long>(boost::multiprecision::floor(r)));
         } else {
             throw std::runtime_error("Bad argument type");
         }
     });
 
-    register_command("CEIL", [](Store& s, Context&) {
-        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
-        Object a = s.pop();
-        if (std::holds_alternative<Integer>(a)) {
-            s.push(a);
-        } else if (std::holds_alternative<Real>(a)) {
-            auto& v = std::get<Real>(a);
-            s.push(Integer(static_cast<long long>(boost::multiprecision::ceil(v))));
-        } else if (std::holds_alternative<Rational>(a)) {
-            Real r(std::get<Rational>(a));
-            s.push(Integer(static_cast<long long>(boost::multiprecision::ceil(r))));
+    register_function("CEIL", 1, [](const Args& args, Context&) -> Object {
+        const Object& a = args[0];
+        if (holds_alternative<Integer>(a)) {
+            return a;
+        } else if (holds_alternative<Real>(a)) {
+            auto& v = get<Real>(a);
+            return Integer(static_cast<long long>(boost::multiprecision::ceil(v)));
+        } else if (holds_alternative<Rational>(a)) {
+            Real r(get<Rational>(a));
+            return Integer(static_cast<long long>(boost::multiprecision::ceil(r)));
         } else {
             throw std::runtime_error("Bad argument type");
         }
     });
 
-    register_command("IP", [](Store& s, Context&) {
-        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
-        Object a = s.pop();
-        if (std::holds_alternative<Integer>(a)) {
-            s.push(a);
-        } else if (std::holds_alternative<Real>(a)) {
-            auto& v = std::get<Real>(a);
-            s.push(Integer(static_cast<long long>(boost::multiprecision::trunc(v))));
-        } else if (std::holds_alternative<Rational>(a)) {
-            Real r(std::get<Rational>(a));
-            s.push(Integer(static_cast<long long>(boost::multiprecision::trunc(r))));
+    register_function("IP", 1, [](const Args& args, Context&) -> Object {
+        const Object& a = args[0];
+        if (holds_alternative<Integer>(a)) {
+            return a;
+        } else if (holds_alternative<Real>(a)) {
+            auto& v = get<Real>(a);
+            return Integer(static_cast<long long>(boost::multiprecision::trunc(v)));
+        } else if (holds_alternative<Rational>(a)) {
+            Real r(get<Rational>(a));
+            return Integer(static_cast<long long>(boost::multiprecision::trunc(r)));
         } else {
             throw std::runtime_error("Bad argument type");
         }
     });
 
-    register_command("FP", [](Store& s, Context&) {
-        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
-        Object a = s.pop();
-        if (std::holds_alternative<Integer>(a)) {
-            s.push(Real(0));
-        } else if (std::holds_alternative<Real>(a)) {
-            auto& v = std::get<Real>(a);
+    register_function("FP", 1, [](const Args& args, Context&) -> Object {
+        const Object& a = args[0];
+        if (holds_alternative<Integer>(a)) {
+            return Real(0);
+        } else if (holds_alternative<Real>(a)) {
+            auto& v = get<Real>(a);
             Real ip = boost::multiprecision::trunc(v);
-            s.push(Real(v - ip));
-        } else if (std::holds_alternative<Rational>(a)) {
-            Real r(std::get<Rational>(a));
+            return Real(v - ip);
+        } else if (holds_alternative<Rational>(a)) {
+            Real r(get<Rational>(a));
             Real ip = boost::multiprecision::trunc(r);
-            s.push(Real(r - ip));
+            return Real(r - ip);
         } else {
             throw std::runtime_error("Bad argument type");
         }
     });
 
     // MIN, MAX, SIGN
-    register_command("MIN", [](Store& s, Context&) {
-        if (s.depth() < 2) throw std::runtime_error("Too few arguments");
-        Object b = s.pop();
-        Object a = s.pop();
-        Object result = binary_numeric(a, b,
-            [](const Integer& x, const Integer& y) -> Integer { return x < y ? x : y; },
-            [](const Rational& x, const Rational& y) -> Rational { return x < y ? x : y; },
-            [](const Real& x, const Real& y) -> Real { return x < y ? x : y; },
-            [](const Complex&, const Complex&) -> Complex {
-                throw std::runtime_error("Bad argument type");
-            });
-        s.push(result);
-    });
-
-    register_command("MAX", [](Store& s, Context&) {
-        if (s.depth() < 2) throw std::runtime_error("Too few arguments");
-        Object b = s.pop();
-        Object a = s.pop();
-        Object result = binary_numeric(a, b,
-            [](const Integer& x, const Integer& y) -> Integer { return x > y ? x : y; },
-            [](const Rational& x, const Rational& y) -> Rational { return x > y ? x : y; },
-            [](const Real& x, const Real& y) -> Real { return x > y ? x : y; },
-            [](const Complex&, const Complex&) -> Complex {
-                throw std::runtime_error("Bad argument type");
-            });
-        s.push(result);
-    });
-
-    register_command("SIGN", [](Store& s, Context&) {
-        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
-        Object a = s.pop();
-        if (std::holds_alternative<Integer>(a)) {
-            auto& v = std::get<Integer>(a);
-            s.push(Integer(v > 0 ? 1 : (v < 0 ? -1 : 0)));
-        } else if (std::holds_alternative<Real>(a)) {
-            auto& v = std::get<Real>(a);
-            s.push(Integer(v > 0 ? 1 : (v < 0 ? -1 : 0)));
-        } else if (std::holds_alternative<Rational>(a)) {
-            auto& v = std::get<Rational>(a);
-            s.push(Integer(v > 0 ? 1 : (v < 0 ? -1 : 0)));
+    register_function("MIN", 2, [](const Args& args, Context&) -> Object {
+        const Object& a = args[0];
+        const Object& b = args[1];
+        return numeric_dispatch(Object(a), b, [](auto&& x, const auto& y) -> Object {
+            using T = std::decay_t<decltype(x)>;
+            if constexpr (std::is_same_v<T, Complex>) throw std::runtime_error("Bad argument type");
+            else return y < x ? T(y) : std::move(x);
+        }, bad_argument_type);
+    });
+
+    register_function("MAX", 2, [](const Args& args, Context&) -> Object {
+        const Object& a = args[0];
+        const Object& b = args[1];
+        return numeric_dispatch(Object(a), b, [](auto&& x, const auto& y) -> Object {
+            using T = std::decay_t<decltype(x)>;
+            if constexpr (std::is_same_v<T, Complex>) throw std::runtime_error("Bad argument type");
+            else return y > x ? T(y) : std::move(x);
+        }, bad_argument_type);
+    });
+
+    register_function("SIGN", 1, [](const Args& args, Context&) -> Object {
+        const Object& a = args[0];
+        if (holds_alternative<Integer>(a)) {
+            auto& v = get<Integer>(a);
+            return Integer(v > 0 ? 1 : (v < 0 ? -1 : 0));
+        } else if (holds_alternative<Real>(a)) {
+            auto& v = get<Real>(a);
+            return Integer(v > 0 ? 1 : (v < 0 ? -1 : 0));
+        } else if (holds_alternative<Rational>(a)) {
+            auto& v = get<Rational>(a);
+            return Integer(v > 0 ? 1 : (v < 0 ? -1 : 0));
         } else {
             throw std::runtime_error("Bad argument type");
         }
     });
 
     // Combinatorics
-    // Factorial (!)
-    register_command("!", [](Store& s, Context&) {
-        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
-        Object a = s.pop();
-        if (!std::holds_alternative<Integer>(a))
+    // Integers are exact (see core/combinatorics.hpp); a Real or Rational
+    // argument goes through the gamma function.
+    auto gamma_arg = [](const Object& a) -> Real {
+        if (holds_alternative<Real>(a) || holds_alternative<Rational>(a))
+            return to_real_value(a);
+        throw std::runtime_error("Bad argument type");
+    };
+    auto int_arg = [](const Object& a) -> const Integer* {
+        return holds_alternative<Integer>(a) ? &get<Integer>(a) : nullptr;
+    };
+
+    // Factorial (!): n! for an Integer, GAMMA(x+1) otherwise
+    register_function("!", 1, [=](const Args& args, Context&) -> Object {
+        if (const Integer* n = int_arg(args[0])) {
+            if (*n < 0 || *n > kMaxCombinatoricN) throw std::runtime_error("Bad argument value");
+            return factorial(n->convert_to<uint64_t>());
+        }
+        return gamma_real(gamma_arg(args[0]) + 1);
+    });
+
+    register_function("GAMMA", 1, [](const Args& args, Context&) -> Object {
+        if (numeric_rank(args[0]) < 0 || numeric_rank(args[0]) > 2)
             throw std::runtime_error("Bad argument type");
-        auto n = std::get<Integer>(a);
-        if (n < 0) throw std::runtime_error("Bad argument value");
-        Integer result = 1;
-        for (Integer i = 2; i <= n; ++i) result *= i;
-        s.push(result);
+        return gamma_real(to_real_value(args[0]));
     });
 
     // COMB(n, k) = n! / (k! * (n-k)!)
-    register_command("COMB", [](Store& s, Context&) {
-        if (s.depth() < 2) throw std::runtime_error("Too few arguments");
-        Object k_obj = s.pop();
-        Object n_obj = s.pop();
-        if (!std::holds_alternative<Integer>(n_obj) || !std::holds_alternative<Integer>(k_obj))
-            throw std::runtime_error("Bad argument type");
-        auto n = std::get<Integer>(n_obj);
-        auto k = std::get<Integer>(k_obj);
-        if (n < 0 || k < 0 || k > n) throw std::runtime_error("Bad argument value");
-        // Use iterative approach to avoid overflow
-        if (k > n - k) k = n - k;
-        Integer result = 1;
-        for (Integer i = 0; i < k; ++i) {
-            result = result * (n - i) / (i + 1);
+    register_function("COMB", 2, [=](const Args& args, Context&) -> Object {
+        const Integer* n = int_arg(args[0]);
+        const Integer* k = int_arg(args[1]);
+        if (n && k) {
+            if (*n < 0 || *k < 0 || *k > *n) throw std::runtime_error("Bad argument value");
+            return binomial(*n, *k);
         }
-        s.push(result);
+        Real rn = n ? Real(*n) : gamma_arg(args[0]);
+        Real rk = k ? Real(*k) : gamma_arg(args[1]);
+        return Real(gamma_real(rn + 1) / (gamma_real(rk + 1) * gamma_real(rn - rk + 1)));
     });
 
     // PERM(n, k) = n! / (n-k)!
-    register_command("PERM", [](Store& s, Context&) {
-        if (s.depth() < 2) throw std::runtime_error("Too few arguments");
-        Object k_obj = s.pop();
-        Object n_obj = s.pop();
-        if (!std::holds_alternative<Integer>(n_obj) || !std::holds_alternative<Integer>(k_obj))
-            throw std::runtime_error("Bad argument type");
-        auto n = std::get<Integer>(n_obj);
-        auto k = std::get<Integer>(k_obj);
-        if (n < 0 || k < 0 || k > n) throw std::runtime_error("Bad argument value");
-        Integer result = 1;
-        for (Integer i = 0; i < k; ++i) {
-            result *= (n - i);
+    register_function("PERM", 2, [=](const Args& args, Context&) -> Object {
+        const Integer* n = int_arg(args[0]);
+        const Integer* k = int_arg(args[1]);
+        if (n && k) {
+            if (*n < 0 || *k < 0 || *k > *n) throw std::runtime_error("Bad argument value");
+            return falling_factorial(*n, *k);
         }
-        s.push(result);
+        Real rn = n ? Real(*n) : gamma_arg(args[0]);
+        Real rk = k ? Real(*k) : gamma_arg(args[1]);
+        return Real(gamma_real(rn + 1) / gamma_real(rn - rk + 1));
+    });
+
+    // MULTINOM: ( { k1 k2 ... } -- (k1+k2+...)! / (k1! k2! ...) )
+    register_command("MULTINOM", [](Store& s, Context&) {
+        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
+        Object lst = s.pop();
+        if (!holds_alternative<List>(lst)) throw std::runtime_error("Bad argument type");
+        std::vector<uint64_t> ks;
+        for (const auto& item : get<List>(lst).items) {
+            if (!holds_alternative<Integer>(item)) throw std::runtime_error("Bad argument type");
+            const Integer& k = get<Integer>(item);
+            if (k < 0 || k > kMaxCombinatoricN) throw std::runtime_error("Bad argument value");
+            ks.push_back(k.convert_to<uint64_t>());
+        }
+        s.push(multinomial(ks));
     });
 
     // Percentage commands
-    register_command("%", [](Store& s, Context&) {
-        if (s.depth() < 2) throw std::runtime_error("Too few arguments");
-        Object b = s.pop();
-        Object a = s.pop();
-        s.push(Real(to_double_value(a) * to_double_value(b) / 100.0));
+    register_function("%", 2, [](const Args& args, Context&) -> Object {
+        const Object& a = args[0];
+        const Object& b = args[1];
+        return Real(to_double_value(a) * to_double_value(b) / 100.0);
     });
 
-    register_command("%T", [](Store& s, Context&) {
-        if (s.depth() < 2) throw std::runtime_error("Too few arguments");
-        Object b = s.pop();
-        Object a = s.pop();
+    register_function("%T", 2, [](const Args& args, Context&) -> Object {
+        const Object& a = args[0];
+        const Object& b = args[1];
         double total = to_double_value(a);
         if (total == 0) throw std::runtime_error("Division by zero");
-        s.push(Real(to_double_value(b) / total * 100.0));
+        return Real(to_double_value(b) / total * 100.0);
     });
 
-    register_command("%CH", [](Store& s, Context&) {
-        if (s.depth() < 2) throw std::runtime_error("Too few arguments");
-        Object b = s.pop();
-        Object a = s.pop();
+    register_function("%CH", 2, [](const Args& args, Context&) -> Object {
+        const Object& a = args[0];
+        const Object& b = args[1];
         double old_val = to_double_value(a);
         if (old_val == 0) throw std::runtime_error("Division by zero");
-        s.push(Real((to_double_value(b) - old_val) / old_val * 100.0));
+        return Real((to_double_value(b) - old_val) / old_val * 100.0);
     });
 
     // Angle conversion
-    auto d2r_fn = [](Store& s, Context&) {
-        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
-        Object a = s.pop();
-        s.push(Real(to_double_value(a) * 3.14159265358979323846 / 180.0));
+    auto d2r_fn = [](const Args& args, Context&) -> Object {
+        return round_digits(to_real_value(args[0]) * pi_real() / 180, kMaxPrecision);
     };
-    register_command("D->R", d2r_fn);
-    register_command("D" "\xe2\x86\x92" "R", d2r_fn);
+    register_function("D->R", 1, d2r_fn);
+    register_function("D" "\xe2\x86\x92" "R", 1, d2r_fn);
 
-    auto r2d_fn = [](Store& s, Context&) {
-        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
-        Object a = s.pop();
-        s.push(Real(to_double_value(a) * 180.0 / 3.14159265358979323846));
+    auto r2d_fn = [](const Args& args, Context&) -> Object {
+        return round_digits(to_real_value(args[0]) * 180 / pi_real(), kMaxPrecision);
     };
-    register_command("R->D", r2d_fn);
-    register_command("R" "\xe2\x86\x92" "D", r2d_fn);
+    register_function("R->D", 1, r2d_fn);
+    register_function("R" "\xe2\x86\x92" "D", 1, r2d_fn);
+}
+
+// ---- Number Theory Commands ----
+
+namespace {
+
+const Integer& integer_arg(const Object& obj) {
+    if (!holds_alternative<Integer>(obj)) throw std::runtime_error("Bad argument type");
+    return get<Integer>(obj);
+}
+
+} // anonymous namespace
+
+void CommandRegistry::register_number_theory_commands() {
+    // ISPRIME?: ( n -- 0|1 )
+    register_function("ISPRIME?", 1, [](const Args& args, Context&) -> Object {
+        return Integer(is_probable_prime(integer_arg(args[0])) ? 1 : 0);
+    });
+
+    register_function("NEXTPRIME", 1, [](const Args& args, Context&) -> Object {
+        return next_prime(integer_arg(args[0]));
+    });
+
+    register_function("PREVPRIME", 1, [](const Args& args, Context&) -> Object {
+        return prev_prime(integer_arg(args[0]));
+    });
+
+    // FACTORS: ( n -- { p1 e1 p2 e2 ... } )
+    // Prime factorization of |n| in increasing order; { } for 1.
+    register_command("FACTORS", [](Store& s, Context&) {
+        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
+        Object n = s.pop();
+        List result;
+        for (auto& [p, e] : factorize(integer_arg(n))) {
+            result.items.push_back(p);
+            result.items.push_back(Integer(e));
+        }
+        s.push(std::move(result));
+    });
+
+    register_function("GCD", 2, [](const Args& args, Context&) -> Object {
+        return gcd_binary(integer_arg(args[0]), integer_arg(args[1]));
+    });
+
+    register_function("LCM", 2, [](const Args& args, Context&) -> Object {
+        return lcm_binary(integer_arg(args[0]), integer_arg(args[1]));
+    });
+
+    // POWMOD: ( a e m -- a^e mod m )
+    register_function("POWMOD", 3, [](const Args& args, Context&) -> Object {
+        return pow_mod(integer_arg(args[0]), integer_arg(args[1]), integer_arg(args[2]));
+    });
+
+    // INVMOD: ( a m -- x ) with a*x = 1 mod m
+    register_function("INVMOD", 2, [](const Args& args, Context&) -> Object {
+        return inv_mod(integer_arg(args[0]), integer_arg(args[1]));
+    });
 }
 
 // ---- String Manipulation Commands ----
@@ -1812,17 +1912,17 @@ void CommandRegistry::register_string_commands() {
     register_command("SIZE", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object a = s.pop();
-        if (!std::holds_alternative<String>(a))
+        if (!holds_alternative<String>(a))
             throw std::runtime_error("Bad argument type");
-        s.push(Integer(static_cast<int>(std::get<String>(a).value.size())));
+        s.push(Integer(static_cast<int>(get<String>(a).value.size())));
     });
 
     register_command("HEAD", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object a = s.pop();
-        if (!std::holds_alternative<String>(a))
+        if (!holds_alternative<String>(a))
             throw std::runtime_error("Bad argument type");
-        auto& str = std::get<String>(a).value;
+        auto& str = get<String>(a).value;
         if (str.empty()) throw std::runtime_error("Bad argument value");
         s.push(String{str.substr(0, 1)});
     });
@@ -1830,9 +1930,9 @@ void CommandRegistry::register_string_commands() {
     register_command("TAIL", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object a = s.pop();
-        if (!std::holds_alternative<String>(a))
+        if (!holds_alternative<String>(a))
             throw std::runtime_error("Bad argument type");
-        auto& str = std::get<String>(a).value;
+        auto& str = get<String>(a).value;
         if (str.empty()) throw std::runtime_error("Bad argument value");
         s.push(String{str.substr(1)});
     });
@@ -1843,13 +1943,13 @@ void CommandRegistry::register_string_commands() {
         Object end_obj = s.pop();
         Object start_obj = s.pop();
         Object str_obj = s.pop();
-        if (!std::holds_alternative<String>(str_obj) ||
-            !std::holds_alternative<Integer>(start_obj) ||
-            !std::holds_alternative<Integer>(end_obj))
+        if (!holds_alternative<String>(str_obj) ||
+            !holds_alternative<Integer>(start_obj) ||
+            !holds_alternative<Integer>(end_obj))
             throw std::runtime_error("Bad argument type");
-        auto& str = std::get<String>(str_obj).value;
-        int start = static_cast<int>(std::get<Integer>(start_obj));
-        int end = static_cast<int>(std::get<Integer>(end_obj));
+        auto& str = get<String>(str_obj).value;
+        int start = static_cast<int>(get<Integer>(start_obj));
+        int end = static_cast<int>(get<Integer>(end_obj));
         if (start < 1) start = 1;
         if (end > static_cast<int>(str.size())) end = static_cast<int>(str.size());
         if (start > end) {
@@ -1864,11 +1964,11 @@ void CommandRegistry::register_string_commands() {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object search_obj = s.pop();
         Object str_obj = s.pop();
-        if (!std::holds_alternative<String>(str_obj) ||
-            !std::holds_alternative<String>(search_obj))
+        if (!holds_alternative<String>(str_obj) ||
+            !holds_alternative<String>(search_obj))
             throw std::runtime_error("Bad argument type");
-        auto& str = std::get<String>(str_obj).value;
-        auto& search = std::get<String>(search_obj).value;
+        auto& str = get<String>(str_obj).value;
+        auto& search = get<String>(search_obj).value;
         auto pos = str.find(search);
         s.push(Integer(pos == std::string::npos ? 0 : static_cast<int>(pos) + 1));
     });
@@ -1879,13 +1979,13 @@ void CommandRegistry::register_string_commands() {
         Object repl_obj = s.pop();
         Object search_obj = s.pop();
         Object str_obj = s.pop();
-        if (!std::holds_alternative<String>(str_obj) ||
-            !std::holds_alternative<String>(search_obj) ||
-            !std::holds_alternative<String>(repl_obj))
+        if (!holds_alternative<String>(str_obj) ||
+            !holds_alternative<String>(search_obj) ||
+            !holds_alternative<String>(repl_obj))
             throw std::runtime_error("Bad argument type");
-        std::string result = std::get<String>(str_obj).value;
-        auto& search = std::get<String>(search_obj).value;
-        auto& repl = std::get<String>(repl_obj).value;
+        std::string result = get<String>(str_obj).value;
+        auto& search = get<String>(search_obj).value;
+        auto& repl = get<String>(repl_obj).value;
         auto pos = result.find(search);
         if (pos != std::string::npos) {
             result.replace(pos, search.size(), repl);
@@ -1897,9 +1997,9 @@ void CommandRegistry::register_string_commands() {
     register_command("NUM", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object a = s.pop();
-        if (!std::holds_alternative<String>(a))
+        if (!holds_alternative<String>(a))
             throw std::runtime_error("Bad argument type");
-        auto& str = std::get<String>(a).value;
+        auto& str = get<String>(a).value;
         if (str.empty()) throw std::runtime_error("Bad argument value");
         s.push(Integer(static_cast<unsigned char>(str[0])));
     });
@@ -1908,9 +2008,9 @@ void CommandRegistry::register_string_commands() {
     register_command("CHR", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object a = s.pop();
-        if (!std::holds_alternative<Integer>(a))
+        if (!holds_alternative<Integer>(a))
             throw std::runtime_error("Bad argument type");
-        int cp = static_cast<int>(std::get<Integer>(a));
+        int cp = static_cast<int>(get<Integer>(a));
         if (cp < 0 || cp > 127) throw std::runtime_error("Bad argument value");
         s.push(String{std::string(1, static_cast<char>(cp))});
     });
@@ -1920,63 +2020,165 @@ void CommandRegistry::register_string_commands() {
 
 void CommandRegistry::register_symbolic_commands() {
     // SUBST: ( 'expr' 'var' 'replacement' -- 'result' )
-    // Tokenize expr, replace matching Name tokens with replacement, reconstruct string.
+    // Rebuild the expression tree with matching Name nodes replaced; subtrees
+    // without the variable are shared, and parentheses come from the renderer.
+    // A List or Matrix of expressions is substituted element by element, with
+    // the replacement tree built once.
     register_command("SUBST", [](Store& s, Context&) {
         if (s.depth() < 3) throw std::runtime_error("Too few arguments");
         Object repl_obj = s.pop();  // level 1: replacement
         Object var_obj = s.pop();   // level 2: variable name
         Object expr_obj = s.pop();  // level 3: expression
 
-        if (!std::holds_alternative<Symbol>(expr_obj) && !std::holds_alternative<Name>(expr_obj))
+        if (!holds_alternative<Name>(var_obj))
             throw std::runtime_error("Bad argument type");
-        if (!std::holds_alternative<Name>(var_obj))
+        const std::string& var = get<Name>(var_obj).value;
+        ExprPtr repl = object_expr_tree(repl_obj);
+
+        auto subst_one = [&](const Object& e) -> Object {
+            if (holds_alternative<Symbol>(e) || holds_alternative<Name>(e))
+                return Symbol{expr_substitute(object_expr_tree(e), var, repl)};
+            if (is_numeric(e)) return e;
+            throw std::runtime_error("Bad argument type");
+        };
+
+        if (holds_alternative<List>(expr_obj)) {
+            List result;
+            for (const auto& item : get<List>(expr_obj).items) result.items.push_back(subst_one(item));
+            s.push(std::move(result));
+        } else if (holds_alternative<Matrix>(expr_obj)) {
+            Matrix result;
+            for (const auto& row : get<Matrix>(expr_obj).rows) {
+                result.rows.emplace_back();
+                for (const auto& item : row) result.rows.back().push_back(subst_one(item));
+            }
+            s.push(std::move(result));
+        } else if (holds_alternative<Symbol>(expr_obj) || holds_alternative<Name>(expr_obj)) {
+            s.push(subst_one(expr_obj));
+        } else {
             throw std::runtime_error("Bad argument type");
+        }
+    });
 
-        std::string expr_str = to_expr_string(expr_obj);
-        std::string var_name = std::get<Name>(var_obj).value;
-        std::string repl_str = to_expr_string(repl_obj);
+    // TABULATE: ( 'expr' vars inputs -- results )
+    // Compile the expression once to a double evaluator over `vars` (a Name
+    // or a List of Names), then run it over every input point. With one
+    // variable, inputs are a List of numbers or a Matrix, and the result has
+    // the same shape. With k variables, each point is a k-element List or a
+    // Matrix row, and the result is a List with one Real per point.
+    register_command("TABULATE", [](Store& s, Context& ctx) {
+        if (s.depth() < 3) throw std::runtime_error("Too few arguments");
+        Object in_obj = s.pop();
+        Object vars_obj = s.pop();
+        Object expr_obj = s.pop();
+        if (!holds_alternative<Symbol>(expr_obj) && !holds_alternative<Name>(expr_obj))
+            throw std::runtime_error("Bad argument type");
 
-        auto tokens = tokenize_expression(expr_str);
+        std::vector<std::string> vars;
+        if (holds_alternative<Name>(vars_obj)) {
+            vars.push_back(get<Name>(vars_obj).value);
+        } else if (holds_alternative<List>(vars_obj)) {
+            for (const auto& v : get<List>(vars_obj).items) {
+                if (!holds_alternative<Name>(v)) throw std::runtime_error("Bad argument type");
+                vars.push_back(get<Name>(v).value);
+            }
+        } else {
+            throw std::runtime_error("Bad argument type");
+        }
+        if (vars.empty()) throw std::runtime_error("Bad argument value");
+        size_t k = vars.size();
 
-        // Reconstruct, replacing matching Name tokens
-        std::string result;
-        for (size_t i = 0; i < tokens.size(); ++i) {
-            auto& tok = tokens[i];
-            if (tok.type == ExprTokenType::Name && tok.value == var_name) {
-                // Check if replacement needs parentheses:
-                // Determine the context precedence by looking at surrounding operators
-                int ctx_prec = 0;
-                // Look backwards for an operator
-                for (int j = static_cast<int>(i) - 1; j >= 0; --j) {
-                    if (tokens[j].type == ExprTokenType::Op) {
-                        ctx_prec = precedence(tokens[j].value);
-                        break;
-                    }
-                    if (tokens[j].type != ExprTokenType::RParen) break;
-                }
-                // Look forward for an operator
-                for (size_t j = i + 1; j < tokens.size(); ++j) {
-                    if (tokens[j].type == ExprTokenType::Op) {
-                        int fwd_prec = precedence(tokens[j].value);
-                        if (fwd_prec > ctx_prec) ctx_prec = fwd_prec;
-                        break;
-                    }
-                    if (tokens[j].type != ExprTokenType::LParen) break;
+        // Flatten the input points, row-major
+        std::vector<double> args;
+        auto add_point = [&](const std::vector<Object>& coords) {
+            if (coords.size() != k) throw std::runtime_error("Dimension mismatch");
+            for (const auto& c : coords) args.push_back(to_double_value(c));
+        };
+        size_t rows = 0, cols = 0;
+        bool matrix_out = false;
+        if (holds_alternative<List>(in_obj)) {
+            const auto& items = get<List>(in_obj).items;
+            args.reserve(items.size() * k);
+            for (const auto& item : items) {
+                if (k == 1) {
+                    args.push_back(to_double_value(item));
+                } else if (holds_alternative<List>(item)) {
+                    add_point(get<List>(item).items);
+                } else {
+                    throw std::runtime_error("Bad argument type");
                 }
-
-                if (needs_parens(repl_str, ctx_prec)) {
-                    result += "(" + repl_str + ")";
+            }
+        } else if (holds_alternative<Matrix>(in_obj)) {
+            const auto& m = get<Matrix>(in_obj).rows;
+            rows = m.size();
+            cols = rows ? m[0].size() : 0;
+            matrix_out = k == 1;
+            args.reserve(rows * cols);
+            for (const auto& row : m) {
+                if (k == 1) {
+                    for (const auto& c : row) args.push_back(to_double_value(c));
                 } else {
-                    result += repl_str;
+                    add_point(row);
                 }
-            } else if (tok.type == ExprTokenType::Comma) {
-                result += ", ";
-            } else {
-                result += tok.value;
             }
+        } else {
+            throw std::runtime_error("Bad argument type");
         }
 
-        s.push(Symbol{result});
+        NumericFunction fn = lambdify(object_expr_tree(expr_obj), vars, ctx);
+        size_t n = args.size() / k;
+        std::vector<double> out(n);
+        fn.evaluate(args.data(), n, out.data());
+
+        auto to_real = [](double v) -> Object {
+            if (!std::isfinite(v)) throw std::runtime_error("Bad argument value");
+            return Real(v);
+        };
+        if (matrix_out) {
+            Matrix result;
+            result.rows.resize(rows);
+            for (size_t r = 0; r < rows; ++r) {
+                result.rows[r].reserve(cols);
+                for (size_t c = 0; c < cols; ++c) result.rows[r].push_back(to_real(out[r * cols + c]));
+            }
+            s.push(std::move(result));
+        } else {
+            List result;
+            result.items.reserve(n);
+            for (double v : out) result.items.push_back(to_real(v));
+            s.push(std::move(result));
+        }
+    });
+
+    // PLOTDATA: ( f 'var' xmin xmax -- { [[ x y ]...] ... } )
+    // Adaptive samples of a Symbol or Program over [xmin, xmax], one Matrix
+    // of points per continuous segment. Hosts wanting a packed buffer use
+    // lpr_plot_data() instead.
+    register_command("PLOTDATA", [](Store& s, Context& ctx) {
+        if (s.depth() < 4) throw std::runtime_error("Too few arguments");
+        Object xmax_obj = s.pop();
+        Object xmin_obj = s.pop();
+        Object var_obj = s.pop();
+        Object fn_obj = s.pop();
+        if (!holds_alternative<Name>(var_obj)) throw std::runtime_error("Bad argument type");
+        double xmin = to_double_value(xmin_obj);
+        double xmax = to_double_value(xmax_obj);
+
+        auto fn = plot_function(fn_obj, get<Name>(var_obj).value, ctx);
+        std::vector<double> xy = sample_plot(fn, xmin, xmax);
+
+        List segments;
+        Matrix current;
+        for (size_t i = 0; i < xy.size(); i += 2) {
+            if (std::isnan(xy[i + 1])) {
+                if (!current.rows.empty()) segments.items.push_back(std::move(current));
+                current = Matrix{};
+                continue;
+            }
+            current.rows.push_back({Real(xy[i]), Real(xy[i + 1])});
+        }
+        if (!current.rows.empty()) segments.items.push_back(std::move(current));
+        s.push(std::move(segments));
     });
 
     // STASH: pop 1 item from stack, store as single-item group on stash
@@ -1990,9 +2192,9 @@ void CommandRegistry::register_symbolic_commands() {
     register_command("STASHN", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object n_obj = s.pop();
-        if (!std::holds_alternative<Integer>(n_obj))
+        if (!holds_alternative<Integer>(n_obj))
             throw std::runtime_error("Bad argument type");
-        int n = static_cast<int>(std::get<Integer>(n_obj));
+        int n = static_cast<int>(get<Integer>(n_obj));
         if (n < 0 || s.depth() < n) throw std::runtime_error("Too few arguments");
 
         // Pop N items (level 1 first = last in group)
@@ -2013,152 +2215,45 @@ void CommandRegistry::register_symbolic_commands() {
 
     // EXPLODE: decompose a Symbol's top-level operation into operands + operator
     // ( 'expr' -- operand1 [operand2 ...] « operator » )
-    register_command("EXPLODE", [](Store& s, Context& ctx) {
+    // Operands are subtrees of the Symbol's tree, so nothing is re-parsed.
+    register_command("EXPLODE", [](Store& s, Context&) {
+        using Kind = ExprNode::Kind;
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object obj = s.pop();
-        if (!std::holds_alternative<Symbol>(obj))
-            throw std::runtime_error("Bad argument type");
-        std::string expr = std::get<Symbol>(obj).value;
-        auto tokens = tokenize_expression(expr);
-
-        if (tokens.empty()) throw std::runtime_error("Cannot EXPLODE empty expression");
-
-        // Check for function-call pattern: NAME(args)
-        if (tokens.size() >= 3 &&
-            tokens[0].type == ExprTokenType::Name &&
-            tokens[1].type == ExprTokenType::LParen &&
-            tokens.back().type == ExprTokenType::RParen) {
-            std::string func_name = tokens[0].value;
-            // Split arguments by commas at paren depth 1 (the outer parens of the call)
-            std::vector<std::string> args;
-            std::string current_arg;
-            int depth = 0;
-            for (size_t i = 2; i < tokens.size() - 1; ++i) {
-                auto& tok = tokens[i];
-                if (tok.type == ExprTokenType::LParen) ++depth;
-                if (tok.type == ExprTokenType::RParen) --depth;
-                if (tok.type == ExprTokenType::Comma && depth == 0) {
-                    // Trim whitespace from arg
-                    args.push_back(current_arg);
-                    current_arg.clear();
-                } else {
-                    current_arg += tok.value;
-                }
-            }
-            if (!current_arg.empty()) {
-                args.push_back(current_arg);
-            }
-
-            // Push each argument as the appropriate type
-            for (auto& arg : args) {
-                // Try to parse as integer
-                bool is_number = true;
-                bool has_dot = false;
-                for (size_t ci = 0; ci < arg.size(); ++ci) {
-                    char c = arg[ci];
-                    if (c == '-' && ci == 0) continue;
-                    if (c == '.' && !has_dot) { has_dot = true; continue; }
-                    if (!std::isdigit(static_cast<unsigned char>(c))) { is_number = false; break; }
-                }
-                if (is_number && !arg.empty() && arg != "-") {
-                    s.push(Symbol{arg});
-                } else {
-                    // Check if it's a simple name (no operators)
-                    auto arg_tokens = tokenize_expression(arg);
-                    if (arg_tokens.size() == 1 && arg_tokens[0].type == ExprTokenType::Name) {
-                        s.push(Name{arg_tokens[0].value});
-                    } else {
-                        s.push(Symbol{arg});
-                    }
-                }
-            }
+        if (!holds_alternative<Symbol>(obj))
+            throw std::runtime_error("Bad argument type");
+        ExprPtr node = get<Symbol>(obj).tree();
 
-            // Push function as a Program
-            s.push(Program{{Token::make_command(func_name)}});
-            return;
-        }
+        // Fully-parenthesized expression: explode what is inside
+        while (node->kind == Kind::Group) node = node->kids[0];
 
-        // Find the lowest-precedence operator at paren depth 0
-        int min_prec = 100;
-        int min_idx = -1;
-        int paren_depth = 0;
-
-        for (int i = 0; i < static_cast<int>(tokens.size()); ++i) {
-            auto& tok = tokens[i];
-            if (tok.type == ExprTokenType::LParen) { ++paren_depth; continue; }
-            if (tok.type == ExprTokenType::RParen) { --paren_depth; continue; }
-            if (paren_depth > 0) continue;
-
-            if (tok.type == ExprTokenType::Op && tok.value != "NEG") {
-                int p = precedence(tok.value);
-                // For left-to-right (non-right-assoc), take the LAST (rightmost) occurrence
-                // at the minimum precedence level so we peel left-to-right.
-                // For right-to-left, take the first occurrence.
-                if (p < min_prec) {
-                    min_prec = p;
-                    min_idx = i;
-                } else if (p == min_prec && !is_right_assoc(tok.value)) {
-                    min_idx = i;  // rightmost for left-associative
-                }
+        // Bare names become Names; anything else stays a Symbol
+        auto push_operand = [&s](const ExprPtr& operand) {
+            if (operand->kind == Kind::Name) {
+                s.push(Name{operand->text});
+            } else {
+                s.push(Symbol{operand});
             }
-        }
+        };
 
-        // Handle unary NEG at depth 0
-        if (min_idx < 0) {
-            // Check for unary NEG
-            if (tokens.size() >= 2 && tokens[0].type == ExprTokenType::Op && tokens[0].value == "NEG") {
-                // Unary negation: push operand and NEG program
-                std::string operand_str;
-                for (size_t i = 1; i < tokens.size(); ++i) {
-                    operand_str += tokens[i].value;
-                }
-                auto operand_tokens = tokenize_expression(operand_str);
-                if (operand_tokens.size() == 1 && operand_tokens[0].type == ExprTokenType::Name) {
-                    s.push(Name{operand_tokens[0].value});
-                } else {
-                    s.push(Symbol{operand_str});
-                }
+        switch (node->kind) {
+            case Kind::Call:
+                for (const auto& arg : node->kids) push_operand(arg);
+                s.push(Program{{Token::make_command(node->text)}});
+                return;
+            case Kind::Neg:
+                push_operand(node->kids[0]);
                 s.push(Program{{Token::make_command("NEG")}});
                 return;
-            }
-
-            // Atomic expression or fully-parenthesized — strip outer parens and re-explode
-            if (tokens.size() >= 2 &&
-                tokens[0].type == ExprTokenType::LParen &&
-                tokens.back().type == ExprTokenType::RParen) {
-                std::string inner;
-                for (size_t i = 1; i + 1 < tokens.size(); ++i) {
-                    inner += tokens[i].value;
-                }
-                s.push(Symbol{inner});
-                ctx.execute_tokens({Token::make_command("EXPLODE")});
+            case Kind::Add: case Kind::Sub: case Kind::Mul:
+            case Kind::Div: case Kind::Pow:
+                push_operand(node->kids[0]);
+                push_operand(node->kids[1]);
+                s.push(Program{{Token::make_command(binary_op_text(node->kind))}});
                 return;
-            }
-
-            throw std::runtime_error("Cannot EXPLODE atomic expression");
+            default:
+                throw std::runtime_error("Cannot EXPLODE atomic expression");
         }
-
-        // Binary operator found — extract left and right operands
-        std::string left_str, right_str;
-        for (int i = 0; i < min_idx; ++i) left_str += tokens[i].value;
-        for (int i = min_idx + 1; i < static_cast<int>(tokens.size()); ++i) right_str += tokens[i].value;
-        std::string op = tokens[min_idx].value;
-
-        // Push left operand
-        auto push_operand = [&s](const std::string& str) {
-            auto toks = tokenize_expression(str);
-            if (toks.size() == 1 && toks[0].type == ExprTokenType::Name) {
-                s.push(Name{toks[0].value});
-            } else {
-                s.push(Symbol{str});
-            }
-        };
-
-        push_operand(left_str);
-        push_operand(right_str);
-
-        // Push operator as a Program
-        s.push(Program{{Token::make_command(op)}});
     });
 
     // ASSEMBLE: loop while stash non-empty — UNSTASH then EVAL level 1
@@ -2181,8 +2276,8 @@ void CommandRegistry::register_symbolic_commands() {
             }
             // EVAL the top of stack (should be a Program from EXPLODE)
             Object top = s.pop();
-            if (std::holds_alternative<Program>(top)) {
-                ctx.execute_tokens(std::get<Program>(top).tokens);
+            if (holds_alternative<Program>(top)) {
+                ctx.execute_tokens(get<Program>(top).tokens);
             } else {
                 s.push(top);
             }
@@ -2190,6 +2285,197 @@ void CommandRegistry::register_symbolic_commands() {
     });
 }
 
+// ---- Polynomial Commands ----
+// Polynomials are coefficient Lists, highest degree first (see core/poly.hpp).
+// They are computed natively, without the CAS bridge.
+
+namespace {
+
+const List& coeff_list(const Object& obj) {
+    if (!holds_alternative<List>(obj)) throw std::runtime_error("Bad argument type");
+    return get<List>(obj);
+}
+
+// Calls f with both polynomials as ExactPolys when every coefficient is
+// exact, else as RealPolys.
+template <typename F>
+void with_polys(const Object& a, const Object& b, F f) {
+    const List& la = coeff_list(a);
+    const List& lb = coeff_list(b);
+    bool exact_a = is_exact_poly(la);
+    bool exact_b = is_exact_poly(lb);
+    if (exact_a && exact_b) {
+        f(to_exact_poly(la), to_exact_poly(lb));
+    } else {
+        f(to_real_poly(la), to_real_poly(lb));
+    }
+}
+
+} // anonymous namespace
+
+void CommandRegistry::register_polynomial_commands() {
+    // PEVAL: ( coeffs x -- p(x) )
+    // Horner evaluation at a number, a Complex, or each element of a List.
+    // Exact coefficients at an exact point give an exact result; a Name or
+    // Symbol point gives the expanded expression.
+    register_command("PEVAL", [](Store& s, Context&) {
+        if (s.depth() < 2) throw std::runtime_error("Too few arguments");
+        Object x = s.pop();
+        Object p = s.pop();
+        const List& coeffs = coeff_list(p);
+        bool exact = is_exact_poly(coeffs);
+        std::optional<ExactPoly> exact_poly;
+        std::optional<RealPoly> real_poly;
+        auto as_real = [&]() -> const RealPoly& {
+            if (!real_poly) real_poly = to_real_poly(coeffs);
+            return *real_poly;
+        };
+        auto eval_at = [&](const Object& at) -> Object {
+            if (is_symbolic(at)) return Symbol{poly_to_expr(coeffs, object_expr_tree(at))};
+            if (holds_alternative<Complex>(at)) return eval_complex(as_real(), get<Complex>(at));
+            if (exact && numeric_rank(at) <= 1 && numeric_rank(at) >= 0) {
+                if (!exact_poly) exact_poly = to_exact_poly(coeffs);
+                return exact_coeff((*exact_poly)(get<Rational>(promote(at, 1))));
+            }
+            return Real(as_real()(to_real_value(at)));
+        };
+        if (holds_alternative<List>(x)) {
+            List out;
+            out.items.reserve(get<List>(x).items.size());
+            for (const auto& at : get<List>(x).items) out.items.push_back(eval_at(at));
+            s.push(std::move(out));
+        } else {
+            s.push(eval_at(x));
+        }
+    });
+
+    // PROOT: ( coeffs -- { roots } )
+    // All roots with multiplicity: exact when rational, else Real or Complex.
+    register_command("PROOT", [](Store& s, Context&) {
+        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
+        Object p = s.pop();
+        const List& coeffs = coeff_list(p);
+        List roots;
+        roots.items = is_exact_poly(coeffs) ? poly_roots(to_exact_poly(coeffs))
+                                            : poly_roots(to_real_poly(coeffs));
+        s.push(std::move(roots));
+    });
+
+    // PCOEF: ( { roots } -- coeffs )
+    // The monic polynomial with the given roots. Complex roots multiply out
+    // at Real precision; coefficients whose imaginary parts cancel are Real.
+    register_command("PCOEF", [](Store& s, Context&) {
+        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
+        Object r = s.pop();
+        const auto& roots = coeff_list(r).items;
+        bool complex = false;
+        for (const auto& root : roots) {
+            if (holds_alternative<Complex>(root)) {
+                complex = true;
+            } else if (numeric_rank(root) < 0) {
+                throw std::runtime_error("Bad argument type");
+            }
+        }
+        if (!complex) {
+            List root_list{roots};
+            if (is_exact_poly(root_list)) {
+                ExactPoly acc({Rational(1)});
+                for (const auto& root : roots) {
+                    Rational v = get<Rational>(promote(root, 1));
+                    acc = acc * ExactPoly({-v, Rational(1)});
+                }
+                s.push(poly_to_list(acc));
+            } else {
+                RealPoly acc({Real(1)});
+                for (const auto& root : roots)
+                    acc = acc * RealPoly({-to_real_value(root), Real(1)});
+                s.push(poly_to_list(acc));
+            }
+            return;
+        }
+
+        // Lowest degree first while multiplying by (x - root)
+        std::vector<Complex> c{{Real(1), Real(0)}};
+        for (const auto& root : roots) {
+            Complex z = get<Complex>(promote(root, 3));
+            c.push_back({Real(0), Real(0)});
+            for (size_t i = c.size(); i-- > 0;) {
+                Real re = z.first * c[i].first - z.second * c[i].second;
+                Real im = z.first * c[i].second + z.second * c[i].first;
+                c[i].first = (i > 0 ? c[i - 1].first : Real(0)) - re;
+                c[i].second = (i > 0 ? c[i - 1].second : Real(0)) - im;
+            }
+        }
+        static const Real eps("1e-40");
+        List coeffs;
+        for (auto it = c.rbegin(); it != c.rend(); ++it) {
+            Real scale = std::max(Real(1), Real(boost::multiprecision::abs(it->first)));
+            if (boost::multiprecision::abs(it->second) <= eps * scale) {
+                coeffs.items.push_back(it->first);
+            } else {
+                coeffs.items.push_back(*it);
+            }
+        }
+        s.push(std::move(coeffs));
+    });
+
+    // PDIV: ( a b -- quotient remainder )
+    register_command("PDIV", [](Store& s, Context&) {
+        if (s.depth() < 2) throw std::runtime_error("Too few arguments");
+        Object b = s.pop();
+        Object a = s.pop();
+        with_polys(a, b, [&](const auto& pa, const auto& pb) {
+            std::decay_t<decltype(pa)> q, r;
+            std::decay_t<decltype(pa)>::divmod(pa, pb, q, r);
+            s.push(poly_to_list(q));
+            s.push(poly_to_list(r));
+        });
+    });
+
+    // PMUL: ( a b -- a*b ), by Karatsuba for long operands
+    register_command("PMUL", [](Store& s, Context&) {
+        if (s.depth() < 2) throw std::runtime_error("Too few arguments");
+        Object b = s.pop();
+        Object a = s.pop();
+        with_polys(a, b, [&](const auto& pa, const auto& pb) {
+            s.push(poly_to_list(pa * pb));
+        });
+    });
+
+    // PGCD: ( a b -- gcd ), monic
+    register_command("PGCD", [](Store& s, Context&) {
+        if (s.depth() < 2) throw std::runtime_error("Too few arguments");
+        Object b = s.pop();
+        Object a = s.pop();
+        with_polys(a, b, [&](const auto& pa, const auto& pb) {
+            s.push(poly_to_list(gcd(pa, pb)));
+        });
+    });
+
+    // ->POLY: ( 'expr' 'var' -- coeffs )
+    auto to_poly = [](Store& s, Context&) {
+        if (s.depth() < 2) throw std::runtime_error("Too few arguments");
+        Object var = s.pop();
+        Object expr = s.pop();
+        if (!holds_alternative<Name>(var) || !is_symbolic(expr))
+            throw std::runtime_error("Bad argument type");
+        s.push(expr_to_poly(object_expr_tree(expr), get<Name>(var).value));
+    };
+    register_command("\xe2\x86\x92POLY", to_poly);
+    register_command("->POLY", to_poly);
+
+    // POLY->: ( coeffs 'var' -- 'expr' )
+    auto from_poly = [](Store& s, Context&) {
+        if (s.depth() < 2) throw std::runtime_error("Too few arguments");
+        Object var = s.pop();
+        Object p = s.pop();
+        if (!holds_alternative<Name>(var)) throw std::runtime_error("Bad argument type");
+        s.push(Symbol{poly_to_expr(coeff_list(p), object_expr_tree(var))});
+    };
+    register_command("POLY\xe2\x86\x92", from_poly);
+    register_command("POLY->", from_poly);
+}
+
 // ---- List Commands ----
 
 void CommandRegistry::register_list_commands() {
@@ -2197,9 +2483,9 @@ void CommandRegistry::register_list_commands() {
     auto list_to = [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object a = s.pop();
-        if (!std::holds_alternative<List>(a))
+        if (!holds_alternative<List>(a))
             throw std::runtime_error("Bad argument type");
-        auto& items = std::get<List>(a).items;
+        auto& items = get<List>(a).items;
         for (auto& item : items) s.push(item);
         s.push(Integer(static_cast<int>(items.size())));
     };
@@ -2210,9 +2496,9 @@ void CommandRegistry::register_list_commands() {
     auto to_list = [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object n_obj = s.pop();
-        if (!std::holds_alternative<Integer>(n_obj))
+        if (!holds_alternative<Integer>(n_obj))
             throw std::runtime_error("Bad argument type");
-        int n = static_cast<int>(std::get<Integer>(n_obj));
+        int n = static_cast<int>(get<Integer>(n_obj));
         if (n < 0 || s.depth() < n) throw std::runtime_error("Too few arguments");
         List list;
         list.items.resize(n);
@@ -2228,28 +2514,28 @@ void CommandRegistry::register_list_commands() {
         Object idx_obj = s.pop();
         Object obj = s.pop();
 
-        if (std::holds_alternative<List>(obj)) {
-            if (!std::holds_alternative<Integer>(idx_obj))
+        if (holds_alternative<List>(obj)) {
+            if (!holds_alternative<Integer>(idx_obj))
                 throw std::runtime_error("Bad argument type");
-            int idx = static_cast<int>(std::get<Integer>(idx_obj));
-            auto& items = std::get<List>(obj).items;
+            int idx = static_cast<int>(get<Integer>(idx_obj));
+            auto& items = get<List>(obj).items;
             if (idx < 1 || idx > static_cast<int>(items.size())) {
                 s.push(obj); s.push(idx_obj);
                 throw std::runtime_error("Index out of range");
             }
             s.push(items[idx - 1]);
-        } else if (std::holds_alternative<Matrix>(obj)) {
+        } else if (holds_alternative<Matrix>(obj)) {
             // Matrix GET expects { row col } list as index
-            if (!std::holds_alternative<List>(idx_obj))
+            if (!holds_alternative<List>(idx_obj))
                 throw std::runtime_error("Bad argument type");
-            auto& idx_list = std::get<List>(idx_obj).items;
+            auto& idx_list = get<List>(idx_obj).items;
             if (idx_list.size() != 2 ||
-                !std::holds_alternative<Integer>(idx_list[0]) ||
-                !std::holds_alternative<Integer>(idx_list[1]))
+                !holds_alternative<Integer>(idx_list[0]) ||
+                !holds_alternative<Integer>(idx_list[1]))
                 throw std::runtime_error("Bad argument type");
-            int r = static_cast<int>(std::get<Integer>(idx_list[0]));
-            int c = static_cast<int>(std::get<Integer>(idx_list[1]));
-            auto& rows = std::get<Matrix>(obj).rows;
+            int r = static_cast<int>(get<Integer>(idx_list[0]));
+            int c = static_cast<int>(get<Integer>(idx_list[1]));
+            auto& rows = get<Matrix>(obj).rows;
             if (r < 1 || r > static_cast<int>(rows.size()) ||
                 c < 1 || c > static_cast<int>(rows[0].size())) {
                 s.push(obj); s.push(idx_obj);
@@ -2269,33 +2555,33 @@ void CommandRegistry::register_list_commands() {
         Object idx_obj = s.pop();
         Object obj = s.pop();
 
-        if (std::holds_alternative<List>(obj)) {
-            if (!std::holds_alternative<Integer>(idx_obj))
+        if (holds_alternative<List>(obj)) {
+            if (!holds_alternative<Integer>(idx_obj))
                 throw std::runtime_error("Bad argument type");
-            int idx = static_cast<int>(std::get<Integer>(idx_obj));
-            auto list = std::get<List>(obj);
+            int idx = static_cast<int>(get<Integer>(idx_obj));
+            auto list = get<List>(obj);
             if (idx < 1 || idx > static_cast<int>(list.items.size())) {
                 s.push(obj); s.push(idx_obj); s.push(val);
                 throw std::runtime_error("Index out of range");
             }
             list.items[idx - 1] = val;
             s.push(std::move(list));
-        } else if (std::holds_alternative<Matrix>(obj)) {
-            if (!std::holds_alternative<List>(idx_obj))
+        } else if (holds_alternative<Matrix>(obj)) {
+            if (!holds_alternative<List>(idx_obj))
                 throw std::runtime_error("Bad argument type");
-            auto& idx_list = std::get<List>(idx_obj).items;
+            auto& idx_list = get<List>(idx_obj).items;
             if (idx_list.size() != 2 ||
-                !std::holds_alternative<Integer>(idx_list[0]) ||
-                !std::holds_alternative<Integer>(idx_list[1]))
+                !holds_alternative<Integer>(idx_list[0]) ||
+                !holds_alternative<Integer>(idx_list[1]))
                 throw std::runtime_error("Bad argument type");
             // Validate element type for matrix
             if (!is_numeric(val) && !is_symbolic(val)) {
                 s.push(obj); s.push(idx_obj); s.push(val);
                 throw std::runtime_error("Invalid matrix element type");
             }
-            int r = static_cast<int>(std::get<Integer>(idx_list[0]));
-            int c = static_cast<int>(std::get<Integer>(idx_list[1]));
-            auto mat = std::get<Matrix>(obj);
+            int r = static_cast<int>(get<Integer>(idx_list[0]));
+            int c = static_cast<int>(get<Integer>(idx_list[1]));
+            auto mat = get<Matrix>(obj);
             if (r < 1 || r > static_cast<int>(mat.rows.size()) ||
                 c < 1 || c > static_cast<int>(mat.rows[0].size())) {
                 s.push(obj); s.push(idx_obj); s.push(val);
@@ -2315,11 +2601,11 @@ void CommandRegistry::register_list_commands() {
         Object idx_obj = s.pop();
         Object obj = s.pop();
 
-        if (std::holds_alternative<List>(obj)) {
-            if (!std::holds_alternative<Integer>(idx_obj))
+        if (holds_alternative<List>(obj)) {
+            if (!holds_alternative<Integer>(idx_obj))
                 throw std::runtime_error("Bad argument type");
-            int idx = static_cast<int>(std::get<Integer>(idx_obj));
-            auto& items = std::get<List>(obj).items;
+            int idx = static_cast<int>(get<Integer>(idx_obj));
+            auto& items = get<List>(obj).items;
             if (idx < 1 || idx > static_cast<int>(items.size())) {
                 s.push(obj); s.push(idx_obj);
                 throw std::runtime_error("Index out of range");
@@ -2341,11 +2627,11 @@ void CommandRegistry::register_list_commands() {
         Object idx_obj = s.pop();
         Object obj = s.pop();
 
-        if (std::holds_alternative<List>(obj)) {
-            if (!std::holds_alternative<Integer>(idx_obj))
+        if (holds_alternative<List>(obj)) {
+            if (!holds_alternative<Integer>(idx_obj))
                 throw std::runtime_error("Bad argument type");
-            int idx = static_cast<int>(std::get<Integer>(idx_obj));
-            auto list = std::get<List>(obj);
+            int idx = static_cast<int>(get<Integer>(idx_obj));
+            auto list = get<List>(obj);
             if (idx < 1 || idx > static_cast<int>(list.items.size())) {
                 s.push(obj); s.push(idx_obj); s.push(val);
                 throw std::runtime_error("Index out of range");
@@ -2364,12 +2650,12 @@ void CommandRegistry::register_list_commands() {
     register_command("HEAD", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object a = s.pop();
-        if (std::holds_alternative<List>(a)) {
-            auto& items = std::get<List>(a).items;
+        if (holds_alternative<List>(a)) {
+            auto& items = get<List>(a).items;
             if (items.empty()) throw std::runtime_error("Empty list");
             s.push(items[0]);
-        } else if (std::holds_alternative<String>(a)) {
-            auto& str = std::get<String>(a).value;
+        } else if (holds_alternative<String>(a)) {
+            auto& str = get<String>(a).value;
             if (str.empty()) throw std::runtime_error("Bad argument value");
             s.push(String{str.substr(0, 1)});
         } else {
@@ -2382,14 +2668,14 @@ void CommandRegistry::register_list_commands() {
     register_command("TAIL", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object a = s.pop();
-        if (std::holds_alternative<List>(a)) {
-            auto& items = std::get<List>(a).items;
+        if (holds_alternative<List>(a)) {
+            auto& items = get<List>(a).items;
             if (items.empty()) throw std::runtime_error("Empty list");
             List result;
             result.items.assign(items.begin() + 1, items.end());
             s.push(std::move(result));
-        } else if (std::holds_alternative<String>(a)) {
-            auto& str = std::get<String>(a).value;
+        } else if (holds_alternative<String>(a)) {
+            auto& str = get<String>(a).value;
             if (str.empty()) throw std::runtime_error("Bad argument value");
             s.push(String{str.substr(1)});
         } else {
@@ -2402,16 +2688,16 @@ void CommandRegistry::register_list_commands() {
     register_command("SIZE", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object a = s.pop();
-        if (std::holds_alternative<List>(a)) {
-            s.push(Integer(static_cast<int>(std::get<List>(a).items.size())));
-        } else if (std::holds_alternative<Matrix>(a)) {
-            auto& rows = std::get<Matrix>(a).rows;
+        if (holds_alternative<List>(a)) {
+            s.push(Integer(static_cast<int>(get<List>(a).items.size())));
+        } else if (holds_alternative<Matrix>(a)) {
+            auto& rows = get<Matrix>(a).rows;
             List dims;
             dims.items.push_back(Integer(static_cast<int>(rows.size())));
             dims.items.push_back(Integer(rows.empty() ? 0 : static_cast<int>(rows[0].size())));
             s.push(std::move(dims));
-        } else if (std::holds_alternative<String>(a)) {
-            s.push(Integer(static_cast<int>(std::get<String>(a).value.size())));
+        } else if (holds_alternative<String>(a)) {
+            s.push(Integer(static_cast<int>(get<String>(a).value.size())));
         } else {
             s.push(a);
             throw std::runtime_error("Bad argument type");
@@ -2423,18 +2709,18 @@ void CommandRegistry::register_list_commands() {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object needle = s.pop();
         Object a = s.pop();
-        if (std::holds_alternative<List>(a)) {
-            auto& items = std::get<List>(a).items;
+        if (holds_alternative<List>(a)) {
+            auto& items = get<List>(a).items;
             for (size_t i = 0; i < items.size(); ++i) {
-                if (repr(items[i]) == repr(needle)) {
+                if (objects_equal(items[i], needle)) {
                     s.push(Integer(static_cast<int>(i + 1)));
                     return;
                 }
             }
             s.push(Integer(0));
-        } else if (std::holds_alternative<String>(a) && std::holds_alternative<String>(needle)) {
-            auto& str = std::get<String>(a).value;
-            auto& search = std::get<String>(needle).value;
+        } else if (holds_alternative<String>(a) && holds_alternative<String>(needle)) {
+            auto& str = get<String>(a).value;
+            auto& search = get<String>(needle).value;
             auto pos = str.find(search);
             s.push(Integer(pos == std::string::npos ? 0 : static_cast<int>(pos) + 1));
         } else {
@@ -2449,15 +2735,15 @@ void CommandRegistry::register_list_commands() {
         Object end_obj = s.pop();
         Object start_obj = s.pop();
         Object a = s.pop();
-        if (!std::holds_alternative<Integer>(start_obj) ||
-            !std::holds_alternative<Integer>(end_obj)) {
+        if (!holds_alternative<Integer>(start_obj) ||
+            !holds_alternative<Integer>(end_obj)) {
             s.push(a); s.push(start_obj); s.push(end_obj);
             throw std::runtime_error("Bad argument type");
         }
-        int start = static_cast<int>(std::get<Integer>(start_obj));
-        int end = static_cast<int>(std::get<Integer>(end_obj));
-        if (std::holds_alternative<List>(a)) {
-            auto& items = std::get<List>(a).items;
+        int start = static_cast<int>(get<Integer>(start_obj));
+        int end = static_cast<int>(get<Integer>(end_obj));
+        if (holds_alternative<List>(a)) {
+            auto& items = get<List>(a).items;
             int sz = static_cast<int>(items.size());
             if (start < 1) start = 1;
             if (end > sz) end = sz;
@@ -2466,8 +2752,8 @@ void CommandRegistry::register_list_commands() {
                 result.items.assign(items.begin() + start - 1, items.begin() + end);
             }
             s.push(std::move(result));
-        } else if (std::holds_alternative<String>(a)) {
-            auto& str = std::get<String>(a).value;
+        } else if (holds_alternative<String>(a)) {
+            auto& str = get<String>(a).value;
             if (start < 1) start = 1;
             if (end > static_cast<int>(str.size())) end = static_cast<int>(str.size());
             if (start > end) {
@@ -2485,42 +2771,59 @@ void CommandRegistry::register_list_commands() {
     register_command("REVLIST", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object a = s.pop();
-        if (!std::holds_alternative<List>(a))
+        if (!holds_alternative<List>(a))
             throw std::runtime_error("Bad argument type");
-        auto list = std::get<List>(a);
+        auto list = get<List>(a);
         std::reverse(list.items.begin(), list.items.end());
         s.push(std::move(list));
     });
 
     // SORT : sort list of homogeneous numeric/string elements
-    register_command("SORT", [](Store& s, Context&) {
-        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
-        Object a = s.pop();
-        if (!std::holds_alternative<List>(a))
-            throw std::runtime_error("Bad argument type");
-        auto list = std::get<List>(a);
-        if (list.items.empty()) { s.push(std::move(list)); return; }
-        // Check if all items are the same numeric or string type
-        bool all_string = true;
-        bool all_numeric = true;
-        for (auto& item : list.items) {
-            if (!std::holds_alternative<String>(item)) all_string = false;
-            if (!is_numeric(item)) all_numeric = false;
-        }
-        if (!all_string && !all_numeric)
-            throw std::runtime_error("SORT requires homogeneous numeric or string list");
-        if (all_string) {
-            std::sort(list.items.begin(), list.items.end(),
-                [](const Object& x, const Object& y) {
-                    return std::get<String>(x).value < std::get<String>(y).value;
-                });
+    register_command("SORT", [](Store& s, Context& ctx) {
+        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
+        Object prog_obj;
+        if (holds_alternative<Program>(s.peek(1))) prog_obj = s.pop();
+        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
+        Object a = s.pop();
+        if (!holds_alternative<List>(a))
+            throw std::runtime_error("Bad argument type");
+        auto& items = get<List>(a).items;
+
+        // Decorate: one key object per element (the element itself, or the
+        // key program's result), then one SortKey per key object.
+        SortKeys sk;
+        if (holds_alternative<Program>(prog_obj)) {
+            const auto& prog = get<Program>(prog_obj);
+            std::vector<std::vector<Object>> groups;
+            groups.reserve(items.size());
+            for (const auto& item : items) groups.push_back({item});
+            auto key_objs = parallel_eval(ctx, prog, groups);
+            if (!key_objs) {
+                key_objs.emplace();
+                key_objs->reserve(items.size());
+                for (const auto& item : items) {
+                    int base = s.depth();
+                    s.push(item);
+                    ctx.execute_tokens(prog.tokens);
+                    // Like parallel_eval: a key program leaves exactly one key
+                    if (s.depth() != base + 1) throw std::runtime_error("Bad argument value");
+                    key_objs->push_back(s.pop());
+                }
+            }
+            sk = make_sort_keys(*key_objs);
         } else {
-            std::sort(list.items.begin(), list.items.end(),
-                [](const Object& x, const Object& y) {
-                    return to_real_value(x) < to_real_value(y);
-                });
+            sk = make_sort_keys(items);
         }
-        s.push(std::move(list));
+
+        // Sort the keys themselves (stable), then undecorate by index.
+        parallel_stable_sort(sk.keys,
+            [&sk](const SortKey& x, const SortKey& y) { return sort_key_less(sk, x, y); },
+            parallel_worker_count(ctx));
+
+        List result;
+        result.items.reserve(items.size());
+        for (const auto& k : sk.keys) result.items.push_back(std::move(items[k.index]));
+        s.push(std::move(result));
     });
 
     // ADD : append element to list
@@ -2528,9 +2831,9 @@ void CommandRegistry::register_list_commands() {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object elem = s.pop();
         Object a = s.pop();
-        if (!std::holds_alternative<List>(a))
+        if (!holds_alternative<List>(a))
             throw std::runtime_error("Bad argument type");
-        auto list = std::get<List>(a);
+        auto list = get<List>(a);
         list.items.push_back(std::move(elem));
         s.push(std::move(list));
     });
@@ -2541,27 +2844,27 @@ void CommandRegistry::register_list_commands() {
     register_command("DOLIST", [](Store& s, Context& ctx) {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object prog_obj = s.pop();
-        if (!std::holds_alternative<Program>(prog_obj))
+        if (!holds_alternative<Program>(prog_obj))
             throw std::runtime_error("Bad argument type");
         Object n_obj = s.pop();
-        if (!std::holds_alternative<Integer>(n_obj))
+        if (!holds_alternative<Integer>(n_obj))
             throw std::runtime_error("Bad argument type");
-        int n = static_cast<int>(std::get<Integer>(n_obj));
+        int n = static_cast<int>(get<Integer>(n_obj));
         if (n < 1 || s.depth() < n) throw std::runtime_error("Too few arguments");
 
         std::vector<List> lists(n);
         for (int i = n - 1; i >= 0; --i) {
             Object lobj = s.pop();
-            if (!std::holds_alternative<List>(lobj))
+            if (!holds_alternative<List>(lobj))
                 throw std::runtime_error("Bad argument type");
-            lists[i] = std::get<List>(std::move(lobj));
+            lists[i] = get<List>(std::move(lobj));
         }
         size_t len = lists[0].items.size();
         for (int i = 1; i < n; ++i) {
             if (lists[i].items.size() != len)
                 throw std::runtime_error("Lists must have same length");
         }
-        auto& prog = std::get<Program>(prog_obj);
+        auto& prog = get<Program>(prog_obj);
         List result;
         for (size_t j = 0; j < len; ++j) {
             for (int i = 0; i < n; ++i) s.push(lists[i].items[j]);
@@ -2575,13 +2878,13 @@ void CommandRegistry::register_list_commands() {
     register_command("MAP", [](Store& s, Context& ctx) {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object prog_obj = s.pop();
-        if (!std::holds_alternative<Program>(prog_obj))
+        if (!holds_alternative<Program>(prog_obj))
             throw std::runtime_error("Bad argument type");
         Object lobj = s.pop();
-        if (!std::holds_alternative<List>(lobj))
+        if (!holds_alternative<List>(lobj))
             throw std::runtime_error("Bad argument type");
-        auto& input_list = std::get<List>(lobj);
-        auto& prog = std::get<Program>(prog_obj);
+        auto& input_list = get<List>(lobj);
+        auto& prog = get<Program>(prog_obj);
         List result;
         for (auto& item : input_list.items) {
             s.push(item);
@@ -2595,14 +2898,14 @@ void CommandRegistry::register_list_commands() {
     register_command("STREAM", [](Store& s, Context& ctx) {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object prog_obj = s.pop();
-        if (!std::holds_alternative<Program>(prog_obj))
+        if (!holds_alternative<Program>(prog_obj))
             throw std::runtime_error("Bad argument type");
         Object lobj = s.pop();
-        if (!std::holds_alternative<List>(lobj))
+        if (!holds_alternative<List>(lobj))
             throw std::runtime_error("Bad argument type");
-        auto& items = std::get<List>(lobj).items;
+        auto& items = get<List>(lobj).items;
         if (items.empty()) throw std::runtime_error("Empty list");
-        auto& prog = std::get<Program>(prog_obj);
+        auto& prog = get<Program>(prog_obj);
         s.push(items[0]);
         for (size_t i = 1; i < items.size(); ++i) {
             s.push(items[i]);
@@ -2617,11 +2920,11 @@ void CommandRegistry::register_list_commands() {
         Object count_obj = s.pop();
         Object step_obj = s.pop();
         Object start_obj = s.pop();
-        if (!std::holds_alternative<Program>(prog_obj) ||
-            !std::holds_alternative<Integer>(count_obj))
+        if (!holds_alternative<Program>(prog_obj) ||
+            !holds_alternative<Integer>(count_obj))
             throw std::runtime_error("Bad argument type");
-        int count = static_cast<int>(std::get<Integer>(count_obj));
-        auto& prog = std::get<Program>(prog_obj);
+        int count = static_cast<int>(get<Integer>(count_obj));
+        auto& prog = get<Program>(prog_obj);
         List result;
         Object current = start_obj;
         for (int i = 0; i < count; ++i) {
@@ -2641,13 +2944,13 @@ void CommandRegistry::register_list_commands() {
     register_command("FILTER", [](Store& s, Context& ctx) {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object prog_obj = s.pop();
-        if (!std::holds_alternative<Program>(prog_obj))
+        if (!holds_alternative<Program>(prog_obj))
             throw std::runtime_error("Bad argument type");
         Object lobj = s.pop();
-        if (!std::holds_alternative<List>(lobj))
+        if (!holds_alternative<List>(lobj))
             throw std::runtime_error("Bad argument type");
-        auto& items = std::get<List>(lobj).items;
-        auto& prog = std::get<Program>(prog_obj);
+        auto& items = get<List>(lobj).items;
+        auto& prog = get<Program>(prog_obj);
         List result;
         for (auto& item : items) {
             s.push(item);
@@ -2666,15 +2969,15 @@ void CommandRegistry::register_list_commands() {
         Object prog_obj = s.pop();
         Object n_obj = s.pop();
         Object lobj = s.pop();
-        if (!std::holds_alternative<Program>(prog_obj) ||
-            !std::holds_alternative<Integer>(n_obj) ||
-            !std::holds_alternative<List>(lobj))
+        if (!holds_alternative<Program>(prog_obj) ||
+            !holds_alternative<Integer>(n_obj) ||
+            !holds_alternative<List>(lobj))
             throw std::runtime_error("Bad argument type");
-        int n = static_cast<int>(std::get<Integer>(n_obj));
-        auto& items = std::get<List>(lobj).items;
+        int n = static_cast<int>(get<Integer>(n_obj));
+        auto& items = get<List>(lobj).items;
         int sz = static_cast<int>(items.size());
         if (n < 1 || n > sz) throw std::runtime_error("Bad argument value");
-        auto& prog = std::get<Program>(prog_obj);
+        auto& prog = get<Program>(prog_obj);
         List result;
         for (int i = 0; i <= sz - n; ++i) {
             for (int j = 0; j < n; ++j) s.push(items[i + j]);
@@ -2684,20 +2987,192 @@ void CommandRegistry::register_list_commands() {
         s.push(std::move(result));
     });
 
+    // --- Parallel higher-order ---
+    // Each P* command runs its program on worker contexts when the program is
+    // parallel-safe (see parallel.hpp) and otherwise hands its arguments back
+    // to the serial command, so results and errors always match it.
+
+    // PWORKERS : set worker thread count for P* commands (0 = hardware)
+    register_command("PWORKERS", [](Store& s, Context&) {
+        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
+        Object n_obj = s.pop();
+        if (!holds_alternative<Integer>(n_obj))
+            throw std::runtime_error("Bad argument type");
+        const auto& n = get<Integer>(n_obj);
+        if (n < 0 || n > 1024) throw std::runtime_error("Bad argument value");
+        s.set_meta("parallel_workers", n.str());
+    });
+
+    // PMAP : parallel MAP
+    register_command("PMAP", [](Store& s, Context& ctx) {
+        if (s.depth() < 2) throw std::runtime_error("Too few arguments");
+        Object prog_obj = s.pop();
+        Object lobj = s.pop();
+        if (!holds_alternative<Program>(prog_obj) ||
+            !holds_alternative<List>(lobj))
+            throw std::runtime_error("Bad argument type");
+        const auto& items = get<List>(lobj).items;
+        std::vector<std::vector<Object>> groups;
+        groups.reserve(items.size());
+        for (const auto& item : items) groups.push_back({item});
+        auto results = parallel_eval(ctx, get<Program>(prog_obj), groups);
+        if (!results) {
+            s.push(std::move(lobj));
+            s.push(std::move(prog_obj));
+            ctx.execute_tokens({Token::make_command("MAP")});
+            return;
+        }
+        List result;
+        result.items = std::move(*results);
+        s.push(std::move(result));
+    });
+
+    // PFILTER : parallel FILTER
+    register_command("PFILTER", [](Store& s, Context& ctx) {
+        if (s.depth() < 2) throw std::runtime_error("Too few arguments");
+        Object prog_obj = s.pop();
+        Object lobj = s.pop();
+        if (!holds_alternative<Program>(prog_obj) ||
+            !holds_alternative<List>(lobj))
+            throw std::runtime_error("Bad argument type");
+        const auto& items = get<List>(lobj).items;
+        std::vector<std::vector<Object>> groups;
+        groups.reserve(items.size());
+        for (const auto& item : items) groups.push_back({item});
+        auto tests = parallel_eval(ctx, get<Program>(prog_obj), groups);
+        if (!tests) {
+            s.push(std::move(lobj));
+            s.push(std::move(prog_obj));
+            ctx.execute_tokens({Token::make_command("FILTER")});
+            return;
+        }
+        List result;
+        for (size_t i = 0; i < items.size(); ++i) {
+            if (is_truthy((*tests)[i])) result.items.push_back(items[i]);
+        }
+        s.push(std::move(result));
+    });
+
+    // PDOLIST : parallel DOLIST
+    register_command("PDOLIST", [](Store& s, Context& ctx) {
+        if (s.depth() < 2) throw std::runtime_error("Too few arguments");
+        Object prog_obj = s.pop();
+        if (!holds_alternative<Program>(prog_obj))
+            throw std::runtime_error("Bad argument type");
+        Object n_obj = s.pop();
+        if (!holds_alternative<Integer>(n_obj))
+            throw std::runtime_error("Bad argument type");
+        int n = static_cast<int>(get<Integer>(n_obj));
+        if (n < 1 || s.depth() < n) throw std::runtime_error("Too few arguments");
+
+        std::vector<List> lists(n);
+        for (int i = n - 1; i >= 0; --i) {
+            Object lobj = s.pop();
+            if (!holds_alternative<List>(lobj))
+                throw std::runtime_error("Bad argument type");
+            lists[i] = get<List>(std::move(lobj));
+        }
+        size_t len = lists[0].items.size();
+        for (int i = 1; i < n; ++i) {
+            if (lists[i].items.size() != len)
+                throw std::runtime_error("Lists must have same length");
+        }
+        std::vector<std::vector<Object>> groups(len);
+        for (size_t j = 0; j < len; ++j) {
+            for (int i = 0; i < n; ++i) groups[j].push_back(lists[i].items[j]);
+        }
+        auto results = parallel_eval(ctx, get<Program>(prog_obj), groups);
+        if (!results) {
+            for (auto& l : lists) s.push(std::move(l));
+            s.push(std::move(n_obj));
+            s.push(std::move(prog_obj));
+            ctx.execute_tokens({Token::make_command("DOLIST")});
+            return;
+        }
+        List result;
+        result.items = std::move(*results);
+        s.push(std::move(result));
+    });
+
+    // PSEQ : parallel SEQ (sequence values are still stepped serially)
+    register_command("PSEQ", [](Store& s, Context& ctx) {
+        if (s.depth() < 4) throw std::runtime_error("Too few arguments");
+        Object prog_obj = s.pop();
+        Object count_obj = s.pop();
+        Object step_obj = s.pop();
+        Object start_obj = s.pop();
+        if (!holds_alternative<Program>(prog_obj) ||
+            !holds_alternative<Integer>(count_obj))
+            throw std::runtime_error("Bad argument type");
+        int count = static_cast<int>(get<Integer>(count_obj));
+        std::vector<std::vector<Object>> groups;
+        Object current = start_obj;
+        for (int i = 0; i < count; ++i) {
+            groups.push_back({current});
+            s.push(current);
+            s.push(step_obj);
+            ctx.execute_tokens({Token::make_command("+")});
+            current = s.pop();
+        }
+        auto results = parallel_eval(ctx, get<Program>(prog_obj), groups);
+        if (!results) {
+            s.push(std::move(start_obj));
+            s.push(std::move(step_obj));
+            s.push(std::move(count_obj));
+            s.push(std::move(prog_obj));
+            ctx.execute_tokens({Token::make_command("SEQ")});
+            return;
+        }
+        List result;
+        result.items = std::move(*results);
+        s.push(std::move(result));
+    });
+
+    // PDOSUBS : parallel DOSUBS
+    register_command("PDOSUBS", [](Store& s, Context& ctx) {
+        if (s.depth() < 3) throw std::runtime_error("Too few arguments");
+        Object prog_obj = s.pop();
+        Object n_obj = s.pop();
+        Object lobj = s.pop();
+        if (!holds_alternative<Program>(prog_obj) ||
+            !holds_alternative<Integer>(n_obj) ||
+            !holds_alternative<List>(lobj))
+            throw std::runtime_error("Bad argument type");
+        int n = static_cast<int>(get<Integer>(n_obj));
+        const auto& items = get<List>(lobj).items;
+        int sz = static_cast<int>(items.size());
+        if (n < 1 || n > sz) throw std::runtime_error("Bad argument value");
+        std::vector<std::vector<Object>> groups;
+        for (int i = 0; i <= sz - n; ++i) {
+            groups.emplace_back(items.begin() + i, items.begin() + i + n);
+        }
+        auto results = parallel_eval(ctx, get<Program>(prog_obj), groups);
+        if (!results) {
+            s.push(std::move(lobj));
+            s.push(std::move(n_obj));
+            s.push(std::move(prog_obj));
+            ctx.execute_tokens({Token::make_command("DOSUBS")});
+            return;
+        }
+        List result;
+        result.items = std::move(*results);
+        s.push(std::move(result));
+    });
+
     // ZIP : transpose N lists into list of lists
     register_command("ZIP", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object n_obj = s.pop();
-        if (!std::holds_alternative<Integer>(n_obj))
+        if (!holds_alternative<Integer>(n_obj))
             throw std::runtime_error("Bad argument type");
-        int n = static_cast<int>(std::get<Integer>(n_obj));
+        int n = static_cast<int>(get<Integer>(n_obj));
         if (n < 1 || s.depth() < n) throw std::runtime_error("Too few arguments");
         std::vector<List> lists(n);
         for (int i = n - 1; i >= 0; --i) {
             Object lobj = s.pop();
-            if (!std::holds_alternative<List>(lobj))
+            if (!holds_alternative<List>(lobj))
                 throw std::runtime_error("Bad argument type");
-            lists[i] = std::get<List>(std::move(lobj));
+            lists[i] = get<List>(std::move(lobj));
         }
         size_t len = lists[0].items.size();
         for (int i = 1; i < n; ++i) {
@@ -2720,16 +3195,14 @@ void CommandRegistry::register_list_commands() {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object b = s.pop();
         Object a = s.pop();
-        if (!std::holds_alternative<List>(a) || !std::holds_alternative<List>(b))
+        if (!holds_alternative<List>(a) || !holds_alternative<List>(b))
             throw std::runtime_error("Bad argument type");
-        auto result = std::get<List>(a);
-        auto& b_items = std::get<List>(b).items;
+        auto& a_items = get<List>(a).items;
+        auto& b_items = get<List>(b).items;
+        ObjectRefSet seen(a_items.begin(), a_items.end());
+        List result{a_items};
         for (auto& item : b_items) {
-            bool found = false;
-            for (auto& existing : result.items) {
-                if (repr(existing) == repr(item)) { found = true; break; }
-            }
-            if (!found) result.items.push_back(item);
+            if (seen.insert(item).second) result.items.push_back(item);
         }
         s.push(std::move(result));
     });
@@ -2739,18 +3212,14 @@ void CommandRegistry::register_list_commands() {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object b = s.pop();
         Object a = s.pop();
-        if (!std::holds_alternative<List>(a) || !std::holds_alternative<List>(b))
+        if (!holds_alternative<List>(a) || !holds_alternative<List>(b))
             throw std::runtime_error("Bad argument type");
-        auto& a_items = std::get<List>(a).items;
-        auto& b_items = std::get<List>(b).items;
+        auto& a_items = get<List>(a).items;
+        auto& b_items = get<List>(b).items;
+        ObjectRefSet b_set(b_items.begin(), b_items.end());
         List result;
         for (auto& item : a_items) {
-            for (auto& bi : b_items) {
-                if (repr(item) == repr(bi)) {
-                    result.items.push_back(item);
-                    break;
-                }
-            }
+            if (b_set.count(item)) result.items.push_back(item);
         }
         s.push(std::move(result));
     });
@@ -2760,17 +3229,14 @@ void CommandRegistry::register_list_commands() {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object b = s.pop();
         Object a = s.pop();
-        if (!std::holds_alternative<List>(a) || !std::holds_alternative<List>(b))
+        if (!holds_alternative<List>(a) || !holds_alternative<List>(b))
             throw std::runtime_error("Bad argument type");
-        auto& a_items = std::get<List>(a).items;
-        auto& b_items = std::get<List>(b).items;
+        auto& a_items = get<List>(a).items;
+        auto& b_items = get<List>(b).items;
+        ObjectRefSet b_set(b_items.begin(), b_items.end());
         List result;
         for (auto& item : a_items) {
-            bool found = false;
-            for (auto& bi : b_items) {
-                if (repr(item) == repr(bi)) { found = true; break; }
-            }
-            if (!found) result.items.push_back(item);
+            if (!b_set.count(item)) result.items.push_back(item);
         }
         s.push(std::move(result));
     });
@@ -2808,9 +3274,9 @@ void CommandRegistry::register_matrix_commands() {
     auto v_to = [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object a = s.pop();
-        if (!std::holds_alternative<Matrix>(a))
+        if (!holds_alternative<Matrix>(a))
             throw std::runtime_error("Bad argument type");
-        auto& rows = std::get<Matrix>(a).rows;
+        auto& rows = get<Matrix>(a).rows;
         if (rows.size() != 1)
             throw std::runtime_error("V-> requires a vector (1-row matrix)");
         for (auto& elem : rows[0]) s.push(elem);
@@ -2823,16 +3289,16 @@ void CommandRegistry::register_matrix_commands() {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object val = s.pop();
         Object dims_obj = s.pop();
-        if (!std::holds_alternative<List>(dims_obj))
+        if (!holds_alternative<List>(dims_obj))
             throw std::runtime_error("Bad argument type");
-        auto& dims = std::get<List>(dims_obj).items;
+        auto& dims = get<List>(dims_obj).items;
         Matrix m;
         if (dims.size() == 1) {
-            int cols = static_cast<int>(std::get<Integer>(dims[0]));
+            int cols = static_cast<int>(get<Integer>(dims[0]));
             m.rows.push_back(std::vector<Object>(cols, val));
         } else if (dims.size() == 2) {
-            int rows = static_cast<int>(std::get<Integer>(dims[0]));
-            int cols = static_cast<int>(std::get<Integer>(dims[1]));
+            int rows = static_cast<int>(get<Integer>(dims[0]));
+            int cols = static_cast<int>(get<Integer>(dims[1]));
             for (int r = 0; r < rows; ++r)
                 m.rows.push_back(std::vector<Object>(cols, val));
         } else {
@@ -2845,9 +3311,9 @@ void CommandRegistry::register_matrix_commands() {
     register_command("IDN", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object n_obj = s.pop();
-        if (!std::holds_alternative<Integer>(n_obj))
+        if (!holds_alternative<Integer>(n_obj))
             throw std::runtime_error("Bad argument type");
-        int n = static_cast<int>(std::get<Integer>(n_obj));
+        int n = static_cast<int>(get<Integer>(n_obj));
         if (n < 1) throw std::runtime_error("Bad argument value");
         Matrix m;
         for (int r = 0; r < n; ++r) {
@@ -2863,10 +3329,10 @@ void CommandRegistry::register_matrix_commands() {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object dims_obj = s.pop();
         Object mat_obj = s.pop();
-        if (!std::holds_alternative<Matrix>(mat_obj) || !std::holds_alternative<List>(dims_obj))
+        if (!holds_alternative<Matrix>(mat_obj) || !holds_alternative<List>(dims_obj))
             throw std::runtime_error("Bad argument type");
-        auto& old_mat = std::get<Matrix>(mat_obj);
-        auto& dims = std::get<List>(dims_obj).items;
+        auto& old_mat = get<Matrix>(mat_obj);
+        auto& dims = get<List>(dims_obj).items;
         // Flatten old matrix
         std::vector<Object> flat;
         for (auto& row : old_mat.rows)
@@ -2874,14 +3340,14 @@ void CommandRegistry::register_matrix_commands() {
                 flat.push_back(elem);
         Matrix m;
         if (dims.size() == 1) {
-            int cols = static_cast<int>(std::get<Integer>(dims[0]));
+            int cols = static_cast<int>(get<Integer>(dims[0]));
             std::vector<Object> row;
             for (int c = 0; c < cols; ++c)
                 row.push_back(c < static_cast<int>(flat.size()) ? flat[c] : Integer(0));
             m.rows.push_back(std::move(row));
         } else if (dims.size() == 2) {
-            int rows = static_cast<int>(std::get<Integer>(dims[0]));
-            int cols = static_cast<int>(std::get<Integer>(dims[1]));
+            int rows = static_cast<int>(get<Integer>(dims[0]));
+            int cols = static_cast<int>(get<Integer>(dims[1]));
             size_t idx = 0;
             for (int r = 0; r < rows; ++r) {
                 std::vector<Object> row;
@@ -2901,9 +3367,9 @@ void CommandRegistry::register_matrix_commands() {
     register_command("TRN", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object a = s.pop();
-        if (!std::holds_alternative<Matrix>(a))
+        if (!holds_alternative<Matrix>(a))
             throw std::runtime_error("Bad argument type");
-        auto& rows = std::get<Matrix>(a).rows;
+        auto& rows = get<Matrix>(a).rows;
         if (rows.empty()) { s.push(a); return; }
         int nr = static_cast<int>(rows.size());
         int nc = static_cast<int>(rows[0].size());
@@ -2920,9 +3386,9 @@ void CommandRegistry::register_matrix_commands() {
     register_command("DET", [this](Store& s, Context& ctx) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object a = s.pop();
-        if (!std::holds_alternative<Matrix>(a))
+        if (!holds_alternative<Matrix>(a))
             throw std::runtime_error("Bad argument type");
-        auto& rows = std::get<Matrix>(a).rows;
+        auto& rows = get<Matrix>(a).rows;
         int n = static_cast<int>(rows.size());
         if (n == 0 || static_cast<int>(rows[0].size()) != n)
             throw std::runtime_error("DET requires a square matrix");
@@ -2987,10 +3453,10 @@ void CommandRegistry::register_matrix_commands() {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object b = s.pop();
         Object a = s.pop();
-        if (!std::holds_alternative<Matrix>(a) || !std::holds_alternative<Matrix>(b))
+        if (!holds_alternative<Matrix>(a) || !holds_alternative<Matrix>(b))
             throw std::runtime_error("Bad argument type");
-        auto& ar = std::get<Matrix>(a).rows;
-        auto& br = std::get<Matrix>(b).rows;
+        auto& ar = get<Matrix>(a).rows;
+        auto& br = get<Matrix>(b).rows;
         if (ar.size() != 1 || ar[0].size() != 3 || br.size() != 1 || br[0].size() != 3)
             throw std::runtime_error("CROSS requires 3D vectors");
         // a x b = [a2*b3-a3*b2, a3*b1-a1*b3, a1*b2-a2*b1]
@@ -3015,10 +3481,10 @@ void CommandRegistry::register_matrix_commands() {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object b = s.pop();
         Object a = s.pop();
-        if (!std::holds_alternative<Matrix>(a) || !std::holds_alternative<Matrix>(b))
+        if (!holds_alternative<Matrix>(a) || !holds_alternative<Matrix>(b))
             throw std::runtime_error("Bad argument type");
-        auto& ar = std::get<Matrix>(a).rows;
-        auto& br = std::get<Matrix>(b).rows;
+        auto& ar = get<Matrix>(a).rows;
+        auto& br = get<Matrix>(b).rows;
         if (ar.size() != 1 || br.size() != 1 || ar[0].size() != br[0].size())
             throw std::runtime_error("DOT requires vectors of equal length");
         size_t n = ar[0].size();
@@ -3048,9 +3514,9 @@ void CommandRegistry::register_display_commands() {
     register_command("FIX", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object obj = s.pop();
-        if (!std::holds_alternative<Integer>(obj))
+        if (!holds_alternative<Integer>(obj))
             throw std::runtime_error("FIX: expected Integer");
-        int n = std::get<Integer>(obj).convert_to<int>();
+        int n = get<Integer>(obj).convert_to<int>();
         if (n < 0 || n > 11) throw std::runtime_error("FIX: digits must be 0-11");
         s.set_meta("number_format", "FIX");
         s.set_meta("format_digits", std::to_string(n));
@@ -3059,9 +3525,9 @@ void CommandRegistry::register_display_commands() {
     register_command("SCI", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object obj = s.pop();
-        if (!std::holds_alternative<Integer>(obj))
+        if (!holds_alternative<Integer>(obj))
             throw std::runtime_error("SCI: expected Integer");
-        int n = std::get<Integer>(obj).convert_to<int>();
+        int n = get<Integer>(obj).convert_to<int>();
         if (n < 0 || n > 11) throw std::runtime_error("SCI: digits must be 0-11");
         s.set_meta("number_format", "SCI");
         s.set_meta("format_digits", std::to_string(n));
@@ -3070,9 +3536,9 @@ void CommandRegistry::register_display_commands() {
     register_command("ENG", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object obj = s.pop();
-        if (!std::holds_alternative<Integer>(obj))
+        if (!holds_alternative<Integer>(obj))
             throw std::runtime_error("ENG: expected Integer");
-        int n = std::get<Integer>(obj).convert_to<int>();
+        int n = get<Integer>(obj).convert_to<int>();
         if (n < 0 || n > 11) throw std::runtime_error("ENG: digits must be 0-11");
         s.set_meta("number_format", "ENG");
         s.set_meta("format_digits", std::to_string(n));
@@ -3098,8 +3564,8 @@ void CommandRegistry::register_flag_commands() {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object obj = s.pop();
         std::string name;
-        if (std::holds_alternative<String>(obj)) name = std::get<String>(obj).value;
-        else if (std::holds_alternative<Name>(obj)) name = std::get<Name>(obj).value;
+        if (holds_alternative<String>(obj)) name = get<String>(obj).value;
+        else if (holds_alternative<Name>(obj)) name = get<Name>(obj).value;
         else throw std::runtime_error("SF: expected String or Name");
         s.set_flag(name, 0, "1");
     });
@@ -3108,8 +3574,8 @@ void CommandRegistry::register_flag_commands() {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object obj = s.pop();
         std::string name;
-        if (std::holds_alternative<String>(obj)) name = std::get<String>(obj).value;
-        else if (std::holds_alternative<Name>(obj)) name = std::get<Name>(obj).value;
+        if (holds_alternative<String>(obj)) name = get<String>(obj).value;
+        else if (holds_alternative<Name>(obj)) name = get<Name>(obj).value;
         else throw std::runtime_error("CF: expected String or Name");
         s.set_flag(name, 0, "0");
     });
@@ -3118,8 +3584,8 @@ void CommandRegistry::register_flag_commands() {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object obj = s.pop();
         std::string name;
-        if (std::holds_alternative<String>(obj)) name = std::get<String>(obj).value;
-        else if (std::holds_alternative<Name>(obj)) name = std::get<Name>(obj).value;
+        if (holds_alternative<String>(obj)) name = get<String>(obj).value;
+        else if (holds_alternative<Name>(obj)) name = get<Name>(obj).value;
         else throw std::runtime_error("FS?: expected String or Name");
         auto flag = s.get_flag(name);
         if (flag && std::get<1>(*flag) == "1")
@@ -3132,8 +3598,8 @@ void CommandRegistry::register_flag_commands() {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object obj = s.pop();
         std::string name;
-        if (std::holds_alternative<String>(obj)) name = std::get<String>(obj).value;
-        else if (std::holds_alternative<Name>(obj)) name = std::get<Name>(obj).value;
+        if (holds_alternative<String>(obj)) name = get<String>(obj).value;
+        else if (holds_alternative<Name>(obj)) name = get<Name>(obj).value;
         else throw std::runtime_error("FC?: expected String or Name");
         auto flag = s.get_flag(name);
         if (!flag || std::get<1>(*flag) == "0")
@@ -3147,16 +3613,16 @@ void CommandRegistry::register_flag_commands() {
         Object name_obj = s.pop();
         Object val_obj = s.pop();
         std::string name;
-        if (std::holds_alternative<String>(name_obj)) name = std::get<String>(name_obj).value;
-        else if (std::holds_alternative<Name>(name_obj)) name = std::get<Name>(name_obj).value;
+        if (holds_alternative<String>(name_obj)) name = get<String>(name_obj).value;
+        else if (holds_alternative<Name>(name_obj)) name = get<Name>(name_obj).value;
         else throw std::runtime_error("SFLAG: expected String or Name for flag name");
 
-        if (std::holds_alternative<Integer>(val_obj)) {
-            s.set_flag(name, 1, std::get<Integer>(val_obj).str());
-        } else if (std::holds_alternative<Real>(val_obj)) {
-            s.set_flag(name, 2, std::get<Real>(val_obj).str());
-        } else if (std::holds_alternative<String>(val_obj)) {
-            s.set_flag(name, 3, std::get<String>(val_obj).value);
+        if (holds_alternative<Integer>(val_obj)) {
+            s.set_flag(name, 1, get<Integer>(val_obj).str());
+        } else if (holds_alternative<Real>(val_obj)) {
+            s.set_flag(name, 2, get<Real>(val_obj).str());
+        } else if (holds_alternative<String>(val_obj)) {
+            s.set_flag(name, 3, get<String>(val_obj).value);
         } else {
             throw std::runtime_error("SFLAG: unsupported value type");
         }
@@ -3166,8 +3632,8 @@ void CommandRegistry::register_flag_commands() {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object obj = s.pop();
         std::string name;
-        if (std::holds_alternative<String>(obj)) name = std::get<String>(obj).value;
-        else if (std::holds_alternative<Name>(obj)) name = std::get<Name>(obj).value;
+        if (holds_alternative<String>(obj)) name = get<String>(obj).value;
+        else if (holds_alternative<Name>(obj)) name = get<Name>(obj).value;
         else throw std::runtime_error("RFLAG: expected String or Name");
 
         auto flag = s.get_flag(name);
@@ -3206,34 +3672,34 @@ void CommandRegistry::register_flag_commands() {
     register_command("RCLF", [](Store& s, Context&) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object obj = s.pop();
-        if (!std::holds_alternative<List>(obj))
+        if (!holds_alternative<List>(obj))
             throw std::runtime_error("RCLF: expected List");
-        const auto& list = std::get<List>(obj);
+        const auto& list = get<List>(obj);
 
         s.clear_all_flags();
         for (const auto& item : list.items) {
-            if (!std::holds_alternative<List>(item))
+            if (!holds_alternative<List>(item))
                 throw std::runtime_error("RCLF: each element must be a { name value } list");
-            const auto& pair = std::get<List>(item);
+            const auto& pair = get<List>(item);
             if (pair.items.size() != 2)
                 throw std::runtime_error("RCLF: each element must have exactly 2 items");
-            if (!std::holds_alternative<String>(pair.items[0]))
+            if (!holds_alternative<String>(pair.items[0]))
                 throw std::runtime_error("RCLF: flag name must be a String");
-            const std::string& name = std::get<String>(pair.items[0]).value;
+            const std::string& name = get<String>(pair.items[0]).value;
             const auto& val = pair.items[1];
 
-            if (std::holds_alternative<Integer>(val)) {
+            if (holds_alternative<Integer>(val)) {
                 // Could be bool (0/1) or integer — store as integer type
-                int iv = std::get<Integer>(val).convert_to<int>();
+                int iv = get<Integer>(val).convert_to<int>();
                 if (iv == 0 || iv == 1) {
                     s.set_flag(name, 0, std::to_string(iv));
                 } else {
-                    s.set_flag(name, 1, std::get<Integer>(val).str());
+                    s.set_flag(name, 1, get<Integer>(val).str());
                 }
-            } else if (std::holds_alternative<Real>(val)) {
-                s.set_flag(name, 2, std::get<Real>(val).str());
-            } else if (std::holds_alternative<String>(val)) {
-                s.set_flag(name, 3, std::get<String>(val).value);
+            } else if (holds_alternative<Real>(val)) {
+                s.set_flag(name, 2, get<Real>(val).str());
+            } else if (holds_alternative<String>(val)) {
+                s.set_flag(name, 3, get<String>(val).value);
             } else {
                 throw std::runtime_error("RCLF: unsupported value type");
             }
@@ -3248,11 +3714,11 @@ void CommandRegistry::register_conversion_commands() {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object obj = s.pop();
         double dv;
-        if (std::holds_alternative<Real>(obj)) {
-            dv = std::get<Real>(obj).convert_to<double>();
-        } else if (std::holds_alternative<Integer>(obj)) {
+        if (holds_alternative<Real>(obj)) {
+            dv = get<Real>(obj).convert_to<double>();
+        } else if (holds_alternative<Integer>(obj)) {
             // Integer is already exact — wrap as rational
-            s.push(Rational(std::get<Integer>(obj), Integer(1)));
+            s.push(Rational(get<Integer>(obj), Integer(1)));
             return;
         } else {
             throw std::runtime_error("->Q: expected Real or Integer");
@@ -3283,10 +3749,10 @@ void CommandRegistry::register_conversion_commands() {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object obj = s.pop();
         Real hms;
-        if (std::holds_alternative<Real>(obj))
-            hms = std::get<Real>(obj);
-        else if (std::holds_alternative<Integer>(obj))
-            hms = Real(std::get<Integer>(obj));
+        if (holds_alternative<Real>(obj))
+            hms = get<Real>(obj);
+        else if (holds_alternative<Integer>(obj))
+            hms = Real(get<Integer>(obj));
         else
             throw std::runtime_error("HMS->: expected Real or Integer");
 
@@ -3305,10 +3771,10 @@ void CommandRegistry::register_conversion_commands() {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object obj = s.pop();
         Real dec;
-        if (std::holds_alternative<Real>(obj))
-            dec = std::get<Real>(obj);
-        else if (std::holds_alternative<Integer>(obj))
-            dec = Real(std::get<Integer>(obj));
+        if (holds_alternative<Real>(obj))
+            dec = get<Real>(obj);
+        else if (holds_alternative<Integer>(obj))
+            dec = Real(get<Integer>(obj));
         else
             throw std::runtime_error("->HMS: expected Real or Integer");
 
@@ -3326,19 +3792,122 @@ void CommandRegistry::register_conversion_commands() {
 
 // ---- CAS commands ----
 
+namespace {
+
+// A List or Matrix of expressions flattened for one batched CAS call.
+struct CasBatch {
+    std::vector<Object> exprs;
+    bool matrix = false;
+    size_t cols = 0;
+};
+
+bool is_cas_container(const Object& obj) {
+    return holds_alternative<List>(obj) || holds_alternative<Matrix>(obj);
+}
+
+// Names and numbers inside a batch become Symbols, so { X 'X^2' 3 } works
+Object as_cas_symbol(const Object& obj, const char* cmd) {
+    if (holds_alternative<Symbol>(obj)) return obj;
+    if (holds_alternative<Name>(obj) || is_numeric(obj)) return Symbol{object_expr_tree(obj)};
+    throw std::runtime_error(std::string(cmd) + " requires a symbolic expression");
+}
+
+CasBatch cas_batch(const Object& obj, const char* cmd) {
+    CasBatch batch;
+    if (holds_alternative<List>(obj)) {
+        for (const auto& item : get<List>(obj).items)
+            batch.exprs.push_back(as_cas_symbol(item, cmd));
+    } else {
+        const auto& rows = get<Matrix>(obj).rows;
+        batch.matrix = true;
+        batch.cols = rows.empty() ? 0 : rows[0].size();
+        for (const auto& row : rows)
+            for (const auto& item : row) batch.exprs.push_back(as_cas_symbol(item, cmd));
+    }
+    return batch;
+}
+
+// Put batch results back in the shape the inputs came in
+Object cas_unbatch(const CasBatch& batch, std::vector<Object> results) {
+    if (!batch.matrix) return List{std::move(results)};
+    Matrix m;
+    for (size_t i = 0; i < results.size(); i += batch.cols) {
+        m.rows.emplace_back(std::make_move_iterator(results.begin() + i),
+                            std::make_move_iterator(results.begin() + i + batch.cols));
+    }
+    return m;
+}
+
+// Variable names from a Name or a non-empty List of Names
+std::vector<std::string> cas_var_names(const Object& obj, const char* cmd) {
+    std::vector<std::string> vars;
+    if (holds_alternative<Name>(obj)) {
+        vars.push_back(get<Name>(obj).value);
+    } else if (holds_alternative<List>(obj)) {
+        for (const auto& v : get<List>(obj).items) {
+            if (!holds_alternative<Name>(v))
+                throw std::runtime_error(std::string(cmd) + ": variable must be a name");
+            vars.push_back(get<Name>(v).value);
+        }
+    }
+    if (vars.empty()) throw std::runtime_error(std::string(cmd) + ": variable must be a name");
+    return vars;
+}
+
+} // anonymous namespace
+
 void CommandRegistry::register_cas_commands() {
     // DIFF: (level 2: Symbol expr, level 1: Name var) → Symbol derivative
+    // A List or Matrix of expressions is differentiated element-wise in one
+    // CAS call; a List of variables gives the List of partial derivatives.
     register_command("DIFF", [](Store& s, Context& ctx) {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object var_obj = s.pop();
         Object expr_obj = s.pop();
-        if (!std::holds_alternative<Name>(var_obj)) {
+        bool var_list = holds_alternative<List>(var_obj);
+        if (!holds_alternative<Name>(var_obj) && !var_list) {
             s.push(expr_obj);
             s.push(var_obj);
             throw std::runtime_error("DIFF: variable must be a name");
         }
-        auto result = ctx.cas().differentiate(expr_obj, std::get<Name>(var_obj).value);
-        s.push(result);
+        if (is_cas_container(expr_obj)) {
+            if (var_list) throw std::runtime_error("DIFF: use JACOBIAN for several variables");
+            CasBatch batch = cas_batch(expr_obj, "DIFF");
+            auto results = ctx.cas().apply_batch(CASOp::Diff, batch.exprs,
+                                                 {get<Name>(var_obj).value});
+            s.push(cas_unbatch(batch, std::move(results)));
+        } else if (var_list) {
+            auto vars = cas_var_names(var_obj, "DIFF");
+            s.push(List{ctx.cas().apply_batch(CASOp::Diff, {expr_obj}, vars)});
+        } else {
+            auto result = ctx.cas().differentiate(expr_obj, get<Name>(var_obj).value);
+            s.push(result);
+        }
+    });
+
+    // GRADIENT: ( 'f' { x1 ... xn } -- { df/dx1 ... df/dxn } )
+    // (GRAD is taken by the angle mode)
+    register_command("GRADIENT", [](Store& s, Context& ctx) {
+        if (s.depth() < 2) throw std::runtime_error("Too few arguments");
+        Object vars_obj = s.pop();
+        Object expr_obj = s.pop();
+        auto vars = cas_var_names(vars_obj, "GRADIENT");
+        s.push(List{ctx.cas().apply_batch(CASOp::Diff, {as_cas_symbol(expr_obj, "GRADIENT")}, vars)});
+    });
+
+    // JACOBIAN: ( { f1 ... fm } { x1 ... xn } -- m×n Matrix of dfi/dxj )
+    register_command("JACOBIAN", [](Store& s, Context& ctx) {
+        if (s.depth() < 2) throw std::runtime_error("Too few arguments");
+        Object vars_obj = s.pop();
+        Object funcs_obj = s.pop();
+        if (!holds_alternative<List>(funcs_obj)) throw std::runtime_error("Bad argument type");
+        auto vars = cas_var_names(vars_obj, "JACOBIAN");
+        CasBatch batch = cas_batch(funcs_obj, "JACOBIAN");
+        if (batch.exprs.empty()) throw std::runtime_error("Bad argument value");
+        // Results come back row-major: function by function, variable by variable
+        batch.matrix = true;
+        batch.cols = vars.size();
+        s.push(cas_unbatch(batch, ctx.cas().apply_batch(CASOp::Diff, batch.exprs, vars)));
     });
 
     // INTEGRATE: (level 2: Symbol expr, level 1: Name var) → Symbol antiderivative
@@ -3346,12 +3915,12 @@ void CommandRegistry::register_cas_commands() {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object var_obj = s.pop();
         Object expr_obj = s.pop();
-        if (!std::holds_alternative<Name>(var_obj)) {
+        if (!holds_alternative<Name>(var_obj)) {
             s.push(expr_obj);
             s.push(var_obj);
             throw std::runtime_error("INTEGRATE: variable must be a name");
         }
-        auto result = ctx.cas().integrate(expr_obj, std::get<Name>(var_obj).value);
+        auto result = ctx.cas().integrate(expr_obj, get<Name>(var_obj).value);
         s.push(result);
     });
 
@@ -3360,27 +3929,37 @@ void CommandRegistry::register_cas_commands() {
         if (s.depth() < 2) throw std::runtime_error("Too few arguments");
         Object var_obj = s.pop();
         Object expr_obj = s.pop();
-        if (!std::holds_alternative<Name>(var_obj)) {
+        if (!holds_alternative<Name>(var_obj)) {
             s.push(expr_obj);
             s.push(var_obj);
             throw std::runtime_error("SOLVE: variable must be a name");
         }
-        auto result = ctx.cas().solve(expr_obj, std::get<Name>(var_obj).value);
+        auto result = ctx.cas().solve(expr_obj, get<Name>(var_obj).value);
         s.push(result);
     });
 
-    // SIMPLIFY: (level 1: Symbol expr) → Symbol simplified
+    // SIMPLIFY: (level 1: Symbol expr) → Symbol simplified (List/Matrix: each element)
     register_command("SIMPLIFY", [](Store& s, Context& ctx) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object expr_obj = s.pop();
+        if (is_cas_container(expr_obj)) {
+            CasBatch batch = cas_batch(expr_obj, "SIMPLIFY");
+            s.push(cas_unbatch(batch, ctx.cas().apply_batch(CASOp::Simplify, batch.exprs, {})));
+            return;
+        }
         auto result = ctx.cas().simplify(expr_obj);
         s.push(result);
     });
 
-    // EXPAND: (level 1: Symbol expr) → Symbol expanded
+    // EXPAND: (level 1: Symbol expr) → Symbol expanded (List/Matrix: each element)
     register_command("EXPAND", [](Store& s, Context& ctx) {
         if (s.depth() < 1) throw std::runtime_error("Too few arguments");
         Object expr_obj = s.pop();
+        if (is_cas_container(expr_obj)) {
+            CasBatch batch = cas_batch(expr_obj, "EXPAND");
+            s.push(cas_unbatch(batch, ctx.cas().apply_batch(CASOp::Expand, batch.exprs, {})));
+            return;
+        }
         auto result = ctx.cas().expand(expr_obj);
         s.push(result);
     });
@@ -3392,6 +3971,33 @@ void CommandRegistry::register_cas_commands() {
         auto result = ctx.cas().factor(expr_obj);
         s.push(result);
     });
+
+    // CASCACHE: (level 1: Integer 0/1) → persist CAS results in the database
+    register_command("CASCACHE", [](Store& s, Context&) {
+        if (s.depth() < 1) throw std::runtime_error("Too few arguments");
+        Object n_obj = s.pop();
+        if (!holds_alternative<Integer>(n_obj))
+            throw std::runtime_error("Bad argument type");
+        const auto& n = get<Integer>(n_obj);
+        if (n != 0 && n != 1) throw std::runtime_error("Bad argument value");
+        s.set_meta("cas_cache_persist", n.str());
+    });
+
+    // CASLIMIT: (level 2: Integer ms, level 1: Integer nodes) → time and size
+    // budget for each CAS call (0 = unlimited)
+    register_command("CASLIMIT", [](Store& s, Context&) {
+        if (s.depth() < 2) throw std::runtime_error("Too few arguments");
+        Object nodes_obj = s.pop();
+        Object ms_obj = s.pop();
+        if (!holds_alternative<Integer>(ms_obj) || !holds_alternative<Integer>(nodes_obj))
+            throw std::runtime_error("Bad argument type");
+        const auto& ms = get<Integer>(ms_obj);
+        const auto& nodes = get<Integer>(nodes_obj);
+        if (ms < 0 || nodes < 0 || ms > 86400000 || nodes > 100000000)
+            throw std::runtime_error("Bad argument value");
+        s.set_meta("cas_timeout_ms", ms.str());
+        s.set_meta("cas_max_nodes", nodes.str());
+    });
 }
 
 } // namespace lpr
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "core/arena.hpp"
 #include "core/object.hpp"
 #include "core/store.hpp"
 #include "cas/bridge.hpp"
@@ -14,6 +15,18 @@ class Context; // forward
 
 using CommandFn = std::function<void(Store&, Context&)>;
 
+// A command that is a pure function of its arguments. Registered as a normal
+// stack command, and also callable directly from expression evaluation
+// ('ATAN2(Y, X)') without a round-trip through the stack store. The argument
+// list lives in the exec arena; copy what must outlive the call.
+using Args = ArenaVector<Object>;
+using NativeFn = std::function<Object(const Args& args, Context&)>;
+
+struct NativeFunction {
+    int arity;
+    NativeFn fn;
+};
+
 class CommandRegistry {
 public:
     CommandRegistry();
@@ -22,8 +35,13 @@ public:
     bool has(const std::string& name) const;
     void execute(const std::string& name, Store& store, Context& ctx) const;
 
+    // args[0] is the deepest stack argument (the first in FUNC(a, b)).
+    void register_function(const std::string& name, int arity, NativeFn fn);
+    const NativeFunction* find_function(const std::string& upper_name) const;
+
 private:
     std::unordered_map<std::string, CommandFn> commands_;
+    std::unordered_map<std::string, NativeFunction> functions_;
 
     void register_stack_commands();
     void register_arithmetic_commands();
@@ -33,8 +51,10 @@ private:
     void register_program_commands();
     void register_logic_commands();
     void register_transcendental_commands();
+    void register_number_theory_commands();
     void register_string_commands();
     void register_symbolic_commands();
+    void register_polynomial_commands();
     void register_list_commands();
     void register_matrix_commands();
     void register_display_commands();
@@ -1,6 +1,10 @@
 #include "core/context.hpp"
 #include "core/parser.hpp"
+#include "core/fusion.hpp"
+#include "core/expression.hpp"
 #include "cas/bridge.hpp"
+#include "cas/caching_bridge.hpp"
+#include "cas/guarded_bridge.hpp"
 #include "cas/symengine_bridge.hpp"
 #include <stdexcept>
 #include <algorithm>
@@ -14,40 +18,55 @@ static std::string to_upper(const std::string& s) {
     return u;
 }
 
-// Helper: collect tokens from position i until a keyword at nesting depth 0.
+// Case-insensitive match of a command token against an uppercase keyword,
+// without building an uppercased copy.
+static bool is_keyword(const std::string& cmd, const char* kw) {
+    size_t n = 0;
+    for (; kw[n]; ++n) {
+        if (n >= cmd.size() || std::toupper(static_cast<unsigned char>(cmd[n])) != kw[n]) return false;
+    }
+    return n == cmd.size();
+}
+
+static bool is_keyword_token(const Token& t, const char* kw) {
+    return t.kind == Token::Command && is_keyword(t.command, kw);
+}
+
+// Helper: the tokens from position i until a keyword at nesting depth 0, as
+// a view into `tokens` (which outlives every use of the result).
 // Properly tracks nesting: FOR/START close with NEXT/STEP, others close with END.
-static std::vector<Token> collect_until(
-    const std::vector<Token>& tokens, size_t& i,
-    const std::vector<std::string>& stop_keywords)
+static TokenSpan collect_until(
+    TokenSpan tokens, size_t& i,
+    std::initializer_list<const char*> stop_keywords)
 {
-    std::vector<Token> collected;
+    size_t start = i;
     // Stack of expected closers: 'E' = END, 'N' = NEXT/STEP
     std::vector<char> nest;
     while (i < tokens.size()) {
         const auto& t = tokens[i];
         if (t.kind == Token::Command) {
-            std::string cmd = to_upper(t.command);
+            const std::string& cmd = t.command;
             if (nest.empty()) {
-                for (const auto& kw : stop_keywords) {
-                    if (cmd == kw) return collected;
+                for (const char* kw : stop_keywords) {
+                    if (is_keyword(cmd, kw)) return tokens.subspan(start, i - start);
                 }
             }
             // Track nesting opens
-            if (cmd == "IF" || cmd == "CASE" || cmd == "WHILE" || cmd == "DO") {
+            if (is_keyword(cmd, "IF") || is_keyword(cmd, "CASE") ||
+                is_keyword(cmd, "WHILE") || is_keyword(cmd, "DO")) {
                 nest.push_back('E'); // closed by END
-            } else if (cmd == "FOR" || cmd == "START") {
+            } else if (is_keyword(cmd, "FOR") || is_keyword(cmd, "START")) {
                 nest.push_back('N'); // closed by NEXT or STEP
             }
             // Track nesting closes
             if (!nest.empty()) {
-                if (nest.back() == 'E' && cmd == "END") {
+                if (nest.back() == 'E' && is_keyword(cmd, "END")) {
                     nest.pop_back();
-                } else if (nest.back() == 'N' && (cmd == "NEXT" || cmd == "STEP")) {
+                } else if (nest.back() == 'N' && (is_keyword(cmd, "NEXT") || is_keyword(cmd, "STEP"))) {
                     nest.pop_back();
                 }
             }
         }
-        collected.push_back(t);
         ++i;
     }
     throw std::runtime_error("Unexpected end of tokens in control structure");
@@ -55,21 +74,71 @@ static std::vector<Token> collect_until(
 
 Context::Context(const char* db_path)
     : store_(db_path)
-    , cas_bridge_(std::make_unique<SymEngineBridge>())
-{}
+    , cas_bridge_(std::make_unique<CachingCASBridge>(
+          std::make_unique<GuardedCASBridge>(
+              [] { return std::make_unique<SymEngineBridge>(); }, store_),
+          store_))
+    , expr_cache_(std::make_unique<ExprCache>())
+    , parse_cache_(std::make_unique<ParseCache>())
+    , fusion_hits_(fusion_rules().size(), 0)
+{
+    store_.set_parse_cache(parse_cache_.get());
+}
 
 Context::~Context() = default;
 
 CASBridge& Context::cas() { return *cas_bridge_; }
 
+std::vector<std::pair<std::string, int64_t>> Context::perf_stats() const {
+    auto n = [](auto v) { return static_cast<int64_t>(v); };
+    std::vector<std::pair<std::string, int64_t>> stats = {
+        {"expr_cache_hits",        n(expr_cache_->hits())},
+        {"expr_cache_misses",      n(expr_cache_->misses())},
+        {"expr_cache_evictions",   n(expr_cache_->evictions())},
+        {"expr_cache_size",        n(expr_cache_->size())},
+        {"parse_cache_hits",       n(parse_cache_->hits())},
+        {"parse_cache_misses",     n(parse_cache_->misses())},
+        {"parse_cache_evictions",  n(parse_cache_->evictions())},
+        {"parse_cache_size",       n(parse_cache_->size())},
+        {"parse_cache_symbol_hits", n(parse_cache_->symbol_hits())},
+        {"arena_allocations",      n(arena_.allocations())},
+        {"arena_blocks",           n(arena_.blocks())},
+        {"atom_table_size",        n(Atom::table_size())},
+    };
+    const auto& rules = fusion_rules();
+    for (size_t r = 0; r < rules.size(); ++r) {
+        stats.push_back({"fusion_" + rules[r].name, fusion_hits_[r]});
+    }
+    stats.push_back({"fusion_fallbacks", fusion_fallbacks_});
+    stats.push_back({"call_frames_peak", n(frames_peak_)});
+    for (auto& stat : cas_bridge_->stats()) stats.push_back(std::move(stat));
+    return stats;
+}
+
+// The CALLMEM setting, in KiB
+void Context::load_call_memory() {
+    std::string kib = store_.get_meta(kCallMemoryKey);
+    if (kib.empty()) {
+        call_memory_ = kDefaultCallMemory;
+        return;
+    }
+    try { call_memory_ = std::stoull(kib) << 10; } catch (...) { call_memory_ = kDefaultCallMemory; }
+}
+
 bool Context::exec(const std::string& input) {
+    // Nothing allocated from the arena outlives the exec that made it; a
+    // nested exec must leave the outer one's temporaries alone.
+    ArenaScope arena_scope(*this);
+
     store_.begin();
     try {
+        if (exec_depth_ == 1) load_call_memory();
+
         // Snapshot BEFORE mutation (so we can undo back to this state)
         int pre_seq = store_.snapshot_stack();
 
-        auto tokens = parse(input);
-        execute_tokens(tokens);
+        auto tokens = parse_cache_->get(input);
+        execute_tokens(*tokens);
 
         // Snapshot AFTER mutation (the result state)
         int post_seq = store_.snapshot_stack();
@@ -87,19 +156,252 @@ bool Context::exec(const std::string& input) {
     }
 }
 
+bool Context::exec_stream(const ReadFn& read, size_t checkpoint_bytes) {
+    ArenaScope arena_scope(*this);
+    StreamSplitter splitter;
+    std::vector<char> chunk(64 * 1024);
+    size_t since_checkpoint = 0;
+
+    // Like exec, the stream is bracketed by a pre and a post snapshot, so
+    // it is one undo step however many checkpoints it spans. Snapshots copy
+    // the whole stack, so none are taken in between. A stream that ran
+    // nothing takes neither, and leaves no empty undo step.
+    bool started = false;
+    bool committed = false; // the pre snapshot is past a checkpoint
+    // Pieces are not put in the parse cache: each is seen once
+    auto run = [&](const std::string& piece) {
+        if (piece.empty()) return;
+        if (!started) {
+            store_.snapshot_stack();
+            started = true;
+        }
+        execute_tokens(parse(piece));
+    };
+
+    store_.begin();
+    try {
+        if (exec_depth_ == 1) load_call_memory();
+        for (;;) {
+            long n = read(chunk.data(), chunk.size());
+            if (n < 0) throw std::runtime_error("Read error");
+            if (n == 0) break;
+            splitter.feed({chunk.data(), static_cast<size_t>(n)});
+            run(splitter.take());
+
+            since_checkpoint += static_cast<size_t>(n);
+            if (checkpoint_bytes > 0 && since_checkpoint >= checkpoint_bytes && started) {
+                store_.commit();
+                store_.begin();
+                committed = true;
+                since_checkpoint = 0;
+                if (exec_depth_ == 1) arena_.reset();
+            }
+        }
+        run(splitter.finish());
+        if (started) store_.snapshot_stack();
+        store_.commit();
+        return true;
+    } catch (const std::exception& e) {
+        store_.rollback();
+
+        store_.begin();
+        store_.push(Error{100, e.what()});
+        // Close the undo step opened by a committed pre snapshot
+        if (committed) store_.snapshot_stack();
+        store_.commit();
+        return false;
+    }
+}
+
 static bool is_arrow_command(const std::string& cmd) {
     return cmd == "->" || cmd == "\xe2\x86\x92";
 }
 
+// Position of the END that closes a CASE whose first clause is at i (or the
+// end of the tokens, if it is missing)
+static size_t case_end(TokenSpan tokens, size_t i) {
+    while (i < tokens.size() && !is_keyword_token(tokens[i], "END")) {
+        collect_until(tokens, i, {"THEN", "END"});
+        if (i < tokens.size() && is_keyword_token(tokens[i], "END")) break; // default clause
+        ++i; // skip THEN
+        collect_until(tokens, i, {"END"});
+        ++i; // skip the END closing this clause
+    }
+    return i;
+}
+
+// A popped condition result: nonzero Integer and Real are true, anything
+// else is false
+static bool is_true(const Object& val) {
+    if (holds_alternative<Integer>(val)) return get<Integer>(val) != 0;
+    if (holds_alternative<Real>(val)) return get<Real>(val) != 0;
+    return false;
+}
+
+static Real loop_real(const Object& o, const char* error) {
+    if (holds_alternative<Integer>(o)) return Real(get<Integer>(o));
+    if (holds_alternative<Real>(o)) return get<Real>(o);
+    throw std::runtime_error(error);
+}
+
 void Context::execute_tokens(const std::vector<Token>& tokens) {
-    for (size_t i = 0; i < tokens.size(); ++i) {
+    execute_tokens(TokenSpan(tokens));
+}
+
+// Runs the fused run starting at tokens[i] and leaves i on its last token.
+// False when the operation declined; the tokens then run one by one.
+bool Context::run_fused(TokenSpan tokens, size_t& i) {
+    size_t rule = tokens[i].fusion - 1;
+    const FusionRule& r = fusion_rules()[rule];
+    if (i + r.pattern.size() > tokens.size() || !r.fn(store_, &tokens[i])) {
+        ++fusion_fallbacks_;
+        return false;
+    }
+    ++fusion_hits_[rule];
+    i += r.pattern.size() - 1;
+    return true;
+}
+
+// The interpreter keeps no state on the native stack between tokens: a
+// nested program, -> body, IF branch or loop body is pushed as a frame on
+// frames_ and run by the loop below. A command that runs a program itself
+// (MAP, IFTE, ...) starts a nested loop whose frames sit above its caller's.
+void Context::execute_tokens(TokenSpan tokens) {
+    char marker;
+    if (native_depth_ == 0) native_base_ = reinterpret_cast<uintptr_t>(&marker);
+    size_t used = native_bytes();
+    if (used > kNativeStackLimit ||
+        frames_.size() * sizeof(Frame) + local_bytes_ + used > call_memory_) {
+        throw std::runtime_error("Insufficient Memory");
+    }
+    size_t base = frames_.size();
+    size_t scope_base = local_scopes_.size();
+    size_t outer_base = run_base_;
+    SharedTokens* outer_defer = defer_to_;
+    run_base_ = base;
+    defer_to_ = nullptr;
+    ++native_depth_;
+    try {
+        push_run(tokens);
+        while (frames_.size() > base) {
+            if (frames_.back().kind == Frame::Run) run(frames_.size() - 1);
+            else resume();
+        }
+    } catch (...) {
+        frames_.erase(frames_.begin() + base, frames_.end());
+        while (local_scopes_.size() > scope_base) pop_locals();
+        run_base_ = outer_base;
+        defer_to_ = outer_defer;
+        --native_depth_;
+        throw;
+    }
+    run_base_ = outer_base;
+    defer_to_ = outer_defer;
+    --native_depth_;
+}
+
+// How far the native stack has grown since the outermost execute_tokens
+size_t Context::native_bytes() const {
+    if (native_depth_ == 0) return 0;
+    char marker;
+    uintptr_t here = reinterpret_cast<uintptr_t>(&marker);
+    return here < native_base_ ? native_base_ - here : here - native_base_;
+}
+
+void Context::run_program(SharedTokens program) {
+    if (defer_to_) {
+        *defer_to_ = std::move(program);
+        defer_to_ = nullptr;  // one program per dispatch
+        return;
+    }
+    execute_tokens(*program);
+}
+
+// Runs cmd, token i of frames_[fi]. A program the command
+// leaves with run_program is pushed as a frame, a tail call when the
+// command ends the body; returns true if so.
+bool Context::dispatch(const Atom& cmd, size_t fi, size_t i) {
+    SharedTokens deferred;
+    SharedTokens* outer_defer = defer_to_;
+    defer_to_ = &deferred;
+    try {
+        commands_.execute(cmd, store_, *this);
+    } catch (...) {
+        defer_to_ = outer_defer;
+        throw;
+    }
+    defer_to_ = outer_defer;
+    if (!deferred) return false;
+    frames_[fi].pc = i + 1;
+    TokenSpan body(*deferred);
+    push_run(body, std::move(deferred));
+    return true;
+}
+
+// Pushes a frame. A Run frame on top with no tokens left is replaced rather
+// than kept: it would only be popped when the new frame finishes, so the new
+// frame takes over its local scopes and its tokens instead. This makes a
+// program, EVAL or control structure at the end of a body a tail call.
+void Context::push_frame(Frame frame) {
+    if (frames_.size() > run_base_) {
+        Frame& top = frames_.back();
+        if (top.kind == Frame::Run && top.pc == top.tokens.size()) {
+            frame.scopes += top.scopes;
+            if (!frame.owner) frame.owner = std::move(top.owner);
+            frames_.pop_back();
+        }
+    }
+    if ((frames_.size() + 1) * sizeof(Frame) + local_bytes_ + native_bytes() > call_memory_) {
+        throw std::runtime_error("Insufficient Memory");
+    }
+    frames_.push_back(std::move(frame));
+    frames_peak_ = std::max(frames_peak_, frames_.size());
+}
+
+void Context::push_run(TokenSpan tokens, SharedTokens owner, uint32_t scopes) {
+    Frame frame;
+    frame.tokens = tokens;
+    frame.owner = std::move(owner);
+    frame.scopes = scopes;
+    push_frame(std::move(frame));
+}
+
+void Context::finish_frame() {
+    for (uint32_t k = frames_.back().scopes; k > 0; --k) pop_locals();
+    frames_.pop_back();
+}
+
+// EVAL of a Program, or of a Name holding one, is run here as a frame rather
+// than by the command, so that it can be a tail call: the operand is popped
+// and the program returned. Anything else is put back for the command.
+SharedTokens Context::eval_operand() {
+    if (store_.depth() < 1) return nullptr;
+    Object a = store_.pop();
+    if (holds_alternative<Program>(a)) {
+        return std::make_shared<const std::vector<Token>>(std::move(get<Program>(a).tokens));
+    }
+    if (holds_alternative<Name>(a)) {
+        SharedTokens program;
+        store_.recall_variable(store_.current_dir(), get<Name>(a).value, &program);
+        if (program) return program;
+    }
+    store_.push(a);
+    return nullptr;
+}
+
+// Runs frames_[fi], the top frame, until it finishes or pushes a frame
+void Context::run(size_t fi) {
+    TokenSpan tokens = frames_[fi].tokens;
+    for (size_t i = frames_[fi].pc; i < tokens.size(); ++i) {
         const auto& tok = tokens[i];
-        if (tok.kind == Token::Literal) {
+        if (tok.fusion && fusion_enabled_ && run_fused(tokens, i)) {
+            continue;
+        } else if (tok.kind == Token::Literal) {
             store_.push(tok.literal);
         } else if (is_arrow_command(tok.command)) {
             // Runstream-consuming: collect parameter names until we hit
             // a Symbol or Program token (the body).
-            std::vector<std::string> names;
+            ArenaVector<std::string> names{ArenaAllocator<std::string>(&arena_)};
             ++i;
             while (i < tokens.size()) {
                 const auto& t = tokens[i];
@@ -125,7 +427,7 @@ void Context::execute_tokens(const std::vector<Token>& tokens) {
             }
             std::unordered_map<std::string, Object> frame;
             // Pop in reverse: last name gets level 1, first name gets level N
-            std::vector<Object> vals(n);
+            ArenaVector<Object> vals(n, ArenaAllocator<Object>(&arena_));
             for (int j = n - 1; j >= 0; --j) {
                 vals[j] = store_.pop();
             }
@@ -133,14 +435,18 @@ void Context::execute_tokens(const std::vector<Token>& tokens) {
                 frame[names[j]] = std::move(vals[j]);
             }
 
-            push_locals(frame);
+            push_locals(std::move(frame));
 
             const auto& body_tok = tokens[i];
             if (body_tok.kind == Token::Literal &&
-                std::holds_alternative<Program>(body_tok.literal)) {
-                execute_tokens(std::get<Program>(body_tok.literal).tokens);
+                holds_alternative<Program>(body_tok.literal)) {
+                // The body's frame owns the scope
+                frames_[fi].pc = i + 1;
+                push_run(get<Program>(body_tok.literal).tokens, nullptr, 1);
+                drop_shadowed_scopes();
+                return;
             } else if (body_tok.kind == Token::Literal &&
-                       std::holds_alternative<Symbol>(body_tok.literal)) {
+                       holds_alternative<Symbol>(body_tok.literal)) {
                 // Evaluate the symbol expression
                 store_.push(body_tok.literal);
                 commands_.execute("EVAL", store_, *this);
@@ -157,230 +463,114 @@ void Context::execute_tokens(const std::vector<Token>& tokens) {
 
             if (cmd == "IF") {
                 // IF ... THEN ... [ELSE ...] END
+                Frame frame;
+                frame.kind = Frame::If;
                 // Collect condition tokens up to THEN
                 ++i;
-                auto cond_tokens = collect_until(tokens, i, {"THEN"});
+                frame.tokens = collect_until(tokens, i, {"THEN"});
                 ++i; // skip THEN
                 // Collect then-body up to ELSE or END
-                auto then_tokens = collect_until(tokens, i, {"ELSE", "END"});
-                std::vector<Token> else_tokens;
-                if (i < tokens.size() && tokens[i].kind == Token::Command && to_upper(tokens[i].command) == "ELSE") {
+                frame.first = collect_until(tokens, i, {"ELSE", "END"});
+                if (i < tokens.size() && is_keyword_token(tokens[i], "ELSE")) {
                     ++i; // skip ELSE
-                    else_tokens = collect_until(tokens, i, {"END"});
-                }
-                // i now points to END, loop increment will advance past it
-
-                // Execute condition
-                execute_tokens(cond_tokens);
-                if (store_.depth() < 1) throw std::runtime_error("IF: missing condition result");
-                Object cond_val = store_.pop();
-                bool cond_true = false;
-                if (std::holds_alternative<Integer>(cond_val)) cond_true = std::get<Integer>(cond_val) != 0;
-                else if (std::holds_alternative<Real>(cond_val)) cond_true = std::get<Real>(cond_val) != 0;
-                else throw std::runtime_error("IF: condition must be numeric");
-
-                if (cond_true) {
-                    execute_tokens(then_tokens);
-                } else if (!else_tokens.empty()) {
-                    execute_tokens(else_tokens);
+                    frame.second = collect_until(tokens, i, {"END"});
                 }
+                // i now points to END
+                frames_[fi].pc = i + 1;
+                push_frame(std::move(frame));
+                return;
 
             } else if (cmd == "CASE") {
                 // CASE val1 THEN body1 END val2 THEN body2 END ... [default] END
-                ++i;
-                bool matched = false;
-                while (i < tokens.size()) {
-                    const auto& ct = tokens[i];
-                    // Check for final END (closes CASE)
-                    if (ct.kind == Token::Command && to_upper(ct.command) == "END") {
-                        break; // end of CASE
-                    }
-                    // Collect tokens up to THEN or END
-                    auto test_tokens = collect_until(tokens, i, {"THEN", "END"});
-                    if (i < tokens.size() && tokens[i].kind == Token::Command && to_upper(tokens[i].command) == "END") {
-                        // This is the default clause (no THEN found) — test_tokens is the default body
-                        if (!matched) {
-                            execute_tokens(test_tokens);
-                        }
-                        break; // END closes CASE
-                    }
-                    // We hit THEN
-                    ++i; // skip THEN
-                    auto body_tokens = collect_until(tokens, i, {"END"});
-                    ++i; // skip END (the one closing this THEN clause)
-
-                    if (!matched) {
-                        execute_tokens(test_tokens);
-                        if (store_.depth() < 1) throw std::runtime_error("CASE: missing test result");
-                        Object test_val = store_.pop();
-                        bool test_true = false;
-                        if (std::holds_alternative<Integer>(test_val)) test_true = std::get<Integer>(test_val) != 0;
-                        else if (std::holds_alternative<Real>(test_val)) test_true = std::get<Real>(test_val) != 0;
-                        if (test_true) {
-                            execute_tokens(body_tokens);
-                            matched = true;
-                            // Skip remaining clauses until final END
-                        }
-                    }
-                }
-                // i points to the final END of CASE
+                size_t end = case_end(tokens, i + 1);
+                Frame frame;
+                frame.kind = Frame::Case;
+                // The clauses and the final END
+                frame.tokens = tokens.subspan(i + 1, std::min(end + 1, tokens.size()) - (i + 1));
+                frames_[fi].pc = end + 1;
+                push_frame(std::move(frame));
+                return;
 
-            } else if (cmd == "FOR") {
+            } else if (cmd == "FOR" || cmd == "START") {
                 // FOR varname body NEXT  or  FOR varname body STEP
+                // START body NEXT  or  START body STEP
+                bool is_for = cmd == "FOR";
+                auto loop = std::make_unique<Loop>();
                 ++i;
-                if (i >= tokens.size() || tokens[i].kind != Token::Command) {
-                    throw std::runtime_error("FOR: expected variable name");
+                if (is_for) {
+                    if (i >= tokens.size() || tokens[i].kind != Token::Command) {
+                        throw std::runtime_error("FOR: expected variable name");
+                    }
+                    loop->var = tokens[i].command; // preserve case
+                    ++i;
                 }
-                std::string var_name = tokens[i].command; // preserve case
-                ++i;
                 // Collect body up to NEXT or STEP
-                auto body_tokens = collect_until(tokens, i, {"NEXT", "STEP"});
-                bool has_step = (i < tokens.size() && tokens[i].kind == Token::Command && to_upper(tokens[i].command) == "STEP");
+                Frame frame;
+                frame.kind = is_for ? Frame::For : Frame::Start;
+                frame.first = collect_until(tokens, i, {"NEXT", "STEP"});
+                loop->has_step = (i < tokens.size() && is_keyword_token(tokens[i], "STEP"));
                 // i points to NEXT or STEP
 
                 // Pop start and end from stack
-                if (store_.depth() < 2) throw std::runtime_error("FOR: Too few arguments");
-                Object end_obj = store_.pop();
-                Object start_obj = store_.pop();
-
-                auto to_real = [](const Object& o) -> Real {
-                    if (std::holds_alternative<Integer>(o)) return Real(std::get<Integer>(o));
-                    if (std::holds_alternative<Real>(o)) return std::get<Real>(o);
-                    throw std::runtime_error("FOR: arguments must be numeric");
-                };
-                Real start_r = to_real(start_obj);
-                Real end_r = to_real(end_obj);
-                Real step_r = 1;
-                Real counter = start_r;
-                bool use_int = std::holds_alternative<Integer>(start_obj);
-                bool first = true;
-
-                for (;;) {
-                    // Termination check (skip on first iteration for STEP since step is unknown)
-                    if (!first || !has_step) {
-                        if (step_r > 0 && counter > end_r) break;
-                        if (step_r < 0 && counter < end_r) break;
-                    }
-                    first = false;
-
-                    // Bind loop variable
-                    std::unordered_map<std::string, Object> frame;
-                    if (use_int) {
-                        Integer ic(counter);
-                        frame[var_name] = ic;
-                    } else {
-                        frame[var_name] = counter;
-                    }
-                    push_locals(frame);
-                    execute_tokens(body_tokens);
-                    pop_locals();
-
-                    if (has_step) {
-                        if (store_.depth() < 1) throw std::runtime_error("STEP: missing step value");
-                        Object step_obj = store_.pop();
-                        step_r = to_real(step_obj);
-                    }
-
-                    counter += step_r;
+                if (store_.depth() < 2) {
+                    throw std::runtime_error(is_for ? "FOR: Too few arguments" : "START: Too few arguments");
                 }
-
-            } else if (cmd == "START") {
-                // START body NEXT  or  START body STEP
-                ++i;
-                auto body_tokens = collect_until(tokens, i, {"NEXT", "STEP"});
-                bool has_step = (i < tokens.size() && tokens[i].kind == Token::Command && to_upper(tokens[i].command) == "STEP");
-                // i points to NEXT or STEP
-
-                if (store_.depth() < 2) throw std::runtime_error("START: Too few arguments");
                 Object end_obj = store_.pop();
                 Object start_obj = store_.pop();
-
-                auto to_real = [](const Object& o) -> Real {
-                    if (std::holds_alternative<Integer>(o)) return Real(std::get<Integer>(o));
-                    if (std::holds_alternative<Real>(o)) return std::get<Real>(o);
-                    throw std::runtime_error("START: arguments must be numeric");
-                };
-                Real start_r = to_real(start_obj);
-                Real end_r = to_real(end_obj);
-                Real step_r = 1;
-                Real counter = start_r;
-                bool first = true;
-
-                for (;;) {
-                    if (!first || !has_step) {
-                        if (step_r > 0 && counter > end_r) break;
-                        if (step_r < 0 && counter < end_r) break;
-                    }
-                    first = false;
-
-                    execute_tokens(body_tokens);
-
-                    if (has_step) {
-                        if (store_.depth() < 1) throw std::runtime_error("STEP: missing step value");
-                        Object step_obj = store_.pop();
-                        step_r = to_real(step_obj);
-                    }
-
-                    counter += step_r;
-                }
-
-            } else if (cmd == "WHILE") {
+                const char* not_numeric = is_for ? "FOR: arguments must be numeric"
+                                                 : "START: arguments must be numeric";
+                loop->counter = loop_real(start_obj, not_numeric);
+                loop->end = loop_real(end_obj, not_numeric);
+                loop->use_int = holds_alternative<Integer>(start_obj);
+                frame.loop = std::move(loop);
+                frames_[fi].pc = i + 1;
+                push_frame(std::move(frame));
+                return;
+
+            } else if (cmd == "WHILE" || cmd == "DO") {
                 // WHILE condition REPEAT body END
-                ++i;
-                auto cond_tokens = collect_until(tokens, i, {"REPEAT"});
-                ++i; // skip REPEAT
-                auto body_tokens = collect_until(tokens, i, {"END"});
-                // i points to END
-
-                for (;;) {
-                    execute_tokens(cond_tokens);
-                    if (store_.depth() < 1) throw std::runtime_error("WHILE: missing condition result");
-                    Object cond_val = store_.pop();
-                    bool cond_true = false;
-                    if (std::holds_alternative<Integer>(cond_val)) cond_true = std::get<Integer>(cond_val) != 0;
-                    else if (std::holds_alternative<Real>(cond_val)) cond_true = std::get<Real>(cond_val) != 0;
-                    if (!cond_true) break;
-                    execute_tokens(body_tokens);
-                }
-
-            } else if (cmd == "DO") {
                 // DO body UNTIL condition END
+                Frame frame;
+                frame.kind = cmd == "WHILE" ? Frame::While : Frame::Do;
                 ++i;
-                auto body_tokens = collect_until(tokens, i, {"UNTIL"});
-                ++i; // skip UNTIL
-                auto cond_tokens = collect_until(tokens, i, {"END"});
+                frame.first = collect_until(tokens, i, {cmd == "WHILE" ? "REPEAT" : "UNTIL"});
+                ++i; // skip REPEAT or UNTIL
+                frame.second = collect_until(tokens, i, {"END"});
                 // i points to END
-
-                for (;;) {
-                    execute_tokens(body_tokens);
-                    execute_tokens(cond_tokens);
-                    if (store_.depth() < 1) throw std::runtime_error("UNTIL: missing condition result");
-                    Object cond_val = store_.pop();
-                    bool cond_true = false;
-                    if (std::holds_alternative<Integer>(cond_val)) cond_true = std::get<Integer>(cond_val) != 0;
-                    else if (std::holds_alternative<Real>(cond_val)) cond_true = std::get<Real>(cond_val) != 0;
-                    if (cond_true) break;
+                frames_[fi].pc = i + 1;
+                push_frame(std::move(frame));
+                return;
+
+            } else if (cmd == "EVAL") {
+                if (SharedTokens program = eval_operand()) {
+                    frames_[fi].pc = i + 1;
+                    TokenSpan body(*program);
+                    push_run(body, std::move(program));
+                    return;
                 }
+                commands_.execute(tok.command, store_, *this);
 
             } else {
                 // Check if it's a known command first
                 if (commands_.has(tok.command)) {
-                    commands_.execute(tok.command, store_, *this);
+                    if (dispatch(tok.command, fi, i)) return;
                 } else {
                     // Try local variable resolution first
                     auto local = resolve_local(tok.command);
                     if (local.has_value()) {
                         store_.push(*local);
                     } else {
-                        // Try recalling as a variable in current directory
-                        Object val = store_.recall_variable(store_.current_dir(), tok.command);
-                        if (!std::holds_alternative<Error>(val)) {
-                            // Found a variable — evaluate programs, push everything else
-                            if (std::holds_alternative<Program>(val)) {
-                                execute_tokens(std::get<Program>(val).tokens);
-                            } else {
-                                store_.push(val);
-                            }
+                        // Try recalling as a variable in current directory;
+                        // a program comes back as shared tokens, not a copy
+                        SharedTokens program;
+                        Object val = store_.recall_variable(store_.current_dir(), tok.command, &program);
+                        if (program) {
+                            frames_[fi].pc = i + 1;
+                            TokenSpan body(*program);
+                            push_run(body, std::move(program));
+                            return;
+                        } else if (!holds_alternative<Error>(val)) {
+                            store_.push(val);
                         } else {
                             // Not a local, not a variable — unknown command
                             commands_.execute(tok.command, store_, *this);
@@ -390,6 +580,134 @@ void Context::execute_tokens(const std::vector<Token>& tokens) {
             }
         }
     }
+    finish_frame();
+}
+
+// Continues the control structure on top once the part it pushed has run
+// (or, on entry, before any part has)
+void Context::resume() {
+    Frame& f = frames_.back();
+    switch (f.kind) {
+    case Frame::If: {
+        if (f.stage == 0) {
+            f.stage = 1;
+            push_run(f.tokens);
+            return;
+        }
+        if (store_.depth() < 1) throw std::runtime_error("IF: missing condition result");
+        Object cond_val = store_.pop();
+        if (!holds_alternative<Integer>(cond_val) && !holds_alternative<Real>(cond_val)) {
+            throw std::runtime_error("IF: condition must be numeric");
+        }
+        // The frame becomes the chosen branch
+        f.kind = Frame::Run;
+        f.tokens = is_true(cond_val) ? f.first : f.second;
+        f.pc = 0;
+        return;
+    }
+    case Frame::Case: {
+        if (f.stage == 1) {
+            if (store_.depth() < 1) throw std::runtime_error("CASE: missing test result");
+            if (is_true(store_.pop())) {
+                f.kind = Frame::Run;
+                f.tokens = f.first;
+                f.pc = 0;
+                return;
+            }
+            f.stage = 0;
+        }
+        size_t i = f.pc;
+        if (i >= f.tokens.size() || is_keyword_token(f.tokens[i], "END")) {
+            finish_frame(); // no clause matched
+            return;
+        }
+        // Collect tokens up to THEN or END
+        TokenSpan test_tokens = collect_until(f.tokens, i, {"THEN", "END"});
+        if (i < f.tokens.size() && is_keyword_token(f.tokens[i], "END")) {
+            // This is the default clause (no THEN found) — test_tokens is the default body
+            f.kind = Frame::Run;
+            f.tokens = test_tokens;
+            f.pc = 0;
+            return;
+        }
+        ++i; // skip THEN
+        f.first = collect_until(f.tokens, i, {"END"});
+        f.pc = i + 1; // skip END (the one closing this THEN clause)
+        f.stage = 1;
+        push_run(test_tokens);
+        return;
+    }
+    case Frame::For:
+    case Frame::Start: {
+        Loop& loop = *f.loop;
+        if (loop.started) {
+            if (loop.has_step) {
+                if (store_.depth() < 1) throw std::runtime_error("STEP: missing step value");
+                loop.step = loop_real(store_.pop(), f.kind == Frame::For ? "FOR: arguments must be numeric"
+                                                                          : "START: arguments must be numeric");
+            }
+            loop.counter += loop.step;
+        }
+        // Termination check (skip on first iteration for STEP since step is unknown)
+        if (loop.started || !loop.has_step) {
+            if ((loop.step > 0 && loop.counter > loop.end) || (loop.step < 0 && loop.counter < loop.end)) {
+                finish_frame();
+                return;
+            }
+        }
+        if (f.kind == Frame::For) {
+            // One scope for the whole loop; each iteration rebinds the
+            // variable in place
+            Object value = loop.use_int ? Object(Integer(loop.counter)) : Object(loop.counter);
+            if (!loop.started) {
+                std::unordered_map<std::string, Object> frame;
+                frame.emplace(loop.var, std::move(value));
+                push_locals(std::move(frame));
+                loop.slot = local_scopes_.size() - 1;
+                ++f.scopes;
+            } else {
+                local_scopes_[loop.slot].find(loop.var)->second = std::move(value);
+            }
+        }
+        loop.started = true;
+        push_run(f.first);
+        return;
+    }
+    case Frame::While: {
+        if (f.stage == 1) {
+            if (store_.depth() < 1) throw std::runtime_error("WHILE: missing condition result");
+            if (!is_true(store_.pop())) {
+                finish_frame();
+                return;
+            }
+            f.stage = 2;
+            push_run(f.second);
+            return;
+        }
+        f.stage = 1;
+        push_run(f.first);
+        return;
+    }
+    case Frame::Do: {
+        if (f.stage == 2) {
+            if (store_.depth() < 1) throw std::runtime_error("UNTIL: missing condition result");
+            if (is_true(store_.pop())) {
+                finish_frame();
+                return;
+            }
+        }
+        if (f.stage == 1) {
+            f.stage = 2;
+            push_run(f.second);
+            return;
+        }
+        f.stage = 1;
+        push_run(f.first);
+        return;
+    }
+    case Frame::Run:
+        break;
+    }
 }
 
 int Context::depth() {
@@ -459,16 +777,42 @@ bool Context::redo() {
     return ok;
 }
 
-void Context::push_locals(const std::unordered_map<std::string, Object>& frame) {
-    local_scopes_.push_back(frame);
+// Rough heap cost of a local scope, for the call memory budget
+static size_t scope_bytes(const std::unordered_map<std::string, Object>& frame) {
+    using Scope = std::unordered_map<std::string, Object>;
+    return sizeof(Scope) + frame.size() * (sizeof(Scope::value_type) + 2 * sizeof(void*));
+}
+
+void Context::push_locals(std::unordered_map<std::string, Object> frame) {
+    local_bytes_ += scope_bytes(frame);
+    local_scopes_.push_back(std::move(frame));
 }
 
 void Context::pop_locals() {
     if (!local_scopes_.empty()) {
+        local_bytes_ -= scope_bytes(local_scopes_.back());
         local_scopes_.pop_back();
     }
 }
 
+// A -> body pushed as a tail call takes over the scopes of the finished
+// frames it replaced; they sit just below its own. One whose names the new
+// scope all rebinds can never be found again, so it goes now and recursion
+// through -> keeps a constant number of scopes. Lookups are unchanged.
+void Context::drop_shadowed_scopes() {
+    Frame& f = frames_.back();
+    while (f.scopes > 1) {
+        const auto& top = local_scopes_.back();
+        const auto& below = local_scopes_[local_scopes_.size() - 2];
+        for (const auto& entry : below) {
+            if (!top.count(entry.first)) return;
+        }
+        local_bytes_ -= scope_bytes(below);
+        local_scopes_.erase(local_scopes_.end() - 2);
+        --f.scopes;
+    }
+}
+
 std::optional<Object> Context::resolve_local(const std::string& name) const {
     // Search innermost scope first
     for (auto it = local_scopes_.rbegin(); it != local_scopes_.rend(); ++it) {
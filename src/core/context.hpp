@@ -1,8 +1,11 @@
 #pragma once
 
+#include "core/arena.hpp"
 #include "core/store.hpp"
 #include "core/commands.hpp"
 #include "core/object.hpp"
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <vector>
 #include <string>
@@ -12,6 +15,8 @@
 namespace lpr {
 
 class CASBridge; // forward declare
+class ExprCache;
+class ParseCache;
 
 class Context {
 public:
@@ -24,6 +29,18 @@ public:
     // Execute RPL input — returns true on success
     bool exec(const std::string& input);
 
+    // Reads up to cap bytes into buf; returns the count, 0 at end of input,
+    // or a negative value on error
+    using ReadFn = std::function<long(char* buf, size_t cap)>;
+
+    // Execute RPL text as it is read, one top-level line or item at a time,
+    // so memory does not grow with the input. The transaction is committed
+    // after every checkpoint_bytes of input (0: only at the end); the whole
+    // stream is one undo step. On error, work since the last checkpoint is
+    // rolled back and the Error is pushed; earlier checkpoints stay.
+    bool exec_stream(const ReadFn& read, size_t checkpoint_bytes = kDefaultCheckpointBytes);
+    static constexpr size_t kDefaultCheckpointBytes = 1 << 20;
+
     // Stack inspection
     int         depth();
     std::string repr_at(int level); // 1-based
@@ -33,24 +50,124 @@ public:
     bool undo();
     bool redo();
 
-    // Execute token stream (used by EVAL, STR→, etc.)
+    // Execute token stream (used by EVAL, STR→, etc.). Nested programs,
+    // control structures and calls run on a continuation stack on the heap,
+    // not the native one; see call_memory().
     void execute_tokens(const std::vector<Token>& tokens);
+    void execute_tokens(TokenSpan tokens);
+
+    // Runs a program as a command's last action (IFT, STR→, ...). For a
+    // command the interpreter dispatched, the program becomes a frame run
+    // once the command returns, so recursion through it needs no native
+    // stack; otherwise it runs nested, like execute_tokens.
+    void run_program(SharedTokens program);
+
+    // Memory the interpreter may hold for pending calls, control structures
+    // and local variables; past it, execution fails with "Insufficient
+    // Memory". Reloaded from the CALLMEM setting by each outermost exec.
+    void set_call_memory(size_t bytes) { call_memory_ = bytes; }
+    size_t call_memory() const { return call_memory_; }
+    static constexpr size_t kDefaultCallMemory = size_t(64) << 20;
+    static constexpr const char* kCallMemoryKey = "call_memory_kib";
+    // Native stack that nested execute_tokens calls (MAP, ASSEMBLE, ...)
+    // may use, whatever the budget; it also counts against call_memory()
+    static constexpr size_t kNativeStackLimit = size_t(4) << 20;
 
     Store& store() { return store_; }
+    const CommandRegistry& commands() const { return commands_; }
 
     // CAS bridge accessor
     CASBridge& cas();
 
+    // Compiled Symbol expressions, keyed by expression text
+    ExprCache& expr_cache() { return *expr_cache_; }
+
+    // Parsed tokens, keyed by source text
+    ParseCache& parse_cache() { return *parse_cache_; }
+
+    // Scratch memory for temporaries within one exec; reset when the
+    // outermost exec returns
+    ExecArena& arena() { return arena_; }
+
+    // Run marked command sequences as fused operations (core/fusion.hpp).
+    // On by default; turning it off changes speed, never results.
+    void set_fusion_enabled(bool on) { fusion_enabled_ = on; }
+    bool fusion_enabled() const { return fusion_enabled_; }
+
+    // Named counters from this context's caches (PERFSTATS)
+    std::vector<std::pair<std::string, int64_t>> perf_stats() const;
+
     // Local variable scope stack
-    void push_locals(const std::unordered_map<std::string, Object>& frame);
+    void push_locals(std::unordered_map<std::string, Object> frame);
     void pop_locals();
     std::optional<Object> resolve_local(const std::string& name) const;
+    const std::vector<std::unordered_map<std::string, Object>>& local_scopes() const {
+        return local_scopes_;
+    }
 
 private:
+    // Counts nested execs; the outermost one resets the arena on the way out
+    struct ArenaScope {
+        Context& ctx;
+        explicit ArenaScope(Context& c) : ctx(c) { ++ctx.exec_depth_; }
+        ~ArenaScope() { if (--ctx.exec_depth_ == 0) ctx.arena_.reset(); }
+    };
+
+    // FOR and START counters
+    struct Loop {
+        Real counter, end, step = 1;
+        bool use_int = false;
+        bool has_step = false;
+        bool started = false;
+        std::string var;  // FOR only
+        size_t slot = 0;  // the variable's scope in local_scopes_
+    };
+
+    // One continuation: the rest of a token run, or a control structure
+    // waiting for one of its parts to finish running
+    struct Frame {
+        enum Kind : uint8_t { Run, If, Case, For, Start, While, Do };
+        Kind kind = Run;
+        uint8_t stage = 0;           // the part a control structure runs next
+        uint32_t scopes = 0;         // local scopes to pop when it finishes
+        TokenSpan tokens;            // Run: the tokens; If: the condition; Case: the clauses
+        size_t pc = 0;               // Run: the next token; Case: the next clause
+        TokenSpan first, second;     // If: then/else; While: condition/body; Do: body/condition
+        std::unique_ptr<Loop> loop;  // FOR and START
+        SharedTokens owner;          // the tokens, when no frame below holds them
+    };
+
+    bool run_fused(TokenSpan tokens, size_t& i);
+    void run(size_t fi);
+    void resume();
+    void push_frame(Frame frame);
+    void push_run(TokenSpan tokens, SharedTokens owner = nullptr, uint32_t scopes = 0);
+    void finish_frame();
+    void drop_shadowed_scopes();
+    SharedTokens eval_operand();
+    bool dispatch(const Atom& cmd, size_t fi, size_t i);
+    size_t native_bytes() const;
+    void load_call_memory();
+
     Store store_;
     CommandRegistry commands_;
     std::unique_ptr<CASBridge> cas_bridge_;
+    std::unique_ptr<ExprCache> expr_cache_;
+    std::unique_ptr<ParseCache> parse_cache_;
+    ExecArena arena_;
+    int exec_depth_ = 0;
+    bool fusion_enabled_ = true;
+    std::vector<int64_t> fusion_hits_;  // per rule in fusion_rules()
+    int64_t fusion_fallbacks_ = 0;
     std::vector<std::unordered_map<std::string, Object>> local_scopes_;
+    size_t local_bytes_ = 0;       // estimated size of local_scopes_
+    std::vector<Frame> frames_;
+    size_t run_base_ = 0;          // first frame of the innermost execute_tokens
+    size_t frames_peak_ = 0;
+    size_t call_memory_ = kDefaultCallMemory;
+    SharedTokens* defer_to_ = nullptr;  // where run_program leaves its program
+    uintptr_t native_base_ = 0;         // stack address of the outermost execute_tokens
+    int native_depth_ = 0;
 };
 
 } // namespace lpr
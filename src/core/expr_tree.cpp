@@ -0,0 +1,510 @@
+#include "core/expr_tree.hpp"
+#include "core/expression.hpp"
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace lpr {
+
+using Kind = ExprNode::Kind;
+
+// ---- Hash-consing ----
+
+namespace {
+
+// Live nodes by structural hash. Entries hold raw pointers; a node's deleter
+// removes its own entry, so the table never keeps a node alive.
+struct Interner {
+    std::mutex mtx;
+    std::unordered_multimap<size_t, std::pair<const ExprNode*, std::weak_ptr<const ExprNode>>> table;
+};
+
+Interner& interner() {
+    static Interner* in = new Interner; // never destroyed: nodes may outlive statics
+    return *in;
+}
+
+size_t hash_node(Kind kind, const std::string& text, const std::vector<ExprPtr>& kids) {
+    size_t h = std::hash<std::string>{}(text) ^ (static_cast<size_t>(kind) * 0x9e3779b97f4a7c15ULL);
+    for (const auto& k : kids) {
+        h ^= std::hash<const void*>{}(k.get()) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    }
+    return h;
+}
+
+// Children are interned, so structural equality is pointer equality on them.
+bool same_node(const ExprNode& n, Kind kind, const std::string& text,
+               const std::vector<ExprPtr>& kids) {
+    if (n.kind != kind || n.text != text || n.kids.size() != kids.size()) return false;
+    for (size_t i = 0; i < kids.size(); ++i) {
+        if (n.kids[i] != kids[i]) return false;
+    }
+    return true;
+}
+
+// Releasing the root of a long chain would otherwise recurse once per level;
+// children dropped while a release is running are queued and freed in a loop.
+thread_local bool releasing = false;
+thread_local std::vector<ExprPtr> release_queue;
+
+void release_node(const ExprNode* n) {
+    {
+        Interner& in = interner();
+        std::lock_guard<std::mutex> lock(in.mtx);
+        auto range = in.table.equal_range(n->hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second.first == n) { in.table.erase(it); break; }
+        }
+    }
+    auto* node = const_cast<ExprNode*>(n);
+    for (auto& k : node->kids) release_queue.push_back(std::move(k));
+    delete node;
+    if (releasing) return;
+    releasing = true;
+    while (!release_queue.empty()) {
+        ExprPtr k = std::move(release_queue.back());
+        release_queue.pop_back();
+        k.reset();
+    }
+    releasing = false;
+}
+
+// Top-level binding strength of verbatim text: 0 for a relation, 1-3 for the
+// loosest operator outside parentheses, 4 for an atom.
+int text_level(const std::string& text) {
+    int depth = 0;
+    int level = 4;
+    for (char c : text) {
+        if (c == '(' || c == '[' || c == '{') { ++depth; continue; }
+        if (c == ')' || c == ']' || c == '}') { --depth; continue; }
+        if (depth > 0) continue;
+        if (c == '=' || c == '<' || c == '>') level = std::min(level, 0);
+        if (c == '+' || c == '-') level = std::min(level, 1);
+        if (c == '*' || c == '/') level = std::min(level, 2);
+        if (c == '^') level = std::min(level, 3);
+    }
+    return level;
+}
+
+int node_level(Kind kind, const std::string& text) {
+    switch (kind) {
+        case Kind::Add: case Kind::Sub: return 1;
+        case Kind::Mul: case Kind::Div: return 2;
+        case Kind::Pow:                 return 3;
+        case Kind::Opaque:              return text_level(text);
+        default:                        return 4;
+    }
+}
+
+ExprPtr intern(Kind kind, std::string text, std::vector<ExprPtr> kids) {
+    size_t h = hash_node(kind, text, kids);
+    Interner& in = interner();
+    std::lock_guard<std::mutex> lock(in.mtx);
+    auto range = in.table.equal_range(h);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (!same_node(*it->second.first, kind, text, kids)) continue;
+        if (ExprPtr live = it->second.second.lock()) return live;
+        // Expired: its deleter is waiting for the lock; make a fresh node.
+    }
+    int level = node_level(kind, text);
+    ExprPtr node(new ExprNode{kind, std::move(text), std::move(kids), h, level}, release_node);
+    in.table.emplace(h, std::make_pair(node.get(), std::weak_ptr<const ExprNode>(node)));
+    return node;
+}
+
+Kind binary_kind(const std::string& op) {
+    if (op == "+") return Kind::Add;
+    if (op == "-") return Kind::Sub;
+    if (op == "*") return Kind::Mul;
+    if (op == "/") return Kind::Div;
+    if (op == "^") return Kind::Pow;
+    throw std::runtime_error("Unknown operator: " + op);
+}
+
+bool is_negative(const ExprNode& n) {
+    return n.kind == Kind::Neg ||
+           (n.kind == Kind::Number && !n.text.empty() && n.text[0] == '-');
+}
+
+// Whether `child` needs parentheses as an operand of `parent`.
+bool needs_wrap(const ExprNode& child, Kind parent, bool right) {
+    int l = child.level;
+    bool neg = is_negative(child);
+    switch (parent) {
+        case Kind::Add: return l < 1;
+        case Kind::Sub: return right ? (l <= 1 || neg) : l < 1;
+        case Kind::Mul: return l < 2 || neg;
+        case Kind::Div: return (right ? l <= 2 : l < 2) || neg;
+        case Kind::Pow: return (right ? l < 3 : l <= 3) || neg;
+        case Kind::Neg: return l <= 3 || neg;
+        default:        return false;
+    }
+}
+
+} // namespace
+
+ExprPtr make_number(const std::string& text) { return intern(Kind::Number, text, {}); }
+ExprPtr make_name(const std::string& name)   { return intern(Kind::Name, name, {}); }
+ExprPtr make_opaque(const std::string& text) { return intern(Kind::Opaque, text, {}); }
+ExprPtr make_group(ExprPtr inner)            { return intern(Kind::Group, "", {std::move(inner)}); }
+ExprPtr make_neg(ExprPtr operand)            { return intern(Kind::Neg, "", {std::move(operand)}); }
+
+ExprPtr make_binary(const std::string& op, ExprPtr lhs, ExprPtr rhs) {
+    return intern(binary_kind(op), "", {std::move(lhs), std::move(rhs)});
+}
+
+ExprPtr make_call(const std::string& func, std::vector<ExprPtr> args) {
+    return intern(Kind::Call, func, std::move(args));
+}
+
+const char* binary_op_text(Kind kind) {
+    switch (kind) {
+        case Kind::Add: return "+";
+        case Kind::Sub: return "-";
+        case Kind::Mul: return "*";
+        case Kind::Div: return "/";
+        case Kind::Pow: return "^";
+        default:        return "";
+    }
+}
+
+size_t expr_node_count() {
+    Interner& in = interner();
+    std::lock_guard<std::mutex> lock(in.mtx);
+    return in.table.size();
+}
+
+// ---- Parsing ----
+
+namespace {
+
+// Recursive descent over the expression tokens, with the same precedence and
+// associativity as the shunting-yard evaluator: NEG binds tightest, ^ is
+// right-associative, the rest left-associative. Nesting (parentheses,
+// calls, NEG and ^ chains) deeper than kMaxDepth throws, and Symbol::tree()
+// keeps such text as an Opaque leaf rather than recursing without bound.
+class TreeParser {
+public:
+    explicit TreeParser(const std::vector<ExprToken>& tokens) : toks_(tokens) {}
+
+    ExprPtr parse() {
+        ExprPtr e = sum();
+        if (pos_ != toks_.size()) throw std::runtime_error("Malformed expression");
+        return e;
+    }
+
+private:
+    static constexpr int kMaxDepth = 3000;  // recursive calls, about 3 per level
+
+    const std::vector<ExprToken>& toks_;
+    size_t pos_ = 0;
+    int depth_ = 0;
+
+    struct Nest {
+        int& depth;
+        explicit Nest(int& d) : depth(d) {
+            if (++depth > kMaxDepth) {
+                --depth;
+                throw std::runtime_error("Expression nested too deeply");
+            }
+        }
+        ~Nest() { --depth; }
+    };
+
+    bool at_op(const char* op) const {
+        return pos_ < toks_.size() && toks_[pos_].type == ExprTokenType::Op &&
+               toks_[pos_].value == op;
+    }
+
+    bool at(ExprTokenType type) const {
+        return pos_ < toks_.size() && toks_[pos_].type == type;
+    }
+
+    ExprPtr sum() {
+        ExprPtr lhs = product();
+        while (at_op("+") || at_op("-")) {
+            std::string op = toks_[pos_++].value;
+            lhs = make_binary(op, lhs, product());
+        }
+        return lhs;
+    }
+
+    ExprPtr product() {
+        ExprPtr lhs = power();
+        while (at_op("*") || at_op("/")) {
+            std::string op = toks_[pos_++].value;
+            lhs = make_binary(op, lhs, power());
+        }
+        return lhs;
+    }
+
+    ExprPtr power() {
+        Nest nest(depth_);
+        ExprPtr base = unary();
+        if (!at_op("^")) return base;
+        ++pos_;
+        return make_binary("^", base, power());
+    }
+
+    ExprPtr unary() {
+        Nest nest(depth_);
+        if (at_op("NEG")) {
+            ++pos_;
+            return make_neg(unary());
+        }
+        return primary();
+    }
+
+    ExprPtr primary() {
+        Nest nest(depth_);
+        if (pos_ >= toks_.size()) throw std::runtime_error("Malformed expression");
+        const ExprToken& tok = toks_[pos_++];
+        switch (tok.type) {
+            case ExprTokenType::Number:
+                return make_number(tok.value);
+            case ExprTokenType::Name: {
+                if (!at(ExprTokenType::LParen)) return make_name(tok.value);
+                ++pos_;
+                std::vector<ExprPtr> args;
+                if (!at(ExprTokenType::RParen)) {
+                    args.push_back(sum());
+                    while (at(ExprTokenType::Comma)) {
+                        ++pos_;
+                        args.push_back(sum());
+                    }
+                }
+                expect_rparen();
+                return make_call(tok.value, std::move(args));
+            }
+            case ExprTokenType::LParen: {
+                ExprPtr inner = sum();
+                expect_rparen();
+                return make_group(inner);
+            }
+            default:
+                throw std::runtime_error("Malformed expression");
+        }
+    }
+
+    void expect_rparen() {
+        if (!at(ExprTokenType::RParen)) throw std::runtime_error("Mismatched parentheses");
+        ++pos_;
+    }
+};
+
+} // namespace
+
+ExprPtr parse_expr_tree(const std::string& text) {
+    auto tokens = tokenize_expression(text);
+    return TreeParser(tokens).parse();
+}
+
+// ---- Rendering ----
+
+std::string render_expr(const ExprPtr& root) {
+    // Explicit work stack (pieces are emitted last-pushed first), so long
+    // left-leaning chains do not recurse.
+    struct Piece { const ExprNode* node; const char* lit; };
+    std::string out;
+    std::vector<Piece> todo{{root.get(), nullptr}};
+
+    auto push_operand = [&todo](const ExprNode* child, Kind parent, bool right) {
+        bool wrap = needs_wrap(*child, parent, right);
+        if (wrap) todo.push_back({nullptr, ")"});
+        todo.push_back({child, nullptr});
+        if (wrap) todo.push_back({nullptr, "("});
+    };
+
+    while (!todo.empty()) {
+        Piece p = todo.back();
+        todo.pop_back();
+        if (!p.node) { out += p.lit; continue; }
+        const ExprNode& n = *p.node;
+        switch (n.kind) {
+            case Kind::Number: case Kind::Name: case Kind::Opaque:
+                out += n.text;
+                break;
+            case Kind::Group:
+                todo.push_back({nullptr, ")"});
+                todo.push_back({n.kids[0].get(), nullptr});
+                out += "(";
+                break;
+            case Kind::Neg:
+                out += "-";
+                push_operand(n.kids[0].get(), Kind::Neg, false);
+                break;
+            case Kind::Call:
+                out += n.text;
+                out += "(";
+                todo.push_back({nullptr, ")"});
+                for (size_t i = n.kids.size(); i-- > 0;) {
+                    todo.push_back({n.kids[i].get(), nullptr});
+                    if (i > 0) todo.push_back({nullptr, ", "});
+                }
+                break;
+            default:
+                push_operand(n.kids[1].get(), n.kind, true);
+                todo.push_back({nullptr, binary_op_text(n.kind)});
+                push_operand(n.kids[0].get(), n.kind, false);
+                break;
+        }
+    }
+    return out;
+}
+
+// ---- Substitution ----
+
+ExprPtr expr_substitute(const ExprPtr& root, const std::string& name, const ExprPtr& repl) {
+    // Post-order walk with an explicit stack; each frame collects its
+    // children's results and rebuilds only if one of them changed.
+    struct Frame { const ExprPtr* node; size_t next; std::vector<ExprPtr> kids; bool changed; };
+    std::vector<Frame> stack;
+    stack.push_back({&root, 0, {}, false});
+    ExprPtr result;
+
+    while (!stack.empty()) {
+        Frame& f = stack.back();
+        const ExprNode& n = **f.node;
+        if (n.kind == Kind::Name) {
+            result = n.text == name ? repl : *f.node;
+        } else if (f.next < n.kids.size()) {
+            const ExprPtr* child = &n.kids[f.next++];
+            stack.push_back({child, 0, {}, false});
+            continue;
+        } else if (!f.changed) {
+            result = *f.node;
+        } else {
+            result = intern(n.kind, n.text, std::move(f.kids));
+        }
+        stack.pop_back();
+        if (stack.empty()) break;
+        Frame& parent = stack.back();
+        const ExprPtr& original = (*parent.node)->kids[parent.kids.size()];
+        parent.changed = parent.changed || result != original;
+        parent.kids.push_back(std::move(result));
+    }
+    return result;
+}
+
+// ---- Symbol ----
+
+struct Symbol::Rep {
+    mutable std::once_flag text_once;
+    mutable std::once_flag tree_once;
+    mutable std::string text;
+    mutable ExprPtr tree;
+    std::shared_ptr<const CasHandle> cas; // atomic access only
+};
+
+Symbol::Symbol() : Symbol(std::string()) {}
+
+Symbol::Symbol(std::string text) : rep_(std::make_shared<Rep>()) {
+    rep_->text = std::move(text);
+    std::call_once(rep_->text_once, [] {});
+}
+
+Symbol::Symbol(ExprPtr tree) : rep_(std::make_shared<Rep>()) {
+    rep_->tree = std::move(tree);
+    std::call_once(rep_->tree_once, [] {});
+}
+
+Symbol::Symbol(ExprPtr tree, std::string text) : rep_(std::make_shared<Rep>()) {
+    rep_->tree = std::move(tree);
+    rep_->text = std::move(text);
+    std::call_once(rep_->tree_once, [] {});
+    std::call_once(rep_->text_once, [] {});
+}
+
+const std::string& Symbol::value() const {
+    std::call_once(rep_->text_once, [this] { rep_->text = render_expr(rep_->tree); });
+    return rep_->text;
+}
+
+const ExprPtr& Symbol::tree() const {
+    std::call_once(rep_->tree_once, [this] {
+        try {
+            rep_->tree = parse_expr_tree(rep_->text);
+        } catch (const std::exception&) {
+            rep_->tree = make_opaque(rep_->text);
+        }
+    });
+    return rep_->tree;
+}
+
+std::shared_ptr<const CasHandle> Symbol::cas_handle() const {
+    return std::atomic_load(&rep_->cas);
+}
+
+void Symbol::set_cas_handle(std::shared_ptr<const CasHandle> handle) const {
+    std::atomic_store(&rep_->cas, std::move(handle));
+}
+
+// ---- Symbolic construction ----
+
+ExprPtr object_expr_tree(const Object& obj) {
+    if (holds_alternative<Symbol>(obj)) return get<Symbol>(obj).tree();
+    if (holds_alternative<Name>(obj))   return make_name(get<Name>(obj).value);
+    if (holds_alternative<Integer>(obj)) return make_number(get<Integer>(obj).str());
+    std::string text = holds_alternative<Rational>(obj)
+        ? get<Rational>(obj).str() : repr(obj);
+    if (holds_alternative<Real>(obj) || holds_alternative<Rational>(obj)) {
+        try { return parse_expr_tree(text); } catch (const std::exception&) {}
+    }
+    return make_opaque(text);
+}
+
+namespace {
+
+// An operand's text: a Symbol's own, so building on a large expression
+// copies its text instead of rendering its tree again
+std::string operand_text(const Object& obj, const ExprPtr& tree) {
+    if (holds_alternative<Symbol>(obj)) return get<Symbol>(obj).value();
+    return render_expr(tree);
+}
+
+void append_operand(std::string& out, const ExprNode& child, const std::string& text,
+                    Kind parent, bool right) {
+    bool wrap = needs_wrap(child, parent, right);
+    if (wrap) out += '(';
+    out += text;
+    if (wrap) out += ')';
+}
+
+} // namespace
+
+Object symbolic_binary(const Object& a, const Object& b, const std::string& op) {
+    ExprPtr lhs = object_expr_tree(a);
+    std::string lhs_text = operand_text(a, lhs);
+    // A negative base is grouped explicitly: '-X^2' as written means -(X^2)
+    // to the CAS, while this node means (-X)^2.
+    if (op == "^" && is_negative(*lhs)) {
+        lhs = make_group(lhs);
+        lhs_text = "(" + lhs_text + ")";
+    }
+    ExprPtr rhs = object_expr_tree(b);
+    std::string rhs_text = operand_text(b, rhs);
+    ExprPtr node = make_binary(op, lhs, rhs);
+    std::string text;
+    text.reserve(lhs_text.size() + rhs_text.size() + 5);
+    append_operand(text, *lhs, lhs_text, node->kind, false);
+    text += op;
+    append_operand(text, *rhs, rhs_text, node->kind, true);
+    return Symbol{std::move(node), std::move(text)};
+}
+
+Object symbolic_call(const std::string& func, const std::vector<Object>& args) {
+    std::vector<ExprPtr> kids;
+    kids.reserve(args.size());
+    std::string text = func + "(";
+    for (size_t i = 0; i < args.size(); ++i) {
+        kids.push_back(object_expr_tree(args[i]));
+        if (i > 0) text += ", ";
+        text += operand_text(args[i], kids.back());
+    }
+    text += ")";
+    return Symbol{make_call(func, std::move(kids)), std::move(text)};
+}
+
+} // namespace lpr
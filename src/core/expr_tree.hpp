@@ -0,0 +1,71 @@
+#pragma once
+
+#include "core/object.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lpr {
+
+// Immutable node of a symbolic expression tree. Nodes are hash-consed: the
+// factories below return the existing node for a structurally equal
+// (kind, text, children) triple, so equal subtrees are shared and compare
+// equal by pointer. Nodes are only created through the factories.
+struct ExprNode {
+    enum class Kind : uint8_t {
+        Number,  // numeric literal, text as written ("2", "-3", "1.5E-3")
+        Name,    // variable
+        Opaque,  // text outside the expression grammar, kept verbatim
+        Group,   // explicit parentheses from the source, one child
+        Neg,     // unary minus, one child
+        Add, Sub, Mul, Div, Pow, // binary, two children
+        Call,    // function call: text is the name, children the arguments
+    };
+
+    Kind kind;
+    std::string text;
+    std::vector<ExprPtr> kids;
+    size_t hash;
+    int level; // binding strength used when parenthesizing operands
+};
+
+ExprPtr make_number(const std::string& text);
+ExprPtr make_name(const std::string& name);
+ExprPtr make_opaque(const std::string& text);
+ExprPtr make_group(ExprPtr inner);
+ExprPtr make_neg(ExprPtr operand);
+ExprPtr make_binary(const std::string& op, ExprPtr lhs, ExprPtr rhs);
+ExprPtr make_call(const std::string& func, std::vector<ExprPtr> args);
+
+// Operator text for a binary kind ("+", "-", "*", "/", "^"), or "" otherwise.
+const char* binary_op_text(ExprNode::Kind kind);
+
+// Parse infix text into a tree. Explicit parentheses become Group nodes so the
+// source layout survives, apart from whitespace. Throws on malformed input.
+ExprPtr parse_expr_tree(const std::string& text);
+
+// Render a tree as infix text, adding only the parentheses precedence needs.
+std::string render_expr(const ExprPtr& root);
+
+// Replace every Name node called `name` with `repl`. Subtrees that do not
+// mention the name are shared with the input, not copied.
+ExprPtr expr_substitute(const ExprPtr& root, const std::string& name, const ExprPtr& repl);
+
+// Number of live interned nodes.
+size_t expr_node_count();
+
+// ---- Building symbolic results from stack objects ----
+
+// Tree for an operand: Symbols give their tree, Names a Name node, numbers
+// their literal; anything else (complex, strings, programs) an Opaque leaf.
+ExprPtr object_expr_tree(const Object& obj);
+
+// Symbol for `a op b` with op one of + - * / ^.
+Object symbolic_binary(const Object& a, const Object& b, const std::string& op);
+
+// Symbol for FUNC(a, b, ...).
+Object symbolic_call(const std::string& func, const std::vector<Object>& args);
+
+} // namespace lpr
@@ -1,10 +1,15 @@
 #include "core/expression.hpp"
 #include "core/context.hpp"
+#include "core/expr_tree.hpp"
+#include "core/numeric.hpp"
 #include <vector>
 #include <string>
 #include <cctype>
 #include <stdexcept>
 #include <cmath>
+#include <algorithm>
+#include <optional>
+#include <iterator>
 
 namespace lpr {
 
@@ -154,6 +159,8 @@ bool is_right_assoc(const std::string& op) {
 std::vector<ExprToken> shunting_yard(const std::vector<ExprToken>& tokens) {
     std::vector<ExprToken> output;
     std::vector<ExprToken> op_stack;
+    // One entry per open paren: -1 for grouping, else commas seen in a call
+    std::vector<int> paren_commas;
 
     for (size_t i = 0; i < tokens.size(); ++i) {
         const auto& tok = tokens[i];
@@ -175,6 +182,7 @@ std::vector<ExprToken> shunting_yard(const std::vector<ExprToken>& tokens) {
                     output.push_back(op_stack.back());
                     op_stack.pop_back();
                 }
+                if (!paren_commas.empty() && paren_commas.back() >= 0) ++paren_commas.back();
                 break;
             case ExprTokenType::Op: {
                 while (!op_stack.empty() && op_stack.back().type == ExprTokenType::Op) {
@@ -192,6 +200,8 @@ std::vector<ExprToken> shunting_yard(const std::vector<ExprToken>& tokens) {
                 break;
             }
             case ExprTokenType::LParen:
+                paren_commas.push_back(
+                    !op_stack.empty() && op_stack.back().type == ExprTokenType::Func ? 0 : -1);
                 op_stack.push_back(tok);
                 break;
             case ExprTokenType::RParen:
@@ -205,9 +215,13 @@ std::vector<ExprToken> shunting_yard(const std::vector<ExprToken>& tokens) {
                 op_stack.pop_back(); // discard LParen
                 // If top of stack is a function, pop it to output
                 if (!op_stack.empty() && op_stack.back().type == ExprTokenType::Func) {
+                    bool empty_call = i > 0 && tokens[i - 1].type == ExprTokenType::LParen;
+                    int commas = paren_commas.empty() ? 0 : std::max(paren_commas.back(), 0);
+                    op_stack.back().argc = empty_call ? 0 : commas + 1;
                     output.push_back(op_stack.back());
                     op_stack.pop_back();
                 }
+                if (!paren_commas.empty()) paren_commas.pop_back();
                 break;
             case ExprTokenType::Func:
                 // Func tokens are only created internally, not from input
@@ -228,192 +242,254 @@ std::vector<ExprToken> shunting_yard(const std::vector<ExprToken>& tokens) {
 
 // --- RPN Evaluator ---
 
-// Convert a numeric Object to its string form for embedding in symbolic expressions.
-std::string expr_repr(const Object& obj) {
-    if (std::holds_alternative<Integer>(obj))  return std::get<Integer>(obj).str();
-    if (std::holds_alternative<Rational>(obj)) return std::get<Rational>(obj).str();
-    if (std::holds_alternative<Symbol>(obj))   return std::get<Symbol>(obj).value;
-    return repr(obj);
+const std::string& op_text(CompiledExpr::Op op) {
+    static const std::string texts[] = {"", "", "NEG", "+", "-", "*", "/", "^"};
+    return texts[static_cast<int>(op)];
 }
 
-// Build a symbolic binary expression with precedence-aware parentheses.
-Object symbolic_binary_expr(const Object& a, const Object& b, const std::string& op) {
-    std::string sa = expr_repr(a);
-    std::string sb = expr_repr(b);
-    int prec = (op == "+" || op == "-") ? 1 : 2;
-    if (needs_parens(sa, prec)) sa = "(" + sa + ")";
-    if (needs_parens(sb, prec)) sb = "(" + sb + ")";
-    return Symbol{sa + op + sb};
+// Expressions evaluate over Integer, Rational and Real; anything else,
+// Complex included, is an error.
+[[noreturn]] Object non_numeric() { throw std::runtime_error("Non-numeric value in expression"); }
+
+// Rejects Complex before an arithmetic kernel sees it
+template <typename Kernel>
+struct RealOnly {
+    template <typename T>
+    Object operator()(T&& x, const T& y) const {
+        if constexpr (std::is_same_v<T, Complex>) non_numeric();
+        else return Kernel{}(std::move(x), y);
+    }
+};
+
+// Division checks the widened divisor, so 0, 0/1 and 0. all count
+struct CheckedDiv {
+    template <typename T>
+    Object operator()(T&& x, const T& y) const {
+        if constexpr (std::is_same_v<T, Complex>) {
+            non_numeric();
+        } else {
+            if (y == 0) throw std::runtime_error("Division by zero");
+            return NumericDiv{}(std::move(x), y);
+        }
+    }
+};
+
+Object apply_binary(CompiledExpr::Op op, Object&& a, const Object& b) {
+    switch (op) {
+        case CompiledExpr::Op::Add: return numeric_dispatch(std::move(a), b, RealOnly<NumericAdd>{}, non_numeric);
+        case CompiledExpr::Op::Sub: return numeric_dispatch(std::move(a), b, RealOnly<NumericSub>{}, non_numeric);
+        case CompiledExpr::Op::Mul: return numeric_dispatch(std::move(a), b, RealOnly<NumericMul>{}, non_numeric);
+        case CompiledExpr::Op::Div: return numeric_dispatch(std::move(a), b, CheckedDiv{}, non_numeric);
+        case CompiledExpr::Op::Pow:
+            // Power: promote everything to Real for simplicity
+            return numeric_dispatch(std::move(a), b, [](auto&& x, const auto& y) -> Object {
+                using T = std::decay_t<decltype(x)>;
+                if constexpr (std::is_same_v<T, Complex>) non_numeric();
+                else return Real(boost::multiprecision::pow(Real(x), Real(y)));
+            }, non_numeric);
+        default:
+            throw std::runtime_error("Unknown operator: " + op_text(op));
+    }
 }
 
-// Numeric helpers (reuse same promotion logic as commands.cpp)
-int numeric_rank(const Object& obj) {
-    if (std::holds_alternative<Integer>(obj))  return 0;
-    if (std::holds_alternative<Rational>(obj)) return 1;
-    if (std::holds_alternative<Real>(obj))     return 2;
-    return -1;
+
+Object parse_number(const std::string& s) {
+    // If it contains '.' or 'E'/'e', it's Real; otherwise Integer
+    for (char c : s) {
+        if (c == '.' || c == 'E' || c == 'e') return Real(s);
+    }
+    return Integer(s);
 }
 
-Object promote(const Object& obj, int target_rank) {
-    int rank = numeric_rank(obj);
-    if (rank == target_rank) return obj;
-    Object cur = obj;
-    int cur_rank = rank;
-    while (cur_rank < target_rank) {
-        if (cur_rank == 0) {
-            cur = Rational(std::get<Integer>(cur), Integer(1));
-            cur_rank = 1;
-        } else if (cur_rank == 1) {
-            cur = Real(std::get<Rational>(cur));
-            cur_rank = 2;
-        }
+// Resolve a variable: locals first, then global store (case-sensitive)
+Object resolve_name(const std::string& name, Context& ctx) {
+    auto local = ctx.resolve_local(name);
+    if (local.has_value()) return std::move(*local);
+    Object val = ctx.store().recall_variable(ctx.store().current_dir(), name);
+    if (holds_alternative<Error>(val)) {
+        throw std::runtime_error("Undefined variable: " + name);
     }
-    return cur;
+    return val;
 }
 
-Object apply_binary(const std::string& op, const Object& a, const Object& b) {
-    int ra = numeric_rank(a);
-    int rb = numeric_rank(b);
-    if (ra < 0 || rb < 0) throw std::runtime_error("Non-numeric value in expression");
+} // anonymous namespace
 
-    int target = std::max(ra, rb);
-    // For division, promote integers to rationals
-    if (op == "/" && target == 0) target = 1;
+// --- Compiler ---
 
-    Object pa = promote(a, target);
-    Object pb = promote(b, target);
+std::shared_ptr<const CompiledExpr> compile_expression(const std::string& expr) {
+    using Op = CompiledExpr::Op;
+    auto rpn = shunting_yard(tokenize_expression(expr));
+    auto code = std::make_shared<CompiledExpr>();
+    code->code.reserve(rpn.size());
 
-    if (op == "+") {
-        if (target == 0) return Integer(std::get<Integer>(pa) + std::get<Integer>(pb));
-        if (target == 1) return Rational(std::get<Rational>(pa) + std::get<Rational>(pb));
-        return Real(std::get<Real>(pa) + std::get<Real>(pb));
-    }
-    if (op == "-") {
-        if (target == 0) return Integer(std::get<Integer>(pa) - std::get<Integer>(pb));
-        if (target == 1) return Rational(std::get<Rational>(pa) - std::get<Rational>(pb));
-        return Real(std::get<Real>(pa) - std::get<Real>(pb));
-    }
-    if (op == "*") {
-        if (target == 0) return Integer(std::get<Integer>(pa) * std::get<Integer>(pb));
-        if (target == 1) return Rational(std::get<Rational>(pa) * std::get<Rational>(pb));
-        return Real(std::get<Real>(pa) * std::get<Real>(pb));
-    }
-    if (op == "/") {
-        // Check division by zero
-        if ((target == 1 && std::get<Rational>(pb) == 0) ||
-            (target == 2 && std::get<Real>(pb) == 0)) {
-            throw std::runtime_error("Division by zero");
+    auto slot_of = [](std::vector<std::string>& table, const std::string& v) {
+        for (size_t i = 0; i < table.size(); ++i) {
+            if (table[i] == v) return static_cast<uint32_t>(i);
+        }
+        table.push_back(v);
+        return static_cast<uint32_t>(table.size() - 1);
+    };
+
+    for (const auto& tok : rpn) {
+        switch (tok.type) {
+            case ExprTokenType::Number:
+                code->code.push_back({Op::Const, static_cast<uint32_t>(code->constants.size())});
+                code->constants.push_back(parse_number(tok.value));
+                break;
+            case ExprTokenType::Name:
+                code->code.push_back({Op::Var, slot_of(code->names, tok.value)});
+                break;
+            case ExprTokenType::Func: {
+                std::string upper = tok.value;
+                std::transform(upper.begin(), upper.end(), upper.begin(),
+                    [](unsigned char c) { return std::toupper(c); });
+                uint32_t slot = slot_of(code->funcs, upper);
+                if (slot == code->calls.size())
+                    code->calls.push_back({Token::make_command(upper)});
+                code->code.push_back({Op::Func, slot, static_cast<uint32_t>(tok.argc)});
+                break;
+            }
+            case ExprTokenType::Op: {
+                Op op = tok.value == "NEG" ? Op::Neg
+                      : tok.value == "+"   ? Op::Add
+                      : tok.value == "-"   ? Op::Sub
+                      : tok.value == "*"   ? Op::Mul
+                      : tok.value == "/"   ? Op::Div
+                      : tok.value == "^"   ? Op::Pow
+                      : throw std::runtime_error("Unknown operator: " + tok.value);
+                code->code.push_back({op, 0});
+                break;
+            }
+            default:
+                break;
         }
-        if (target == 1) return Rational(std::get<Rational>(pa) / std::get<Rational>(pb));
-        return Real(std::get<Real>(pa) / std::get<Real>(pb));
-    }
-    if (op == "^") {
-        // Power: promote everything to Real for simplicity
-        Object ra_obj = promote(pa, 2);
-        Object rb_obj = promote(pb, 2);
-        Real base = std::get<Real>(ra_obj);
-        Real exp = std::get<Real>(rb_obj);
-        return Real(boost::multiprecision::pow(base, exp));
     }
+    return code;
+}
+
+// --- Cache ---
 
-    throw std::runtime_error("Unknown operator: " + op);
+std::shared_ptr<const CompiledExpr> ExprCache::get(const std::string& expr) {
+    auto it = index_.find(expr);
+    if (it != index_.end()) {
+        ++hits_;
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return it->second->second;
+    }
+    ++misses_;
+    auto code = compile_expression(expr);
+    if (capacity_ == 0) return code;
+    if (index_.size() >= capacity_) {
+        index_.erase(lru_.back().first);
+        lru_.pop_back();
+        ++evictions_;
+    }
+    lru_.emplace_front(expr, code);
+    index_.emplace(expr, lru_.begin());
+    return code;
 }
 
-Object eval_rpn(const std::vector<ExprToken>& rpn, Context& ctx, bool exact) {
-    std::vector<Object> stack;
+// --- Evaluator ---
 
-    for (const auto& tok : rpn) {
-        if (tok.type == ExprTokenType::Number) {
-            // Parse number: if it contains '.' or 'E'/'e', it's Real; otherwise Integer
-            const auto& s = tok.value;
-            bool is_real = false;
-            for (char c : s) {
-                if (c == '.' || c == 'E' || c == 'e') { is_real = true; break; }
-            }
-            if (is_real) {
-                stack.push_back(Real(s));
-            } else {
-                stack.push_back(Integer(s));
+Object eval_compiled(const CompiledExpr& code, Context& ctx, bool exact) {
+    using Op = CompiledExpr::Op;
+    ArenaAllocator<Object> scratch(&ctx.arena());
+    ArenaVector<Object> stack(scratch);
+    stack.reserve(code.code.size());
+    // Variable slots are resolved on first use within this evaluation
+    ArenaVector<std::optional<Object>> vars(code.names.size(), scratch);
+
+    for (const auto& ins : code.code) {
+        switch (ins.op) {
+            case Op::Const:
+                stack.push_back(code.constants[ins.arg]);
+                break;
+            case Op::Var: {
+                auto& slot = vars[ins.arg];
+                if (!slot) slot = resolve_name(code.names[ins.arg], ctx);
+                stack.push_back(*slot);
+                break;
             }
-        } else if (tok.type == ExprTokenType::Name) {
-            // Resolve variable: locals first, then global store (case-sensitive)
-            auto local = ctx.resolve_local(tok.value);
-            if (local.has_value()) {
-                stack.push_back(*local);
-            } else {
-                Object val = ctx.store().recall_variable(ctx.store().current_dir(), tok.value);
-                if (std::holds_alternative<Error>(val)) {
-                    throw std::runtime_error("Undefined variable: " + tok.value);
+            case Op::Func: {
+                size_t argc = ins.argc;
+                if (stack.size() < argc) throw std::runtime_error("Malformed expression");
+                Args args(std::make_move_iterator(stack.end() - argc),
+                          std::make_move_iterator(stack.end()), scratch);
+                stack.resize(stack.size() - argc);
+                const std::string& upper = code.funcs[ins.arg];
+
+                Object result;
+                if (const NativeFunction* fn = ctx.commands().find_function(upper)) {
+                    // Built-in numeric function: call it directly
+                    if (fn->arity != static_cast<int>(argc))
+                        throw std::runtime_error("Wrong number of arguments: " + upper);
+                    result = fn->fn(args, ctx);
+                } else {
+                    // Other commands and user-defined programs take their
+                    // arguments from the stack (a program binds them with ->)
+                    Store& store = ctx.store();
+                    int base = store.depth();
+                    for (const auto& arg : args) store.push(arg);
+                    ctx.execute_tokens(code.calls[ins.arg]);
+                    if (store.depth() != base + 1)
+                        throw std::runtime_error("Function must return one value: " + upper);
+                    result = store.pop();
                 }
-                stack.push_back(val);
-            }
-        } else if (tok.type == ExprTokenType::Func) {
-            // Dispatch function call through the command registry.
-            // Pop arg from eval stack, push to store, execute command, pop result back.
-            if (stack.empty()) throw std::runtime_error("Malformed expression");
-            Object arg = stack.back(); stack.pop_back();
-            std::string upper = tok.value;
-            std::transform(upper.begin(), upper.end(), upper.begin(),
-                [](unsigned char c) { return std::toupper(c); });
-
-            // Track whether input was exact (Integer or Rational)
-            bool arg_was_exact = std::holds_alternative<Integer>(arg)
-                              || std::holds_alternative<Rational>(arg);
-
-            ctx.store().push(arg);
-            ctx.execute_tokens({Token::make_command(upper)});
-            Object result = ctx.store().pop();
-
-            // If input was exact but output is Real, exactness was lost — keep symbolic
-            if (exact && arg_was_exact && std::holds_alternative<Real>(result)) {
-                stack.push_back(Symbol{upper + "(" + expr_repr(arg) + ")"});
-            } else {
-                stack.push_back(result);
+
+                // If all inputs were exact but output is Real, exactness was
+                // lost — keep symbolic
+                bool args_exact = true;
+                for (const auto& arg : args) {
+                    if (!holds_alternative<Integer>(arg) &&
+                        !holds_alternative<Rational>(arg)) { args_exact = false; break; }
+                }
+                if (exact && args_exact && holds_alternative<Real>(result)) {
+                    stack.push_back(symbolic_call(upper, {args.begin(), args.end()}));
+                } else {
+                    stack.push_back(std::move(result));
+                }
+                break;
             }
-        } else if (tok.type == ExprTokenType::Op) {
-            if (tok.value == "NEG") {
+            case Op::Neg: {
                 if (stack.empty()) throw std::runtime_error("Malformed expression");
-                Object a = stack.back(); stack.pop_back();
-                if (std::holds_alternative<Symbol>(a)) {
-                    stack.push_back(Symbol{"-(" + std::get<Symbol>(a).value + ")"});
-                } else if (std::holds_alternative<Integer>(a)) {
-                    stack.push_back(Integer(-std::get<Integer>(a)));
-                } else if (std::holds_alternative<Rational>(a)) {
-                    stack.push_back(Rational(-std::get<Rational>(a)));
-                } else if (std::holds_alternative<Real>(a)) {
-                    stack.push_back(Real(-std::get<Real>(a)));
+                Object& a = stack.back();
+                if (holds_alternative<Symbol>(a)) {
+                    a = Symbol{make_neg(make_group(get<Symbol>(a).tree()))};
+                } else if (holds_alternative<Integer>(a)) {
+                    a = Integer(-get<Integer>(a));
+                } else if (holds_alternative<Rational>(a)) {
+                    a = Rational(-get<Rational>(a));
+                } else if (holds_alternative<Real>(a)) {
+                    a = Real(-get<Real>(a));
                 } else {
                     throw std::runtime_error("Non-numeric value in expression");
                 }
-            } else {
+                break;
+            }
+            default: {
                 if (stack.size() < 2) throw std::runtime_error("Malformed expression");
-                Object b = stack.back(); stack.pop_back();
-                Object a = stack.back(); stack.pop_back();
-                if (std::holds_alternative<Symbol>(a) || std::holds_alternative<Symbol>(b)) {
-                    stack.push_back(symbolic_binary_expr(a, b, tok.value));
+                Object b = std::move(stack.back()); stack.pop_back();
+                Object a = std::move(stack.back()); stack.pop_back();
+                if (holds_alternative<Symbol>(a) || holds_alternative<Symbol>(b)) {
+                    stack.push_back(symbolic_binary(a, b, op_text(ins.op)));
                 } else {
-                    stack.push_back(apply_binary(tok.value, a, b));
+                    stack.push_back(apply_binary(ins.op, std::move(a), b));
                 }
+                break;
             }
         }
     }
 
     if (stack.size() != 1) throw std::runtime_error("Malformed expression");
-    return stack[0];
+    return std::move(stack[0]);
 }
 
-} // anonymous namespace
-
 Object eval_expression(const std::string& expr, Context& ctx) {
-    auto tokens = tokenize_expression(expr);
-    auto rpn = shunting_yard(tokens);
-    return eval_rpn(rpn, ctx, true);
+    return eval_compiled(*ctx.expr_cache().get(expr), ctx, true);
 }
 
 Object eval_expression_numeric(const std::string& expr, Context& ctx) {
-    auto tokens = tokenize_expression(expr);
-    auto rpn = shunting_yard(tokens);
-    return eval_rpn(rpn, ctx, false);
+    return eval_compiled(*ctx.expr_cache().get(expr), ctx, false);
 }
 
 } // namespace lpr
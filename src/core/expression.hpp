@@ -1,7 +1,11 @@
 #pragma once
 
 #include "core/object.hpp"
+#include <cstdint>
+#include <list>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace lpr {
@@ -15,6 +19,7 @@ enum class ExprTokenType { Number, Name, Op, LParen, RParen, Comma, Func };
 struct ExprToken {
     ExprTokenType type;
     std::string value;
+    int argc = 0; // Func only: number of call arguments (set by shunting-yard)
 };
 
 // Tokenize an infix expression string into tokens.
@@ -27,6 +32,53 @@ int precedence(const std::string& op);
 // of an operator with the given precedence.
 bool needs_parens(const std::string& expr, int outer_prec);
 
+// --- Compiled expressions ---
+
+// An expression compiled once to a flat RPN program. Number literals are
+// parsed up front; each distinct variable name gets a slot, so a name used
+// several times is looked up once per evaluation.
+struct CompiledExpr {
+    enum class Op : uint8_t { Const, Var, Neg, Add, Sub, Mul, Div, Pow, Func };
+    struct Instr {
+        Op op;
+        uint32_t arg;      // constants / names / funcs index for Const, Var, Func
+        uint32_t argc = 0; // Func only
+    };
+    std::vector<Instr> code;
+    std::vector<Object> constants;
+    std::vector<std::string> names;
+    std::vector<std::string> funcs;          // uppercased
+    std::vector<std::vector<Token>> calls;   // per funcs entry, for non-native calls
+};
+
+// Tokenize, run shunting-yard and lower to a CompiledExpr. Throws on
+// malformed input.
+std::shared_ptr<const CompiledExpr> compile_expression(const std::string& expr);
+
+// Bounded LRU cache from expression text to its compiled form. One per
+// Context, so it needs no locking.
+class ExprCache {
+public:
+    explicit ExprCache(size_t capacity = 512) : capacity_(capacity) {}
+
+    std::shared_ptr<const CompiledExpr> get(const std::string& expr);
+
+    size_t size() const { return index_.size(); }
+    size_t capacity() const { return capacity_; }
+    uint64_t hits() const { return hits_; }
+    uint64_t misses() const { return misses_; }
+    uint64_t evictions() const { return evictions_; }
+
+private:
+    using Entry = std::pair<std::string, std::shared_ptr<const CompiledExpr>>;
+    size_t capacity_;
+    std::list<Entry> lru_; // most recent first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t evictions_ = 0;
+};
+
 // Evaluate an infix expression string (from a Symbol).
 // Resolves variables via context (locals first, then global store).
 // Uses exact arithmetic: operations that would lose exactness (e.g. SQRT
@@ -36,4 +88,7 @@ Object eval_expression(const std::string& expr, Context& ctx);
 // Evaluate forcing numeric results (used by ->NUM).
 Object eval_expression_numeric(const std::string& expr, Context& ctx);
 
+// Evaluate an already compiled expression.
+Object eval_compiled(const CompiledExpr& code, Context& ctx, bool exact);
+
 } // namespace lpr
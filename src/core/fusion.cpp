@@ -0,0 +1,260 @@
+#include "core/fusion.hpp"
+#include "core/numeric.hpp"
+#include "core/store.hpp"
+#include <algorithm>
+#include <cctype>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+
+namespace lpr {
+
+namespace {
+
+bool is_number(const Object& obj) {
+    return holds_alternative<Integer>(obj) || holds_alternative<Real>(obj) ||
+           holds_alternative<Rational>(obj) || holds_alternative<Complex>(obj);
+}
+
+// Operands are checked with is_number first, so this is never reached
+Object bad_argument_type() { throw std::runtime_error("Bad argument type"); }
+
+// ---- Fused operations ----
+// Each mirrors its run's commands on numeric operands: the arithmetic and
+// comparison commands go straight to numeric_dispatch for those.
+
+// DUP op: ( x -- x op x )
+template <typename Op>
+bool dup_op(Store& s, const Token*) {
+    if (s.depth() < 1) return false;
+    Object x = s.pop();
+    if (!is_number(x)) {
+        s.push(x);
+        return false;
+    }
+    Object lhs = x;
+    s.push(numeric_dispatch(std::move(lhs), x, Op{}, bad_argument_type));
+    return true;
+}
+
+// SWAP op: ( a b -- b op a )
+template <typename Op>
+bool swap_op(Store& s, const Token*) {
+    if (s.depth() < 2) return false;
+    Object b = s.pop();
+    Object a = s.pop();
+    if (!is_number(a) || !is_number(b)) {
+        s.push(a);
+        s.push(b);
+        return false;
+    }
+    s.push(numeric_dispatch(std::move(b), a, Op{}, bad_argument_type));
+    return true;
+}
+
+// OVER op: ( a b -- a b op a )
+template <typename Op>
+bool over_op(Store& s, const Token*) {
+    if (s.depth() < 2) return false;
+    Object b = s.pop();
+    Object a = s.peek(1);
+    if (!is_number(a) || !is_number(b)) {
+        s.push(b);
+        return false;
+    }
+    s.push(numeric_dispatch(std::move(b), a, Op{}, bad_argument_type));
+    return true;
+}
+
+// n op: ( x -- x op n ), n being the run's numeric literal
+template <typename Op>
+bool literal_op(Store& s, const Token* run) {
+    if (s.depth() < 1) return false;
+    Object x = s.pop();
+    if (!is_number(x)) {
+        s.push(x);
+        return false;
+    }
+    s.push(numeric_dispatch(std::move(x), run[0].literal, Op{}, bad_argument_type));
+    return true;
+}
+
+// DUP ROT: ( a b -- b b a )
+bool dup_rot(Store& s, const Token*) {
+    if (s.depth() < 2) return false;
+    Object b = s.pop();
+    Object a = s.pop();
+    s.push(b);
+    s.push(b);
+    s.push(a);
+    return true;
+}
+
+// SWAP DROP: ( a b -- b )
+bool swap_drop(Store& s, const Token*) {
+    if (s.depth() < 2) return false;
+    Object b = s.pop();
+    s.pop();
+    s.push(b);
+    return true;
+}
+
+using Equal   = NumericCompare<std::equal_to<>>;
+using Less    = NumericCompare<std::less<>>;
+using Greater = NumericCompare<std::greater<>>;
+
+// To add a fusion, give it a row here: a counter name, the token pattern
+// and an operation with the same stack effect.
+struct RuleSpec {
+    const char* name;
+    const char* pattern;
+    FusedFn fn;
+};
+
+const RuleSpec kRules[] = {
+    {"dup_mul",   "DUP *",     dup_op<NumericMul>},
+    {"dup_add",   "DUP +",     dup_op<NumericAdd>},
+    {"dup_rot",   "DUP ROT",   dup_rot},
+    {"swap_sub",  "SWAP -",    swap_op<NumericSub>},
+    {"swap_drop", "SWAP DROP", swap_drop},
+    {"over_add",  "OVER +",    over_op<NumericAdd>},
+    {"over_sub",  "OVER -",    over_op<NumericSub>},
+    {"over_mul",  "OVER *",    over_op<NumericMul>},
+    {"lit_add",   "# +",       literal_op<NumericAdd>},
+    {"lit_sub",   "# -",       literal_op<NumericSub>},
+    {"lit_mul",   "# *",       literal_op<NumericMul>},
+    {"lit_eq",    "# ==",      literal_op<Equal>},
+    {"lit_lt",    "# <",       literal_op<Less>},
+    {"lit_gt",    "# >",       literal_op<Greater>},
+};
+
+// Token::fusion holds 1 + the rule index in a byte
+static_assert(sizeof(kRules) / sizeof(kRules[0]) < 256, "too many fusion rules");
+
+// Case-insensitive match against an uppercase pattern word; interned, so
+// the usual spelling is a pointer compare
+bool command_is(const Atom& cmd, const Atom& upper) {
+    if (cmd == upper) return true;
+    if (cmd.size() != upper.size()) return false;
+    for (size_t i = 0; i < cmd.size(); ++i) {
+        if (std::toupper(static_cast<unsigned char>(cmd.str()[i])) != upper.str()[i]) return false;
+    }
+    return true;
+}
+
+struct Word {
+    bool number;  // "#": any numeric literal
+    Atom upper;
+};
+
+// fusion_rules() grouped by first word, so a token is only tried against
+// rules that can start with it
+struct RuleIndex {
+    std::vector<std::vector<Word>> words;  // per rule
+    std::vector<size_t> number_first;
+    std::vector<std::pair<Atom, std::vector<size_t>>> command_first;
+    Atom arrow = Atom::intern("->"), arrow_utf8 = Atom::intern("\xe2\x86\x92"),
+         for_word = Atom::intern("FOR");
+};
+
+const RuleIndex& rule_index() {
+    static const RuleIndex index = [] {
+        RuleIndex ix;
+        const auto& rules = fusion_rules();
+        for (size_t r = 0; r < rules.size(); ++r) {
+            std::vector<Word> words;
+            for (const auto& w : rules[r].pattern) words.push_back({w == "#", Atom::intern(w)});
+            if (words[0].number) {
+                ix.number_first.push_back(r);
+            } else {
+                auto it = std::find_if(ix.command_first.begin(), ix.command_first.end(),
+                                       [&](const auto& g) { return g.first == words[0].upper; });
+                if (it == ix.command_first.end()) {
+                    ix.command_first.push_back({words[0].upper, {}});
+                    it = ix.command_first.end() - 1;
+                }
+                it->second.push_back(r);
+            }
+            ix.words.push_back(std::move(words));
+        }
+        return ix;
+    }();
+    return index;
+}
+
+// Whether the rule's words after the first match tokens from i + 1 on
+bool matches_rest(const std::vector<Token>& tokens, size_t i, const std::vector<Word>& words) {
+    if (i + words.size() > tokens.size()) return false;
+    for (size_t k = 1; k < words.size(); ++k) {
+        const Token& t = tokens[i + k];
+        if (words[k].number) {
+            if (t.kind != Token::Literal || !is_number(t.literal)) return false;
+        } else if (t.kind != Token::Command || !command_is(t.command, words[k].upper)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Index of the first rule that matches at tokens[i]; ix.words.size() if none
+size_t match_at(const std::vector<Token>& tokens, size_t i, const RuleIndex& ix) {
+    const Token& t = tokens[i];
+    if (t.kind == Token::Literal) {
+        if (!is_number(t.literal)) return ix.words.size();
+        for (size_t r : ix.number_first) {
+            if (matches_rest(tokens, i, ix.words[r])) return r;
+        }
+        return ix.words.size();
+    }
+    for (const auto& [first, rules] : ix.command_first) {
+        if (!command_is(t.command, first)) continue;
+        for (size_t r : rules) {
+            if (matches_rest(tokens, i, ix.words[r])) return r;
+        }
+        break;
+    }
+    return ix.words.size();
+}
+
+} // anonymous namespace
+
+const std::vector<FusionRule>& fusion_rules() {
+    static const std::vector<FusionRule> rules = [] {
+        std::vector<FusionRule> out;
+        for (const RuleSpec& spec : kRules) {
+            FusionRule rule{spec.name, {}, spec.fn};
+            std::istringstream words(spec.pattern);
+            for (std::string w; words >> w;) rule.pattern.push_back(w);
+            out.push_back(std::move(rule));
+        }
+        return out;
+    }();
+    return rules;
+}
+
+void mark_fusions(std::vector<Token>& tokens) {
+    const RuleIndex& ix = rule_index();
+    size_t i = 0;
+    while (i < tokens.size()) {
+        Token& t = tokens[i];
+        if (t.kind == Token::Command && (t.command == ix.arrow || t.command == ix.arrow_utf8)) {
+            // Local names run up to the body
+            ++i;
+            while (i < tokens.size() && tokens[i].kind == Token::Command) ++i;
+            continue;
+        }
+        if (t.kind == Token::Command && command_is(t.command, ix.for_word)) {
+            i += 2; // FOR and its loop variable
+            continue;
+        }
+        size_t r = match_at(tokens, i, ix);
+        if (r == ix.words.size()) {
+            ++i;
+            continue;
+        }
+        t.fusion = static_cast<uint8_t>(r + 1);
+        i += ix.words[r].size();
+    }
+}
+
+} // namespace lpr
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "core/object.hpp"
+#include <string>
+#include <vector>
+
+namespace lpr {
+
+class Store;
+
+// Superinstructions: short command sequences such as DUP * or 1 + that
+// the interpreter runs as one native operation.
+//
+// The parser marks the first token of every matching run (Token::fusion)
+// and leaves the tokens themselves alone, so program text, equality and
+// serialization do not change. A fused operation has the same effect on the
+// stack as its run but reads and writes the store fewer times. When its fast
+// path does not apply (too few arguments, a non-numeric operand) it leaves
+// the stack as it found it and returns false; the interpreter then runs the
+// tokens one by one, so errors still come from the original commands.
+
+// Applies a run, starting at its first token; false if it did nothing
+using FusedFn = bool (*)(Store& s, const Token* run);
+
+struct FusionRule {
+    std::string name;                  // suffix of the PERFSTATS counter
+    std::vector<std::string> pattern;  // uppercase command names; "#" is a numeric literal
+    FusedFn fn;
+};
+
+// All rules, built once from a static table. Where two rules match at the
+// same token, the earlier one wins.
+const std::vector<FusionRule>& fusion_rules();
+
+// Mark fusable runs in one token vector (not in nested programs: the parser
+// calls this once per program body). Local names after -> and the loop
+// variable after FOR are never part of a run.
+void mark_fusions(std::vector<Token>& tokens);
+
+} // namespace lpr
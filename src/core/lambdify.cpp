@@ -0,0 +1,282 @@
+#include "core/lambdify.hpp"
+#include "core/context.hpp"
+#include "core/expr_tree.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace lpr {
+
+namespace {
+
+using Op = NumericFunction::Op;
+using Instr = NumericFunction::Instr;
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kE = 2.71828182845904523536;
+
+double fn_sq(double x) { return x * x; }
+double fn_alog(double x) { return std::pow(10.0, x); }
+double fn_fp(double x) { return x - std::trunc(x); }
+double fn_sign(double x) { return x > 0 ? 1.0 : x < 0 ? -1.0 : x; }
+double fn_d2r(double x) { return x * kPi / 180.0; }
+double fn_r2d(double x) { return x * 180.0 / kPi; }
+double fn_pct(double a, double b) { return a * b / 100.0; }
+
+// How a function relates to the angle mode
+enum class Angle { None, Arg, Result };
+
+struct Unary { const char* name; double (*fn)(double); Angle angle; };
+struct Binary { const char* name; double (*fn)(double, double); Angle angle; };
+
+// Double forms of the native functions registered in commands.cpp
+const Unary kUnary[] = {
+    {"ABS", [](double x) { return std::fabs(x); }, Angle::None},
+    {"SIN", [](double x) { return std::sin(x); }, Angle::Arg},
+    {"COS", [](double x) { return std::cos(x); }, Angle::Arg},
+    {"TAN", [](double x) { return std::tan(x); }, Angle::Arg},
+    {"ASIN", [](double x) { return std::asin(x); }, Angle::Result},
+    {"ACOS", [](double x) { return std::acos(x); }, Angle::Result},
+    {"ATAN", [](double x) { return std::atan(x); }, Angle::Result},
+    {"EXP", [](double x) { return std::exp(x); }, Angle::None},
+    {"LN", [](double x) { return std::log(x); }, Angle::None},
+    {"LOG", [](double x) { return std::log10(x); }, Angle::None},
+    {"ALOG", fn_alog, Angle::None},
+    {"SQRT", [](double x) { return std::sqrt(x); }, Angle::None},
+    {"SQ", fn_sq, Angle::None},
+    {"FLOOR", [](double x) { return std::floor(x); }, Angle::None},
+    {"CEIL", [](double x) { return std::ceil(x); }, Angle::None},
+    {"IP", [](double x) { return std::trunc(x); }, Angle::None},
+    {"FP", fn_fp, Angle::None},
+    {"SIGN", fn_sign, Angle::None},
+    {"GAMMA", [](double x) { return std::tgamma(x); }, Angle::None},
+    {"D->R", fn_d2r, Angle::None},
+    {"D" "\xe2\x86\x92" "R", fn_d2r, Angle::None},
+    {"R->D", fn_r2d, Angle::None},
+    {"R" "\xe2\x86\x92" "D", fn_r2d, Angle::None},
+};
+
+const Binary kBinary[] = {
+    {"ATAN2", [](double y, double x) { return std::atan2(y, x); }, Angle::Result},
+    {"MIN", [](double a, double b) { return std::fmin(a, b); }, Angle::None},
+    {"MAX", [](double a, double b) { return std::fmax(a, b); }, Angle::None},
+    {"%", fn_pct, Angle::None},
+};
+
+double exec(const Instr* ip, const Instr* end, const double* args, double* stack) {
+    double* sp = stack; // one past the top
+    for (; ip != end; ++ip) {
+        switch (ip->op) {
+            case Op::Const:  *sp++ = ip->value; break;
+            case Op::Var:    *sp++ = args[ip->index]; break;
+            case Op::Neg:    sp[-1] = -sp[-1]; break;
+            case Op::Add:    --sp; sp[-1] += sp[0]; break;
+            case Op::Sub:    --sp; sp[-1] -= sp[0]; break;
+            case Op::Mul:    --sp; sp[-1] *= sp[0]; break;
+            case Op::Div:    --sp; sp[-1] /= sp[0]; break;
+            case Op::Pow:    --sp; sp[-1] = std::pow(sp[-1], sp[0]); break;
+            case Op::Square: sp[-1] *= sp[-1]; break;
+            case Op::Call1:  sp[-1] = ip->fn1(sp[-1]); break;
+            case Op::Call2:  --sp; sp[-1] = ip->fn2(sp[-1], sp[0]); break;
+        }
+    }
+    return stack[0];
+}
+
+double object_to_double(const Object& obj) {
+    if (holds_alternative<Integer>(obj)) return get<Integer>(obj).convert_to<double>();
+    if (holds_alternative<Rational>(obj)) return get<Rational>(obj).convert_to<double>();
+    if (holds_alternative<Real>(obj)) return get<Real>(obj).convert_to<double>();
+    throw std::runtime_error("Bad argument type");
+}
+
+// Emits code for a tree in post-order, folding operations whose operands
+// are all constants as it goes.
+class Compiler {
+public:
+    Compiler(const std::vector<std::string>& params, Context& ctx)
+        : params_(params), ctx_(ctx) {
+        std::string mode = ctx.store().get_meta("angle_mode", "RAD");
+        to_rad_ = mode == "DEG" ? kPi / 180.0 : mode == "GRAD" ? kPi / 200.0 : 1.0;
+    }
+
+    std::vector<Instr> compile(const ExprPtr& root) {
+        using Kind = ExprNode::Kind;
+        // Explicit stack, so deep left-leaning sums do not recurse
+        std::vector<std::pair<const ExprNode*, size_t>> work{{root.get(), 0}};
+        while (!work.empty()) {
+            auto& [node, next] = work.back();
+            if (next < node->kids.size()) {
+                const ExprNode* kid = node->kids[next++].get();
+                work.push_back({kid, 0});
+                continue;
+            }
+            const ExprNode* done = node;
+            work.pop_back();
+            switch (done->kind) {
+                case Kind::Number: constant(std::strtod(done->text.c_str(), nullptr)); break;
+                case Kind::Name:   name(done->text); break;
+                case Kind::Group:  break; // operand already emitted
+                case Kind::Neg:    emit({Op::Neg}, 1); break;
+                case Kind::Add:    emit({Op::Add}, 2); break;
+                case Kind::Sub:    emit({Op::Sub}, 2); break;
+                case Kind::Mul:    emit({Op::Mul}, 2); break;
+                case Kind::Div:    emit({Op::Div}, 2); break;
+                case Kind::Pow:    power(); break;
+                case Kind::Call:   call(done->text, done->kids.size()); break;
+                case Kind::Opaque:
+                    throw std::runtime_error("Cannot compile expression: " + done->text);
+            }
+        }
+        return std::move(code_);
+    }
+
+private:
+    struct Value { size_t start; bool constant; };
+
+    void constant(double v) {
+        Instr ins{Op::Const};
+        ins.value = v;
+        emit(ins, 0);
+    }
+
+    void name(const std::string& n) {
+        for (size_t i = 0; i < params_.size(); ++i) {
+            if (params_[i] == n) {
+                Instr ins{Op::Var};
+                ins.index = static_cast<uint32_t>(i);
+                emit(ins, 0);
+                return;
+            }
+        }
+        // Not a parameter: bind its current value
+        if (auto local = ctx_.resolve_local(n)) {
+            constant(object_to_double(*local));
+            return;
+        }
+        Object val = ctx_.store().recall_variable(ctx_.store().current_dir(), n);
+        if (!holds_alternative<Error>(val)) {
+            constant(object_to_double(val));
+        } else if (n == "PI") {
+            constant(kPi);
+        } else if (n == "E") {
+            constant(kE);
+        } else {
+            throw std::runtime_error("Undefined variable: " + n);
+        }
+    }
+
+    void power() {
+        // x^2 is by far the most common power: multiply instead of pow()
+        const Value& exp = values_.back();
+        if (exp.constant && code_[exp.start].value == 2.0) {
+            code_.pop_back();
+            values_.pop_back();
+            emit({Op::Square}, 1);
+        } else {
+            emit({Op::Pow}, 2);
+        }
+    }
+
+    void call(const std::string& func, size_t argc) {
+        for (const auto& u : kUnary) {
+            if (func != u.name) continue;
+            if (argc != 1) throw std::runtime_error("Wrong number of arguments: " + func);
+            if (u.angle == Angle::Arg) scale(to_rad_);
+            Instr ins{Op::Call1};
+            ins.fn1 = u.fn;
+            emit(ins, 1);
+            if (u.angle == Angle::Result) scale(1.0 / to_rad_);
+            return;
+        }
+        for (const auto& b : kBinary) {
+            if (func != b.name) continue;
+            if (argc != 2) throw std::runtime_error("Wrong number of arguments: " + func);
+            Instr ins{Op::Call2};
+            ins.fn2 = b.fn;
+            emit(ins, 2);
+            if (b.angle == Angle::Result) scale(1.0 / to_rad_);
+            return;
+        }
+        throw std::runtime_error("Cannot compile function: " + func);
+    }
+
+    // Multiply the top value by an angle conversion factor
+    void scale(double factor) {
+        if (factor == 1.0) return;
+        constant(factor);
+        emit({Op::Mul}, 2);
+    }
+
+    void emit(Instr ins, size_t argc) {
+        if (values_.size() < argc) throw std::runtime_error("Malformed expression");
+        size_t start = argc ? values_[values_.size() - argc].start : code_.size();
+        bool all_const = true;
+        for (size_t i = values_.size() - argc; i < values_.size(); ++i)
+            all_const = all_const && values_[i].constant;
+        values_.resize(values_.size() - argc);
+        code_.push_back(ins);
+
+        if (argc > 0 && all_const) {
+            std::vector<double> stack(code_.size() - start);
+            double v = exec(code_.data() + start, code_.data() + code_.size(), nullptr, stack.data());
+            code_.resize(start);
+            Instr folded{Op::Const};
+            folded.value = v;
+            code_.push_back(folded);
+        }
+        values_.push_back({start, argc == 0 ? ins.op == Op::Const : all_const});
+    }
+
+    const std::vector<std::string>& params_;
+    Context& ctx_;
+    double to_rad_ = 1.0;
+    std::vector<Instr> code_;
+    std::vector<Value> values_;
+};
+
+} // namespace
+
+double NumericFunction::run(const double* args, double* stack) const {
+    return exec(code_.data(), code_.data() + code_.size(), args, stack);
+}
+
+double NumericFunction::operator()(const double* args) const {
+    if (max_depth_ <= 32) {
+        double stack[32];
+        return run(args, stack);
+    }
+    std::vector<double> stack(max_depth_);
+    return run(args, stack.data());
+}
+
+void NumericFunction::evaluate(const double* args, size_t n, double* out) const {
+    std::vector<double> stack(max_depth_);
+    for (size_t i = 0; i < n; ++i) out[i] = run(args + i * arity_, stack.data());
+}
+
+NumericFunction lambdify(const ExprPtr& tree, const std::vector<std::string>& params,
+                         Context& ctx) {
+    NumericFunction fn;
+    fn.code_ = Compiler(params, ctx).compile(tree);
+    fn.arity_ = params.size();
+
+    size_t depth = 0;
+    for (const auto& ins : fn.code_) {
+        switch (ins.op) {
+            case Op::Const: case Op::Var:
+                fn.max_depth_ = std::max(fn.max_depth_, ++depth);
+                break;
+            case Op::Add: case Op::Sub: case Op::Mul: case Op::Div:
+            case Op::Pow: case Op::Call2:
+                --depth;
+                break;
+            default:
+                break;
+        }
+    }
+    if (depth != 1) throw std::runtime_error("Malformed expression");
+    return fn;
+}
+
+} // namespace lpr
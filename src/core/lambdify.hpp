@@ -0,0 +1,58 @@
+#pragma once
+
+#include "core/object.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lpr {
+
+class Context;
+
+// A Symbol compiled to a flat double-precision program over declared
+// parameters. Evaluation touches no Objects, locals or SQL, so a compiled
+// function can be run over millions of points. Domain errors follow IEEE
+// arithmetic (NaN or infinity) instead of throwing; callers decide what an
+// undefined point means.
+class NumericFunction {
+public:
+    enum class Op : uint8_t {
+        Const, Var, Neg, Add, Sub, Mul, Div, Pow, Square, Call1, Call2,
+    };
+    struct Instr {
+        Op op;
+        uint32_t index = 0;                   // Var: parameter slot
+        double value = 0;                     // Const
+        double (*fn1)(double) = nullptr;      // Call1
+        double (*fn2)(double, double) = nullptr; // Call2
+    };
+
+    size_t arity() const { return arity_; }
+    size_t size() const { return code_.size(); }
+
+    // Evaluate at one point; `args` holds arity() values.
+    double operator()(const double* args) const;
+
+    // Evaluate `n` points stored row-major, arity() values per point.
+    void evaluate(const double* args, size_t n, double* out) const;
+
+private:
+    friend NumericFunction lambdify(const ExprPtr&, const std::vector<std::string>&, Context&);
+
+    double run(const double* args, double* stack) const;
+
+    std::vector<Instr> code_;
+    size_t arity_ = 0;
+    size_t max_depth_ = 0;
+};
+
+// Compile `tree` with `params` as the parameters, in order. Other names are
+// bound now: local and global variables holding real numbers, then the
+// constants PI and E. Trigonometric functions use the current angle mode.
+// Subtrees without parameters are folded to constants. Throws for names
+// that do not resolve to a number and for functions with no double form.
+NumericFunction lambdify(const ExprPtr& tree, const std::vector<std::string>& params,
+                         Context& ctx);
+
+} // namespace lpr
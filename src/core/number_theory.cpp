@@ -0,0 +1,474 @@
+#include "core/number_theory.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <stdexcept>
+
+namespace lpr {
+
+namespace {
+
+using u64 = uint64_t;
+using u128 = unsigned __int128;
+
+constexpr u64 kU64Max = std::numeric_limits<u64>::max();
+
+bool fits_u64(const Integer& n) { return n >= 0 && n <= kU64Max; }
+
+// Primes below 1000 for trial division
+const std::vector<u64>& small_primes() {
+    static const std::vector<u64> primes = [] {
+        std::vector<u64> p;
+        std::vector<bool> composite(1000, false);
+        for (u64 i = 2; i < 1000; ++i) {
+            if (composite[i]) continue;
+            p.push_back(i);
+            for (u64 j = i * i; j < 1000; j += i) composite[j] = true;
+        }
+        return p;
+    }();
+    return primes;
+}
+
+// ---- 64-bit kernels ----
+
+u64 mulmod64(u64 a, u64 b, u64 m) { return static_cast<u64>(u128(a) * b % m); }
+
+u64 powmod64(u64 b, u64 e, u64 m) {
+    u64 r = 1 % m;
+    b %= m;
+    for (; e; e >>= 1) {
+        if (e & 1) r = mulmod64(r, b, m);
+        b = mulmod64(b, b, m);
+    }
+    return r;
+}
+
+u64 gcd64(u64 a, u64 b) {
+    if (a == 0) return b;
+    if (b == 0) return a;
+    int shift = __builtin_ctzll(a | b);
+    a >>= __builtin_ctzll(a);
+    do {
+        b >>= __builtin_ctzll(b);
+        if (a > b) std::swap(a, b);
+        b -= a;
+    } while (b);
+    return a << shift;
+}
+
+// Strong probable-prime test to base a, for odd n > 2
+bool strong_probable_prime64(u64 n, u64 a) {
+    a %= n;
+    if (a == 0) return true;
+    u64 d = n - 1;
+    int s = __builtin_ctzll(d);
+    d >>= s;
+    u64 x = powmod64(a, d, n);
+    if (x == 1 || x == n - 1) return true;
+    for (int i = 1; i < s; ++i) {
+        x = mulmod64(x, x, n);
+        if (x == n - 1) return true;
+    }
+    return false;
+}
+
+bool is_prime64(u64 n) {
+    if (n < 2) return false;
+    for (u64 p : small_primes()) {
+        if (n % p == 0) return n == p;
+    }
+    if (n < 1000 * 1000) return true;
+    // Jim Sinclair's bases: deterministic for every n < 2^64
+    for (u64 a : {2ull, 325ull, 9375ull, 28178ull, 450775ull, 9780504ull, 1795265022ull}) {
+        if (!strong_probable_prime64(n, a)) return false;
+    }
+    return true;
+}
+
+// Pollard-Brent rho: a non-trivial factor of odd composite n, or 0
+u64 rho64(u64 n) {
+    for (u64 c = 1; c < 64; ++c) {
+        auto f = [&](u64 x) { return static_cast<u64>((u128(x) * x + c) % n); };
+        u64 y = 2, x = 2, ys = 2, q = 1, g = 1;
+        const u64 m = 128;
+        for (u64 r = 1; g == 1; r <<= 1) {
+            x = y;
+            for (u64 i = 0; i < r; ++i) y = f(y);
+            for (u64 k = 0; k < r && g == 1; k += m) {
+                ys = y;
+                for (u64 i = 0; i < std::min(m, r - k); ++i) {
+                    y = f(y);
+                    q = mulmod64(q, x > y ? x - y : y - x, n);
+                }
+                g = gcd64(q, n);
+            }
+        }
+        if (g == n) {
+            // The batch overshot: retrace it one step at a time
+            do {
+                ys = f(ys);
+                g = gcd64(x > ys ? x - ys : ys - x, n);
+            } while (g == 1);
+        }
+        if (g != n) return g;
+    }
+    return 0;
+}
+
+// ---- Big kernels ----
+
+Integer mod_pos(const Integer& a, const Integer& m) {
+    Integer r = a % m;
+    return r < 0 ? Integer(r + m) : r;
+}
+
+bool strong_probable_prime(const Integer& n, const Integer& a) {
+    Integer d = n - 1;
+    unsigned s = boost::multiprecision::lsb(d);
+    d >>= s;
+    Integer x = boost::multiprecision::powm(a, d, n);
+    if (x == 1 || x == n - 1) return true;
+    for (unsigned i = 1; i < s; ++i) {
+        x = x * x % n;
+        if (x == n - 1) return true;
+    }
+    return false;
+}
+
+// Jacobi symbol (a/n) for odd n > 0
+int jacobi(Integer a, Integer n) {
+    a = mod_pos(a, n);
+    int result = 1;
+    while (a != 0) {
+        unsigned twos = boost::multiprecision::lsb(a);
+        a >>= twos;
+        unsigned n8 = static_cast<unsigned>(n % 8);
+        if ((twos & 1) && (n8 == 3 || n8 == 5)) result = -result;
+        if (a % 4 == 3 && n % 4 == 3) result = -result;
+        std::swap(a, n);
+        a %= n;
+    }
+    return n == 1 ? result : 0;
+}
+
+// Strong Lucas probable-prime test with Selfridge's parameters, for odd
+// n that is not a perfect square
+bool strong_lucas_probable_prime(const Integer& n) {
+    long d_val = 5;
+    for (;; d_val = d_val > 0 ? -(d_val + 2) : -d_val + 2) {
+        int j = jacobi(Integer(d_val), n);
+        if (j == -1) break;
+        if (j == 0 && n != (d_val < 0 ? -d_val : d_val)) return false;
+    }
+    Integer D = mod_pos(Integer(d_val), n);
+    Integer Q = mod_pos(Integer((1 - d_val) / 4), n);
+    auto half = [&](Integer x) {
+        if (x & 1) x += n;
+        return Integer(x >> 1);
+    };
+
+    Integer k = n + 1;
+    unsigned s = boost::multiprecision::lsb(k);
+    k >>= s;
+    // U_1 = 1, V_1 = P = 1, then walk the bits of k below the top one
+    Integer U = 1, V = 1, Qk = Q;
+    for (int bit = static_cast<int>(boost::multiprecision::msb(k)) - 1; bit >= 0; --bit) {
+        U = U * V % n;
+        V = mod_pos(V * V - 2 * Qk, n);
+        Qk = Qk * Qk % n;
+        if (boost::multiprecision::bit_test(k, bit)) {
+            Integer u1 = half(U + V);
+            V = half(mod_pos(D * U + V, n));
+            U = u1 % n;
+            Qk = Qk * Q % n;
+        }
+    }
+    if (U == 0 || V == 0) return true;
+    for (unsigned r = 1; r < s; ++r) {
+        V = mod_pos(V * V - 2 * Qk, n);
+        if (V == 0) return true;
+        Qk = Qk * Qk % n;
+    }
+    return false;
+}
+
+bool is_prime_big(const Integer& n) {
+    for (u64 p : small_primes()) {
+        if (n % p == 0) return false;
+    }
+    if (!strong_probable_prime(n, 2)) return false;
+    Integer root = boost::multiprecision::sqrt(n);
+    if (root * root == n) return false;
+    return strong_lucas_probable_prime(n);
+}
+
+// Pollard-Brent rho on big n within an iteration budget; 0 on failure
+Integer rho_big(const Integer& n, u64 budget) {
+    for (unsigned c = 1; c < 4; ++c) {
+        auto f = [&](const Integer& x) { return Integer((x * x + c) % n); };
+        Integer y = 2, x = 2, ys = 2, q = 1, g = 1;
+        const u64 m = 128;
+        u64 steps = 0;
+        for (u64 r = 1; g == 1 && steps < budget; r <<= 1) {
+            x = y;
+            for (u64 i = 0; i < r; ++i) y = f(y);
+            for (u64 k = 0; k < r && g == 1; k += m) {
+                ys = y;
+                for (u64 i = 0; i < std::min(m, r - k); ++i) {
+                    y = f(y);
+                    q = q * (x > y ? Integer(x - y) : Integer(y - x)) % n;
+                }
+                g = boost::multiprecision::gcd(q, n);
+            }
+            steps += 2 * r;
+        }
+        if (g == 1) return 0; // out of budget
+        if (g == n) {
+            do {
+                ys = f(ys);
+                g = boost::multiprecision::gcd(x > ys ? Integer(x - ys) : Integer(ys - x), n);
+            } while (g == 1);
+        }
+        if (g != n) return g;
+    }
+    return 0;
+}
+
+// ECM stage 1 on Montgomery curves in x-only (X:Z) coordinates, with
+// Suyama's parametrization. Returns a non-trivial factor of n, or 0.
+class Ecm {
+public:
+    explicit Ecm(const Integer& n) : n_(n) {}
+
+    Integer run() {
+        // (B1, curves): enough to find factors of about 15, 20 and 25 digits
+        static const std::pair<u64, int> kStages[] = {{2000, 25}, {11000, 50}, {50000, 40}};
+        std::vector<u64> primes = primes_upto(kStages[2].first);
+        u64 sigma = 6;
+        for (const auto& [b1, curves] : kStages) {
+            for (int c = 0; c < curves; ++c, ++sigma) {
+                Integer g = curve(sigma, b1, primes);
+                if (g != 0) return g;
+            }
+        }
+        return 0;
+    }
+
+private:
+    struct Point { Integer x, z; };
+
+    static std::vector<u64> primes_upto(u64 n) {
+        std::vector<bool> composite(n + 1, false);
+        std::vector<u64> out;
+        for (u64 i = 2; i <= n; ++i) {
+            if (composite[i]) continue;
+            out.push_back(i);
+            for (u64 j = i * i; j <= n; j += i) composite[j] = true;
+        }
+        return out;
+    }
+
+    Integer sub(const Integer& a, const Integer& b) const { return a >= b ? Integer(a - b) : Integer(a + n_ - b); }
+    Integer mul(const Integer& a, const Integer& b) const { return a * b % n_; }
+
+    Point dbl(const Point& p) const {
+        Integer s = mul(p.x + p.z, p.x + p.z);
+        Integer d = mul(sub(p.x, p.z), sub(p.x, p.z));
+        Integer t = sub(s, d);
+        return {mul(s, d), mul(t, (d + mul(a24_, t)) % n_)};
+    }
+
+    // p + q, given their difference
+    Point add(const Point& p, const Point& q, const Point& diff) const {
+        Integer u = mul(sub(p.x, p.z), q.x + q.z);
+        Integer v = mul(p.x + p.z, sub(q.x, q.z));
+        Integer plus = (u + v) % n_, minus = sub(u, v);
+        return {mul(diff.z, mul(plus, plus)), mul(diff.x, mul(minus, minus))};
+    }
+
+    // Montgomery ladder
+    Point times(const Point& p, u64 k) const {
+        Point r0 = p, r1 = dbl(p);
+        for (int bit = 62 - __builtin_clzll(k); bit >= 0; --bit) {
+            if ((k >> bit) & 1) {
+                r0 = add(r1, r0, p);
+                r1 = dbl(r1);
+            } else {
+                r1 = add(r1, r0, p);
+                r0 = dbl(r0);
+            }
+        }
+        return r0;
+    }
+
+    Integer curve(u64 sigma, u64 b1, const std::vector<u64>& primes) {
+        Integer s = sigma;
+        Integer u = mod_pos(s * s - 5, n_);
+        Integer v = mod_pos(4 * s, n_);
+        Integer u3 = mul(mul(u, u), u);
+        Integer vu = sub(v, u);
+        Integer num = mul(mul(mul(vu, vu), vu), (3 * u + v) % n_);
+        Integer den = mul(16 * u3 % n_, v);
+        Integer g = boost::multiprecision::gcd(den, n_);
+        if (g != 1) return g != n_ ? g : Integer(0);
+        a24_ = mul(num, inv_mod(den, n_));
+
+        Point p{u3, mul(mul(v, v), v)};
+        for (u64 prime : primes) {
+            if (prime > b1) break;
+            u64 q = prime;
+            while (q <= b1 / prime) q *= prime;
+            p = times(p, q);
+        }
+        g = boost::multiprecision::gcd(p.z, n_);
+        if (g == 1) g = stage2(p, b1, 100 * b1);
+        return g != 1 && g != n_ ? g : Integer(0);
+    }
+
+    // Stage 2 catches a single extra prime q in (b1, b2] in the group order.
+    // Giant steps T = 2Dk*P are compared with baby steps j*P for odd j < D
+    // coprime to D: x(T) = x(jP) mod the factor exactly when (2Dk -+ j)*P
+    // vanishes, and 2Dk +- j covers every candidate q.
+    Integer stage2(const Point& p, u64 b1, u64 b2) const {
+        constexpr u64 D = 210;
+        std::vector<Point> baby;
+        Point p2 = dbl(p), prev = p, cur = add(p2, p, p); // P, 3P
+        baby.push_back(p);
+        for (u64 j = 3; j < D; j += 2) {
+            if (std::gcd(j, D) == 1) baby.push_back(cur);
+            Point next = add(cur, p2, prev);
+            prev = cur;
+            cur = next;
+        }
+        // k = 1 has no predecessor for the differential add: double instead
+        Point step = times(p, 2 * D);
+        u64 k = std::max<u64>(b1 / (2 * D), 1);
+        Point t = times(p, 2 * D * k);
+        Point t_prev = k > 1 ? times(p, 2 * D * (k - 1)) : t;
+        Integer acc = 1;
+        for (; 2 * D * k <= b2 + D; ++k) {
+            for (const Point& b : baby) acc = mul(acc, sub(mul(t.x, b.z), mul(b.x, t.z)));
+            Point next = k > 1 ? add(t, step, t_prev) : dbl(step);
+            t_prev = t;
+            t = next;
+        }
+        return boost::multiprecision::gcd(acc, n_);
+    }
+
+    const Integer& n_;
+    Integer a24_;
+};
+
+// A non-trivial factor of composite n > 1
+Integer split(const Integer& n) {
+    if (fits_u64(n)) {
+        if (u64 f = rho64(n.convert_to<u64>())) return f;
+    } else {
+        Integer f = rho_big(n, u64(1) << 14);
+        if (f != 0) return f;
+        f = Ecm(n).run();
+        if (f != 0) return f;
+    }
+    throw std::runtime_error("FACTORS: no factor found for " + n.str());
+}
+
+} // namespace
+
+bool is_probable_prime(const Integer& n) {
+    if (n < 2) return false;
+    if (fits_u64(n)) return is_prime64(n.convert_to<u64>());
+    return is_prime_big(n);
+}
+
+Integer next_prime(const Integer& n) {
+    if (n < 2) return 2;
+    Integer c = n + 1;
+    if (c > 2 && c % 2 == 0) ++c;
+    for (;; c += 2) {
+        if (is_probable_prime(c)) return c;
+    }
+}
+
+Integer prev_prime(const Integer& n) {
+    if (n <= 2) throw std::runtime_error("Bad argument value");
+    if (n == 3) return 2;
+    Integer c = n - 1;
+    if (c % 2 == 0) --c;
+    for (;; c -= 2) {
+        if (is_probable_prime(c)) return c;
+    }
+}
+
+std::vector<std::pair<Integer, unsigned>> factorize(const Integer& n) {
+    if (n == 0) throw std::runtime_error("Bad argument value");
+    std::map<Integer, unsigned> found;
+    Integer rest = n < 0 ? Integer(-n) : n;
+    for (u64 p : small_primes()) {
+        while (rest % p == 0) {
+            ++found[Integer(p)];
+            rest /= p;
+        }
+    }
+    std::vector<Integer> work;
+    if (rest > 1) work.push_back(rest);
+    while (!work.empty()) {
+        Integer m = std::move(work.back());
+        work.pop_back();
+        if (is_probable_prime(m)) {
+            ++found[m];
+            continue;
+        }
+        Integer f = split(m);
+        work.push_back(m / f);
+        work.push_back(std::move(f));
+    }
+    return {found.begin(), found.end()};
+}
+
+Integer gcd_binary(const Integer& a, const Integer& b) {
+    Integer x = a < 0 ? Integer(-a) : a;
+    Integer y = b < 0 ? Integer(-b) : b;
+    if (fits_u64(x) && fits_u64(y)) return gcd64(x.convert_to<u64>(), y.convert_to<u64>());
+    // cpp_int's own gcd is a limb-level binary GCD
+    return boost::multiprecision::gcd(x, y);
+}
+
+Integer lcm_binary(const Integer& a, const Integer& b) {
+    if (a == 0 || b == 0) return 0;
+    Integer l = a / gcd_binary(a, b) * b;
+    return l < 0 ? Integer(-l) : l;
+}
+
+Integer pow_mod(const Integer& base, const Integer& exp, const Integer& m) {
+    if (m <= 0) throw std::runtime_error("Bad argument value");
+    Integer b = exp < 0 ? inv_mod(base, m) : mod_pos(base, m);
+    Integer e = exp < 0 ? Integer(-exp) : exp;
+    if (fits_u64(m) && fits_u64(e))
+        return powmod64(b.convert_to<u64>(), e.convert_to<u64>(), m.convert_to<u64>());
+    return boost::multiprecision::powm(b, e, m);
+}
+
+Integer inv_mod(const Integer& a, const Integer& m) {
+    if (m <= 0) throw std::runtime_error("Bad argument value");
+    // Extended Euclid, tracking only the coefficient of a
+    Integer r0 = m, r1 = mod_pos(a, m), t0 = 0, t1 = 1;
+    while (r1 != 0) {
+        Integer q = r0 / r1;
+        Integer r2 = r0 - q * r1;
+        Integer t2 = t0 - q * t1;
+        r0 = std::move(r1);
+        r1 = std::move(r2);
+        t0 = std::move(t1);
+        t1 = std::move(t2);
+    }
+    if (r0 != 1) {
+        if (m == 1) return 0;
+        throw std::runtime_error("Bad argument value");
+    }
+    return mod_pos(t0, m);
+}
+
+} // namespace lpr
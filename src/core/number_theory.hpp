@@ -0,0 +1,42 @@
+#pragma once
+
+#include "core/object.hpp"
+#include <utility>
+#include <vector>
+
+namespace lpr {
+
+// Integer number theory. Values that fit in 64 bits take a machine-word
+// path (128-bit products for modular multiplication); larger ones use
+// cpp_int arithmetic.
+
+// Primality. Deterministic below 2^64 (Miller-Rabin with a fixed base set);
+// above, the Baillie-PSW test (strong base-2 Miller-Rabin plus a strong
+// Lucas test), which has no known counterexample.
+bool is_probable_prime(const Integer& n);
+
+// Smallest prime > n; largest prime < n (throws "Bad argument value" when
+// there is none, n <= 2).
+Integer next_prime(const Integer& n);
+Integer prev_prime(const Integer& n);
+
+// Prime factorization of |n| as (prime, exponent) pairs in increasing order;
+// empty for 1. Trial division, then Pollard-Brent rho, then elliptic-curve
+// (ECM stage 1) for composites rho does not split within its budget.
+// Throws for 0, and when a composite resists both (factors much beyond 25
+// digits).
+std::vector<std::pair<Integer, unsigned>> factorize(const Integer& n);
+
+// Non-negative GCD and LCM by binary GCD
+Integer gcd_binary(const Integer& a, const Integer& b);
+Integer lcm_binary(const Integer& a, const Integer& b);
+
+// base^exp mod m in [0, m). A negative exponent uses the inverse of base.
+// Throws "Bad argument value" for m <= 0 or a missing inverse.
+Integer pow_mod(const Integer& base, const Integer& exp, const Integer& m);
+
+// x in [0, m) with a*x = 1 mod m. Throws "Bad argument value" if
+// gcd(a, m) != 1 or m <= 0.
+Integer inv_mod(const Integer& a, const Integer& m);
+
+} // namespace lpr
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "core/object.hpp"
+#include <type_traits>
+#include <utility>
+
+namespace lpr {
+
+// Numeric tower Integer < Rational < Real < Complex, and the type-pair
+// dispatch used by arithmetic and comparison.
+
+template <typename T> inline constexpr int kNumericRank = -1;
+template <> inline constexpr int kNumericRank<Integer> = 0;
+template <> inline constexpr int kNumericRank<Rational> = 1;
+template <> inline constexpr int kNumericRank<Real> = 2;
+template <> inline constexpr int kNumericRank<Complex> = 3;
+
+template <typename A, typename B>
+using CommonNumeric = std::conditional_t<(kNumericRank<A> >= kNumericRank<B>), A, B>;
+
+// v converted up the tower to To, in one step
+template <typename To, typename From>
+To promote_to(const From& v) {
+    static_assert(kNumericRank<From> < kNumericRank<To>, "promote_to only widens");
+    if constexpr (std::is_same_v<To, Complex>) {
+        if constexpr (std::is_same_v<From, Real>) return Complex{v, Real(0)};
+        else return Complex{Real(v), Real(0)};
+    } else {
+        return To(v);
+    }
+}
+
+// op applied to a and b at their common numeric type. Visiting the two
+// variants compiles to a table with one entry per (lhs, rhs) alternative
+// pair. Each entry widens at most one operand and calls
+// op(T&& x, const T& y) with no Object copies in between. a is consumed, so
+// op may build its result in x's storage. Pairs where either side is not
+// numeric return fallback().
+template <typename Op, typename Fallback>
+Object numeric_dispatch(Object&& a, const Object& b, Op&& op, Fallback&& fallback) {
+    return visit_object(
+        [&](auto& x, const auto& y) -> Object {
+            using A = std::decay_t<decltype(x)>;
+            using B = std::decay_t<decltype(y)>;
+            if constexpr (kNumericRank<A> < 0 || kNumericRank<B> < 0) {
+                return fallback();
+            } else if constexpr (std::is_same_v<A, B>) {
+                return op(std::move(x), y);
+            } else if constexpr (kNumericRank<A> > kNumericRank<B>) {
+                return op(std::move(x), promote_to<A>(y));
+            } else {
+                return op(promote_to<B>(x), y);
+            }
+        },
+        a, b);
+}
+
+// ---- Arithmetic kernels for numeric_dispatch ----
+// Integer, Rational and Real update x in place and move it out; Complex
+// follows the usual formulas.
+
+struct NumericAdd {
+    template <typename T>
+    T operator()(T&& x, const T& y) const {
+        if constexpr (std::is_same_v<T, Complex>) {
+            x.first += y.first;
+            x.second += y.second;
+        } else {
+            x += y;
+        }
+        return std::move(x);
+    }
+};
+
+struct NumericSub {
+    template <typename T>
+    T operator()(T&& x, const T& y) const {
+        if constexpr (std::is_same_v<T, Complex>) {
+            x.first -= y.first;
+            x.second -= y.second;
+        } else {
+            x -= y;
+        }
+        return std::move(x);
+    }
+};
+
+struct NumericMul {
+    template <typename T>
+    T operator()(T&& x, const T& y) const {
+        if constexpr (std::is_same_v<T, Complex>) {
+            return {x.first * y.first - x.second * y.second, x.first * y.second + x.second * y.first};
+        } else {
+            x *= y;
+            return std::move(x);
+        }
+    }
+};
+
+// Integer / Integer is an exact Rational. Callers check for a zero divisor.
+struct NumericDiv {
+    Rational operator()(Integer&& x, const Integer& y) const { return Rational(std::move(x), y); }
+
+    template <typename T>
+    T operator()(T&& x, const T& y) const {
+        if constexpr (std::is_same_v<T, Complex>) {
+            Real denom = y.first * y.first + y.second * y.second;
+            return {(x.first * y.first + x.second * y.second) / denom,
+                    (x.second * y.first - x.first * y.second) / denom};
+        } else {
+            x /= y;
+            return std::move(x);
+        }
+    }
+};
+
+// Comparison kernel: Integer 1 or 0 from pred(x, y). Complex values compare
+// by their real parts only.
+template <typename Pred>
+struct NumericCompare {
+    Pred pred;
+
+    template <typename T>
+    Object operator()(T&& x, const T& y) const {
+        if constexpr (std::is_same_v<T, Complex>) return Integer(pred(x.first, y.first) ? 1 : 0);
+        else return Integer(pred(x, y) ? 1 : 0);
+    }
+};
+
+template <typename Pred>
+NumericCompare<std::decay_t<Pred>> numeric_compare(Pred&& pred) {
+    return {std::forward<Pred>(pred)};
+}
+
+} // namespace lpr
@@ -2,12 +2,21 @@
 #include "core/parser.hpp"
 #include <sstream>
 #include <iomanip>
+#include <climits>
 #include <cmath>
+#include <functional>
 
 namespace lpr {
 
 // ---------- formatted number helpers ----------
 
+// cpp_int::str() goes through several temporary buffers even for one limb;
+// nearly every Integer on the stack fits a long long
+static std::string integer_str(const Integer& v) {
+    if (v >= LLONG_MIN && v <= LLONG_MAX) return std::to_string(v.convert_to<long long>());
+    return v.str();
+}
+
 static std::string format_real(const Real& v, const DisplaySettings& ds) {
     if (ds.format == NumberFormat::STD) {
         std::string s = v.str();
@@ -97,10 +106,10 @@ std::string repr(const Object& obj) {
 }
 
 std::string repr(const Object& obj, const DisplaySettings& ds) {
-    return std::visit([&ds](auto&& v) -> std::string {
+    return visit_object([&ds](auto&& v) -> std::string {
         using T = std::decay_t<decltype(v)>;
         if constexpr (std::is_same_v<T, Integer>) {
-            return v.str();
+            return integer_str(v);
         } else if constexpr (std::is_same_v<T, Real>) {
             return format_real(v, ds);
         } else if constexpr (std::is_same_v<T, Rational>) {
@@ -116,12 +125,12 @@ std::string repr(const Object& obj, const DisplaySettings& ds) {
         } else if constexpr (std::is_same_v<T, Error>) {
             return "Error " + std::to_string(v.code) + ": " + v.message;
         } else if constexpr (std::is_same_v<T, Symbol>) {
-            return "'" + v.value + "'";
+            return "'" + v.value() + "'";
         } else if constexpr (std::is_same_v<T, List>) {
             std::string s = "{ ";
             for (size_t i = 0; i < v.items.size(); ++i) {
                 if (i > 0) s += " ";
-                s += repr(Object(v.items[i]), ds);
+                s += repr(v.items[i], ds);
             }
             s += " }";
             return s;
@@ -131,13 +140,13 @@ std::string repr(const Object& obj, const DisplaySettings& ds) {
                 if (r > 0) s += " ][ ";
                 for (size_t c = 0; c < v.rows[r].size(); ++c) {
                     if (c > 0) s += " ";
-                    s += repr(Object(v.rows[r][c]), ds);
+                    s += repr(v.rows[r][c], ds);
                 }
             }
             s += " ]]";
             return s;
         }
-    }, obj.as_variant());
+    }, obj);
 }
 
 static std::string repr_tokens(const std::vector<Token>& tokens) {
@@ -153,6 +162,128 @@ static std::string repr_tokens(const std::vector<Token>& tokens) {
     return result;
 }
 
+// ---------- structural equality / hash ----------
+
+static bool tokens_equal(const std::vector<Token>& a, const std::vector<Token>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].kind != b[i].kind) return false;
+        if (a[i].kind == Token::Command) {
+            if (a[i].command != b[i].command) return false;
+        } else if (!objects_equal(a[i].literal, b[i].literal)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool objects_equal(const Object& a, const Object& b) {
+    if (a.index() != b.index()) return false;
+    return visit_object([&b](auto&& va) -> bool {
+        using T = std::decay_t<decltype(va)>;
+        const auto& vb = get<T>(b);
+        if constexpr (std::is_same_v<T, Integer> || std::is_same_v<T, Real> ||
+                      std::is_same_v<T, Rational>) {
+            return va == vb;
+        } else if constexpr (std::is_same_v<T, Complex>) {
+            return va.first == vb.first && va.second == vb.second;
+        } else if constexpr (std::is_same_v<T, String> || std::is_same_v<T, Name>) {
+            return va.value == vb.value;
+        } else if constexpr (std::is_same_v<T, Symbol>) {
+            return va.value() == vb.value();
+        } else if constexpr (std::is_same_v<T, Error>) {
+            return va.code == vb.code && va.message == vb.message;
+        } else if constexpr (std::is_same_v<T, Program>) {
+            return tokens_equal(va.tokens, vb.tokens);
+        } else if constexpr (std::is_same_v<T, List>) {
+            if (va.items.size() != vb.items.size()) return false;
+            for (size_t i = 0; i < va.items.size(); ++i)
+                if (!objects_equal(va.items[i], vb.items[i])) return false;
+            return true;
+        } else if constexpr (std::is_same_v<T, Matrix>) {
+            if (va.rows.size() != vb.rows.size()) return false;
+            for (size_t r = 0; r < va.rows.size(); ++r) {
+                if (va.rows[r].size() != vb.rows[r].size()) return false;
+                for (size_t c = 0; c < va.rows[r].size(); ++c)
+                    if (!objects_equal(va.rows[r][c], vb.rows[r][c])) return false;
+            }
+            return true;
+        }
+    }, a);
+}
+
+namespace {
+
+size_t hash_combine(size_t seed, size_t v) {
+    return seed ^ (v + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+size_t hash_integer(const Integer& v) {
+    const auto& be = v.backend();
+    size_t h = be.sign() ? 1 : 0;
+    for (unsigned i = 0; i < be.size(); ++i) h = hash_combine(h, static_cast<size_t>(be.limbs()[i]));
+    return h;
+}
+
+// Equal Reals convert to equal doubles, which is all a hash needs; values
+// that only differ past double precision simply share a bucket.
+size_t hash_real(const Real& v) {
+    double d = v.convert_to<double>();
+    if (d == 0) d = 0; // fold -0 into +0
+    return std::hash<double>{}(d);
+}
+
+size_t hash_string(const std::string& s) {
+    return std::hash<std::string>{}(s);
+}
+
+size_t hash_tokens(const std::vector<Token>& tokens) {
+    size_t h = tokens.size();
+    for (const auto& t : tokens) {
+        h = hash_combine(h, t.kind == Token::Command ? hash_string(t.command)
+                                                     : object_hash(t.literal));
+    }
+    return h;
+}
+
+} // anonymous namespace
+
+size_t object_hash(const Object& obj) {
+    size_t h = visit_object([](auto&& v) -> size_t {
+        using T = std::decay_t<decltype(v)>;
+        if constexpr (std::is_same_v<T, Integer>) {
+            return hash_integer(v);
+        } else if constexpr (std::is_same_v<T, Real>) {
+            return hash_real(v);
+        } else if constexpr (std::is_same_v<T, Rational>) {
+            return hash_combine(hash_integer(boost::multiprecision::numerator(v)),
+                                hash_integer(boost::multiprecision::denominator(v)));
+        } else if constexpr (std::is_same_v<T, Complex>) {
+            return hash_combine(hash_real(v.first), hash_real(v.second));
+        } else if constexpr (std::is_same_v<T, String> || std::is_same_v<T, Name>) {
+            return hash_string(v.value);
+        } else if constexpr (std::is_same_v<T, Symbol>) {
+            return hash_string(v.value());
+        } else if constexpr (std::is_same_v<T, Error>) {
+            return hash_combine(static_cast<size_t>(v.code), hash_string(v.message));
+        } else if constexpr (std::is_same_v<T, Program>) {
+            return hash_tokens(v.tokens);
+        } else if constexpr (std::is_same_v<T, List>) {
+            size_t lh = v.items.size();
+            for (const auto& item : v.items) lh = hash_combine(lh, object_hash(item));
+            return lh;
+        } else if constexpr (std::is_same_v<T, Matrix>) {
+            size_t mh = v.rows.size();
+            for (const auto& row : v.rows) {
+                mh = hash_combine(mh, row.size());
+                for (const auto& e : row) mh = hash_combine(mh, object_hash(e));
+            }
+            return mh;
+        }
+    }, obj);
+    return hash_combine(h, obj.index());
+}
+
 // ---------- type_tag ----------
 
 TypeTag type_tag(const Object& obj) {
@@ -164,10 +295,10 @@ TypeTag type_tag(const Object& obj) {
 static std::string serialize_tokens(const std::vector<Token>& tokens);
 
 std::string serialize(const Object& obj) {
-    return std::visit([](auto&& v) -> std::string {
+    return visit_object([](auto&& v) -> std::string {
         using T = std::decay_t<decltype(v)>;
         if constexpr (std::is_same_v<T, Integer>) {
-            return v.str();
+            return integer_str(v);
         } else if constexpr (std::is_same_v<T, Real>) {
             return v.str();
         } else if constexpr (std::is_same_v<T, Rational>) {
@@ -184,14 +315,14 @@ std::string serialize(const Object& obj) {
         } else if constexpr (std::is_same_v<T, Error>) {
             return std::to_string(v.code) + "|" + v.message;
         } else if constexpr (std::is_same_v<T, Symbol>) {
-            return v.value;
+            return v.value();
         } else if constexpr (std::is_same_v<T, List>) {
             // Use repr form — re-parsed on deserialize (handles nesting)
             return repr(Object(v));
         } else if constexpr (std::is_same_v<T, Matrix>) {
             return repr(Object(v));
         }
-    }, obj.as_variant());
+    }, obj);
 }
 
 static std::string serialize_tokens(const std::vector<Token>& tokens) {
@@ -202,7 +333,7 @@ static std::string serialize_tokens(const std::vector<Token>& tokens) {
 
 namespace {
 
-Object deserialize_impl(TypeTag tag, const std::string& data) {
+Object deserialize_impl(TypeTag tag, const std::string& data, ParseCache* cache) {
     switch (tag) {
         case TypeTag::Integer:
             return Integer(data);
@@ -226,7 +357,7 @@ Object deserialize_impl(TypeTag tag, const std::string& data) {
         case TypeTag::Program: {
             Program p;
             if (!data.empty()) {
-                p.tokens = parse(data);
+                p.tokens = cache ? *cache->get(data) : parse(data);
             }
             return p;
         }
@@ -239,14 +370,24 @@ Object deserialize_impl(TypeTag tag, const std::string& data) {
             return Error{code, msg};
         }
         case TypeTag::Symbol:
+            if (cache) {
+                if (auto sym = cache->symbol(data)) return *sym;
+            }
             return Symbol{data};
         case TypeTag::List:
         case TypeTag::Matrix: {
             // Stored as repr form — parse it back
             if (!data.empty()) {
-                auto tokens = parse(data);
-                if (tokens.size() == 1 && tokens[0].kind == Token::Literal) {
-                    return std::move(tokens[0].literal);
+                if (cache) {
+                    auto tokens = cache->get(data);
+                    if (tokens->size() == 1 && (*tokens)[0].kind == Token::Literal) {
+                        return (*tokens)[0].literal;
+                    }
+                } else {
+                    auto tokens = parse(data);
+                    if (tokens.size() == 1 && tokens[0].kind == Token::Literal) {
+                        return std::move(tokens[0].literal);
+                    }
                 }
             }
             if (tag == TypeTag::List) return List{};
@@ -258,8 +399,8 @@ Object deserialize_impl(TypeTag tag, const std::string& data) {
 
 } // anonymous namespace
 
-Object deserialize(TypeTag tag, const std::string& data) {
-    return deserialize_impl(tag, data);
+Object deserialize(TypeTag tag, const std::string& data, ParseCache* cache) {
+    return deserialize_impl(tag, data, cache);
 }
 
 } // namespace lpr
@@ -1,6 +1,10 @@
 #pragma once
 
+#include "core/atom.hpp"
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <type_traits>
 #include <variant>
 #include <vector>
 #include <utility>
@@ -17,7 +21,33 @@ using Complex  = std::pair<Real, Real>;
 
 struct String  { std::string value; };
 struct Name    { std::string value; };
-struct Symbol  { std::string value; };
+struct ExprNode; // core/expr_tree.hpp
+using ExprPtr = std::shared_ptr<const ExprNode>;
+struct CasHandle; // defined by the CAS bridge
+
+// Symbolic expression. Backed by a shared, immutable expression tree and/or
+// the text it was written as; whichever is missing is produced on first use
+// and kept, so copies share both. Source text is preserved verbatim.
+class Symbol {
+public:
+    Symbol();
+    Symbol(std::string text);
+    explicit Symbol(ExprPtr tree);
+    Symbol(ExprPtr tree, std::string text); // text as the tree renders, up to operand layout
+
+    const std::string& value() const; // infix text
+    const ExprPtr& tree() const;      // never null; Opaque leaf if unparsable
+
+    // The CAS bridge's converted form of this expression, or null. Symbols
+    // are immutable, so an attached handle stays valid for every copy.
+    std::shared_ptr<const CasHandle> cas_handle() const;
+    void set_cas_handle(std::shared_ptr<const CasHandle> handle) const;
+
+private:
+    struct Rep;
+    std::shared_ptr<Rep> rep_;
+};
+
 struct Error   { int code; std::string message; };
 
 // Forward declare — Token is used in Program
@@ -46,24 +76,58 @@ enum class TypeTag : int {
     Matrix   = 10,
 };
 
-// Base variant type — exposed so std::visit can be called via cast
+// Value-semantic heap cell for alternatives too large to keep inline in
+// Object. Copies are deep; a moved-from Boxed is empty, and copying it
+// gives another empty Boxed. An empty one may only be copied, assigned to
+// or destroyed. It converts from anything T converts from, so
+// Object(Real(...)) and obj = Complex{...} read as before.
+template <typename T>
+class Boxed {
+public:
+    template <typename U, typename = std::enable_if_t<
+                              std::is_convertible_v<U&&, T> &&
+                              !std::is_same_v<std::decay_t<U>, Boxed>>>
+    Boxed(U&& v) : p_(std::make_unique<T>(std::forward<U>(v))) {}
+    Boxed(const Boxed& o) : p_(o.p_ ? std::make_unique<T>(*o.p_) : nullptr) {}
+    Boxed(Boxed&&) noexcept = default;
+    Boxed& operator=(const Boxed& o) {
+        if (!o.p_) p_.reset();
+        else if (p_) *p_ = *o.p_;
+        else p_ = std::make_unique<T>(*o.p_);
+        return *this;
+    }
+    Boxed& operator=(Boxed&&) noexcept = default;
+
+    T& operator*() { return *p_; }
+    const T& operator*() const { return *p_; }
+
+private:
+    std::unique_ptr<T> p_;
+};
+
+// Object layout. Integer (cpp_int) stays inline: values up to 128 bits live
+// in its own small buffer. Strings, names, symbols and containers are a
+// pointer plus length or a shared handle. Real, Rational, Complex, Program
+// and Error are boxed, which keeps Object at 48 bytes instead of the 128 a
+// Complex needs inline.
 using ObjectBase = std::variant<
-    Integer,   // 0
-    Real,      // 1
-    Rational,  // 2
-    Complex,   // 3
-    String,    // 4
-    Program,   // 5
-    Name,      // 6
-    Error,     // 7
-    Symbol,    // 8
-    List,      // 9
-    Matrix     // 10
+    Integer,           // 0
+    Boxed<Real>,       // 1
+    Boxed<Rational>,   // 2
+    Boxed<Complex>,    // 3
+    String,            // 4
+    Boxed<Program>,    // 5
+    Name,              // 6
+    Boxed<Error>,      // 7
+    Symbol,            // 8
+    List,              // 9
+    Matrix             // 10
 >;
 
-// Object inherits from variant so it can be forward-declared for List/Matrix
-// while keeping std::holds_alternative, std::get working directly.
-// Use as_variant() for std::visit calls.
+// Object inherits from variant so it can be forward-declared for List/Matrix.
+// Access alternatives by their value type through lpr::holds_alternative,
+// lpr::get and lpr::get_if below, which look through the boxes; visit with
+// visit_object. as_variant() exposes the raw storage.
 struct Object : ObjectBase {
     using ObjectBase::ObjectBase;
     using ObjectBase::operator=;
@@ -71,12 +135,64 @@ struct Object : ObjectBase {
     ObjectBase& as_variant() { return *this; }
 };
 
+// The variant alternative that stores a T
+template <typename T> struct ObjectStorage { using type = T; };
+template <> struct ObjectStorage<Real> { using type = Boxed<Real>; };
+template <> struct ObjectStorage<Rational> { using type = Boxed<Rational>; };
+template <> struct ObjectStorage<Complex> { using type = Boxed<Complex>; };
+template <> struct ObjectStorage<Program> { using type = Boxed<Program>; };
+template <> struct ObjectStorage<Error> { using type = Boxed<Error>; };
+template <typename T> using object_storage_t = typename ObjectStorage<T>::type;
+
+template <typename T> T& unbox(T& v) { return v; }
+template <typename T> const T& unbox(const T& v) { return v; }
+template <typename T> T& unbox(Boxed<T>& v) { return *v; }
+template <typename T> const T& unbox(const Boxed<T>& v) { return *v; }
+
+template <typename T>
+bool holds_alternative(const Object& obj) noexcept {
+    return std::holds_alternative<object_storage_t<T>>(obj.as_variant());
+}
+
+// Throw std::bad_variant_access when obj holds another type
+template <typename T>
+T& get(Object& obj) {
+    return unbox(std::get<object_storage_t<T>>(obj.as_variant()));
+}
+template <typename T>
+const T& get(const Object& obj) {
+    return unbox(std::get<object_storage_t<T>>(obj.as_variant()));
+}
+
+template <typename T>
+T* get_if(Object* obj) noexcept {
+    auto* v = obj ? std::get_if<object_storage_t<T>>(&obj->as_variant()) : nullptr;
+    return v ? &unbox(*v) : nullptr;
+}
+template <typename T>
+const T* get_if(const Object* obj) noexcept {
+    auto* v = obj ? std::get_if<object_storage_t<T>>(&obj->as_variant()) : nullptr;
+    return v ? &unbox(*v) : nullptr;
+}
+
+// std::visit over one or more Objects, with boxed alternatives passed to f
+// as their value type
+template <typename F, typename... Objs>
+decltype(auto) visit_object(F&& f, Objs&&... objs) {
+    return std::visit([&f](auto&... v) -> decltype(auto) { return f(unbox(v)...); },
+                      objs.as_variant()...);
+}
+
 // Token: either a literal to push, or a command name to execute
 struct Token {
     enum Kind { Literal, Command };
     Kind kind;
+    // Set on the first token of a run the interpreter can execute as one
+    // fused operation: 1 + the rule's index in fusion_rules(), else 0.
+    // Not part of the token's value (equality, hashing, text).
+    uint8_t fusion = 0;
     Object literal;       // used when kind == Literal
-    std::string command;  // used when kind == Command
+    Atom command;         // used when kind == Command
 
     static Token make_literal(Object obj) {
         Token t;
@@ -84,16 +200,37 @@ struct Token {
         t.literal = std::move(obj);
         return t;
     }
-    static Token make_command(std::string cmd) {
+    static Token make_command(Atom cmd) {
         Token t;
         t.kind = Command;
         t.command = std::move(cmd);
         return t;
     }
+    static Token make_command(std::string_view cmd) { return make_command(Atom(cmd)); }
 private:
     Token() : kind(Command) {}
 };
 
+// A run of tokens inside a token vector that outlives it, e.g. the body of
+// a loop inside a program. Converts from the whole vector.
+class TokenSpan {
+public:
+    TokenSpan() = default;
+    TokenSpan(const Token* first, size_t size) : first_(first), size_(size) {}
+    TokenSpan(const std::vector<Token>& tokens) : first_(tokens.data()), size_(tokens.size()) {}
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const Token& operator[](size_t i) const { return first_[i]; }
+    const Token* begin() const { return first_; }
+    const Token* end() const { return first_ + size_; }
+    TokenSpan subspan(size_t offset, size_t count) const { return {first_ + offset, count}; }
+
+private:
+    const Token* first_ = nullptr;
+    size_t size_ = 0;
+};
+
 // Display settings
 enum class NumberFormat { STD, FIX, SCI, ENG };
 enum class CoordinateMode { RECT, POLAR, SPHERICAL };
@@ -109,9 +246,24 @@ struct DisplaySettings {
 std::string repr(const Object& obj);
 std::string repr(const Object& obj, const DisplaySettings& settings);
 
-// Serialization
+// Structural equality and hashing: same type and same value, recursing into
+// lists, matrices and programs. No rendering; Integer 1 and Real 1. differ.
+bool   objects_equal(const Object& a, const Object& b);
+size_t object_hash(const Object& obj);
+
+struct ObjectHash {
+    size_t operator()(const Object& obj) const { return object_hash(obj); }
+};
+struct ObjectEqual {
+    bool operator()(const Object& a, const Object& b) const { return objects_equal(a, b); }
+};
+
+class ParseCache;
+
+// Serialization. Program, List and Matrix text is parsed back through cache
+// when one is given.
 TypeTag     type_tag(const Object& obj);
 std::string serialize(const Object& obj);
-Object      deserialize(TypeTag tag, const std::string& data);
+Object      deserialize(TypeTag tag, const std::string& data, ParseCache* cache = nullptr);
 
 } // namespace lpr
@@ -0,0 +1,326 @@
+#include "core/optimizer.hpp"
+#include "core/context.hpp"
+#include "core/fusion.hpp"
+#include "core/parser.hpp"
+#include <cctype>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+
+namespace lpr {
+
+namespace {
+
+// Commands whose result depends only on their numeric arguments. The
+// transcendental functions read PREC and the angle mode, and display, flag
+// and variable commands read or change state, so none of them is listed.
+struct PureCommand {
+    const char* name;
+    int arity;
+};
+
+const PureCommand kPureCommands[] = {
+    {"PI", 0},    {"E", 0},
+    {"NEG", 1},   {"ABS", 1},  {"INV", 1},  {"SQ", 1},  {"SQRT", 1},
+    {"FLOOR", 1}, {"CEIL", 1}, {"IP", 1},   {"FP", 1},
+    {"+", 2},     {"-", 2},    {"*", 2},    {"/", 2},   {"^", 2},
+    {"MOD", 2},   {"MIN", 2},  {"MAX", 2},
+    {"==", 2},    {"!=", 2},   {"<", 2},    {">", 2},   {"<=", 2}, {">=", 2},
+};
+
+bool is_keyword(const Token& t, const char* kw) {
+    if (t.kind != Token::Command) return false;
+    const std::string& cmd = t.command;
+    size_t n = 0;
+    for (; kw[n]; ++n) {
+        if (n >= cmd.size() || std::toupper(static_cast<unsigned char>(cmd[n])) != kw[n]) return false;
+    }
+    return n == cmd.size();
+}
+
+bool is_arrow(const Token& t) {
+    return t.kind == Token::Command &&
+           (t.command == std::string_view("->") || t.command == std::string_view("\xe2\x86\x92"));
+}
+
+const PureCommand* find_pure(const Token& t) {
+    for (const PureCommand& p : kPureCommands) {
+        if (is_keyword(t, p.name)) return &p;
+    }
+    return nullptr;
+}
+
+bool is_number(const Object& obj) {
+    return holds_alternative<Integer>(obj) || holds_alternative<Real>(obj) ||
+           holds_alternative<Rational>(obj) || holds_alternative<Complex>(obj);
+}
+
+// The branch IF or WHILE takes for a constant condition; nullopt where the
+// interpreter would raise an error instead
+std::optional<bool> truth_of(const Object& obj) {
+    if (holds_alternative<Integer>(obj)) return get<Integer>(obj) != 0;
+    if (holds_alternative<Real>(obj)) return get<Real>(obj) != 0;
+    return std::nullopt;
+}
+
+// Stored programs are saved as text, so a folded value must read back as
+// itself
+bool survives_text(const Object& obj) {
+    auto tokens = parse(repr(obj));
+    return tokens.size() == 1 && tokens[0].kind == Token::Literal &&
+           objects_equal(tokens[0].literal, obj);
+}
+
+// Index of the first of `stops` at nesting depth 0 in tokens[from..], or
+// tokens.size() if there is none. Nesting follows the interpreter: FOR and
+// START close with NEXT or STEP, the other structures with END.
+size_t find_closer(TokenSpan tokens, size_t from, std::initializer_list<const char*> stops) {
+    std::vector<char> nest;
+    for (size_t i = from; i < tokens.size(); ++i) {
+        const Token& t = tokens[i];
+        if (t.kind != Token::Command) continue;
+        if (nest.empty()) {
+            for (const char* kw : stops) {
+                if (is_keyword(t, kw)) return i;
+            }
+        }
+        if (is_keyword(t, "IF") || is_keyword(t, "CASE") || is_keyword(t, "WHILE") ||
+            is_keyword(t, "DO")) {
+            nest.push_back('E');
+        } else if (is_keyword(t, "FOR") || is_keyword(t, "START")) {
+            nest.push_back('N');
+        } else if (!nest.empty()) {
+            if (nest.back() == 'E' && is_keyword(t, "END")) {
+                nest.pop_back();
+            } else if (nest.back() == 'N' && (is_keyword(t, "NEXT") || is_keyword(t, "STEP"))) {
+                nest.pop_back();
+            }
+        }
+    }
+    return tokens.size();
+}
+
+class Optimizer {
+public:
+    explicit Optimizer(Context& ctx) : ctx_(ctx) {}
+
+    std::vector<Token> run(TokenSpan tokens) {
+        std::vector<Token> out;
+        Tail tail;
+        emit(tokens, out, tail);
+        remark(out);
+        return out;
+    }
+
+private:
+    // What is statically known about the end of `out` in the current
+    // straight-line stretch: how many trailing tokens are numeric literals,
+    // and how many are literals of any type (values surely on the stack)
+    struct Tail {
+        size_t numbers = 0;
+        size_t values = 0;
+    };
+
+    void emit(TokenSpan tokens, std::vector<Token>& out, Tail& tail) {
+        for (size_t i = 0; i < tokens.size(); ++i) {
+            const Token& t = tokens[i];
+            if (t.kind == Token::Literal) {
+                out.push_back(t);
+                tail.numbers = is_number(t.literal) ? tail.numbers + 1 : 0;
+                ++tail.values;
+            } else if (is_arrow(t)) {
+                i = emit_arrow(tokens, i, out, tail);
+            } else if (is_keyword(t, "IF")) {
+                i = emit_if(tokens, i, out, tail);
+            } else if (is_keyword(t, "WHILE")) {
+                i = emit_while(tokens, i, out, tail);
+            } else if (is_keyword(t, "FOR")) {
+                // FOR and its loop variable
+                out.push_back(t);
+                if (i + 1 < tokens.size()) out.push_back(tokens[++i]);
+                tail = {};
+            } else if (const PureCommand* pure = find_pure(t); pure && fold(*pure, out, tail)) {
+                continue;
+            } else {
+                out.push_back(t);
+                tail = {};
+            }
+        }
+    }
+
+    // Replaces the trailing literals with the command's result. False, with
+    // nothing changed, if they are not all numbers or the command fails.
+    bool fold(const PureCommand& pure, std::vector<Token>& out, Tail& tail) {
+        size_t arity = static_cast<size_t>(pure.arity);
+        if (tail.numbers < arity) return false;
+        Store& s = scratch();
+        s.clear_stack();
+        for (size_t k = out.size() - arity; k < out.size(); ++k) s.push(out[k].literal);
+        try {
+            ctx_.commands().execute(pure.name, s, ctx_);
+        } catch (const std::exception&) {
+            return false; // left for run time, which raises the same error
+        }
+        if (s.depth() != 1) return false;
+        Object result = s.pop();
+        if (!is_number(result) || !survives_text(result)) return false;
+        out.erase(out.end() - static_cast<std::ptrdiff_t>(arity), out.end());
+        out.push_back(Token::make_literal(std::move(result)));
+        tail.numbers = tail.numbers - arity + 1;
+        tail.values = tail.values - arity + 1;
+        return true;
+    }
+
+    // IF cond THEN a [ELSE b] END. A condition that is one constant, or a
+    // constant already on the stack before an empty condition, selects the
+    // branch now. Returns the index of the END.
+    size_t emit_if(TokenSpan tokens, size_t i, std::vector<Token>& out, Tail& tail) {
+        size_t then_at = find_closer(tokens, i + 1, {"THEN"});
+        size_t else_at = find_closer(tokens, then_at + 1, {"ELSE", "END"});
+        size_t end_at = else_at;
+        if (else_at < tokens.size() && is_keyword(tokens[else_at], "ELSE")) {
+            end_at = find_closer(tokens, else_at + 1, {"END"});
+        }
+        if (then_at >= tokens.size() || end_at >= tokens.size()) {
+            return copy_rest(tokens, i, out, tail); // malformed: run time reports it
+        }
+        TokenSpan cond = tokens.subspan(i + 1, then_at - i - 1);
+        TokenSpan then_body = tokens.subspan(then_at + 1, else_at - then_at - 1);
+        TokenSpan else_body;
+        if (else_at != end_at) else_body = tokens.subspan(else_at + 1, end_at - else_at - 1);
+
+        std::vector<Token> cond_out = run_block(cond);
+        std::optional<bool> taken;
+        if (cond_out.size() == 1 && cond_out[0].kind == Token::Literal) {
+            taken = truth_of(cond_out[0].literal);
+        } else if (cond_out.empty() && tail.values > 0 && out.back().kind == Token::Literal) {
+            taken = truth_of(out.back().literal);
+            if (taken) {
+                out.pop_back();
+                tail.numbers = tail.numbers ? tail.numbers - 1 : 0;
+                --tail.values;
+            }
+        }
+        if (taken) {
+            emit(*taken ? then_body : else_body, out, tail);
+            return end_at;
+        }
+
+        out.push_back(tokens[i]);
+        append(out, cond_out);
+        out.push_back(tokens[then_at]);
+        append(out, run_block(then_body));
+        if (else_at != end_at) {
+            out.push_back(tokens[else_at]);
+            append(out, run_block(else_body));
+        }
+        out.push_back(tokens[end_at]);
+        tail = {};
+        return end_at;
+    }
+
+    // WHILE cond REPEAT body END. A constant false condition removes the
+    // loop. Returns the index of the END.
+    size_t emit_while(TokenSpan tokens, size_t i, std::vector<Token>& out, Tail& tail) {
+        size_t repeat_at = find_closer(tokens, i + 1, {"REPEAT"});
+        size_t end_at = find_closer(tokens, repeat_at + 1, {"END"});
+        if (repeat_at >= tokens.size() || end_at >= tokens.size()) {
+            return copy_rest(tokens, i, out, tail);
+        }
+        std::vector<Token> cond_out = run_block(tokens.subspan(i + 1, repeat_at - i - 1));
+        if (cond_out.size() == 1 && cond_out[0].kind == Token::Literal &&
+            truth_of(cond_out[0].literal) == false) {
+            return end_at;
+        }
+        out.push_back(tokens[i]);
+        append(out, cond_out);
+        out.push_back(tokens[repeat_at]);
+        append(out, run_block(tokens.subspan(repeat_at + 1, end_at - repeat_at - 1)));
+        out.push_back(tokens[end_at]);
+        tail = {};
+        return end_at;
+    }
+
+    // -> names body. The body is optimized on its own. An identity frame
+    // (-> a b « a b ») is dropped when its values are known to be on the
+    // stack; otherwise it stays for the "Too few arguments" check. Returns
+    // the index of the body.
+    size_t emit_arrow(TokenSpan tokens, size_t i, std::vector<Token>& out, Tail& tail) {
+        size_t body_at = i + 1;
+        while (body_at < tokens.size() && tokens[body_at].kind == Token::Command) ++body_at;
+        if (body_at >= tokens.size()) return copy_rest(tokens, i, out, tail);
+        size_t names = body_at - i - 1;
+        const Token& body = tokens[body_at];
+
+        if (!holds_alternative<Program>(body.literal)) {
+            for (size_t k = i; k <= body_at; ++k) out.push_back(tokens[k]);
+            tail = {};
+            return body_at;
+        }
+        std::vector<Token> body_out = run_block(get<Program>(body.literal).tokens);
+
+        if (names > 0 && tail.values >= names && is_identity(tokens.subspan(i + 1, names), body_out)) {
+            return body_at;
+        }
+        for (size_t k = i; k < body_at; ++k) out.push_back(tokens[k]);
+        remark(body_out);
+        out.push_back(Token::make_literal(Program{std::move(body_out)}));
+        tail = {};
+        return body_at;
+    }
+
+    // The body pushes exactly the frame's locals in binding order. A name
+    // that is also a command runs the command, not the local.
+    bool is_identity(TokenSpan names, const std::vector<Token>& body) const {
+        if (body.size() != names.size()) return false;
+        for (size_t k = 0; k < names.size(); ++k) {
+            if (body[k].kind != Token::Command || body[k].command != names[k].command) return false;
+            if (ctx_.commands().has(names[k].command)) return false;
+        }
+        return true;
+    }
+
+    std::vector<Token> run_block(TokenSpan tokens) {
+        std::vector<Token> out;
+        Tail tail;
+        emit(tokens, out, tail);
+        return out;
+    }
+
+    size_t copy_rest(TokenSpan tokens, size_t i, std::vector<Token>& out, Tail& tail) {
+        for (size_t k = i; k < tokens.size(); ++k) out.push_back(tokens[k]);
+        tail = {};
+        return tokens.size() - 1;
+    }
+
+    // Folding and splicing change which tokens are adjacent
+    static void remark(std::vector<Token>& tokens) {
+        for (Token& t : tokens) t.fusion = 0;
+        mark_fusions(tokens);
+    }
+
+    static void append(std::vector<Token>& out, const std::vector<Token>& more) {
+        out.insert(out.end(), more.begin(), more.end());
+    }
+
+    Store& scratch() {
+        if (!scratch_) scratch_ = std::make_unique<Store>(nullptr);
+        return *scratch_;
+    }
+
+    Context& ctx_;
+    std::unique_ptr<Store> scratch_;  // made on the first fold
+};
+
+} // anonymous namespace
+
+std::vector<Token> optimize_tokens(const std::vector<Token>& tokens, Context& ctx) {
+    return Optimizer(ctx).run(tokens);
+}
+
+bool optimizer_enabled(Store& store) {
+    auto flag = store.get_flag(kOptimizeFlag);
+    return flag && std::get<1>(*flag) == "1";
+}
+
+} // namespace lpr
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "core/object.hpp"
+#include <vector>
+
+namespace lpr {
+
+class Context;
+class Store;
+
+// Ahead-of-time simplification of stored programs, run by STO when the
+// `optimize` flag is set. Every rewrite keeps the program's results,
+// including its errors:
+//
+// - Runs of numeric literals followed by pure commands (arithmetic,
+//   comparison, PI, E, ...) are folded into the literal they produce, by
+//   running the command itself on a scratch stack. Commands that read a
+//   mode, the working precision, flags or variables are never folded.
+// - IF and WHILE whose condition folds to a constant lose the dead branch.
+// - Identity frames such as -> x « x » are dropped where the values they
+//   bind are known to be on the stack, and -> bodies are optimized too.
+//
+// Nested programs that are only pushed as data are left as written.
+std::vector<Token> optimize_tokens(const std::vector<Token>& tokens, Context& ctx);
+
+// Name of the boolean flag that turns optimization on for STO
+inline constexpr const char* kOptimizeFlag = "optimize";
+
+bool optimizer_enabled(Store& store);
+
+} // namespace lpr
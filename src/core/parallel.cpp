@@ -0,0 +1,249 @@
+#include "core/parallel.hpp"
+#include "core/context.hpp"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_set>
+
+namespace lpr {
+
+static std::string to_upper(const std::string& s) {
+    std::string u = s;
+    std::transform(u.begin(), u.end(), u.begin(),
+        [](unsigned char c) { return std::toupper(c); });
+    return u;
+}
+
+// ---- Work-stealing loop ----
+
+namespace {
+
+struct Slice {
+    std::mutex mtx;
+    size_t next = 0;
+    size_t end = 0;
+};
+
+// Claim the next index from the worker's own slice.
+bool take_own(Slice& own, size_t& index) {
+    std::lock_guard<std::mutex> lock(own.mtx);
+    if (own.next >= own.end) return false;
+    index = own.next++;
+    return true;
+}
+
+// Move the back half of the fullest other slice into `own`.
+bool steal(std::vector<Slice>& slices, size_t self) {
+    for (;;) {
+        size_t victim = slices.size();
+        size_t most = 0;
+        for (size_t v = 0; v < slices.size(); ++v) {
+            if (v == self) continue;
+            std::lock_guard<std::mutex> lock(slices[v].mtx);
+            size_t left = slices[v].end - slices[v].next;
+            if (left > most) { most = left; victim = v; }
+        }
+        if (victim == slices.size()) return false;
+
+        size_t lo, hi;
+        {
+            std::lock_guard<std::mutex> lock(slices[victim].mtx);
+            size_t left = slices[victim].end - slices[victim].next;
+            if (left == 0) continue; // drained meanwhile; look again
+            hi = slices[victim].end;
+            lo = hi - (left + 1) / 2;
+            slices[victim].end = lo;
+        }
+        std::lock_guard<std::mutex> lock(slices[self].mtx);
+        slices[self].next = lo;
+        slices[self].end = hi;
+        return true;
+    }
+}
+
+} // namespace
+
+void parallel_for(size_t count, size_t workers,
+                  const std::function<void(size_t worker, size_t index)>& body) {
+    if (count == 0) return;
+    workers = std::max<size_t>(1, std::min(workers, count));
+    if (workers == 1) {
+        for (size_t i = 0; i < count; ++i) body(0, i);
+        return;
+    }
+
+    std::vector<Slice> slices(workers);
+    for (size_t w = 0; w < workers; ++w) {
+        slices[w].next = count * w / workers;
+        slices[w].end = count * (w + 1) / workers;
+    }
+
+    auto run = [&](size_t w) {
+        size_t index;
+        for (;;) {
+            if (!take_own(slices[w], index)) {
+                if (!steal(slices, w)) return;
+                continue;
+            }
+            body(w, index);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers);
+    for (size_t w = 0; w < workers; ++w) threads.emplace_back(run, w);
+    for (auto& t : threads) t.join();
+}
+
+size_t parallel_worker_count(Context& ctx) {
+    std::string setting = ctx.store().get_meta("parallel_workers", "0");
+    long n = 0;
+    try { n = std::stol(setting); } catch (...) { n = 0; }
+    if (n > 0) return static_cast<size_t>(n);
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw == 0 ? 1 : hw;
+}
+
+// ---- Purity check ----
+
+namespace {
+
+// Commands whose effect depends on or changes state a worker context does
+// not share with the caller.
+const std::unordered_set<std::string>& unsafe_commands() {
+    static const std::unordered_set<std::string> cmds = {
+        // Variables and directories
+        "STO", "RCL", "PURGE", "HOME", "PATH", "CRDIR", "CD", "UPDIR",
+        "PGDIR", "VARS",
+        // Evaluation that may recall global variables
+        "EVAL", "STR->", "STR\xe2\x86\x92", "->NUM", "\xe2\x86\x92NUM", "TABULATE",
+        "PLOTDATA",
+        // Modes and flags
+        "DEG", "RAD", "GRAD", "STD", "FIX", "SCI", "ENG", "RECT", "POLAR",
+        "SPHERICAL", "SF", "CF", "SFLAG", "STOF", "PWORKERS", "CASCACHE",
+        "CASLIMIT", "PREC", "CALLMEM",
+        // Whole-stack and stash access
+        "DEPTH", "CLEAR", "STASH", "STASHN", "UNSTASH", "ASSEMBLE",
+        // Symbolic algebra: each session runs SymEngine from one thread at a
+        // time (apart from calls abandoned after a timeout), and P* workers
+        // would each start their own
+        "DIFF", "INTEGRATE", "SOLVE", "SIMPLIFY", "EXPAND", "FACTOR", "SUBST",
+        "JACOBIAN", "GRADIENT",
+    };
+    return cmds;
+}
+
+bool is_control_keyword(const std::string& cmd) {
+    return cmd == "IF" || cmd == "THEN" || cmd == "ELSE" || cmd == "END" ||
+           cmd == "CASE" || cmd == "FOR" || cmd == "NEXT" || cmd == "STEP" ||
+           cmd == "START" || cmd == "WHILE" || cmd == "REPEAT" ||
+           cmd == "DO" || cmd == "UNTIL";
+}
+
+bool scan_tokens(const std::vector<Token>& tokens, Context& ctx,
+                 std::unordered_set<std::string>& bound) {
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        const auto& tok = tokens[i];
+        if (tok.kind == Token::Literal) {
+            if (holds_alternative<Program>(tok.literal) &&
+                !scan_tokens(get<Program>(tok.literal).tokens, ctx, bound))
+                return false;
+            continue;
+        }
+        if (tok.command == "->" || tok.command == "\xe2\x86\x92") {
+            while (i + 1 < tokens.size() && tokens[i + 1].kind == Token::Command)
+                bound.insert(tokens[++i].command);
+            continue;
+        }
+        std::string cmd = to_upper(tok.command);
+        if (cmd == "FOR") {
+            if (i + 1 < tokens.size() && tokens[i + 1].kind == Token::Command)
+                bound.insert(tokens[++i].command);
+            continue;
+        }
+        if (is_control_keyword(cmd)) continue;
+        if (unsafe_commands().count(cmd)) return false;
+        if (ctx.commands().has(cmd)) continue;
+        if (bound.count(tok.command) || ctx.resolve_local(tok.command)) continue;
+        return false; // global variable or unknown name
+    }
+    return true;
+}
+
+// Settings that change what a command computes or how ->STR formats, and
+// the CASLIMIT budget.
+const char* const kCopiedMeta[] = {
+    "angle_mode", "number_format", "format_digits", "coordinate_mode", "precision",
+    "cas_timeout_ms", "cas_max_nodes",
+};
+
+} // namespace
+
+bool is_parallel_safe(const std::vector<Token>& tokens, Context& ctx) {
+    std::unordered_set<std::string> bound;
+    return scan_tokens(tokens, ctx, bound);
+}
+
+// ---- Parallel evaluation ----
+
+std::optional<std::vector<Object>> parallel_eval(
+    Context& ctx, const Program& prog,
+    const std::vector<std::vector<Object>>& arg_groups) {
+    size_t workers = std::min(parallel_worker_count(ctx), arg_groups.size());
+    // Spinning up worker contexts is not free; below two items per worker
+    // the serial path wins.
+    if (workers < 2 || arg_groups.size() < 2 * workers) return std::nullopt;
+    if (!is_parallel_safe(prog.tokens, ctx)) return std::nullopt;
+
+    // Snapshot the caller's state on this thread; workers only read copies.
+    std::vector<std::pair<std::string, std::string>> meta;
+    for (const char* key : kCopiedMeta) {
+        std::string val = ctx.store().get_meta(key);
+        if (!val.empty()) meta.emplace_back(key, val);
+    }
+    auto flags = ctx.store().all_flags();
+    const auto& scopes = ctx.local_scopes();
+
+    std::vector<std::unique_ptr<Context>> contexts(workers);
+    std::vector<Object> results(arg_groups.size());
+    std::atomic<bool> failed{false};
+
+    parallel_for(arg_groups.size(), workers, [&](size_t w, size_t index) {
+        if (failed.load(std::memory_order_relaxed)) return;
+        try {
+            if (!contexts[w]) {
+                auto wctx = std::make_unique<Context>(nullptr);
+                Store& ws = wctx->store();
+                ws.begin();
+                for (const auto& [key, val] : meta) ws.set_meta(key, val);
+                for (const auto& [name, tag, val] : flags) ws.set_flag(name, tag, val);
+                ws.set_meta("parallel_workers", "1"); // no nested fan-out
+                for (const auto& frame : scopes) wctx->push_locals(frame);
+                contexts[w] = std::move(wctx);
+            }
+            Context& wctx = *contexts[w];
+            Store& ws = wctx.store();
+            for (const auto& arg : arg_groups[index]) ws.push(arg);
+            wctx.execute_tokens(prog.tokens);
+            if (ws.depth() != 1) {
+                failed = true;
+                return;
+            }
+            results[index] = ws.pop();
+        } catch (...) {
+            failed = true;
+        }
+    });
+
+    for (auto& wctx : contexts) {
+        if (wctx) wctx->store().rollback();
+    }
+    if (failed) return std::nullopt;
+    return results;
+}
+
+} // namespace lpr
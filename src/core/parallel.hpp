@@ -0,0 +1,69 @@
+#pragma once
+
+#include "core/object.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace lpr {
+
+class Context; // forward
+
+// Run body(worker, index) for every index in [0, count) on `workers` threads.
+// Each worker starts on a contiguous slice of the range; once its slice runs
+// dry it steals the back half of the largest remaining slice.
+void parallel_for(size_t count, size_t workers,
+                  const std::function<void(size_t worker, size_t index)>& body);
+
+// Stable merge sort: sorts `workers` chunks concurrently, then merges them
+// pairwise in parallel rounds. Small inputs use std::stable_sort directly.
+template <typename T, typename Compare>
+void parallel_stable_sort(std::vector<T>& v, Compare comp, size_t workers) {
+    constexpr size_t kMinParallel = size_t(1) << 15;
+    size_t n = v.size();
+    if (workers < 2 || n < kMinParallel) {
+        std::stable_sort(v.begin(), v.end(), comp);
+        return;
+    }
+    size_t chunks = std::min(workers, n / (kMinParallel / 4));
+    std::vector<size_t> bounds(chunks + 1);
+    for (size_t c = 0; c <= chunks; ++c) bounds[c] = n * c / chunks;
+
+    parallel_for(chunks, workers, [&](size_t, size_t c) {
+        std::stable_sort(v.begin() + bounds[c], v.begin() + bounds[c + 1], comp);
+    });
+    for (size_t width = 1; width < chunks; width *= 2) {
+        size_t pairs = (chunks + 2 * width - 1) / (2 * width);
+        parallel_for(pairs, workers, [&](size_t, size_t p) {
+            size_t lo = p * 2 * width;
+            size_t mid = std::min(lo + width, chunks);
+            size_t hi = std::min(lo + 2 * width, chunks);
+            if (mid < hi) {
+                std::inplace_merge(v.begin() + bounds[lo], v.begin() + bounds[mid],
+                                   v.begin() + bounds[hi], comp);
+            }
+        });
+    }
+}
+
+// Worker threads for the P* list commands: the "parallel_workers" meta
+// setting (PWORKERS), or the hardware concurrency when unset or 0.
+size_t parallel_worker_count(Context& ctx);
+
+// True if a program gives the same result on an isolated worker context as
+// on the shared stack: it must not touch variables, directories, modes, flags
+// or the stash, must not inspect the whole stack, and every bare name must be
+// a command or a local binding.
+bool is_parallel_safe(const std::vector<Token>& tokens, Context& ctx);
+
+// Evaluate `prog` once per argument group on per-worker in-memory contexts,
+// returning results in input order. Every run must leave exactly one object.
+// Returns std::nullopt when the caller should run serially instead: unsafe
+// program, one worker, too little work, or any error on a worker.
+std::optional<std::vector<Object>> parallel_eval(
+    Context& ctx, const Program& prog,
+    const std::vector<std::vector<Object>>& arg_groups);
+
+} // namespace lpr
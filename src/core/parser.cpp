@@ -1,5 +1,7 @@
 #include "core/parser.hpp"
+#include "core/fusion.hpp"
 #include <cctype>
+#include <optional>
 
 namespace lpr {
 
@@ -8,7 +10,7 @@ namespace {
 bool is_whitespace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
 
 // Check if string looks like an integer: optional '-' followed by digits
-bool is_integer(const std::string& s) {
+bool is_integer(std::string_view s) {
     if (s.empty()) return false;
     size_t start = (s[0] == '-') ? 1 : 0;
     if (start >= s.size()) return false;
@@ -19,7 +21,7 @@ bool is_integer(const std::string& s) {
 }
 
 // Check if string looks like a real: digits with '.' and/or 'E'/'e'
-bool is_real(const std::string& s) {
+bool is_real(std::string_view s) {
     if (s.empty()) return false;
     bool has_dot = false;
     bool has_e = false;
@@ -45,319 +47,532 @@ bool is_real(const std::string& s) {
     return has_digit && (has_dot || has_e);
 }
 
+// Word already checked by is_integer. Up to 18 digits cannot overflow a
+// long long, which skips cpp_int's string constructor for nearly every literal.
+Integer make_integer(std::string_view word) {
+    bool neg = word[0] == '-';
+    if (word.size() - neg > 18) return Integer(std::string(word));
+    long long v = 0;
+    for (size_t i = neg; i < word.size(); ++i) v = v * 10 + (word[i] - '0');
+    return Integer(neg ? -v : v);
+}
+
+// A rational as repr writes it: an integer, '/', and a nonzero unsigned
+// integer ("-11/2"). Lists holding Rationals read back through this.
+bool is_rational(std::string_view s) {
+    size_t slash = s.find('/');
+    if (slash == std::string_view::npos) return false;
+    std::string_view den = s.substr(slash + 1);
+    if (!is_integer(s.substr(0, slash)) || !is_integer(den) || den[0] == '-') return false;
+    return den.find_first_not_of('0') != std::string_view::npos;
+}
+
+// Word already checked by is_rational; a whole value is an Integer
+Object make_rational(std::string_view word) {
+    size_t slash = word.find('/');
+    Rational r(make_integer(word.substr(0, slash)), make_integer(word.substr(slash + 1)));
+    if (boost::multiprecision::denominator(r) == 1) return Integer(boost::multiprecision::numerator(r));
+    return r;
+}
+
 // UTF-8 helpers for « (0xC2 0xAB) and » (0xC2 0xBB)
-bool starts_with_laquo(const std::string& s, size_t pos) {
+bool starts_with_laquo(std::string_view s, size_t pos) {
     return pos + 1 < s.size() &&
            static_cast<unsigned char>(s[pos]) == 0xC2 &&
            static_cast<unsigned char>(s[pos+1]) == 0xAB;
 }
 
-bool starts_with_raquo(const std::string& s, size_t pos) {
+bool starts_with_raquo(std::string_view s, size_t pos) {
     return pos + 1 < s.size() &&
            static_cast<unsigned char>(s[pos]) == 0xC2 &&
            static_cast<unsigned char>(s[pos+1]) == 0xBB;
 }
 
 // ASCII helpers for << and >>
-bool starts_with_ascii_open(const std::string& s, size_t pos) {
+bool starts_with_ascii_open(std::string_view s, size_t pos) {
     return pos + 1 < s.size() && s[pos] == '<' && s[pos+1] == '<';
 }
 
-bool starts_with_ascii_close(const std::string& s, size_t pos) {
+bool starts_with_ascii_close(std::string_view s, size_t pos) {
     return pos + 1 < s.size() && s[pos] == '>' && s[pos+1] == '>';
 }
 
-bool starts_with_prog_open(const std::string& s, size_t pos) {
+bool starts_with_prog_open(std::string_view s, size_t pos) {
     return starts_with_laquo(s, pos) || starts_with_ascii_open(s, pos);
 }
 
-bool starts_with_prog_close(const std::string& s, size_t pos) {
+bool starts_with_prog_close(std::string_view s, size_t pos) {
     return starts_with_raquo(s, pos) || starts_with_ascii_close(s, pos);
 }
 
-} // anonymous namespace
+// ]] or ][ — matrix delimiters that end a bare word
+bool starts_with_matrix_close(std::string_view s, size_t pos) {
+    return s[pos] == ']' && pos + 1 < s.size() && (s[pos+1] == ']' || s[pos+1] == '[');
+}
 
-std::vector<Token> parse(const std::string& input) {
-    std::vector<Token> tokens;
-    size_t i = 0;
-    size_t len = input.size();
+// The text between ( and ) as a complex literal, or nothing if it is not one
+std::optional<Complex> complex_literal(std::string_view inner) {
+    auto comma = inner.find(',');
+    if (comma == std::string_view::npos) return std::nullopt;
+    auto trim = [](std::string_view s) {
+        size_t a = s.find_first_not_of(" \t");
+        size_t b = s.find_last_not_of(" \t");
+        return a == std::string_view::npos ? s : s.substr(a, b - a + 1);
+    };
+    try {
+        Real re{std::string(trim(inner.substr(0, comma)))};
+        Real im{std::string(trim(inner.substr(comma + 1)))};
+        return Complex{re, im};
+    } catch (...) {
+        return std::nullopt;
+    }
+}
 
-    while (i < len) {
-        // Skip whitespace
-        while (i < len && is_whitespace(input[i])) ++i;
-        if (i >= len) break;
-
-        // Program literal: « ... » or << ... >>
-        if (starts_with_prog_open(input, i)) {
-            i += 2; // skip « or <<
-            int nesting = 1;
-            std::string body;
-            while (i < len && nesting > 0) {
-                if (starts_with_prog_open(input, i)) {
-                    body += input[i];
-                    body += input[i+1];
-                    i += 2;
-                    nesting++;
-                } else if (starts_with_prog_close(input, i)) {
-                    nesting--;
-                    if (nesting > 0) {
-                        body += input[i];
-                        body += input[i+1];
-                    }
-                    i += 2;
-                } else {
-                    body += input[i];
-                    ++i;
-                }
+// Characters that can end a bare word: whitespace, and the first byte of
+// every delimiter the word loop stops at (<< >> « » { } [[ ]] ][). Most word
+// characters are not in the set, so the loop only looks closer at these.
+struct WordBreaks {
+    bool table[256] = {};
+    WordBreaks() {
+        for (unsigned char c : {' ', '\t', '\n', '\r', '<', '>', '{', '}', '[', ']'}) table[c] = true;
+        table[0xC2] = true;
+    }
+};
+const WordBreaks kWordBreaks;
+
+bool may_break_word(char c) { return kWordBreaks.table[static_cast<unsigned char>(c)]; }
+
+// Single pass over the input. Programs and lists being built are kept on an
+// explicit stack of frames; a token always goes into the innermost one, and a
+// closing bracket turns that frame into a literal in its parent. Nothing is
+// copied out of the input except the text a literal actually keeps.
+class Parser {
+public:
+    explicit Parser(std::string_view input) : in_(input) {
+        frames_.push_back({Frame::Top, {}});
+    }
+
+    std::vector<Token> run() {
+        size_t len = in_.size();
+        while (i_ < len) {
+            // Skip whitespace
+            while (i_ < len && is_whitespace(in_[i_])) ++i_;
+            if (i_ >= len) break;
+            char c = in_[i_];
+
+            // Program literal: « ... » or << ... >>
+            if (starts_with_prog_open(in_, i_)) {
+                frames_.push_back({Frame::Program, {}});
+                i_ += 2;
+            } else if (starts_with_prog_close(in_, i_)) {
+                close_or_word(Frame::Program, 2);
+            } else if (c == '{') {
+                // List literal: { ... }
+                frames_.push_back({Frame::List, {}});
+                ++i_;
+            } else if (c == '}') {
+                close_or_word(Frame::List, 1);
+            } else if (c == '"') {
+                parse_string();
+            } else if (c == '\'') {
+                parse_quoted();
+            } else if (c == '[' && i_ + 1 < len && in_[i_ + 1] == '[') {
+                parse_matrix();
+            } else if (starts_with_matrix_close(in_, i_)) {
+                // Stray matrix delimiter outside a matrix
+                emit(Token::make_command(in_.substr(i_, 2)));
+                i_ += 2;
+            } else if (c != '(' || !parse_complex()) {
+                parse_word();
             }
-            // Trim leading/trailing whitespace from body
-            size_t bs = body.find_first_not_of(" \t\n\r");
-            size_t be = body.find_last_not_of(" \t\n\r");
-            if (bs != std::string::npos) {
-                body = body.substr(bs, be - bs + 1);
+        }
+        // Unterminated programs and lists end with the input
+        while (frames_.size() > 1) close_innermost();
+        mark_fusions(frames_.back().tokens);
+        return std::move(frames_.back().tokens);
+    }
+
+private:
+    struct Frame {
+        enum Kind { Top, Program, List };
+        Kind kind;
+        std::vector<Token> tokens;
+    };
+
+    void emit(Token t) { frames_.back().tokens.push_back(std::move(t)); }
+
+    void close_innermost() {
+        Frame frame = std::move(frames_.back());
+        frames_.pop_back();
+        if (frame.kind == Frame::Program) {
+            mark_fusions(frame.tokens);
+            emit(Token::make_literal(Program{std::move(frame.tokens)}));
+            return;
+        }
+        // Bare words inside a list are kept as names for later evaluation
+        List list;
+        list.items.reserve(frame.tokens.size());
+        for (auto& t : frame.tokens) {
+            if (t.kind == Token::Literal) {
+                list.items.push_back(std::move(t.literal));
             } else {
-                body.clear();
+                list.items.push_back(Name{t.command.str()});
             }
-            // Recursively parse body
-            Program p;
-            p.tokens = parse(body);
-            tokens.push_back(Token::make_literal(std::move(p)));
-            continue;
         }
+        emit(Token::make_literal(std::move(list)));
+    }
 
-        // String literal: "..."
-        if (input[i] == '"') {
-            ++i;
-            std::string value;
-            while (i < len && input[i] != '"') {
-                if (input[i] == '\\' && i + 1 < len) {
-                    ++i;
-                    switch (input[i]) {
-                        case 'n': value += '\n'; break;
-                        case 't': value += '\t'; break;
-                        case '"': value += '"'; break;
-                        case '\\': value += '\\'; break;
-                        default: value += input[i]; break;
-                    }
-                } else {
-                    value += input[i];
-                }
-                ++i;
-            }
-            if (i < len) ++i; // skip closing "
-            tokens.push_back(Token::make_literal(String{value}));
-            continue;
+    // A closing bracket ends the innermost open frame of its kind, along with
+    // any unterminated frames inside it. With no such frame open it is just a
+    // word, which fails as an unknown command when executed.
+    void close_or_word(Frame::Kind kind, size_t width) {
+        size_t k = frames_.size();
+        while (k > 1 && frames_[k - 1].kind != kind) --k;
+        if (k > 1) {
+            while (frames_.size() >= k) close_innermost();
+        } else {
+            emit(Token::make_command(in_.substr(i_, width)));
         }
+        i_ += width;
+    }
 
-        // Quoted name or symbol: '...'
-        if (input[i] == '\'') {
-            ++i;
-            std::string value;
-            while (i < len && input[i] != '\'') {
-                value += input[i];
-                ++i;
-            }
-            if (i < len) ++i; // skip closing '
-            // If it contains operators/spaces/parens/commas, it's a Symbol; otherwise a Name
-            bool has_ops = false;
-            for (char c : value) {
-                if (c == '+' || c == '-' || c == '*' || c == '/' ||
-                    c == '^' || c == '=' || c == ' ' || c == '(' ||
-                    c == ')' || c == ',') {
-                    has_ops = true;
+    // String literal: "..."
+    void parse_string() {
+        size_t len = in_.size();
+        ++i_;
+        std::string value;
+        while (i_ < len && in_[i_] != '"') {
+            // Copy the run up to the next quote or escape in one go
+            size_t run = i_;
+            while (i_ < len && in_[i_] != '"' && in_[i_] != '\\') ++i_;
+            value.append(in_.data() + run, i_ - run);
+            if (i_ < len && in_[i_] == '\\') {
+                if (i_ + 1 >= len) {
+                    value += '\\';
+                    ++i_;
                     break;
                 }
+                ++i_;
+                switch (in_[i_]) {
+                    case 'n': value += '\n'; break;
+                    case 't': value += '\t'; break;
+                    case '"': value += '"'; break;
+                    case '\\': value += '\\'; break;
+                    default: value += in_[i_]; break;
+                }
+                ++i_;
             }
-            if (has_ops) {
-                tokens.push_back(Token::make_literal(Symbol{value}));
-            } else {
-                tokens.push_back(Token::make_literal(Name{value}));
-            }
-            continue;
         }
+        if (i_ < len) ++i_; // skip closing "
+        emit(Token::make_literal(String{std::move(value)}));
+    }
+
+    // Quoted name or symbol: '...'
+    void parse_quoted() {
+        size_t start = ++i_;
+        size_t close = in_.find('\'', start);
+        if (close == std::string_view::npos) close = in_.size();
+        std::string_view value = in_.substr(start, close - start);
+        i_ = close < in_.size() ? close + 1 : close;
+        // If it contains operators/spaces/parens/commas, it's a Symbol; otherwise a Name
+        bool has_ops = value.find_first_of("+-*/^= (),") != std::string_view::npos;
+        if (has_ops) {
+            emit(Token::make_literal(Symbol{std::string(value)}));
+        } else {
+            emit(Token::make_literal(Name{std::string(value)}));
+        }
+    }
 
-        // List literal: { ... }
-        if (input[i] == '{') {
-            ++i; // skip {
-            int nesting = 1;
-            std::string body;
-            while (i < len && nesting > 0) {
-                if (input[i] == '{') {
-                    nesting++;
-                    body += input[i];
-                    ++i;
-                } else if (input[i] == '}') {
-                    nesting--;
-                    if (nesting > 0) {
-                        body += input[i];
-                    }
-                    ++i;
+    // Matrix literal: [[ ... ][ ... ] ... ]]
+    void parse_matrix() {
+        size_t len = in_.size();
+        i_ += 2; // skip [[
+        Matrix mat;
+        std::vector<Object> current_row;
+        size_t elem_start = std::string_view::npos;
+
+        auto flush_elem = [&]() {
+            if (elem_start == std::string_view::npos) return;
+            auto elem_tokens = Parser(in_.substr(elem_start, i_ - elem_start)).run();
+            elem_start = std::string_view::npos;
+            if (elem_tokens.size() == 1 && elem_tokens[0].kind == Token::Literal) {
+                Object obj = std::move(elem_tokens[0].literal);
+                // Validate: only numeric and symbolic types allowed
+                if (holds_alternative<Integer>(obj) ||
+                    holds_alternative<Real>(obj) ||
+                    holds_alternative<Rational>(obj) ||
+                    holds_alternative<Complex>(obj) ||
+                    holds_alternative<Symbol>(obj) ||
+                    holds_alternative<Name>(obj)) {
+                    current_row.push_back(std::move(obj));
                 } else {
-                    body += input[i];
-                    ++i;
-                }
-            }
-            // Trim whitespace from body
-            size_t bs = body.find_first_not_of(" \t\n\r");
-            size_t be = body.find_last_not_of(" \t\n\r");
-            if (bs != std::string::npos) {
-                body = body.substr(bs, be - bs + 1);
-            } else {
-                body.clear();
-            }
-            // Parse body tokens and evaluate them into list items
-            List list;
-            if (!body.empty()) {
-                auto inner_tokens = parse(body);
-                for (auto& t : inner_tokens) {
-                    if (t.kind == Token::Literal) {
-                        list.items.push_back(std::move(t.literal));
-                    } else {
-                        // Bare word in list — try as number, otherwise treat as command name
-                        // (commands in list literals are pushed as-is for later evaluation)
-                        list.items.push_back(Name{t.command});
-                    }
+                    throw std::runtime_error("Invalid matrix element type");
                 }
+            } else if (elem_tokens.size() == 1 && elem_tokens[0].kind == Token::Command) {
+                // Bare name in matrix -> Name
+                current_row.push_back(Name{elem_tokens[0].command.str()});
+            } else if (!elem_tokens.empty()) {
+                throw std::runtime_error("Invalid matrix element");
             }
-            tokens.push_back(Token::make_literal(std::move(list)));
-            continue;
-        }
+        };
 
-        // Matrix literal: [[ ... ][ ... ] ... ]]
-        if (input[i] == '[' && i + 1 < len && input[i + 1] == '[') {
-            i += 2; // skip [[
-            Matrix mat;
-            std::vector<Object> current_row;
-            std::string elem;
-
-            auto flush_elem = [&]() {
-                // Trim whitespace
-                size_t a = elem.find_first_not_of(" \t\n\r");
-                size_t b = elem.find_last_not_of(" \t\n\r");
-                if (a != std::string::npos) {
-                    std::string trimmed = elem.substr(a, b - a + 1);
-                    auto elem_tokens = parse(trimmed);
-                    if (elem_tokens.size() == 1 && elem_tokens[0].kind == Token::Literal) {
-                        Object obj = std::move(elem_tokens[0].literal);
-                        // Validate: only numeric and symbolic types allowed
-                        if (std::holds_alternative<Integer>(obj) ||
-                            std::holds_alternative<Real>(obj) ||
-                            std::holds_alternative<Rational>(obj) ||
-                            std::holds_alternative<Complex>(obj) ||
-                            std::holds_alternative<Symbol>(obj) ||
-                            std::holds_alternative<Name>(obj)) {
-                            current_row.push_back(std::move(obj));
-                        } else {
-                            throw std::runtime_error("Invalid matrix element type");
-                        }
-                    } else if (elem_tokens.size() == 1 && elem_tokens[0].kind == Token::Command) {
-                        // Bare name in matrix -> Name
-                        current_row.push_back(Name{elem_tokens[0].command});
-                    } else if (!elem_tokens.empty()) {
-                        throw std::runtime_error("Invalid matrix element");
-                    }
-                }
-                elem.clear();
-            };
-
-            while (i < len) {
-                // Check for ][ (row separator)
-                if (input[i] == ']' && i + 1 < len && input[i + 1] == '[') {
-                    flush_elem();
-                    if (!current_row.empty()) {
-                        mat.rows.push_back(std::move(current_row));
-                        current_row.clear();
-                    }
-                    i += 2;
-                    continue;
-                }
-                // Check for ]] (matrix close)
-                if (input[i] == ']' && i + 1 < len && input[i + 1] == ']') {
-                    flush_elem();
-                    if (!current_row.empty()) {
-                        mat.rows.push_back(std::move(current_row));
-                    }
-                    i += 2;
-                    break;
+        while (i_ < len) {
+            // Check for ][ (row separator)
+            if (in_[i_] == ']' && i_ + 1 < len && in_[i_ + 1] == '[') {
+                flush_elem();
+                if (!current_row.empty()) {
+                    mat.rows.push_back(std::move(current_row));
+                    current_row.clear();
                 }
-                // Whitespace separates elements
-                if (is_whitespace(input[i])) {
-                    flush_elem();
-                    ++i;
-                    continue;
-                }
-                elem += input[i];
-                ++i;
+                i_ += 2;
+                continue;
             }
-            // Validate uniform row lengths
-            if (!mat.rows.empty()) {
-                size_t cols = mat.rows[0].size();
-                for (size_t r = 1; r < mat.rows.size(); ++r) {
-                    if (mat.rows[r].size() != cols) {
-                        throw std::runtime_error("Matrix rows must have uniform length");
-                    }
+            // Check for ]] (matrix close)
+            if (in_[i_] == ']' && i_ + 1 < len && in_[i_ + 1] == ']') {
+                flush_elem();
+                if (!current_row.empty()) {
+                    mat.rows.push_back(std::move(current_row));
                 }
+                i_ += 2;
+                break;
             }
-            tokens.push_back(Token::make_literal(std::move(mat)));
-            continue;
+            // Whitespace separates elements
+            if (is_whitespace(in_[i_])) {
+                flush_elem();
+            } else if (elem_start == std::string_view::npos) {
+                elem_start = i_;
+            }
+            ++i_;
         }
-
-        // Complex literal: (re, im)
-        if (input[i] == '(') {
-            size_t start = i;
-            // Find matching )
-            size_t close = input.find(')', i);
-            if (close != std::string::npos) {
-                std::string inner = input.substr(i + 1, close - i - 1);
-                auto comma = inner.find(',');
-                if (comma != std::string::npos) {
-                    std::string re_str = inner.substr(0, comma);
-                    std::string im_str = inner.substr(comma + 1);
-                    // Trim whitespace
-                    auto trim = [](std::string& s) {
-                        size_t a = s.find_first_not_of(" \t");
-                        size_t b = s.find_last_not_of(" \t");
-                        if (a != std::string::npos) s = s.substr(a, b - a + 1);
-                    };
-                    trim(re_str);
-                    trim(im_str);
-                    try {
-                        Real re(re_str);
-                        Real im(im_str);
-                        tokens.push_back(Token::make_literal(Complex{re, im}));
-                        i = close + 1;
-                        continue;
-                    } catch (...) {
-                        // Not a valid complex literal, fall through to bare word
-                    }
+        // Validate uniform row lengths
+        if (!mat.rows.empty()) {
+            size_t cols = mat.rows[0].size();
+            for (size_t r = 1; r < mat.rows.size(); ++r) {
+                if (mat.rows[r].size() != cols) {
+                    throw std::runtime_error("Matrix rows must have uniform length");
                 }
             }
-            // Fall through — treat as bare word
         }
+        emit(Token::make_literal(std::move(mat)));
+    }
 
-        // Bare word or number
-        size_t start = i;
-        while (i < len && !is_whitespace(input[i]) &&
-               !starts_with_prog_open(input, i) && !starts_with_prog_close(input, i) &&
-               input[i] != '{' && input[i] != '}') {
-            // Stop at [[ or ]] (matrix delimiters)
-            if (input[i] == '[' && i + 1 < len && input[i + 1] == '[') break;
-            if (input[i] == ']' && i + 1 < len && input[i + 1] == ']') break;
-            if (input[i] == ']' && i + 1 < len && input[i + 1] == '[') break;
-            ++i;
+    // Complex literal: (re, im). Returns false, consuming nothing, when the
+    // text is not one so it can be read as a bare word instead.
+    bool parse_complex() {
+        size_t close = in_.find(')', i_);
+        if (close == std::string_view::npos) return false;
+        auto value = complex_literal(in_.substr(i_ + 1, close - i_ - 1));
+        if (!value) return false;
+        emit(Token::make_literal(std::move(*value)));
+        i_ = close + 1;
+        return true;
+    }
+
+    // Bare word or number
+    void parse_word() {
+        size_t len = in_.size();
+        size_t start = i_;
+        while (i_ < len) {
+            if (may_break_word(in_[i_])) {
+                if (is_whitespace(in_[i_]) || in_[i_] == '{' || in_[i_] == '}') break;
+                if (starts_with_prog_open(in_, i_) || starts_with_prog_close(in_, i_)) break;
+                // Stop at [[, ]] or ][ (matrix delimiters)
+                if (in_[i_] == '[' && i_ + 1 < len && in_[i_ + 1] == '[') break;
+                if (starts_with_matrix_close(in_, i_)) break;
+            }
+            ++i_;
         }
-        std::string word = input.substr(start, i - start);
+        std::string_view word = in_.substr(start, i_ - start);
 
         if (is_integer(word)) {
-            tokens.push_back(Token::make_literal(Integer(word)));
+            emit(Token::make_literal(make_integer(word)));
         } else if (is_real(word)) {
-            tokens.push_back(Token::make_literal(Real(word)));
+            emit(Token::make_literal(Real(std::string(word))));
+        } else if (is_rational(word)) {
+            emit(Token::make_literal(make_rational(word)));
         } else {
-            tokens.push_back(Token::make_command(word));
+            emit(Token::make_command(word));
         }
     }
 
+    std::string_view in_;
+    size_t i_ = 0;
+    std::vector<Frame> frames_;
+};
+
+} // anonymous namespace
+
+std::vector<Token> parse(std::string_view input) {
+    return Parser(input).run();
+}
+
+ParseCache::Tokens ParseCache::get(const std::string& text) {
+    auto it = index_.find(text);
+    if (it != index_.end()) {
+        ++hits_;
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return it->second->second;
+    }
+    ++misses_;
+    Tokens tokens = std::make_shared<const std::vector<Token>>(parse(text));
+    if (capacity_ == 0 || text.size() > max_text_) return tokens;
+    if (index_.size() >= capacity_) {
+        index_.erase(lru_.back().first);
+        lru_.pop_back();
+        ++evictions_;
+    }
+    lru_.emplace_front(text, tokens);
+    index_.emplace(text, lru_.begin());
     return tokens;
 }
 
+void ParseCache::keep_symbol(const Symbol& sym) {
+    const std::string& text = sym.value();
+    if (capacity_ == 0 || text.size() > kSymbolBytes) return;
+    auto it = symbol_index_.find(text);
+    if (it != symbol_index_.end()) {
+        auto entry = it->second;
+        symbol_bytes_ -= entry->value().size();
+        symbol_index_.erase(it);
+        symbols_.erase(entry);
+    }
+    while (!symbols_.empty() && (symbols_.size() >= kSymbolCapacity ||
+                                 symbol_bytes_ + text.size() > kSymbolBytes)) {
+        symbol_bytes_ -= symbols_.back().value().size();
+        symbol_index_.erase(symbols_.back().value());
+        symbols_.pop_back();
+    }
+    symbols_.push_front(sym);
+    symbol_index_.emplace(symbols_.front().value(), symbols_.begin());
+    symbol_bytes_ += text.size();
+}
+
+std::optional<Symbol> ParseCache::symbol(const std::string& text) {
+    auto it = symbol_index_.find(text);
+    if (it == symbol_index_.end()) return std::nullopt;
+    ++symbol_hits_;
+    symbols_.splice(symbols_.begin(), symbols_, it->second);
+    return *it->second;
+}
+
+// Follows the same rules as Parser::run for where tokens start and end, but
+// only tracks what is needed to know whether a line break is at top level.
+void StreamSplitter::scan() {
+    std::string_view in = buf_;
+    size_t len = in.size();
+    size_t i = scanned_;
+    while (i < len) {
+        char c = in[i];
+        // Two-byte delimiters need their second byte before we can decide
+        bool pair_start = c == '<' || c == '>' || c == '[' || c == ']' ||
+                          static_cast<unsigned char>(c) == 0xC2;
+        if (pair_start && i + 1 >= len && mode_ != Mode::String && mode_ != Mode::Quote) break;
+
+        switch (mode_) {
+        case Mode::String:
+            if (c == '\\') mode_ = Mode::StringEscape;
+            else if (c == '"') mode_ = Mode::Token;
+            ++i;
+            continue;
+        case Mode::StringEscape:
+            mode_ = Mode::String;
+            ++i;
+            continue;
+        case Mode::Quote:
+            if (c == '\'') mode_ = Mode::Token;
+            ++i;
+            continue;
+        case Mode::Matrix:
+            if (c == ']' && in[i + 1] == ']') {
+                mode_ = Mode::Token;
+                i += 2;
+            } else {
+                ++i;
+            }
+            continue;
+        case Mode::Token:
+        case Mode::Word:
+            break;
+        }
+
+        if (is_whitespace(c)) {
+            mode_ = Mode::Token;
+            ++i;
+            if (c == '\n' && frames_.empty()) cut_ = i;
+        } else if (starts_with_prog_open(in, i)) {
+            frames_.push_back('P');
+            mode_ = Mode::Token;
+            i += 2;
+        } else if (starts_with_prog_close(in, i)) {
+            close_frame('P');
+            mode_ = Mode::Token;
+            i += 2;
+        } else if (c == '{') {
+            frames_.push_back('L');
+            mode_ = Mode::Token;
+            ++i;
+        } else if (c == '}') {
+            close_frame('L');
+            mode_ = Mode::Token;
+            ++i;
+        } else if (c == '[' && in[i + 1] == '[') {
+            mode_ = Mode::Matrix;
+            i += 2;
+        } else if (starts_with_matrix_close(in, i)) {
+            mode_ = Mode::Token;
+            i += 2;
+        } else if (mode_ == Mode::Token && c == '"') {
+            mode_ = Mode::String;
+            ++i;
+        } else if (mode_ == Mode::Token && c == '\'') {
+            mode_ = Mode::Quote;
+            ++i;
+        } else if (mode_ == Mode::Token && c == '(') {
+            // A complex literal is one token even with spaces inside, and
+            // the next token starts right after it. It cannot span a line
+            // break, so a ')' past the next newline does not count.
+            size_t close = in.find(')', i);
+            size_t newline = in.find('\n', i);
+            if (close == std::string_view::npos && newline == std::string_view::npos) break;
+            if (close < newline && complex_literal(in.substr(i + 1, close - i - 1))) {
+                mode_ = Mode::Token;
+                i = close + 1;
+            } else {
+                mode_ = Mode::Word;
+                ++i;
+            }
+        } else {
+            mode_ = Mode::Word;
+            ++i;
+        }
+    }
+    scanned_ = i;
+}
+
+// Same matching as Parser::close_or_word; a closer with nothing to close is a word
+void StreamSplitter::close_frame(char kind) {
+    size_t k = frames_.size();
+    while (k > 0 && frames_[k - 1] != kind) --k;
+    if (k > 0) frames_.resize(k - 1);
+}
+
+std::string StreamSplitter::take() {
+    scan();
+    if (cut_ == 0) return {};
+    std::string piece = buf_.substr(0, cut_);
+    buf_.erase(0, cut_);
+    scanned_ -= cut_;
+    cut_ = 0;
+    return piece;
+}
+
+std::string StreamSplitter::finish() {
+    std::string rest = std::move(buf_);
+    buf_.clear();
+    scanned_ = cut_ = 0;
+    mode_ = Mode::Token;
+    frames_.clear();
+    return rest;
+}
+
 } // namespace lpr
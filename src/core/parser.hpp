@@ -1,11 +1,95 @@
 #pragma once
 
 #include "core/object.hpp"
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace lpr {
 
-std::vector<Token> parse(const std::string& input);
+std::vector<Token> parse(std::string_view input);
+
+// Bounded LRU cache from source text to its parsed tokens, shared by exec,
+// STR→ and reading Programs and Lists back from the store. One per Context,
+// so it needs no locking. Entries are immutable and shared: tokens stay valid
+// for whoever holds them even if the entry is evicted meanwhile. Text longer
+// than max_text is parsed every time rather than cached.
+//
+// It also keeps the Symbols last written to the store, by text, so that one
+// read back shares the original's parsed tree instead of parsing it again;
+// building an expression a step at a time then costs one new node per step.
+class ParseCache {
+public:
+    using Tokens = std::shared_ptr<const std::vector<Token>>;
+
+    explicit ParseCache(size_t capacity = 256, size_t max_text = 4096)
+        : capacity_(capacity), max_text_(max_text) {}
+
+    Tokens get(const std::string& text);
+
+    void keep_symbol(const Symbol& sym);
+    std::optional<Symbol> symbol(const std::string& text);
+
+    size_t size() const { return index_.size(); }
+    size_t capacity() const { return capacity_; }
+    uint64_t hits() const { return hits_; }
+    uint64_t misses() const { return misses_; }
+    uint64_t evictions() const { return evictions_; }
+    uint64_t symbol_hits() const { return symbol_hits_; }
+
+private:
+    using Entry = std::pair<std::string, Tokens>;
+    size_t capacity_;
+    size_t max_text_;
+    std::list<Entry> lru_; // most recent first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t evictions_ = 0;
+
+    // Keyed by each Symbol's own text, which never changes
+    static constexpr size_t kSymbolCapacity = 64;
+    static constexpr size_t kSymbolBytes = size_t(8) << 20;
+    std::list<Symbol> symbols_; // most recent first
+    std::unordered_map<std::string_view, std::list<Symbol>::iterator> symbol_index_;
+    size_t symbol_bytes_ = 0;
+    uint64_t symbol_hits_ = 0;
+};
+
+// Cuts a stream of RPL text into pieces that can be parsed and run one at a
+// time: parsing the pieces in order gives the same tokens as parsing the
+// whole text. A cut is made only at a line break outside any program, list,
+// matrix, string or quoted name, so the buffer holds at most the current
+// top-level line or item plus the last chunk fed.
+class StreamSplitter {
+public:
+    void feed(std::string_view chunk) { buf_.append(chunk.data(), chunk.size()); }
+
+    // Removes and returns the buffered text up to the last cut; empty if
+    // there is no complete piece yet
+    std::string take();
+
+    // Everything still buffered, once the input has ended
+    std::string finish();
+
+    size_t buffered() const { return buf_.size(); }
+
+private:
+    enum class Mode : uint8_t { Token, Word, String, StringEscape, Quote, Matrix };
+
+    void scan();
+    void close_frame(char kind);
+
+    std::string buf_;
+    size_t scanned_ = 0;       // prefix of buf_ the state below describes
+    size_t cut_ = 0;           // end of the last complete piece in buf_
+    Mode mode_ = Mode::Token;
+    std::vector<char> frames_; // open programs ('P') and lists ('L')
+};
 
 } // namespace lpr
@@ -0,0 +1,159 @@
+#include "core/plot.hpp"
+#include "core/context.hpp"
+#include "core/expr_tree.hpp"
+#include "core/lambdify.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+namespace lpr {
+
+namespace {
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+class Sampler {
+public:
+    Sampler(const std::function<double(double)>& f, const PlotOptions& opts)
+        : f_(f), opts_(opts) {}
+
+    std::vector<double> run(double xmin, double xmax) {
+        size_t n = std::max<size_t>(opts_.initial_samples, 2);
+        std::vector<double> xs(n), ys(n);
+        for (size_t i = 0; i < n; ++i) {
+            xs[i] = xmin + (xmax - xmin) * static_cast<double>(i) / (n - 1);
+            ys[i] = f_(xs[i]);
+        }
+        set_scale(ys);
+
+        emit(xs[0], ys[0]);
+        for (size_t i = 0; i + 1 < n; ++i) {
+            refine(xs[i], ys[i], xs[i + 1], ys[i + 1], 0);
+            emit(xs[i + 1], ys[i + 1]);
+        }
+        // No trailing gap marker
+        while (!out_.empty() && std::isnan(out_.back())) out_.resize(out_.size() - 2);
+        return std::move(out_);
+    }
+
+private:
+    // The y span that tolerances are relative to: the 5th to 95th
+    // percentile of the grid, so a sample next to a pole does not flatten
+    // everything else.
+    void set_scale(const std::vector<double>& ys) {
+        std::vector<double> finite;
+        for (double y : ys) {
+            if (std::isfinite(y)) finite.push_back(y);
+        }
+        double span = 0;
+        if (!finite.empty()) {
+            std::sort(finite.begin(), finite.end());
+            size_t lo = finite.size() / 20;
+            size_t hi = finite.size() - 1 - finite.size() / 20;
+            span = finite[hi] - finite[lo];
+        }
+        if (!(span > 0)) span = 1.0;
+        tol_ = opts_.tolerance * span;
+        jump_ = 0.05 * span;
+    }
+
+    void emit(double x, double y) {
+        if (!std::isfinite(y)) {
+            // Collapse runs of undefined points into one gap marker
+            if (out_.empty() || std::isnan(out_.back())) return;
+            y = kNaN;
+        }
+        out_.push_back(x);
+        out_.push_back(y);
+    }
+
+    void gap(double x) { emit(x, kNaN); }
+
+    // Emit the points strictly between (x0, y0) and (x1, y1)
+    void refine(double x0, double y0, double x1, double y1, int depth) {
+        bool finite0 = std::isfinite(y0), finite1 = std::isfinite(y1);
+        bool budget = out_.size() / 2 < opts_.max_points && depth < opts_.max_depth;
+        if (!finite0 && !finite1) return; // inside an undefined stretch
+
+        double xm = 0.5 * (x0 + x1);
+        double ym = f_(xm);
+        bool split;
+        if (!finite0 || !finite1 || !std::isfinite(ym)) {
+            split = budget; // narrow down where the function stops being defined
+        } else {
+            split = budget && std::fabs(ym - 0.5 * (y0 + y1)) > tol_;
+        }
+
+        if (split) {
+            refine(x0, y0, xm, ym, depth + 1);
+            emit(xm, ym);
+            refine(xm, ym, x1, y1, depth + 1);
+            return;
+        }
+        // Out of depth with a large rise left in the interval. On a steep but
+        // continuous stretch each half carries about half of it; at a jump
+        // one half carries nearly all of it, and across a pole the midpoint
+        // overshoots both ends.
+        if (depth >= opts_.max_depth && finite0 && finite1) {
+            double rise = std::fabs(y1 - y0);
+            double half = std::max(std::fabs(ym - y0), std::fabs(y1 - ym));
+            if (rise > jump_ && (!std::isfinite(ym) || half > 0.9 * rise)) gap(xm);
+        }
+    }
+
+    const std::function<double(double)>& f_;
+    const PlotOptions& opts_;
+    double tol_ = 0;
+    double jump_ = 0;
+    std::vector<double> out_;
+};
+
+double object_to_double(const Object& obj) {
+    if (holds_alternative<Integer>(obj)) return get<Integer>(obj).convert_to<double>();
+    if (holds_alternative<Rational>(obj)) return get<Rational>(obj).convert_to<double>();
+    if (holds_alternative<Real>(obj)) return get<Real>(obj).convert_to<double>();
+    return kNaN;
+}
+
+} // namespace
+
+std::vector<double> sample_plot(const std::function<double(double)>& f,
+                                double xmin, double xmax, const PlotOptions& opts) {
+    if (!std::isfinite(xmin) || !std::isfinite(xmax) || !(xmin < xmax))
+        throw std::runtime_error("Bad argument value");
+    return Sampler(f, opts).run(xmin, xmax);
+}
+
+std::function<double(double)> plot_function(const Object& fn, const std::string& var,
+                                            Context& ctx) {
+    if (holds_alternative<Symbol>(fn) || holds_alternative<Name>(fn)) {
+        auto compiled = std::make_shared<NumericFunction>(
+            lambdify(object_expr_tree(fn), {var}, ctx));
+        return [compiled](double x) { return (*compiled)(&x); };
+    }
+    if (holds_alternative<Program>(fn)) {
+        auto tokens = std::make_shared<std::vector<Token>>(get<Program>(fn).tokens);
+        return [tokens, var, &ctx](double x) {
+            Store& store = ctx.store();
+            int base = store.depth();
+            size_t scopes = ctx.local_scopes().size();
+            ctx.push_locals({{var, Real(x)}});
+            double y = kNaN;
+            try {
+                ctx.execute_tokens(*tokens);
+                if (store.depth() == base + 1) y = object_to_double(store.pop());
+            } catch (const std::exception&) {
+                // Undefined here: leave a gap
+            }
+            // A failing program may leave its own frames and values behind
+            while (ctx.local_scopes().size() > scopes) ctx.pop_locals();
+            while (store.depth() > base) store.pop();
+            return y;
+        };
+    }
+    throw std::runtime_error("Bad argument type");
+}
+
+} // namespace lpr
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "core/object.hpp"
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace lpr {
+
+class Context;
+
+struct PlotOptions {
+    size_t initial_samples = 65; // uniform grid before refinement
+    int max_depth = 10;          // halvings allowed per grid interval
+    double tolerance = 1e-3;     // allowed midpoint error, as a fraction of the y span
+    size_t max_points = 4096;    // refinement stops once this many points exist
+};
+
+// Sample f over [xmin, xmax], halving intervals where the midpoint strays
+// from the chord (high curvature). Returns packed (x, y) pairs in x order.
+// A pair with y = NaN marks a gap: f was undefined there, or the curve jumps
+// at a discontinuity that refinement could not close.
+std::vector<double> sample_plot(const std::function<double(double)>& f,
+                                double xmin, double xmax, const PlotOptions& opts = {});
+
+// Numeric function of `var` for a Symbol, Name or Program. Symbols are
+// compiled once with lambdify(); Programs run with `var` bound as a local and
+// must leave one number. Points where evaluation fails give NaN.
+std::function<double(double)> plot_function(const Object& fn, const std::string& var,
+                                            Context& ctx);
+
+} // namespace lpr
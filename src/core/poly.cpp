@@ -0,0 +1,638 @@
+#include "core/poly.hpp"
+#include "core/transcendental.hpp"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+namespace lpr {
+
+namespace {
+
+using boost::multiprecision::abs;
+
+// Relative size below which a Real is taken as rounding noise
+const Real& real_eps() {
+    static const Real eps("1e-40");
+    return eps;
+}
+
+bool negligible(const Rational& c, const Rational&) { return c == 0; }
+bool negligible(const Real& c, const Real& scale) { return abs(c) <= scale * real_eps(); }
+
+template <typename T>
+T max_abs(const std::vector<T>& v) {
+    T m = 0;
+    for (const auto& c : v) {
+        T a = abs(c);
+        if (a > m) m = a;
+    }
+    return m;
+}
+
+// out[0, na+nb-1) += a*b
+template <typename T>
+void mul_add(const T* a, size_t na, const T* b, size_t nb, T* out) {
+    constexpr size_t cutoff = Poly<T>::kKaratsubaCutoff;
+    if (na < nb) {
+        std::swap(a, b);
+        std::swap(na, nb);
+    }
+    if (nb < cutoff) {
+        for (size_t i = 0; i < na; ++i)
+            for (size_t j = 0; j < nb; ++j) out[i + j] += a[i] * b[j];
+        return;
+    }
+    if (2 * nb <= na) {
+        // Lopsided: multiply the shorter operand into nb-sized slices
+        for (size_t i = 0; i < na; i += nb) mul_add(a + i, std::min(nb, na - i), b, nb, out + i);
+        return;
+    }
+
+    // a = a0 + a1*x^m, b = b0 + b1*x^m; three half-size products instead of four
+    size_t m = na / 2;
+    size_t na1 = na - m, nb1 = nb - m;
+    std::vector<T> z0(2 * m - 1), z2(na1 + nb1 - 1);
+    mul_add(a, m, b, m, z0.data());
+    mul_add(a + m, na1, b + m, nb1, z2.data());
+
+    std::vector<T> sa(a + m, a + na), sb(std::max(m, nb1));
+    for (size_t i = 0; i < m; ++i) sa[i] += a[i];
+    for (size_t i = 0; i < sb.size(); ++i) {
+        if (i < m) sb[i] += b[i];
+        if (i < nb1) sb[i] += b[m + i];
+    }
+    std::vector<T> z1(sa.size() + sb.size() - 1);
+    mul_add(sa.data(), sa.size(), sb.data(), sb.size(), z1.data());
+    for (size_t i = 0; i < z0.size(); ++i) z1[i] -= z0[i];
+    for (size_t i = 0; i < z2.size(); ++i) z1[i] -= z2[i];
+
+    for (size_t i = 0; i < z0.size(); ++i) out[i] += z0[i];
+    // z1 may carry high zero terms beyond the product's length
+    size_t len = na + nb - 1;
+    for (size_t i = 0; i < z1.size() && m + i < len; ++i) out[m + i] += z1[i];
+    for (size_t i = 0; i < z2.size(); ++i) out[2 * m + i] += z2[i];
+}
+
+// ---- Complex arithmetic at Real precision ----
+
+Complex cmul(const Complex& a, const Complex& b) {
+    return {a.first * b.first - a.second * b.second, a.first * b.second + a.second * b.first};
+}
+
+Complex cdiv(const Complex& a, const Complex& b) {
+    Real d = b.first * b.first + b.second * b.second;
+    return {(a.first * b.first + a.second * b.second) / d,
+            (a.second * b.first - a.first * b.second) / d};
+}
+
+Real cnorm(const Complex& a) { return a.first * a.first + a.second * a.second; }
+
+// p(z) and p'(z) in one Horner pass
+void eval_with_derivative(const std::vector<Real>& c, const Complex& z, Complex& p, Complex& dp) {
+    p = {c.back(), Real(0)};
+    dp = {Real(0), Real(0)};
+    for (size_t i = c.size() - 1; i-- > 0;) {
+        dp = cmul(dp, z);
+        dp.first += p.first;
+        dp.second += p.second;
+        p = cmul(p, z);
+        p.first += c[i];
+    }
+}
+
+// ---- Root finding ----
+
+// Aberth-Ehrlich: Newton's correction for each root, deflated implicitly by
+// the pull of all the others. Needs c[0] != 0 and at least degree 1.
+std::vector<std::complex<double>> aberth(const std::vector<Real>& c) {
+    size_t n = c.size() - 1;
+    std::vector<double> a(c.size());
+    for (size_t i = 0; i <= n; ++i) {
+        a[i] = c[i].convert_to<double>();
+        if (!std::isfinite(a[i])) throw std::runtime_error("Bad argument value");
+    }
+
+    // Start evenly spread on a circle enclosing every root
+    double radius = 0;
+    for (size_t i = 0; i < n; ++i)
+        radius = std::max(radius, std::pow(std::fabs(a[i] / a[n]), 1.0 / double(n - i)));
+    if (!(radius > 0) || !std::isfinite(radius)) radius = 1;
+    std::vector<std::complex<double>> z(n);
+    const double two_pi = 6.28318530717958647692;
+    for (size_t k = 0; k < n; ++k) z[k] = std::polar(radius, two_pi * double(k) / double(n) + 0.4);
+
+    for (int iter = 0; iter < 500; ++iter) {
+        bool moved = false;
+        for (size_t k = 0; k < n; ++k) {
+            std::complex<double> p = a[n], dp = 0.0;
+            for (size_t i = n; i-- > 0;) {
+                dp = dp * z[k] + p;
+                p = p * z[k] + a[i];
+            }
+            if (p == 0.0) continue;
+            std::complex<double> pull = 0.0;
+            for (size_t j = 0; j < n; ++j) {
+                if (j != k) pull += 1.0 / (z[k] - z[j]);
+            }
+            std::complex<double> denom = dp - p * pull;
+            if (denom == 0.0) continue;
+            std::complex<double> w = p / denom;
+            z[k] -= w;
+            if (std::abs(w) > 1e-15 * std::abs(z[k])) moved = true;
+        }
+        if (!moved) break;
+    }
+    return z;
+}
+
+// x to the digits above err, at most Real's; zero if it is within err
+Real settle(const Real& x, const Real& err) {
+    if (err == 0) return round_digits(x, kMaxPrecision);
+    if (abs(x) <= err) return Real(0);
+    long long digits = x.backend().order() - err.backend().order();
+    return round_digits(x, int(std::clamp<long long>(digits, 1, kMaxPrecision)));
+}
+
+// Newton steps at Real precision, kept only while the residual shrinks. The
+// last step bounds the error: the root comes back rounded to the digits it
+// settled, so a root that is only good to 1e-7 does not print 50 digits of
+// noise, and an imaginary part within the error is zero.
+Complex polish(const std::vector<Real>& c, std::complex<double> start) {
+    Complex z{Real(start.real()), Real(start.imag())};
+    Complex p, dp;
+    eval_with_derivative(c, z, p, dp);
+    Real res = cnorm(p);
+    Real err = 0;
+    for (int iter = 0; iter < 8 && res != 0 && cnorm(dp) != 0; ++iter) {
+        Complex step = cdiv(p, dp);
+        err = sqrt(cnorm(step));
+        Complex next{z.first - step.first, z.second - step.second};
+        Complex np, ndp;
+        eval_with_derivative(c, next, np, ndp);
+        Real nres = cnorm(np);
+        if (nres >= res) break;
+        z = next;
+        p = np;
+        dp = ndp;
+        res = nres;
+        if (res == 0) err = 0;
+    }
+    return {settle(z.first, err), settle(z.second, err)};
+}
+
+// Roots of a polynomial with a non-zero constant term
+std::vector<Complex> nonzero_roots(const std::vector<Real>& c) {
+    std::vector<Complex> roots;
+    if (c.size() < 2) return roots;
+    for (const auto& z : aberth(c)) roots.push_back(polish(c, z));
+    return roots;
+}
+
+bool is_real_root(const Complex& z) {
+    return abs(z.second) <= real_eps() * std::max(Real(1), Real(abs(z.first)));
+}
+
+struct Root {
+    Complex at;
+    Object value;
+};
+
+std::vector<Object> sorted_roots(std::vector<Root> roots) {
+    std::sort(roots.begin(), roots.end(), [](const Root& a, const Root& b) {
+        return a.at.first != b.at.first ? a.at.first < b.at.first : a.at.second < b.at.second;
+    });
+    std::vector<Object> out;
+    out.reserve(roots.size());
+    for (auto& r : roots) out.push_back(std::move(r.value));
+    return out;
+}
+
+Root inexact_root(const Complex& z) {
+    if (is_real_root(z)) return {{z.first, Real(0)}, z.first};
+    return {z, z};
+}
+
+// The exact value of a real root of f, if it is rational. By the rational
+// root theorem its denominator divides f's leading coefficient once f is
+// scaled to integer coefficients.
+std::optional<Rational> rational_root(const ExactPoly& f, const Real& x) {
+    Integer den = 1;
+    for (const auto& c : f.coeffs())
+        den = boost::multiprecision::lcm(den, boost::multiprecision::denominator(c));
+    Integer lead = boost::multiprecision::numerator(Rational(f.lead() * den));
+    if (lead < 0) lead = -lead;
+    Real scaled = x * Real(lead);
+    static const Real limit("1e40");
+    if (abs(scaled) > limit) return std::nullopt;
+    Integer num = boost::multiprecision::round(scaled).convert_to<Integer>();
+    Rational r(num, lead);
+    if (f(r) != 0) return std::nullopt;
+    return r;
+}
+
+// p with the coefficients that are rounding noise against `scale` zeroed
+template <typename T>
+Poly<T> chop(const Poly<T>& p, const T& scale) {
+    std::vector<T> c = p.coeffs();
+    for (auto& x : c) {
+        if (negligible(x, scale)) x = 0;
+    }
+    return Poly<T>(std::move(c));
+}
+
+// Yun's square-free factorization: factors paired with their multiplicity.
+// Over Real, the gcds drop remainders within rounding of zero, so only
+// roots repeated to working precision are merged.
+template <typename T>
+std::vector<std::pair<Poly<T>, int>> squarefree(const Poly<T>& a) {
+    std::vector<std::pair<Poly<T>, int>> out;
+    Poly<T> b = a.derivative();
+    Poly<T> c = gcd(a, b);
+    Poly<T> w, y, rem;
+    Poly<T>::divmod(a, c, w, rem);
+    Poly<T>::divmod(b, c, y, rem);
+    Poly<T> z = chop(y - w.derivative(), max_abs(y.coeffs()));
+    for (int i = 1; w.degree() > 0 && i <= a.degree(); ++i) {
+        Poly<T> g = gcd(w, z);
+        if (g.degree() > 0) out.push_back({g, i});
+        Poly<T> next;
+        Poly<T>::divmod(w, g, next, rem);
+        w = std::move(next);
+        Poly<T>::divmod(z, g, y, rem);
+        z = chop(y - w.derivative(), max_abs(y.coeffs()));
+    }
+    return out;
+}
+
+// Number of roots at the origin: the count of zero low-order coefficients
+template <typename T>
+size_t zero_roots(const Poly<T>& p) {
+    if (p.is_zero()) throw std::runtime_error("Bad argument value");
+    size_t k = 0;
+    while (p.coeffs()[k] == 0) ++k;
+    return k;
+}
+
+// ---- Expression conversion ----
+
+bool small_exponent(const Rational& e, long& out) {
+    if (boost::multiprecision::denominator(e) != 1 || e < 0 || e > 1000000) return false;
+    out = boost::multiprecision::numerator(e).convert_to<long>();
+    return true;
+}
+
+bool small_exponent(const Real& e, long& out) {
+    if (e < 0 || e > 1000000 || e != boost::multiprecision::floor(e)) return false;
+    out = e.convert_to<long>();
+    return true;
+}
+
+template <typename T> T parse_coeff(const std::string& text);
+template <> Rational parse_coeff<Rational>(const std::string& text) { return Rational(Integer(text)); }
+template <> Real parse_coeff<Real>(const std::string& text) { return Real(text); }
+
+bool has_inexact_literal(const ExprPtr& root) {
+    std::vector<const ExprNode*> work{root.get()};
+    while (!work.empty()) {
+        const ExprNode* node = work.back();
+        work.pop_back();
+        if (node->kind == ExprNode::Kind::Number &&
+            node->text.find_first_of(".Ee") != std::string::npos)
+            return true;
+        for (const auto& kid : node->kids) work.push_back(kid.get());
+    }
+    return false;
+}
+
+template <typename T>
+Poly<T> build_poly(const ExprPtr& root, const std::string& var) {
+    using Kind = ExprNode::Kind;
+    auto not_poly = [&] { return std::runtime_error("Not a polynomial in " + var); };
+    std::vector<Poly<T>> values;
+    // Explicit stack, so long sums do not recurse
+    std::vector<std::pair<const ExprNode*, size_t>> work{{root.get(), 0}};
+    while (!work.empty()) {
+        auto& [node, next] = work.back();
+        if (next < node->kids.size()) {
+            const ExprNode* kid = node->kids[next++].get();
+            work.push_back({kid, 0});
+            continue;
+        }
+        const ExprNode* done = node;
+        work.pop_back();
+        switch (done->kind) {
+            case Kind::Number:
+                values.push_back(Poly<T>({parse_coeff<T>(done->text)}));
+                break;
+            case Kind::Name:
+                if (done->text != var) throw not_poly();
+                values.push_back(Poly<T>({T(0), T(1)}));
+                break;
+            case Kind::Group:
+                break;
+            case Kind::Neg:
+                values.back() = Poly<T>() - values.back();
+                break;
+            case Kind::Add: case Kind::Sub: case Kind::Mul: case Kind::Div: case Kind::Pow: {
+                Poly<T> rhs = std::move(values.back());
+                values.pop_back();
+                Poly<T>& lhs = values.back();
+                if (done->kind == Kind::Add) {
+                    lhs = lhs + rhs;
+                } else if (done->kind == Kind::Sub) {
+                    lhs = lhs - rhs;
+                } else if (done->kind == Kind::Mul) {
+                    lhs = lhs * rhs;
+                } else if (done->kind == Kind::Div) {
+                    if (rhs.degree() > 0) throw not_poly();
+                    Poly<T> q, r;
+                    Poly<T>::divmod(lhs, rhs, q, r);
+                    lhs = std::move(q);
+                } else {
+                    long e = 0;
+                    if (rhs.degree() > 0 || (!rhs.is_zero() && !small_exponent(rhs.lead(), e)))
+                        throw not_poly();
+                    if (lhs.degree() > 0 && e > 1000000 / lhs.degree())
+                        throw std::runtime_error("Bad argument value");
+                    Poly<T> result({T(1)});
+                    for (Poly<T> base = lhs; e; e >>= 1) {
+                        if (e & 1) result = result * base;
+                        if (e > 1) base = base * base;
+                    }
+                    lhs = std::move(result);
+                }
+                break;
+            }
+            default: // calls and text outside the grammar
+                throw not_poly();
+        }
+    }
+    return values.back();
+}
+
+int coeff_sign(const Object& c) {
+    if (holds_alternative<Integer>(c)) return get<Integer>(c).sign();
+    if (holds_alternative<Rational>(c)) return get<Rational>(c).sign();
+    if (holds_alternative<Real>(c)) return get<Real>(c).sign();
+    throw std::runtime_error("Bad argument type");
+}
+
+Object negated(const Object& c) {
+    if (holds_alternative<Integer>(c)) return Integer(-get<Integer>(c));
+    if (holds_alternative<Rational>(c)) return Rational(-get<Rational>(c));
+    return Real(-get<Real>(c));
+}
+
+bool is_one(const Object& c) {
+    if (holds_alternative<Integer>(c)) return get<Integer>(c) == 1;
+    if (holds_alternative<Rational>(c)) return get<Rational>(c) == 1;
+    return false; // 1. stays visible, as written
+}
+
+} // namespace
+
+// ---- Poly ----
+
+template <typename T>
+Poly<T>::Poly(std::vector<T> coeffs) : c_(std::move(coeffs)) {
+    while (!c_.empty() && c_.back() == 0) c_.pop_back();
+}
+
+template <typename T>
+T Poly<T>::operator()(const T& x) const {
+    if (c_.empty()) return T(0);
+    T acc = c_.back();
+    for (size_t i = c_.size() - 1; i-- > 0;) acc = acc * x + c_[i];
+    return acc;
+}
+
+template <typename T>
+Poly<T> Poly<T>::operator+(const Poly& rhs) const {
+    std::vector<T> out = c_.size() >= rhs.c_.size() ? c_ : rhs.c_;
+    const std::vector<T>& other = c_.size() >= rhs.c_.size() ? rhs.c_ : c_;
+    for (size_t i = 0; i < other.size(); ++i) out[i] += other[i];
+    return Poly(std::move(out));
+}
+
+template <typename T>
+Poly<T> Poly<T>::operator-(const Poly& rhs) const {
+    std::vector<T> out = c_;
+    if (out.size() < rhs.c_.size()) out.resize(rhs.c_.size());
+    for (size_t i = 0; i < rhs.c_.size(); ++i) out[i] -= rhs.c_[i];
+    return Poly(std::move(out));
+}
+
+template <typename T>
+Poly<T> Poly<T>::operator*(const Poly& rhs) const {
+    if (is_zero() || rhs.is_zero()) return Poly();
+    std::vector<T> out(c_.size() + rhs.c_.size() - 1);
+    mul_add(c_.data(), c_.size(), rhs.c_.data(), rhs.c_.size(), out.data());
+    return Poly(std::move(out));
+}
+
+template <typename T>
+void Poly<T>::divmod(const Poly& a, const Poly& b, Poly& q, Poly& r) {
+    if (b.is_zero()) throw std::runtime_error("Division by zero");
+    std::vector<T> rem = a.c_;
+    int db = b.degree();
+    int shift = a.degree() - db;
+    std::vector<T> quo(shift >= 0 ? shift + 1 : 0);
+    for (int i = shift; i >= 0; --i) {
+        T coef = rem[i + db] / b.lead();
+        for (int j = 0; j < db; ++j) rem[i + j] -= coef * b.c_[j];
+        rem[i + db] = 0;
+        quo[i] = std::move(coef);
+    }
+    if (rem.size() > static_cast<size_t>(db)) rem.resize(db);
+    q = Poly(std::move(quo));
+    r = Poly(std::move(rem));
+}
+
+template <typename T>
+Poly<T> Poly<T>::derivative() const {
+    std::vector<T> out;
+    for (size_t i = 1; i < c_.size(); ++i) out.push_back(c_[i] * T(static_cast<long long>(i)));
+    return Poly(std::move(out));
+}
+
+template <typename T>
+Poly<T> Poly<T>::monic() const {
+    if (is_zero()) return *this;
+    std::vector<T> out = c_;
+    for (auto& c : out) c /= c_.back();
+    return Poly(std::move(out));
+}
+
+template <typename T>
+Poly<T> gcd(const Poly<T>& a, const Poly<T>& b) {
+    Poly<T> x = a, y = b;
+    while (!y.is_zero()) {
+        Poly<T> q, r;
+        Poly<T>::divmod(x, y, q, r);
+        T scale = max_abs(x.coeffs());
+        std::vector<T> rc = r.coeffs();
+        for (auto& c : rc) {
+            if (negligible(c, scale)) c = 0;
+        }
+        x = std::move(y);
+        y = Poly<T>(std::move(rc)).monic(); // keeps exact coefficients small
+    }
+    return x.monic();
+}
+
+template class Poly<Rational>;
+template class Poly<Real>;
+template ExactPoly gcd(const ExactPoly&, const ExactPoly&);
+template RealPoly gcd(const RealPoly&, const RealPoly&);
+
+Complex eval_complex(const RealPoly& p, const Complex& z) {
+    if (p.is_zero()) return {Real(0), Real(0)};
+    Complex acc{p.lead(), Real(0)};
+    const auto& c = p.coeffs();
+    for (size_t i = c.size() - 1; i-- > 0;) {
+        acc = cmul(acc, z);
+        acc.first += c[i];
+    }
+    return acc;
+}
+
+std::vector<Object> poly_roots(const RealPoly& p) {
+    size_t zeros = zero_roots(p);
+    std::vector<Root> roots(zeros, Root{{Real(0), Real(0)}, Real(0)});
+    RealPoly rest({p.coeffs().begin() + zeros, p.coeffs().end()});
+    // Split off repeated roots first: found together they only agree to
+    // about 1/multiplicity of the digits. If rounding upset the split,
+    // fall back to the polynomial as it is.
+    auto factors = squarefree(rest);
+    int found = 0;
+    for (const auto& [factor, mult] : factors) found += factor.degree() * mult;
+    if (found != rest.degree()) factors = {{rest, 1}};
+    for (const auto& [factor, mult] : factors) {
+        for (const auto& z : nonzero_roots(factor.coeffs())) {
+            Root root = inexact_root(z);
+            for (int i = 0; i < mult; ++i) roots.push_back(root);
+        }
+    }
+    return sorted_roots(std::move(roots));
+}
+
+std::vector<Object> poly_roots(const ExactPoly& p) {
+    size_t zeros = zero_roots(p);
+    std::vector<Root> roots(zeros, Root{{Real(0), Real(0)}, Integer(0)});
+    ExactPoly rest({p.coeffs().begin() + zeros, p.coeffs().end()});
+    for (const auto& [factor, mult] : squarefree(rest)) {
+        std::vector<Real> c;
+        for (const auto& r : factor.coeffs()) c.push_back(Real(r));
+        for (const auto& z : nonzero_roots(c)) {
+            Root root = inexact_root(z);
+            if (is_real_root(z)) {
+                if (auto exact = rational_root(factor, z.first)) {
+                    root = {{Real(*exact), Real(0)}, exact_coeff(*exact)};
+                }
+            }
+            for (int i = 0; i < mult; ++i) roots.push_back(root);
+        }
+    }
+    return sorted_roots(std::move(roots));
+}
+
+// ---- Stack form ----
+
+Object exact_coeff(const Rational& c) {
+    if (boost::multiprecision::denominator(c) == 1) return boost::multiprecision::numerator(c);
+    return c;
+}
+
+bool is_exact_poly(const List& coeffs) {
+    bool exact = true;
+    for (const auto& c : coeffs.items) {
+        if (holds_alternative<Real>(c)) {
+            exact = false;
+        } else if (!holds_alternative<Integer>(c) && !holds_alternative<Rational>(c)) {
+            throw std::runtime_error("Bad argument type");
+        }
+    }
+    return exact;
+}
+
+ExactPoly to_exact_poly(const List& coeffs) {
+    std::vector<Rational> c;
+    c.reserve(coeffs.items.size());
+    for (auto it = coeffs.items.rbegin(); it != coeffs.items.rend(); ++it) {
+        if (holds_alternative<Integer>(*it)) {
+            c.push_back(Rational(get<Integer>(*it)));
+        } else if (holds_alternative<Rational>(*it)) {
+            c.push_back(get<Rational>(*it));
+        } else {
+            throw std::runtime_error("Bad argument type");
+        }
+    }
+    return ExactPoly(std::move(c));
+}
+
+RealPoly to_real_poly(const List& coeffs) {
+    std::vector<Real> c;
+    c.reserve(coeffs.items.size());
+    for (auto it = coeffs.items.rbegin(); it != coeffs.items.rend(); ++it) {
+        if (holds_alternative<Integer>(*it)) {
+            c.push_back(Real(get<Integer>(*it)));
+        } else if (holds_alternative<Rational>(*it)) {
+            c.push_back(Real(get<Rational>(*it)));
+        } else if (holds_alternative<Real>(*it)) {
+            c.push_back(get<Real>(*it));
+        } else {
+            throw std::runtime_error("Bad argument type");
+        }
+    }
+    return RealPoly(std::move(c));
+}
+
+List poly_to_list(const ExactPoly& p) {
+    if (p.is_zero()) return List{{Integer(0)}};
+    List out;
+    out.items.reserve(p.coeffs().size());
+    for (auto it = p.coeffs().rbegin(); it != p.coeffs().rend(); ++it) out.items.push_back(exact_coeff(*it));
+    return out;
+}
+
+List poly_to_list(const RealPoly& p) {
+    if (p.is_zero()) return List{{Real(0)}};
+    List out;
+    out.items.reserve(p.coeffs().size());
+    for (auto it = p.coeffs().rbegin(); it != p.coeffs().rend(); ++it) out.items.push_back(*it);
+    return out;
+}
+
+List expr_to_poly(const ExprPtr& tree, const std::string& var) {
+    if (has_inexact_literal(tree)) return poly_to_list(build_poly<Real>(tree, var));
+    return poly_to_list(build_poly<Rational>(tree, var));
+}
+
+ExprPtr poly_to_expr(const List& coeffs, const ExprPtr& x) {
+    const auto& items = coeffs.items;
+    ExprPtr result;
+    for (size_t k = 0; k < items.size(); ++k) {
+        size_t power = items.size() - 1 - k;
+        int sign = coeff_sign(items[k]);
+        if (sign == 0) continue;
+        Object mag = sign < 0 ? negated(items[k]) : items[k];
+        ExprPtr term;
+        if (power == 0) {
+            term = object_expr_tree(mag);
+        } else {
+            term = power == 1 ? x : make_binary("^", x, make_number(std::to_string(power)));
+            if (!is_one(mag)) term = make_binary("*", object_expr_tree(mag), term);
+        }
+        if (!result) {
+            result = sign < 0 ? make_neg(term) : term;
+        } else {
+            result = make_binary(sign < 0 ? "-" : "+", result, term);
+        }
+    }
+    return result ? result : make_number("0");
+}
+
+} // namespace lpr
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "core/object.hpp"
+#include "core/expr_tree.hpp"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace lpr {
+
+// Dense univariate polynomial over T: Rational when every coefficient is
+// exact, Real otherwise. Coefficients are stored lowest degree first with no
+// zero leading term, so the zero polynomial has no coefficients.
+template <typename T>
+class Poly {
+public:
+    // Operands shorter than this multiply by the schoolbook method
+    static constexpr size_t kKaratsubaCutoff = 32;
+
+    Poly() = default;
+    explicit Poly(std::vector<T> coeffs);
+
+    int degree() const { return static_cast<int>(c_.size()) - 1; } // -1 for zero
+    bool is_zero() const { return c_.empty(); }
+    const std::vector<T>& coeffs() const { return c_; }
+    const T& lead() const { return c_.back(); }
+
+    // Horner's rule
+    T operator()(const T& x) const;
+
+    Poly operator+(const Poly& rhs) const;
+    Poly operator-(const Poly& rhs) const;
+    Poly operator*(const Poly& rhs) const;
+
+    // a = q*b + r with deg r < deg b. Throws on a zero divisor.
+    static void divmod(const Poly& a, const Poly& b, Poly& q, Poly& r);
+
+    Poly derivative() const;
+    Poly monic() const;
+
+private:
+    std::vector<T> c_;
+};
+
+using ExactPoly = Poly<Rational>;
+using RealPoly  = Poly<Real>;
+
+// Monic greatest common divisor by Euclid's algorithm. With Real
+// coefficients, remainder terms within rounding of zero are dropped.
+template <typename T>
+Poly<T> gcd(const Poly<T>& a, const Poly<T>& b);
+
+// p(z) for a complex z
+Complex eval_complex(const RealPoly& p, const Complex& z);
+
+// All roots, repeated by multiplicity and sorted by real then imaginary
+// part: Reals, or Complex for non-real roots. Aberth-Ehrlich iteration in
+// double precision finds them, Newton steps at Real precision polish them,
+// and each is rounded to the digits the steps settled. Polynomials are first
+// split into square-free factors, so repeated roots are as accurate as
+// simple ones, and rational roots of exact polynomials come back exact.
+// Throws for the zero polynomial.
+std::vector<Object> poly_roots(const RealPoly& p);
+std::vector<Object> poly_roots(const ExactPoly& p);
+
+// ---- Stack form ----
+// On the stack a polynomial is a List of numbers, highest degree first as
+// on the HP 50g: { 1 -3 2 } is X^2-3*X+2.
+
+// An exact coefficient: an Integer when whole, else a Rational
+Object exact_coeff(const Rational& c);
+
+// True when every coefficient is an Integer or Rational. Throws if one is
+// not a real number.
+bool is_exact_poly(const List& coeffs);
+ExactPoly to_exact_poly(const List& coeffs);
+RealPoly to_real_poly(const List& coeffs);
+List poly_to_list(const ExactPoly& p);
+List poly_to_list(const RealPoly& p);
+
+// Coefficients of an expression that is a polynomial in `var`: sums,
+// differences and products of numbers and `var`, division by constants and
+// constant non-negative integer powers. Exact unless a literal has a
+// decimal point or exponent.
+List expr_to_poly(const ExprPtr& tree, const std::string& var);
+
+// Expanded form c_n*x^n+...+c_0 of a coefficient List, with `x` in place of
+// the variable.
+ExprPtr poly_to_expr(const List& coeffs, const ExprPtr& x);
+
+} // namespace lpr
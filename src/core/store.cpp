@@ -1,4 +1,5 @@
 #include "core/store.hpp"
+#include "core/parser.hpp"
 #include <sqlite3.h>
 #include <stdexcept>
 #include <cstring>
@@ -92,6 +93,12 @@ void Store::create_schema() {
             seq INTEGER PRIMARY KEY AUTOINCREMENT,
             input TEXT NOT NULL
         );
+        CREATE TABLE IF NOT EXISTS cas_cache (
+            key TEXT PRIMARY KEY,
+            type_tag INTEGER NOT NULL,
+            data TEXT NOT NULL,
+            compute_us INTEGER NOT NULL
+        );
     )");
 }
 
@@ -116,6 +123,13 @@ void Store::ensure_home() {
     }
 }
 
+// Text for the objects table; a Symbol is also kept in the parse cache so
+// reading it back reuses its tree
+std::string Store::serialize_object(const Object& obj) {
+    if (parse_cache_ && holds_alternative<Symbol>(obj)) parse_cache_->keep_symbol(get<Symbol>(obj));
+    return serialize(obj);
+}
+
 // --- Stack operations ---
 
 void Store::push(const Object& obj) {
@@ -123,8 +137,9 @@ void Store::push(const Object& obj) {
     sqlite3_stmt* stmt = nullptr;
     sqlite3_prepare_v2(db_, "INSERT INTO objects (type_tag, data) VALUES (?, ?)", -1, &stmt, nullptr);
     sqlite3_bind_int(stmt, 1, static_cast<int>(type_tag(obj)));
-    std::string data = serialize(obj);
-    sqlite3_bind_text(stmt, 2, data.c_str(), -1, SQLITE_TRANSIENT);
+    std::string data = serialize_object(obj);
+    // data outlives the step, so SQLite can read it in place
+    sqlite3_bind_text(stmt, 2, data.c_str(), static_cast<int>(data.size()), SQLITE_STATIC);
     sqlite3_step(stmt);
     sqlite3_finalize(stmt);
 
@@ -151,13 +166,16 @@ Object Store::pop() {
         "SELECT o.type_tag, o.data FROM stack s JOIN objects o ON s.object_id = o.id WHERE s.pos = ?",
         -1, &stmt, nullptr);
     sqlite3_bind_int(stmt, 1, d);
-    Object result = Error{2, "Stack read error"};
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
+    // Build the Error only on a miss: it is boxed, so it would allocate
+    Object result;
+    bool found = sqlite3_step(stmt) == SQLITE_ROW;
+    if (found) {
         auto tag = static_cast<TypeTag>(sqlite3_column_int(stmt, 0));
         const char* data = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        result = deserialize(tag, data ? data : "");
+        result = deserialize(tag, data ? data : "", parse_cache_);
     }
     sqlite3_finalize(stmt);
+    if (!found) result = Error{2, "Stack read error"};
 
     // Remove from stack
     sqlite3_prepare_v2(db_, "DELETE FROM stack WHERE pos = ?", -1, &stmt, nullptr);
@@ -181,13 +199,16 @@ Object Store::peek(int level) {
         "SELECT o.type_tag, o.data FROM stack s JOIN objects o ON s.object_id = o.id WHERE s.pos = ?",
         -1, &stmt, nullptr);
     sqlite3_bind_int(stmt, 1, pos);
-    Object result = Error{2, "Stack read error"};
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
+    // Build the Error only on a miss: it is boxed, so it would allocate
+    Object result;
+    bool found = sqlite3_step(stmt) == SQLITE_ROW;
+    if (found) {
         auto tag = static_cast<TypeTag>(sqlite3_column_int(stmt, 0));
         const char* data = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        result = deserialize(tag, data ? data : "");
+        result = deserialize(tag, data ? data : "", parse_cache_);
     }
     sqlite3_finalize(stmt);
+    if (!found) result = Error{2, "Stack read error"};
     return result;
 }
 
@@ -318,8 +339,9 @@ void Store::store_variable(int dir_id, const std::string& name, const Object& ob
     sqlite3_stmt* stmt = nullptr;
     sqlite3_prepare_v2(db_, "INSERT INTO objects (type_tag, data) VALUES (?, ?)", -1, &stmt, nullptr);
     sqlite3_bind_int(stmt, 1, static_cast<int>(type_tag(obj)));
-    std::string data = serialize(obj);
-    sqlite3_bind_text(stmt, 2, data.c_str(), -1, SQLITE_TRANSIENT);
+    std::string data = serialize_object(obj);
+    // data outlives the step, so SQLite can read it in place
+    sqlite3_bind_text(stmt, 2, data.c_str(), static_cast<int>(data.size()), SQLITE_STATIC);
     sqlite3_step(stmt);
     sqlite3_finalize(stmt);
 
@@ -338,6 +360,10 @@ void Store::store_variable(int dir_id, const std::string& name, const Object& ob
 }
 
 Object Store::recall_variable(int dir_id, const std::string& name) {
+    return recall_variable(dir_id, name, nullptr);
+}
+
+Object Store::recall_variable(int dir_id, const std::string& name, SharedTokens* program) {
     sqlite3_stmt* stmt = nullptr;
     sqlite3_prepare_v2(db_,
         "SELECT o.type_tag, o.data FROM variables v JOIN objects o ON v.object_id = o.id "
@@ -346,13 +372,23 @@ Object Store::recall_variable(int dir_id, const std::string& name) {
     sqlite3_bind_int(stmt, 1, dir_id);
     sqlite3_bind_text(stmt, 2, name.c_str(), -1, SQLITE_TRANSIENT);
 
-    Object result = Error{3, "Undefined Name"};
-    if (sqlite3_step(stmt) == SQLITE_ROW) {
+    // Build the Error only on a miss: it is boxed, so it would allocate
+    Object result;
+    bool found = sqlite3_step(stmt) == SQLITE_ROW;
+    if (found) {
         auto tag = static_cast<TypeTag>(sqlite3_column_int(stmt, 0));
         const char* data = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        result = deserialize(tag, data ? data : "");
+        if (program && tag == TypeTag::Program) {
+            std::string text = data ? data : "";
+            *program = parse_cache_ ? parse_cache_->get(text)
+                                    : std::make_shared<const std::vector<Token>>(parse(text));
+            result = Program{};
+        } else {
+            result = deserialize(tag, data ? data : "", parse_cache_);
+        }
     }
     sqlite3_finalize(stmt);
+    if (!found) result = Error{3, "Undefined Name"};
     return result;
 }
 
@@ -564,7 +600,7 @@ void Store::stash_push(const std::vector<Object>& group) {
         // Insert object
         sqlite3_prepare_v2(db_, "INSERT INTO objects (type_tag, data) VALUES (?, ?)", -1, &stmt, nullptr);
         sqlite3_bind_int(stmt, 1, static_cast<int>(type_tag(group[i])));
-        std::string data = serialize(group[i]);
+        std::string data = serialize_object(group[i]);
         sqlite3_bind_text(stmt, 2, data.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_step(stmt);
         sqlite3_finalize(stmt);
@@ -605,7 +641,7 @@ std::vector<Object> Store::stash_pop() {
     while (sqlite3_step(stmt) == SQLITE_ROW) {
         auto tag = static_cast<TypeTag>(sqlite3_column_int(stmt, 0));
         const char* data = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        group.push_back(deserialize(tag, data ? data : ""));
+        group.push_back(deserialize(tag, data ? data : "", parse_cache_));
     }
     sqlite3_finalize(stmt);
 
@@ -716,4 +752,43 @@ std::string Store::input_history_entry(int index) {
     return result;
 }
 
+std::optional<std::tuple<int, std::string, int64_t>> Store::cas_cache_get(const std::string& key) {
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(db_, "SELECT type_tag, data, compute_us FROM cas_cache WHERE key = ?",
+                       -1, &stmt, nullptr);
+    sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_TRANSIENT);
+    std::optional<std::tuple<int, std::string, int64_t>> result;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        int tag = sqlite3_column_int(stmt, 0);
+        const char* data = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        int64_t us = sqlite3_column_int64(stmt, 2);
+        result = std::make_tuple(tag, std::string(data ? data : ""), us);
+    }
+    sqlite3_finalize(stmt);
+    return result;
+}
+
+void Store::cas_cache_put(const std::string& key, int type_tag, const std::string& data,
+                          int64_t compute_us, int max_rows) {
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(db_,
+        "INSERT OR REPLACE INTO cas_cache (key, type_tag, data, compute_us) VALUES (?, ?, ?, ?)",
+        -1, &stmt, nullptr);
+    sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 2, type_tag);
+    sqlite3_bind_text(stmt, 3, data.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 4, compute_us);
+    sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+
+    // Oldest rows go first once the table outgrows its bound
+    sqlite3_prepare_v2(db_,
+        "DELETE FROM cas_cache WHERE rowid NOT IN "
+        "(SELECT rowid FROM cas_cache ORDER BY rowid DESC LIMIT ?)",
+        -1, &stmt, nullptr);
+    sqlite3_bind_int(stmt, 1, max_rows);
+    sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+}
+
 } // namespace lpr
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "core/object.hpp"
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <memory>
@@ -12,6 +13,8 @@ struct sqlite3_stmt;
 
 namespace lpr {
 
+using SharedTokens = std::shared_ptr<const std::vector<Token>>;
+
 class Store {
 public:
     explicit Store(const char* db_path); // nullptr for in-memory
@@ -40,6 +43,9 @@ public:
     // Variables
     void   store_variable(int dir_id, const std::string& name, const Object& obj);
     Object recall_variable(int dir_id, const std::string& name);
+    // As above, except that a Program is not copied out: its shared parsed
+    // tokens go to *program and an empty Program is returned
+    Object recall_variable(int dir_id, const std::string& name, SharedTokens* program);
     bool   purge_variable(int dir_id, const std::string& name);
     std::vector<std::string> list_variables(int dir_id);
 
@@ -82,9 +88,20 @@ public:
     int  input_history_count();
     std::string input_history_entry(int index); // 0 = most recent; empty if out of range
 
+    // Persistent CAS result cache: (type_tag, data, compute_us) by key
+    std::optional<std::tuple<int, std::string, int64_t>> cas_cache_get(const std::string& key);
+    void cas_cache_put(const std::string& key, int type_tag, const std::string& data,
+                       int64_t compute_us, int max_rows);
+
+    // Programs and lists read back from the stack, variables and stash are
+    // parsed through this cache when set
+    void set_parse_cache(ParseCache* cache) { parse_cache_ = cache; }
+
 private:
     sqlite3* db_ = nullptr;
+    ParseCache* parse_cache_ = nullptr;
 
+    std::string serialize_object(const Object& obj);
     void exec_sql(const char* sql);
     void create_schema();
     void ensure_home();
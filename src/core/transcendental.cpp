@@ -0,0 +1,287 @@
+#include "core/transcendental.hpp"
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace lpr {
+
+namespace {
+
+using boost::multiprecision::abs;
+using boost::multiprecision::ldexp;
+using boost::multiprecision::sqrt;
+
+// Series stop once a term is below 10^-(digits+3) relative to the sum. The
+// three guard digits absorb the rounding of the reduction steps.
+const Real& epsilon(int digits) {
+    static const std::array<Real, kMaxPrecision + 1> table = [] {
+        std::array<Real, kMaxPrecision + 1> t;
+        for (int d = 0; d <= kMaxPrecision; ++d) t[d] = Real("1e-" + std::to_string(d + 3));
+        return t;
+    }();
+    return table[std::min(std::max(digits, 0), kMaxPrecision)];
+}
+
+bool fast(int digits) { return digits <= kFastPrecision; }
+
+// Real to double for the fast path. convert_to<double> rounds correctly but
+// goes through a decimal string (microseconds); the leading limbs plus an
+// exact power of ten are within an ulp, which that tier cannot see.
+double to_double(const Real& x) {
+    static const double kPow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                    1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                    1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    if (!boost::multiprecision::isfinite(x)) return x.convert_to<double>();
+    double mantissa = 0;
+    Real::backend_type::exponent_type exponent = 0;
+    x.backend().extract_parts(mantissa, exponent);
+    if (exponent >= 0 && exponent <= 22) return mantissa * kPow10[exponent];
+    if (exponent < 0 && exponent >= -22) return mantissa / kPow10[-exponent];
+    return mantissa * std::pow(10.0, static_cast<double>(exponent));
+}
+
+// atanh(z) = z + z^3/3 + z^5/5 + ... for |z| well below 1
+Real atanh_series(const Real& z, const Real& eps) {
+    Real z2 = z * z;
+    Real power = z, sum = z;
+    Real limit = eps * abs(z);
+    for (unsigned long long n = 3;; n += 2) {
+        power *= z2;
+        Real term = power / n;
+        sum += term;
+        if (abs(term) <= limit) break;
+    }
+    return sum;
+}
+
+// x - x^3/3 + x^5/5 - ... for |x| well below 1
+Real atan_series(const Real& x, const Real& eps) {
+    Real x2 = x * x;
+    Real power = x, sum = x;
+    Real limit = eps * abs(x);
+    for (unsigned long long n = 3;; n += 2) {
+        power *= x2;
+        power = -power;
+        Real term = power / n;
+        sum += term;
+        if (abs(term) <= limit) break;
+    }
+    return sum;
+}
+
+// Taylor series of sin and cos at |r| <= pi/4
+Real sin_series(const Real& r, const Real& eps) {
+    Real r2 = r * r;
+    Real term = r, sum = r;
+    Real limit = eps * abs(r);
+    for (unsigned long long n = 2;; n += 2) {
+        term *= r2;
+        term /= n * (n + 1);
+        term = -term;
+        sum += term;
+        if (abs(term) <= limit) break;
+    }
+    return sum;
+}
+
+Real cos_series(const Real& r, const Real& eps) {
+    Real r2 = r * r;
+    Real term = 1, sum = 1;
+    for (unsigned long long n = 1;; n += 2) {
+        term *= r2;
+        term /= n * (n + 1);
+        term = -term;
+        sum += term;
+        if (abs(term) <= eps) break;
+    }
+    return sum;
+}
+
+// x = k*(pi/2) + r with |r| <= pi/4; returns k mod 4. Past about 10^40 the
+// reduction has no correct digits left, as at any fixed precision.
+int reduce_quadrant(const Real& x, Real& r) {
+    Real half_pi = pi_real() / 2;
+    Real k = boost::multiprecision::round(x / half_pi);
+    r = x - k * half_pi;
+    Real q = k - 4 * boost::multiprecision::floor(k / 4);
+    return q.convert_to<int>();
+}
+
+} // namespace
+
+// ---- Constants ----
+
+const Real& pi_real() {
+    // Gauss-Legendre AGM: each step doubles the correct digits
+    static const Real pi = [] {
+        Real a = 1, b = 1 / sqrt(Real(2)), t = Real(1) / 4, p = 1;
+        for (int i = 0; i < 8; ++i) {
+            Real an = (a + b) / 2;
+            b = sqrt(a * b);
+            t -= p * (a - an) * (a - an);
+            a = an;
+            p *= 2;
+        }
+        return Real((a + b) * (a + b) / (4 * t));
+    }();
+    return pi;
+}
+
+const Real& ln2_real() {
+    // ln 2 = 2 atanh(1/3)
+    static const Real ln2 = 2 * atanh_series(Real(1) / 3, epsilon(kMaxPrecision));
+    return ln2;
+}
+
+const Real& ln10_real() {
+    static const Real ln10 = ln_real(Real(10));
+    return ln10;
+}
+
+Real round_digits(const Real& x, int digits) {
+    if (x == 0 || !boost::multiprecision::isfinite(x)) return x;
+    // Scaling by powers of ten is exact in a decimal float
+    auto shift = digits - 1 - x.backend().order();
+    Real up(Real::backend_type(1.0, shift));
+    Real down(Real::backend_type(1.0, -shift));
+    return boost::multiprecision::round(Real(x * up)) * down;
+}
+
+// ---- Exponential and logarithm ----
+
+Real exp_real(const Real& x, int digits) {
+    if (fast(digits)) return Real(std::exp(to_double(x)));
+    if (x == 0) return 1;
+    // x = k ln2 + r, |r| <= ln2/2; beyond |k| ~ 10^8 the result leaves
+    // Real's exponent range
+    Real k = boost::multiprecision::round(x / ln2_real());
+    if (abs(k) > 100000000) return x > 0 ? std::numeric_limits<Real>::infinity() : Real(0);
+    // e^r = (e^(r/256))^256; the series at r/256 needs few terms
+    Real r = ldexp(Real(x - k * ln2_real()), -8);
+    const Real& eps = epsilon(digits);
+    Real term = 1, sum = 1;
+    for (unsigned long long n = 1;; ++n) {
+        term *= r;
+        term /= n;
+        sum += term;
+        if (abs(term) <= eps) break;
+    }
+    for (int i = 0; i < 8; ++i) sum *= sum;
+    return ldexp(sum, k.convert_to<int>());
+}
+
+Real ln_real(const Real& x, int digits) {
+    if (x <= 0) throw std::runtime_error("Bad argument value");
+    if (fast(digits)) return Real(std::log(to_double(x)));
+    if (x == 1) return 0;
+    // x = m 2^e with m in [1/sqrt2, sqrt2); ln m = 2 atanh((m-1)/(m+1))
+    int e = 0;
+    Real m = boost::multiprecision::frexp(x, &e);
+    static const Real inv_sqrt2 = 1 / sqrt(Real(2));
+    if (m < inv_sqrt2) {
+        m *= 2;
+        --e;
+    }
+    Real result = (m == 1) ? Real(0) : Real(2 * atanh_series((m - 1) / (m + 1), epsilon(digits)));
+    if (e != 0) result += e * ln2_real();
+    return result;
+}
+
+Real log10_real(const Real& x, int digits) {
+    if (x <= 0) throw std::runtime_error("Bad argument value");
+    if (fast(digits)) return Real(std::log10(to_double(x)));
+    return ln_real(x, digits) / ln10_real();
+}
+
+Real alog_real(const Real& x, int digits) {
+    // Integer powers of ten are exact in a decimal float
+    if (x == boost::multiprecision::trunc(x) && abs(x) <= 100000)
+        return Real("1e" + x.convert_to<Integer>().str());
+    if (fast(digits)) return Real(std::pow(10.0, to_double(x)));
+    return exp_real(x * ln10_real(), digits);
+}
+
+// ---- Trigonometry ----
+
+Real sin_real(const Real& x, int digits) {
+    if (fast(digits)) return Real(std::sin(to_double(x)));
+    if (x == 0) return 0;
+    Real r;
+    int q = reduce_quadrant(x, r);
+    const Real& eps = epsilon(digits);
+    switch (q) {
+        case 0: return sin_series(r, eps);
+        case 1: return cos_series(r, eps);
+        case 2: return -sin_series(r, eps);
+        default: return -cos_series(r, eps);
+    }
+}
+
+Real cos_real(const Real& x, int digits) {
+    if (fast(digits)) return Real(std::cos(to_double(x)));
+    if (x == 0) return 1;
+    Real r;
+    int q = reduce_quadrant(x, r);
+    const Real& eps = epsilon(digits);
+    switch (q) {
+        case 0: return cos_series(r, eps);
+        case 1: return -sin_series(r, eps);
+        case 2: return -cos_series(r, eps);
+        default: return sin_series(r, eps);
+    }
+}
+
+Real tan_real(const Real& x, int digits) {
+    if (fast(digits)) return Real(std::tan(to_double(x)));
+    if (x == 0) return 0;
+    Real r;
+    int q = reduce_quadrant(x, r);
+    const Real& eps = epsilon(digits);
+    Real s = sin_series(r, eps), c = cos_series(r, eps);
+    // tan has period pi: odd quadrants give -cot r
+    return (q % 2 == 0) ? Real(s / c) : Real(-c / s);
+}
+
+Real atan_real(const Real& x, int digits) {
+    if (fast(digits)) return Real(std::atan(to_double(x)));
+    if (x == 0) return 0;
+    Real a = abs(x);
+    bool invert = a > 1;
+    if (invert) a = 1 / a;
+    // Two half-angle steps, atan a = 2 atan(a / (1 + sqrt(1 + a^2))),
+    // bring a below 0.2
+    for (int i = 0; i < 2; ++i) a = a / (1 + sqrt(1 + a * a));
+    Real result = ldexp(atan_series(a, epsilon(digits)), 2);
+    if (invert) result = pi_real() / 2 - result;
+    return x < 0 ? Real(-result) : result;
+}
+
+Real asin_real(const Real& x, int digits) {
+    if (x < -1 || x > 1) throw std::runtime_error("Bad argument value");
+    if (fast(digits)) return Real(std::asin(to_double(x)));
+    if (x == 1) return pi_real() / 2;
+    if (x == -1) return -pi_real() / 2;
+    return atan_real(x / sqrt((1 - x) * (1 + x)), digits);
+}
+
+Real acos_real(const Real& x, int digits) {
+    if (x < -1 || x > 1) throw std::runtime_error("Bad argument value");
+    if (fast(digits)) return Real(std::acos(to_double(x)));
+    return pi_real() / 2 - asin_real(x, digits);
+}
+
+Real atan2_real(const Real& y, const Real& x, int digits) {
+    if (fast(digits)) return Real(std::atan2(to_double(y), to_double(x)));
+    if (x > 0) return atan_real(y / x, digits);
+    if (x < 0) {
+        Real a = atan_real(y / x, digits);
+        return y >= 0 ? Real(a + pi_real()) : Real(a - pi_real());
+    }
+    if (y > 0) return pi_real() / 2;
+    if (y < 0) return -pi_real() / 2;
+    return 0;
+}
+
+} // namespace lpr
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "core/object.hpp"
+
+namespace lpr {
+
+// Elementary functions on Real at a working precision in significant digits
+// (PREC). At kFastPrecision digits or fewer they run on hardware double.
+// Above that they reduce the argument and sum a series until its terms drop
+// below the requested precision, so fewer digits cost fewer terms.
+
+constexpr int kFastPrecision = 16;
+constexpr int kMaxPrecision = 50; // Real's digits10
+
+// Constants to full Real precision, computed once
+const Real& pi_real();
+const Real& ln2_real();
+const Real& ln10_real();
+
+// x rounded to the given significant digits. The functions below return
+// every digit they computed so that follow-on steps such as the angle-mode
+// conversion don't compound rounding; results leaving for the stack go
+// through this.
+Real round_digits(const Real& x, int digits);
+
+// Domain errors throw "Bad argument value": ln and log10 of x <= 0, asin and
+// acos outside [-1, 1].
+Real exp_real(const Real& x, int digits = kMaxPrecision);
+Real ln_real(const Real& x, int digits = kMaxPrecision);
+Real log10_real(const Real& x, int digits = kMaxPrecision);
+Real alog_real(const Real& x, int digits = kMaxPrecision);
+
+// Angles in radians
+Real sin_real(const Real& x, int digits = kMaxPrecision);
+Real cos_real(const Real& x, int digits = kMaxPrecision);
+Real tan_real(const Real& x, int digits = kMaxPrecision);
+Real asin_real(const Real& x, int digits = kMaxPrecision);
+Real acos_real(const Real& x, int digits = kMaxPrecision);
+Real atan_real(const Real& x, int digits = kMaxPrecision);
+Real atan2_real(const Real& y, const Real& x, int digits = kMaxPrecision);
+
+} // namespace lpr
@@ -1,7 +1,14 @@
 #include "lpr/lpr.h"
 #include "core/context.hpp"
+#include "core/parser.hpp"
+#include "core/plot.hpp"
+#include <cerrno>
 #include <cstring>
 #include <cstdlib>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include <unistd.h>
 
 struct lpr_ctx {
     lpr::Context context;
@@ -31,6 +38,27 @@ lpr_result lpr_exec(lpr_ctx* ctx, const char* input) {
     return {ok ? 1 : 0};
 }
 
+lpr_result lpr_exec_stream(lpr_ctx* ctx, lpr_read_fn read, void* user,
+                           size_t checkpoint_bytes) {
+    if (!ctx || !read) return {0};
+    bool ok = ctx->context.exec_stream(
+        [&](char* buf, size_t cap) { return read(user, buf, cap); }, checkpoint_bytes);
+    return {ok ? 1 : 0};
+}
+
+lpr_result lpr_exec_fd(lpr_ctx* ctx, int fd, size_t checkpoint_bytes) {
+    if (!ctx || fd < 0) return {0};
+    bool ok = ctx->context.exec_stream(
+        [fd](char* buf, size_t cap) -> long {
+            for (;;) {
+                ssize_t n = ::read(fd, buf, cap);
+                if (n >= 0 || errno != EINTR) return static_cast<long>(n);
+            }
+        },
+        checkpoint_bytes);
+    return {ok ? 1 : 0};
+}
+
 int lpr_depth(lpr_ctx* ctx) {
     if (!ctx) return 0;
     return ctx->context.depth();
@@ -138,6 +166,39 @@ char* lpr_history_entry(lpr_ctx* ctx, int index) {
     return result;
 }
 
+// Sample `fn` (RPL source for a Symbol, Name or Program) over [xmin, xmax].
+// Returns `*count` packed (x, y) pairs; y is NaN at gaps. Nothing the
+// function does to the stack or variables is kept.
+double* lpr_plot_data(lpr_ctx* ctx, const char* fn, const char* var,
+                      double xmin, double xmax, int max_points, int* count) {
+    if (count) *count = 0;
+    if (!ctx || !fn || !var || !count) return nullptr;
+    auto& context = ctx->context;
+    auto& store = context.store();
+    std::vector<double> xy;
+    store.begin();
+    try {
+        auto tokens = lpr::parse(fn);
+        if (tokens.size() != 1) throw std::runtime_error("Bad argument type");
+        lpr::Object obj = tokens[0].kind == lpr::Token::Literal
+            ? tokens[0].literal
+            : lpr::Object(lpr::Name{tokens[0].command});
+        lpr::PlotOptions opts;
+        if (max_points > 0) opts.max_points = static_cast<size_t>(max_points);
+        xy = lpr::sample_plot(lpr::plot_function(obj, var, context), xmin, xmax, opts);
+    } catch (...) {
+        store.rollback();
+        return nullptr;
+    }
+    store.rollback();
+
+    double* buf = static_cast<double*>(std::malloc(std::max<size_t>(xy.size(), 1) * sizeof(double)));
+    if (!buf) return nullptr;
+    std::memcpy(buf, xy.data(), xy.size() * sizeof(double));
+    *count = static_cast<int>(xy.size() / 2);
+    return buf;
+}
+
 void lpr_free(void* ptr) {
     std::free(ptr);
 }
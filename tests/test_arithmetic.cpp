@@ -91,6 +91,18 @@ TEST_CASE("Mixed-type addition promotes to Real", "[arithmetic]") {
     REQUIRE(r.find("3.5") != std::string::npos);
 }
 
+TEST_CASE("Mixed-type operands promote to the wider type", "[arithmetic]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("1 2 3 / +"));
+    REQUIRE(ctx.repr_at(1) == "5/3");
+    REQUIRE(ctx.exec("DROP (1,2) 2 *"));
+    REQUIRE(ctx.repr_at(1) == "(2., 4.)");
+    REQUIRE(ctx.exec("DROP 2 (1,2) -"));
+    REQUIRE(ctx.repr_at(1) == "(1., -2.)");
+    REQUIRE(ctx.exec("DROP 1 3 / 0.5 <"));
+    REQUIRE(ctx.repr_at(1) == "1");
+}
+
 TEST_CASE("Too few arguments produces error", "[arithmetic]") {
     auto ctx = make_ctx();
     REQUIRE_FALSE(ctx.exec("+"));
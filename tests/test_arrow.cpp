@@ -9,8 +9,8 @@ using namespace lpr;
 TEST_CASE("Parser recognizes -> as command inside program", "[arrow][parser]") {
     auto tokens = parse("<< -> X Y 'X*Y' >>");
     REQUIRE(tokens.size() == 1);
-    REQUIRE(std::holds_alternative<Program>(tokens[0].literal));
-    auto& prog = std::get<Program>(tokens[0].literal);
+    REQUIRE(holds_alternative<Program>(tokens[0].literal));
+    auto& prog = get<Program>(tokens[0].literal);
     // Tokens should be: -> X Y 'X*Y'
     REQUIRE(prog.tokens.size() == 4);
     REQUIRE(prog.tokens[0].kind == Token::Command);
@@ -20,21 +20,21 @@ TEST_CASE("Parser recognizes -> as command inside program", "[arrow][parser]") {
     REQUIRE(prog.tokens[2].kind == Token::Command);
     REQUIRE(prog.tokens[2].command == "Y");
     REQUIRE(prog.tokens[3].kind == Token::Literal);
-    REQUIRE(std::holds_alternative<Symbol>(prog.tokens[3].literal));
+    REQUIRE(holds_alternative<Symbol>(prog.tokens[3].literal));
 }
 
 TEST_CASE("Parser recognizes UTF-8 arrow as command inside program", "[arrow][parser]") {
     auto tokens = parse("<< \xe2\x86\x92 X Y << X Y * >> >>");
     REQUIRE(tokens.size() == 1);
-    REQUIRE(std::holds_alternative<Program>(tokens[0].literal));
-    auto& prog = std::get<Program>(tokens[0].literal);
+    REQUIRE(holds_alternative<Program>(tokens[0].literal));
+    auto& prog = get<Program>(tokens[0].literal);
     // Tokens should be: → X Y <program>
     REQUIRE(prog.tokens.size() == 4);
     REQUIRE(prog.tokens[0].kind == Token::Command);
     // UTF-8 arrow command (case preserved)
     REQUIRE(prog.tokens[0].command == "\xe2\x86\x92");
     REQUIRE(prog.tokens[3].kind == Token::Literal);
-    REQUIRE(std::holds_alternative<Program>(prog.tokens[3].literal));
+    REQUIRE(holds_alternative<Program>(prog.tokens[3].literal));
 }
 
 // --- Execution tests ---
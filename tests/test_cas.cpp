@@ -327,3 +327,77 @@ TEST_CASE("Undo restores pre-DIFF state", "[cas][integration]") {
     REQUIRE(ctx.depth() == 1);
     REQUIRE(ctx.repr_at(1) == before);
 }
+
+TEST_CASE("Chained CAS commands on one expression", "[cas][conversion]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("'(X+1)^2' EXPAND 'X' DIFF"));
+    check_symbol(ctx, "'2 + 2*X'");
+    REQUIRE(ctx.exec("SIMPLIFY"));
+    check_symbol(ctx, "'2 + 2*X'");
+}
+
+TEST_CASE("CAS reads -X^2 as -(X^2)", "[cas][conversion]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("'-X^2' 'X' DIFF"));
+    check_symbol(ctx, "'-2*X'");
+    // Built on the stack, the negation is grouped: (-X)^2
+    REQUIRE(ctx.exec("CLEAR 'X' NEG 2 ^ 'X' DIFF"));
+    check_symbol(ctx, "'2*X'");
+}
+
+TEST_CASE("CAS results print with RPL function names", "[cas][conversion]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("'EXP(2*X)' 'X' DIFF"));
+    check_symbol(ctx, "'2*EXP(2*X)'");
+}
+
+// ============================================================
+// Batched operations over Lists and Matrices
+// ============================================================
+
+TEST_CASE("DIFF over a List differentiates each element", "[cas][batch]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("{ 'X^2' 'SIN(X)' X 5 } 'X' DIFF"));
+    REQUIRE(ctx.repr_at(1) == "{ '2*X' 'COS(X)' '1' '0' }");
+}
+
+TEST_CASE("DIFF over a Matrix keeps its shape", "[cas][batch]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("[[ 'X^2' 'X*Y' ][ 'Y' '3*X' ]] 'X' DIFF"));
+    REQUIRE(ctx.repr_at(1) == "[[ '2*X' 'Y' ][ '0' '3' ]]");
+}
+
+TEST_CASE("GRADIENT and JACOBIAN", "[cas][batch]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("'X^2*Y' { X Y } GRADIENT"));
+    REQUIRE(ctx.repr_at(1) == "{ '2*X*Y' 'X^2' }");
+    REQUIRE(ctx.exec("CLEAR { 'X*Y' 'X+Y' } { X Y } JACOBIAN"));
+    REQUIRE(ctx.repr_at(1) == "[[ 'Y' 'X' ][ '1' '1' ]]");
+    // DIFF with a List of variables is the gradient
+    REQUIRE(ctx.exec("CLEAR 'X*Y' { X Y } DIFF"));
+    REQUIRE(ctx.repr_at(1) == "{ 'Y' 'X' }");
+}
+
+TEST_CASE("SIMPLIFY and EXPAND over a List", "[cas][batch]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("{ '(X+1)^2' '2*(X+1)' } EXPAND"));
+    REQUIRE(ctx.repr_at(1) == "{ '1 + 2*X + X^2' '2 + 2*X' }");
+    REQUIRE(ctx.exec("CLEAR { 'X+X' 'Y*Y' } SIMPLIFY"));
+    REQUIRE(ctx.repr_at(1) == "{ '2*X' 'Y^2' }");
+}
+
+TEST_CASE("Batched CAS errors", "[cas][batch]") {
+    auto ctx = make_ctx();
+    REQUIRE_FALSE(ctx.exec("{ 'X' \"s\" } 'X' DIFF"));
+    REQUIRE_FALSE(ctx.exec("{ 'X*Y' } { X Y } DIFF"));
+    REQUIRE_FALSE(ctx.exec("{ } { X } JACOBIAN"));
+}
+
+TEST_CASE("PMAP over CAS commands runs serially and matches MAP", "[cas][parallel]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("4 PWORKERS"));
+    REQUIRE(ctx.exec("{ 'X^2' 'X^3' 'X^4' 'X^5' 'X^6' 'X^7' 'X^8' 'X^9' } DUP"));
+    REQUIRE(ctx.exec("\xC2\xAB 'X' DIFF \xC2\xBB PMAP SWAP \xC2\xAB 'X' DIFF \xC2\xBB MAP"));
+    REQUIRE(ctx.repr_at(1) == ctx.repr_at(2));
+    REQUIRE(ctx.repr_at(1) == "{ '2*X' '3*X^2' '4*X^3' '5*X^4' '6*X^5' '7*X^6' '8*X^7' '9*X^8' }");
+}
@@ -0,0 +1,166 @@
+#include <catch2/catch_test_macros.hpp>
+#include "cas/caching_bridge.hpp"
+#include "core/context.hpp"
+#include "core/store.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+
+using namespace lpr;
+
+// Stand-in CAS that counts calls and tags its answers with the operation.
+class CountingBridge : public CASBridge {
+public:
+    int calls = 0;
+
+    Object differentiate(const Object& e, const std::string& var) override {
+        return answer("D", e, var);
+    }
+    Object integrate(const Object& e, const std::string& var) override {
+        return answer("I", e, var);
+    }
+    Object solve(const Object&, const std::string&) override {
+        ++calls;
+        return List{{Symbol("0")}};
+    }
+    Object simplify(const Object& e) override { return answer("S", e, ""); }
+    Object expand(const Object& e) override { return answer("E", e, ""); }
+    Object factor(const Object&) override {
+        ++calls;
+        throw std::runtime_error("FACTOR: failed");
+    }
+
+private:
+    Object answer(const std::string& op, const Object& e, const std::string& var) {
+        ++calls;
+        if (!holds_alternative<Symbol>(e)) throw std::runtime_error("Bad argument type");
+        return Symbol(op + "(" + get<Symbol>(e).value() + var + ")");
+    }
+};
+
+TEST_CASE("CAS cache returns repeated results without recomputing", "[cas][cache]") {
+    Store store(nullptr);
+    auto inner = std::make_unique<CountingBridge>();
+    CountingBridge* counter = inner.get();
+    CachingCASBridge cas(std::move(inner), store);
+
+    auto a = cas.differentiate(Symbol("X^2+1"), "X");
+    auto b = cas.differentiate(Symbol("X^2+1"), "X");
+    REQUIRE(repr(a) == repr(b));
+    REQUIRE(counter->calls == 1);
+    REQUIRE(cas.hits() == 1);
+    REQUIRE(cas.misses() == 1);
+
+    // Operation and variable are part of the key
+    cas.differentiate(Symbol("X^2+1"), "Y");
+    cas.integrate(Symbol("X^2+1"), "X");
+    REQUIRE(counter->calls == 3);
+
+    // Keys use the canonical rendering, so spacing does not matter
+    cas.differentiate(Symbol("X ^ 2 + 1"), "X");
+    REQUIRE(counter->calls == 3);
+    REQUIRE(cas.hits() == 2);
+}
+
+TEST_CASE("CAS cache does not cache errors or non-symbolic input", "[cas][cache]") {
+    Store store(nullptr);
+    auto inner = std::make_unique<CountingBridge>();
+    CountingBridge* counter = inner.get();
+    CachingCASBridge cas(std::move(inner), store);
+
+    REQUIRE_THROWS(cas.factor(Symbol("X")));
+    REQUIRE_THROWS(cas.factor(Symbol("X")));
+    REQUIRE(counter->calls == 2);
+
+    REQUIRE_THROWS(cas.simplify(Integer(3)));
+    REQUIRE(cas.size() == 0);
+}
+
+TEST_CASE("CAS cache evicts least recently used entries by size", "[cas][cache]") {
+    Store store(nullptr);
+    auto inner = std::make_unique<CountingBridge>();
+    CountingBridge* counter = inner.get();
+    CachingCASBridge cas(std::move(inner), store, 400);
+
+    cas.expand(Symbol("A"));
+    cas.expand(Symbol("B"));
+    cas.expand(Symbol("A")); // A is now most recent
+    for (int i = 0; i < 8; ++i) cas.expand(Symbol("C" + std::to_string(i)));
+    REQUIRE(cas.bytes() <= 400);
+    REQUIRE(cas.size() < 10);
+
+    int before = counter->calls;
+    cas.expand(Symbol("C7"));
+    REQUIRE(counter->calls == before);
+    cas.expand(Symbol("B"));
+    REQUIRE(counter->calls == before + 1);
+}
+
+TEST_CASE("CASCACHE persists results in the database", "[cas][cache]") {
+    auto path = (std::filesystem::temp_directory_path() / "lpr_cas_cache_test.lpr").string();
+    std::remove(path.c_str());
+    {
+        Store store(path.c_str());
+        auto inner = std::make_unique<CountingBridge>();
+        CachingCASBridge cas(std::move(inner), store);
+        store.set_meta("cas_cache_persist", "1");
+        cas.simplify(Symbol("X+X"));
+        cas.solve(Symbol("X"), "X");
+    }
+    {
+        Store store(path.c_str());
+        auto inner = std::make_unique<CountingBridge>();
+        CountingBridge* counter = inner.get();
+        CachingCASBridge cas(std::move(inner), store);
+        REQUIRE(repr(cas.simplify(Symbol("X + X"))) == "'S(X+X)'");
+        REQUIRE(repr(cas.solve(Symbol("X"), "X")) == "{ '0' }");
+        REQUIRE(counter->calls == 0);
+
+        store.set_meta("cas_cache_persist", "0");
+        cas.simplify(Symbol("Y+Y"));
+        REQUIRE(counter->calls == 1);
+        REQUIRE_FALSE(store.cas_cache_get("SIMPLIFY\x1fY+Y\x1f"));
+    }
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+}
+
+TEST_CASE("CASCACHE validates its argument", "[cas][cache]") {
+    Context ctx(nullptr);
+    REQUIRE(ctx.exec("1 CASCACHE"));
+    REQUIRE(ctx.store().get_meta("cas_cache_persist") == "1");
+    REQUIRE_FALSE(ctx.exec("2 CASCACHE"));
+    REQUIRE_FALSE(ctx.exec("\"1\" CASCACHE"));
+}
+
+TEST_CASE("PERFSTATS reports CAS cache counters", "[cas][cache]") {
+    Context ctx(nullptr);
+    REQUIRE(ctx.exec("PERFSTATS"));
+    std::string r = ctx.repr_at(1);
+    REQUIRE(r.find("\"cas_cache_hits\"") != std::string::npos);
+    REQUIRE(r.find("\"cas_cache_saved_us\"") != std::string::npos);
+}
+
+TEST_CASE("Batched CAS calls only send cache misses to the CAS", "[cas][cache][batch]") {
+    Store store(nullptr);
+    auto inner = std::make_unique<CountingBridge>();
+    CountingBridge* counter = inner.get();
+    CachingCASBridge cas(std::move(inner), store);
+
+    cas.differentiate(Symbol("A"), "X");
+    auto out = cas.apply_batch(CASOp::Diff, {Symbol("A"), Symbol("B")}, {"X", "Y"});
+    REQUIRE(out.size() == 4);
+    REQUIRE(repr(out[0]) == "'D(AX)'");
+    REQUIRE(repr(out[3]) == "'D(BY)'");
+    // A/Y was missing, so A went again with B: 1 + 4 calls
+    REQUIRE(counter->calls == 5);
+
+    auto again = cas.apply_batch(CASOp::Diff, {Symbol("A"), Symbol("B")}, {"X", "Y"});
+    REQUIRE(counter->calls == 5);
+    REQUIRE(repr(again[2]) == "'D(BX)'");
+
+    auto simplified = cas.apply_batch(CASOp::Simplify, {Symbol("A"), Symbol("C")}, {"ignored"});
+    REQUIRE(simplified.size() == 2);
+    REQUIRE(repr(simplified[1]) == "'S(C)'");
+}
@@ -0,0 +1,126 @@
+#include <catch2/catch_test_macros.hpp>
+#include "cas/guarded_bridge.hpp"
+#include "core/context.hpp"
+#include "core/store.hpp"
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+using namespace lpr;
+
+// Stand-in CAS: SIMPLIFY sleeps for the number of milliseconds in the
+// expression text, everything else answers at once.
+class SleepyBridge : public CASBridge {
+public:
+    Object differentiate(const Object& e, const std::string&) override { return e; }
+    Object integrate(const Object& e, const std::string&) override { return e; }
+    Object solve(const Object&, const std::string&) override {
+        throw std::runtime_error("SOLVE: no solution");
+    }
+    Object simplify(const Object& e) override {
+        int ms = std::stoi(get<Symbol>(e).value());
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+        return e;
+    }
+    Object expand(const Object& e) override { return e; }
+    Object factor(const Object& e) override { return e; }
+};
+
+static GuardedCASBridge::Factory counting_factory(int& made) {
+    return [&made] {
+        ++made;
+        return std::make_unique<SleepyBridge>();
+    };
+}
+
+TEST_CASE("CAS calls that overrun the time limit fail and the bridge recovers", "[cas][limits]") {
+    Store store(nullptr);
+    int made = 0;
+    GuardedCASBridge cas(counting_factory(made), store);
+    store.set_meta("cas_timeout_ms", "50");
+
+    REQUIRE(repr(cas.simplify(Symbol("1"))) == "'1'");
+    REQUIRE(made == 1);
+
+    auto start = std::chrono::steady_clock::now();
+    REQUIRE_THROWS_WITH(cas.simplify(Symbol("2000")), "SIMPLIFY: timed out after 50 ms");
+    REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(1000));
+    REQUIRE(cas.timeouts() == 1);
+
+    // The next call gets a fresh bridge on a fresh worker
+    REQUIRE(repr(cas.expand(Symbol("X+1"))) == "'X+1'");
+    REQUIRE(made == 2);
+}
+
+TEST_CASE("CAS errors pass through the worker", "[cas][limits]") {
+    Store store(nullptr);
+    int made = 0;
+    GuardedCASBridge cas(counting_factory(made), store);
+    REQUIRE_THROWS_WITH(cas.solve(Symbol("X"), "X"), "SOLVE: no solution");
+    store.set_meta("cas_timeout_ms", "0"); // inline
+    REQUIRE_THROWS_WITH(cas.solve(Symbol("X"), "X"), "SOLVE: no solution");
+    REQUIRE(made == 1);
+}
+
+TEST_CASE("CAS inputs over the size limit are refused", "[cas][limits]") {
+    Store store(nullptr);
+    int made = 0;
+    GuardedCASBridge cas(counting_factory(made), store);
+    store.set_meta("cas_max_nodes", "10");
+    REQUIRE_NOTHROW(cas.differentiate(Symbol("X^2+3*X"), "X"));
+    REQUIRE_THROWS_WITH(cas.differentiate(Symbol("X+X+X+X+X+X+X"), "X"),
+                        "DIFF: expression too complex");
+    store.set_meta("cas_max_nodes", "0");
+    REQUIRE_NOTHROW(cas.differentiate(Symbol("X+X+X+X+X+X+X"), "X"));
+}
+
+TEST_CASE("CAS latency percentiles are reported", "[cas][limits]") {
+    Store store(nullptr);
+    int made = 0;
+    GuardedCASBridge cas(counting_factory(made), store);
+    for (int i = 0; i < 5; ++i) cas.expand(Symbol("X"));
+    auto stats = cas.stats();
+    auto find = [&](const std::string& name) -> const int64_t* {
+        for (const auto& [key, value] : stats) {
+            if (key == name) return &value;
+        }
+        return nullptr;
+    };
+    REQUIRE(find("cas_expand_calls") != nullptr);
+    REQUIRE(*find("cas_expand_calls") == 5);
+    REQUIRE(find("cas_expand_p99_us") != nullptr);
+    REQUIRE(*find("cas_expand_p50_us") <= *find("cas_expand_p99_us"));
+    REQUIRE(find("cas_diff_calls") == nullptr);
+}
+
+TEST_CASE("CASLIMIT sets the CAS budget", "[cas][limits]") {
+    Context ctx(nullptr);
+    REQUIRE(ctx.exec("2000 500 CASLIMIT"));
+    REQUIRE(ctx.store().get_meta("cas_timeout_ms") == "2000");
+    REQUIRE(ctx.store().get_meta("cas_max_nodes") == "500");
+    REQUIRE_FALSE(ctx.exec("-1 0 CASLIMIT"));
+    REQUIRE_FALSE(ctx.exec("1. 0 CASLIMIT"));
+}
+
+TEST_CASE("A batch is one guarded call with a size check per element", "[cas][limits][batch]") {
+    Store store(nullptr);
+    int made = 0;
+    GuardedCASBridge cas(counting_factory(made), store);
+    auto out = cas.apply_batch(CASOp::Expand, {Symbol("X"), Symbol("Y")}, {});
+    REQUIRE(out.size() == 2);
+    REQUIRE(repr(out[1]) == "'Y'");
+    auto stats = cas.stats();
+    bool one_call = false;
+    for (const auto& [key, value] : stats) {
+        if (key == "cas_expand_calls") one_call = value == 1;
+    }
+    REQUIRE(one_call);
+
+    // Together these are over the limit, but each one is within it
+    store.set_meta("cas_max_nodes", "8");
+    std::vector<Object> many(3, Symbol("X+Y"));
+    REQUIRE(cas.apply_batch(CASOp::Expand, many, {}).size() == 3);
+    many.push_back(Symbol("X+X+X+X+X+X+X"));
+    REQUIRE_THROWS_WITH(cas.apply_batch(CASOp::Expand, many, {}), "EXPAND: expression too complex");
+}
@@ -119,8 +119,8 @@ TEST_CASE("SF and FS? set and test boolean flag", "[flags]") {
     ctx.exec("'exact_mode' SF");
     ctx.exec("'exact_mode' FS?");
     Object result = ctx.store().peek(1);
-    REQUIRE(std::holds_alternative<Integer>(result));
-    REQUIRE(std::get<Integer>(result) == 1);
+    REQUIRE(holds_alternative<Integer>(result));
+    REQUIRE(get<Integer>(result) == 1);
 }
 
 TEST_CASE("CF clears boolean flag", "[flags]") {
@@ -129,16 +129,16 @@ TEST_CASE("CF clears boolean flag", "[flags]") {
     ctx.exec("'exact_mode' CF");
     ctx.exec("'exact_mode' FS?");
     Object result = ctx.store().peek(1);
-    REQUIRE(std::holds_alternative<Integer>(result));
-    REQUIRE(std::get<Integer>(result) == 0);
+    REQUIRE(holds_alternative<Integer>(result));
+    REQUIRE(get<Integer>(result) == 0);
 }
 
 TEST_CASE("FC? returns 1 for nonexistent flag", "[flags]") {
     auto ctx = make_ctx();
     ctx.exec("'nonexistent' FC?");
     Object result = ctx.store().peek(1);
-    REQUIRE(std::holds_alternative<Integer>(result));
-    REQUIRE(std::get<Integer>(result) == 1);
+    REQUIRE(holds_alternative<Integer>(result));
+    REQUIRE(get<Integer>(result) == 1);
 }
 
 TEST_CASE("FC? returns 0 for set flag", "[flags]") {
@@ -146,8 +146,8 @@ TEST_CASE("FC? returns 0 for set flag", "[flags]") {
     ctx.exec("'myflag' SF");
     ctx.exec("'myflag' FC?");
     Object result = ctx.store().peek(1);
-    REQUIRE(std::holds_alternative<Integer>(result));
-    REQUIRE(std::get<Integer>(result) == 0);
+    REQUIRE(holds_alternative<Integer>(result));
+    REQUIRE(get<Integer>(result) == 0);
 }
 
 TEST_CASE("SFLAG/RFLAG store and recall integer", "[flags]") {
@@ -155,8 +155,8 @@ TEST_CASE("SFLAG/RFLAG store and recall integer", "[flags]") {
     ctx.exec("1000 'max_iterations' SFLAG");
     ctx.exec("'max_iterations' RFLAG");
     Object result = ctx.store().peek(1);
-    REQUIRE(std::holds_alternative<Integer>(result));
-    REQUIRE(std::get<Integer>(result) == 1000);
+    REQUIRE(holds_alternative<Integer>(result));
+    REQUIRE(get<Integer>(result) == 1000);
 }
 
 TEST_CASE("SFLAG/RFLAG store and recall string", "[flags]") {
@@ -164,8 +164,8 @@ TEST_CASE("SFLAG/RFLAG store and recall string", "[flags]") {
     ctx.exec("\"hello\" 'greeting' SFLAG");
     ctx.exec("'greeting' RFLAG");
     Object result = ctx.store().peek(1);
-    REQUIRE(std::holds_alternative<String>(result));
-    REQUIRE(std::get<String>(result).value == "hello");
+    REQUIRE(holds_alternative<String>(result));
+    REQUIRE(get<String>(result).value == "hello");
 }
 
 TEST_CASE("RFLAG on nonexistent flag errors", "[flags]") {
@@ -180,16 +180,16 @@ TEST_CASE("STOF/RCLF bulk round-trip", "[flags]") {
     ctx.exec("1000 'max_iterations' SFLAG");
     ctx.exec("STOF");
     Object saved = ctx.store().peek(1);
-    REQUIRE(std::holds_alternative<List>(saved));
-    auto& list = std::get<List>(saved);
+    REQUIRE(holds_alternative<List>(saved));
+    auto& list = get<List>(saved);
     REQUIRE(list.items.size() == 2);
 
     // Clear and restore
     ctx.exec("RCLF");
     ctx.exec("'exact_mode' FS?");
     Object result = ctx.store().peek(1);
-    REQUIRE(std::holds_alternative<Integer>(result));
-    REQUIRE(std::get<Integer>(result) == 1);
+    REQUIRE(holds_alternative<Integer>(result));
+    REQUIRE(get<Integer>(result) == 1);
 }
 
 // ===== 8.4 ->Q rational approximation =====
@@ -198,8 +198,8 @@ TEST_CASE("->Q approximates 0.5 as 1/2", "[conversion]") {
     auto ctx = make_ctx();
     ctx.exec("0.5 ->Q");
     Object result = ctx.store().peek(1);
-    REQUIRE(std::holds_alternative<Rational>(result));
-    auto& r = std::get<Rational>(result);
+    REQUIRE(holds_alternative<Rational>(result));
+    auto& r = get<Rational>(result);
     REQUIRE(boost::multiprecision::numerator(r) == 1);
     REQUIRE(boost::multiprecision::denominator(r) == 2);
 }
@@ -208,8 +208,8 @@ TEST_CASE("->Q approximates pi", "[conversion]") {
     auto ctx = make_ctx();
     ctx.exec("3.14159265358979 ->Q");
     Object result = ctx.store().peek(1);
-    REQUIRE(std::holds_alternative<Rational>(result));
-    auto& r = std::get<Rational>(result);
+    REQUIRE(holds_alternative<Rational>(result));
+    auto& r = get<Rational>(result);
     // Should be 355/113 or similar good approximation
     double approx = boost::multiprecision::numerator(r).convert_to<double>() /
                     boost::multiprecision::denominator(r).convert_to<double>();
@@ -220,8 +220,8 @@ TEST_CASE("->Q on Integer wraps to rational", "[conversion]") {
     auto ctx = make_ctx();
     ctx.exec("5 ->Q");
     Object result = ctx.store().peek(1);
-    REQUIRE(std::holds_alternative<Rational>(result));
-    auto& r = std::get<Rational>(result);
+    REQUIRE(holds_alternative<Rational>(result));
+    auto& r = get<Rational>(result);
     REQUIRE(boost::multiprecision::numerator(r) == 5);
     REQUIRE(boost::multiprecision::denominator(r) == 1);
 }
@@ -232,8 +232,8 @@ TEST_CASE("HMS-> converts H.MMSSss to decimal", "[conversion]") {
     auto ctx = make_ctx();
     ctx.exec("2.3000 HMS->");
     Object result = ctx.store().peek(1);
-    REQUIRE(std::holds_alternative<Real>(result));
-    double val = std::get<Real>(result).convert_to<double>();
+    REQUIRE(holds_alternative<Real>(result));
+    double val = get<Real>(result).convert_to<double>();
     REQUIRE(std::fabs(val - 2.5) < 1e-10);
 }
 
@@ -241,8 +241,8 @@ TEST_CASE("->HMS converts decimal to H.MMSSss", "[conversion]") {
     auto ctx = make_ctx();
     ctx.exec("2.5 ->HMS");
     Object result = ctx.store().peek(1);
-    REQUIRE(std::holds_alternative<Real>(result));
-    double val = std::get<Real>(result).convert_to<double>();
+    REQUIRE(holds_alternative<Real>(result));
+    double val = get<Real>(result).convert_to<double>();
     REQUIRE(std::fabs(val - 2.3) < 1e-10);
 }
 
@@ -250,8 +250,8 @@ TEST_CASE("HMS round-trip", "[conversion]") {
     auto ctx = make_ctx();
     ctx.exec("1.4530 HMS-> ->HMS");
     Object result = ctx.store().peek(1);
-    REQUIRE(std::holds_alternative<Real>(result));
-    double val = std::get<Real>(result).convert_to<double>();
+    REQUIRE(holds_alternative<Real>(result));
+    double val = get<Real>(result).convert_to<double>();
     REQUIRE(std::fabs(val - 1.4530) < 1e-8);
 }
 
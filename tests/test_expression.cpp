@@ -9,36 +9,36 @@ using namespace lpr;
 TEST_CASE("Expression: simple addition", "[expression]") {
     Context ctx(nullptr);
     Object r = eval_expression("2+3", ctx);
-    REQUIRE(std::holds_alternative<Integer>(r));
-    REQUIRE(std::get<Integer>(r) == 5);
+    REQUIRE(holds_alternative<Integer>(r));
+    REQUIRE(get<Integer>(r) == 5);
 }
 
 TEST_CASE("Expression: subtraction", "[expression]") {
     Context ctx(nullptr);
     Object r = eval_expression("10-4", ctx);
-    REQUIRE(std::get<Integer>(r) == 6);
+    REQUIRE(get<Integer>(r) == 6);
 }
 
 TEST_CASE("Expression: multiplication", "[expression]") {
     Context ctx(nullptr);
     Object r = eval_expression("6*7", ctx);
-    REQUIRE(std::get<Integer>(r) == 42);
+    REQUIRE(get<Integer>(r) == 42);
 }
 
 TEST_CASE("Expression: division produces rational", "[expression]") {
     Context ctx(nullptr);
     Object r = eval_expression("7/2", ctx);
-    REQUIRE(std::holds_alternative<Rational>(r));
+    REQUIRE(holds_alternative<Rational>(r));
     Rational expected(Integer(7), Integer(2));
-    REQUIRE(std::get<Rational>(r) == expected);
+    REQUIRE(get<Rational>(r) == expected);
 }
 
 TEST_CASE("Expression: power", "[expression]") {
     Context ctx(nullptr);
     Object r = eval_expression("2^10", ctx);
     // Power promotes to Real
-    REQUIRE(std::holds_alternative<Real>(r));
-    REQUIRE(std::get<Real>(r) == Real(1024));
+    REQUIRE(holds_alternative<Real>(r));
+    REQUIRE(get<Real>(r) == Real(1024));
 }
 
 // --- Precedence ---
@@ -46,15 +46,15 @@ TEST_CASE("Expression: power", "[expression]") {
 TEST_CASE("Expression: multiplication before addition", "[expression]") {
     Context ctx(nullptr);
     Object r = eval_expression("2+3*4", ctx);
-    REQUIRE(std::get<Integer>(r) == 14);
+    REQUIRE(get<Integer>(r) == 14);
 }
 
 TEST_CASE("Expression: power before multiplication", "[expression]") {
     Context ctx(nullptr);
     // 2*3^2 = 2*9 = 18
     Object r = eval_expression("2*3^2", ctx);
-    REQUIRE(std::holds_alternative<Real>(r));
-    REQUIRE(std::get<Real>(r) == Real(18));
+    REQUIRE(holds_alternative<Real>(r));
+    REQUIRE(get<Real>(r) == Real(18));
 }
 
 // --- Parentheses ---
@@ -62,13 +62,13 @@ TEST_CASE("Expression: power before multiplication", "[expression]") {
 TEST_CASE("Expression: parentheses override precedence", "[expression]") {
     Context ctx(nullptr);
     Object r = eval_expression("(2+3)*4", ctx);
-    REQUIRE(std::get<Integer>(r) == 20);
+    REQUIRE(get<Integer>(r) == 20);
 }
 
 TEST_CASE("Expression: nested parentheses", "[expression]") {
     Context ctx(nullptr);
     Object r = eval_expression("((1+2)*(3+4))", ctx);
-    REQUIRE(std::get<Integer>(r) == 21);
+    REQUIRE(get<Integer>(r) == 21);
 }
 
 // --- Unary negation ---
@@ -76,13 +76,13 @@ TEST_CASE("Expression: nested parentheses", "[expression]") {
 TEST_CASE("Expression: unary negation", "[expression]") {
     Context ctx(nullptr);
     Object r = eval_expression("-5+3", ctx);
-    REQUIRE(std::get<Integer>(r) == -2);
+    REQUIRE(get<Integer>(r) == -2);
 }
 
 TEST_CASE("Expression: negation in parentheses", "[expression]") {
     Context ctx(nullptr);
     Object r = eval_expression("(-3)*(-4)", ctx);
-    REQUIRE(std::get<Integer>(r) == 12);
+    REQUIRE(get<Integer>(r) == 12);
 }
 
 // --- Variables ---
@@ -91,7 +91,7 @@ TEST_CASE("Expression: global variable", "[expression]") {
     Context ctx(nullptr);
     ctx.exec("10 'X' STO");
     Object r = eval_expression("X*X", ctx);
-    REQUIRE(std::get<Integer>(r) == 100);
+    REQUIRE(get<Integer>(r) == 100);
 }
 
 TEST_CASE("Expression: local variable", "[expression]") {
@@ -100,7 +100,7 @@ TEST_CASE("Expression: local variable", "[expression]") {
     frame["A"] = Integer(7);
     ctx.push_locals(frame);
     Object r = eval_expression("A+3", ctx);
-    REQUIRE(std::get<Integer>(r) == 10);
+    REQUIRE(get<Integer>(r) == 10);
     ctx.pop_locals();
 }
 
@@ -111,7 +111,7 @@ TEST_CASE("Expression: local shadows global", "[expression]") {
     frame["X"] = Integer(5);
     ctx.push_locals(frame);
     Object r = eval_expression("X", ctx);
-    REQUIRE(std::get<Integer>(r) == 5);
+    REQUIRE(get<Integer>(r) == 5);
     ctx.pop_locals();
 }
 
@@ -120,7 +120,7 @@ TEST_CASE("Expression: local shadows global", "[expression]") {
 TEST_CASE("Expression: real number literal", "[expression]") {
     Context ctx(nullptr);
     Object r = eval_expression("3.14*2", ctx);
-    REQUIRE(std::holds_alternative<Real>(r));
+    REQUIRE(holds_alternative<Real>(r));
 }
 
 // --- Spaces ---
@@ -128,7 +128,7 @@ TEST_CASE("Expression: real number literal", "[expression]") {
 TEST_CASE("Expression: with spaces", "[expression]") {
     Context ctx(nullptr);
     Object r = eval_expression("2 + 3 * 4", ctx);
-    REQUIRE(std::get<Integer>(r) == 14);
+    REQUIRE(get<Integer>(r) == 14);
 }
 
 // --- Integration: EVAL on Symbol ---
@@ -169,15 +169,15 @@ TEST_CASE("EVAL on Symbol: complex expression", "[expression][eval]") {
 TEST_CASE("EVAL exact: sqrt of non-perfect square stays symbolic", "[expression][eval]") {
     Context ctx(nullptr);
     Object r = eval_expression("sqrt(14)", ctx);
-    REQUIRE(std::holds_alternative<Symbol>(r));
-    REQUIRE(std::get<Symbol>(r).value == "SQRT(14)");
+    REQUIRE(holds_alternative<Symbol>(r));
+    REQUIRE(get<Symbol>(r).value() == "SQRT(14)");
 }
 
 TEST_CASE("EVAL exact: sqrt of perfect square returns integer", "[expression][eval]") {
     Context ctx(nullptr);
     Object r = eval_expression("sqrt(4)", ctx);
-    REQUIRE(std::holds_alternative<Integer>(r));
-    REQUIRE(std::get<Integer>(r) == 2);
+    REQUIRE(holds_alternative<Integer>(r));
+    REQUIRE(get<Integer>(r) == 2);
 }
 
 TEST_CASE("EVAL exact: expression with irrational stays symbolic", "[expression][eval]") {
@@ -185,22 +185,22 @@ TEST_CASE("EVAL exact: expression with irrational stays symbolic", "[expression]
     REQUIRE(ctx.exec("'sqrt(2+12)/((2+3)*(8-2))' EVAL"));
     REQUIRE(ctx.depth() == 1);
     auto obj = ctx.store().pop();
-    REQUIRE(std::holds_alternative<Symbol>(obj));
-    REQUIRE(std::get<Symbol>(obj).value == "SQRT(14)/30");
+    REQUIRE(holds_alternative<Symbol>(obj));
+    REQUIRE(get<Symbol>(obj).value() == "SQRT(14)/30");
 }
 
 TEST_CASE("EVAL exact: pure arithmetic still numeric", "[expression][eval]") {
     Context ctx(nullptr);
     Object r = eval_expression("2+3", ctx);
-    REQUIRE(std::holds_alternative<Integer>(r));
-    REQUIRE(std::get<Integer>(r) == 5);
+    REQUIRE(holds_alternative<Integer>(r));
+    REQUIRE(get<Integer>(r) == 5);
 }
 
 TEST_CASE("EVAL exact: rational result stays rational", "[expression][eval]") {
     Context ctx(nullptr);
     Object r = eval_expression("1/3+1/6", ctx);
-    REQUIRE(std::holds_alternative<Rational>(r));
-    REQUIRE(std::get<Rational>(r) == Rational(Integer(1), Integer(2)));
+    REQUIRE(holds_alternative<Rational>(r));
+    REQUIRE(get<Rational>(r) == Rational(Integer(1), Integer(2)));
 }
 
 TEST_CASE("->NUM on symbolic expression", "[expression][eval]") {
@@ -208,7 +208,7 @@ TEST_CASE("->NUM on symbolic expression", "[expression][eval]") {
     REQUIRE(ctx.exec("'sqrt(2)' EVAL ->NUM"));
     REQUIRE(ctx.depth() == 1);
     auto obj = ctx.store().pop();
-    REQUIRE(std::holds_alternative<Real>(obj));
+    REQUIRE(holds_alternative<Real>(obj));
 }
 
 TEST_CASE("EVAL exact: implicit multiplication with symbolic", "[expression][eval]") {
@@ -216,5 +216,81 @@ TEST_CASE("EVAL exact: implicit multiplication with symbolic", "[expression][eva
     REQUIRE(ctx.exec("'sqrt(2+12)/((2+3)(8-2))' EVAL"));
     REQUIRE(ctx.depth() == 1);
     auto obj = ctx.store().pop();
-    REQUIRE(std::holds_alternative<Symbol>(obj));
+    REQUIRE(holds_alternative<Symbol>(obj));
+}
+
+// --- Compiled expression cache ---
+
+TEST_CASE("Expression cache: repeated EVAL hits the cache", "[expression][cache]") {
+    Context ctx(nullptr);
+    REQUIRE(ctx.exec("2 'A' STO 3 'B' STO"));
+    REQUIRE(ctx.exec("1 5 FOR X 'A*X^2+B*X' EVAL DROP NEXT"));
+    REQUIRE(ctx.expr_cache().misses() == 1);
+    REQUIRE(ctx.expr_cache().hits() == 4);
+    // Cached form still sees the current variable values
+    REQUIRE(ctx.exec("CLEAR 10 'A' STO 2 -> X 'A*X+B'"));
+    REQUIRE(ctx.repr_at(1) == "23");
+}
+
+TEST_CASE("Expression cache: repeated variable resolves to one value", "[expression][cache]") {
+    Context ctx(nullptr);
+    auto code = compile_expression("X*X+X-Y");
+    REQUIRE(code->names.size() == 2);
+    REQUIRE(code->constants.empty());
+    REQUIRE(ctx.exec("3 'X' STO 1 'Y' STO"));
+    Object r = eval_compiled(*code, ctx, true);
+    REQUIRE(get<Integer>(r) == 11);
+}
+
+TEST_CASE("Expression cache: bounded LRU", "[expression][cache]") {
+    ExprCache cache(2);
+    cache.get("1+1");
+    cache.get("2+2");
+    cache.get("1+1");          // hit, 1+1 most recent
+    cache.get("3+3");          // evicts 2+2
+    REQUIRE(cache.size() == 2);
+    REQUIRE(cache.hits() == 1);
+    REQUIRE(cache.evictions() == 1);
+    cache.get("1+1");
+    REQUIRE(cache.hits() == 2);
+    cache.get("2+2");
+    REQUIRE(cache.misses() == 4);
+}
+
+TEST_CASE("PERFSTATS reports expression cache counters", "[expression][cache]") {
+    Context ctx(nullptr);
+    REQUIRE(ctx.exec("'1+2' EVAL '1+2' EVAL DROP2 PERFSTATS"));
+    std::string r = ctx.repr_at(1);
+    REQUIRE(r.find("{ \"expr_cache_hits\" 1 }") != std::string::npos);
+    REQUIRE(r.find("{ \"expr_cache_misses\" 1 }") != std::string::npos);
+}
+
+TEST_CASE("Expression functions: multi-argument native calls", "[expression][functions]") {
+    Context ctx(nullptr);
+    REQUIRE(ctx.exec("'MAX(3, 7)+MIN(2, 9)' EVAL"));
+    REQUIRE(ctx.repr_at(1) == "9");
+    REQUIRE(ctx.exec("CLEAR 'MOD(7, 3)*COMB(5, 2)' EVAL"));
+    REQUIRE(ctx.repr_at(1) == "10");
+    REQUIRE(ctx.exec("CLEAR DEG 'ATAN2(1., 1.)' EVAL"));
+    REQUIRE(ctx.repr_at(1) == "45.");
+    // Exact arguments with an inexact result stay symbolic
+    REQUIRE(ctx.exec("CLEAR 'SQRT(2)' EVAL"));
+    REQUIRE(ctx.repr_at(1) == "'SQRT(2)'");
+    REQUIRE(ctx.exec("CLEAR 'ATAN2(1, 1)' EVAL"));
+    REQUIRE(ctx.repr_at(1) == "'ATAN2(1, 1)'");
+}
+
+TEST_CASE("Expression functions: wrong argument count", "[expression][functions]") {
+    Context ctx(nullptr);
+    REQUIRE_FALSE(ctx.exec("'MAX(3)' EVAL"));
+    REQUIRE_FALSE(ctx.exec("'SIN(1, 2)' EVAL"));
+}
+
+TEST_CASE("Expression functions: user-defined programs bind arguments", "[expression][functions]") {
+    Context ctx(nullptr);
+    REQUIRE(ctx.exec("<< -> a b 'a*b+1' >> 'F' STO"));
+    REQUIRE(ctx.exec("'F(2, 3)+F(1, 1)' EVAL"));
+    REQUIRE(ctx.repr_at(1) == "9");
+    REQUIRE(ctx.exec("CLEAR << DROP >> 'G' STO"));
+    REQUIRE_FALSE(ctx.exec("'G(1)' EVAL"));
 }
@@ -0,0 +1,93 @@
+#include <catch2/catch_test_macros.hpp>
+#include "core/context.hpp"
+#include "core/fusion.hpp"
+#include "core/parser.hpp"
+
+using namespace lpr;
+
+namespace {
+
+std::vector<std::string> stack_of(Context& ctx) {
+    std::vector<std::string> out;
+    for (int level = ctx.depth(); level >= 1; --level) out.push_back(ctx.repr_at(level));
+    return out;
+}
+
+int64_t stat(Context& ctx, const std::string& name) {
+    for (const auto& [key, value] : ctx.perf_stats()) {
+        if (key == name) return value;
+    }
+    FAIL("no counter " << name);
+    return -1;
+}
+
+} // namespace
+
+TEST_CASE("Parser marks fusable runs without changing the tokens", "[fusion]") {
+    auto tokens = parse("3 DUP * 1 + x 0 ==");
+    REQUIRE(tokens.size() == 8);
+    REQUIRE(tokens[1].fusion != 0);
+    REQUIRE(fusion_rules()[tokens[1].fusion - 1].name == "dup_mul");
+    REQUIRE(tokens[3].fusion != 0);
+    REQUIRE(fusion_rules()[tokens[3].fusion - 1].name == "lit_add");
+    REQUIRE(tokens[6].fusion != 0);
+    REQUIRE(fusion_rules()[tokens[6].fusion - 1].name == "lit_eq");
+    REQUIRE(tokens[2].fusion == 0);
+    REQUIRE(tokens[5].fusion == 0);
+
+    // Program bodies are marked too, and print as written
+    auto prog = parse("<< dup * >>");
+    const auto& body = get<Program>(prog[0].literal).tokens;
+    REQUIRE(body[0].fusion != 0);
+    REQUIRE(repr(prog[0].literal) == "\xC2\xAB dup * \xC2\xBB");
+
+    // Local names and loop variables are never part of a run
+    auto arrow = parse("-> DUP * << 1 >>");
+    REQUIRE(arrow[1].fusion == 0);
+    auto loop = parse("1 3 FOR DUP * NEXT");
+    REQUIRE(loop[3].fusion == 0);
+}
+
+TEST_CASE("Fused and unfused runs leave the same stack", "[fusion]") {
+    const char* inputs[] = {
+        "3 DUP * 2.5 DUP + 1 2 DUP ROT 7 4 SWAP - 1 2 SWAP DROP",
+        "5 9 OVER + 5 9 OVER - 5 9 OVER * 7 1 + 7 1 - 7 3 *",
+        "4 0 == 0 0 == 3 5 < 3 5 > 1/2 1 + (1,2) DUP *",
+        "0 1 10 FOR I I DUP * + NEXT",
+        "<< -> N << 1 1 N FOR K K * NEXT >> >> 'FACT' STO 6 FACT 0 WHILE DUP 5 < REPEAT 1 + END",
+        // Non-numeric operands decline and run the commands as written
+        "\"a\" DUP + { 1 2 } 1 + 'X' DUP * 'Y' 2 * \"b\" \"c\" SWAP DROP",
+    };
+    for (const char* input : inputs) {
+        Context fused(nullptr), plain(nullptr);
+        plain.set_fusion_enabled(false);
+        INFO(input);
+        REQUIRE(fused.exec(input) == plain.exec(input));
+        REQUIRE(stack_of(fused) == stack_of(plain));
+    }
+}
+
+TEST_CASE("Fused runs fail the same way as their commands", "[fusion]") {
+    const char* inputs[] = {"DUP *", "5 SWAP -", "1 DUP ROT", "\"a\" 1 +", "{ 1 } 2 SWAP -"};
+    for (const char* input : inputs) {
+        Context fused(nullptr), plain(nullptr);
+        plain.set_fusion_enabled(false);
+        INFO(input);
+        REQUIRE(fused.exec("9"));
+        REQUIRE(plain.exec("9"));
+        REQUIRE(fused.exec(input) == plain.exec(input));
+        REQUIRE(stack_of(fused) == stack_of(plain));
+    }
+}
+
+TEST_CASE("PERFSTATS counts fused operations and fallbacks", "[fusion]") {
+    Context ctx(nullptr);
+    REQUIRE(ctx.exec("0 1 5 FOR I I DUP * + NEXT"));
+    REQUIRE(stat(ctx, "fusion_dup_mul") == 5);
+    REQUIRE(ctx.exec("\"a\" DUP *"));
+    REQUIRE(stat(ctx, "fusion_fallbacks") == 1);
+
+    ctx.set_fusion_enabled(false);
+    REQUIRE(ctx.exec("DROP 3 DUP *"));
+    REQUIRE(stat(ctx, "fusion_dup_mul") == 5);
+}
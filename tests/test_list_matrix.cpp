@@ -1,6 +1,8 @@
 #include <catch2/catch_test_macros.hpp>
 #include "core/context.hpp"
 #include "core/parser.hpp"
+#include "core/parallel.hpp"
+#include <algorithm>
 
 using namespace lpr;
 
@@ -198,6 +200,60 @@ TEST_CASE("SORT string list", "[list][commands]") {
     REQUIRE(ctx.repr_at(1) == "{ \"apple\" \"banana\" \"cherry\" }");
 }
 
+TEST_CASE("SORT keeps exact precision", "[list][commands]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("{ 1000000000000000000000000000000000000000000000000000000000001 "
+                     "1000000000000000000000000000000000000000000000000000000000000 0.25 7 } SORT"));
+    REQUIRE(ctx.repr_at(1) == "{ 0.25 7 1000000000000000000000000000000000000000000000000000000000000 "
+                              "1000000000000000000000000000000000000000000000000000000000001 }");
+}
+
+TEST_CASE("SORT compares Reals exactly against big integers", "[list][commands]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("{ 1000000000000000000000000000000000000000000000000000000000001 1.E60 "
+                     "1000000000000000000000000000000000000000000000000000000000000 } SORT"));
+    REQUIRE(ctx.repr_at(1) == "{ 1000000000000000000000000000000000000000000000000000000000000. "
+                              "1000000000000000000000000000000000000000000000000000000000000 "
+                              "1000000000000000000000000000000000000000000000000000000000001 }");
+}
+
+TEST_CASE("SORT mixed list: numbers, strings, then others", "[list][commands]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("{ \"b\" 'X' 2 { 1 } 1.5 \"a\" } SORT"));
+    REQUIRE(ctx.repr_at(1) == "{ 1.5 2 \"a\" \"b\" 'X' { 1 } }");
+}
+
+TEST_CASE("SORT with key program is stable", "[list][commands]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("{ \"ccc\" \"a\" \"bb\" \"d\" } << SIZE >> SORT"));
+    REQUIRE(ctx.repr_at(1) == "{ \"a\" \"d\" \"bb\" \"ccc\" }");
+    REQUIRE(ctx.exec("{ 3 -1 2 -4 } << NEG >> SORT"));
+    REQUIRE(ctx.repr_at(1) == "{ 3 2 -1 -4 }");
+}
+
+TEST_CASE("SORT key program must leave exactly one key", "[list][commands]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("99 { 3 1 2 }"));
+    REQUIRE_FALSE(ctx.exec("<< DROP >> SORT"));
+    REQUIRE(ctx.repr_at(1).find("Bad argument value") != std::string::npos);
+    REQUIRE(ctx.exec("DROP"));
+    REQUIRE_FALSE(ctx.exec("<< DUP >> SORT"));
+    REQUIRE(ctx.repr_at(1).find("Bad argument value") != std::string::npos);
+    REQUIRE(ctx.exec("DROP"));
+    REQUIRE(ctx.depth() == 2);
+    REQUIRE(ctx.repr_at(2) == "99");
+}
+
+TEST_CASE("parallel_stable_sort matches std::stable_sort", "[list][parallel]") {
+    std::vector<std::pair<int, int>> v;
+    for (int i = 0; i < 100000; ++i) v.push_back({(i * 7919) % 1000, i});
+    auto expected = v;
+    auto by_first = [](const auto& a, const auto& b) { return a.first < b.first; };
+    std::stable_sort(expected.begin(), expected.end(), by_first);
+    parallel_stable_sort(v, by_first, 4);
+    REQUIRE(v == expected);
+}
+
 TEST_CASE("ADD element to list", "[list][commands]") {
     auto ctx = make_ctx();
     REQUIRE(ctx.exec("{ 1 2 } 3 ADD"));
@@ -248,6 +304,74 @@ TEST_CASE("ZIP", "[list][higher-order]") {
     REQUIRE(ctx.repr_at(1) == "{ { 1 4 } { 2 5 } { 3 6 } }");
 }
 
+// ==================== Parallel Higher-Order ====================
+
+TEST_CASE("PMAP matches MAP and keeps order", "[list][parallel]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("4 PWORKERS"));
+    REQUIRE(ctx.exec("1 1 40 << >> SEQ DUP << SQ 1 + >> PMAP SWAP << SQ 1 + >> MAP"));
+    REQUIRE(ctx.repr_at(1) == ctx.repr_at(2));
+    REQUIRE(ctx.exec("CLEAR { 1 2 3 4 5 6 7 8 9 10 } << 2 * >> PMAP"));
+    REQUIRE(ctx.repr_at(1) == "{ 2 4 6 8 10 12 14 16 18 20 }");
+}
+
+TEST_CASE("PFILTER, PDOLIST, PSEQ, PDOSUBS", "[list][parallel]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("4 PWORKERS"));
+    REQUIRE(ctx.exec("{ 1 2 3 4 5 6 7 8 9 10 } << 2 MOD 0 == >> PFILTER"));
+    REQUIRE(ctx.repr_at(1) == "{ 2 4 6 8 10 }");
+    REQUIRE(ctx.exec("{ 1 2 3 4 5 6 7 8 } { 8 7 6 5 4 3 2 1 } 2 << - >> PDOLIST"));
+    REQUIRE(ctx.repr_at(1) == "{ -7 -5 -3 -1 1 3 5 7 }");
+    REQUIRE(ctx.exec("1 2 10 << DUP * >> PSEQ"));
+    REQUIRE(ctx.repr_at(1) == "{ 1 9 25 49 81 121 169 225 289 361 }");
+    REQUIRE(ctx.exec("{ 1 2 3 4 5 6 7 8 9 10 } 3 << + + >> PDOSUBS"));
+    REQUIRE(ctx.repr_at(1) == "{ 6 9 12 15 18 21 24 27 }");
+}
+
+TEST_CASE("PMAP sees enclosing locals", "[list][parallel]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("4 PWORKERS"));
+    REQUIRE(ctx.exec("10 << -> k << { 1 2 3 4 5 6 7 8 } << k * >> PMAP >> >> EVAL"));
+    REQUIRE(ctx.repr_at(1) == "{ 10 20 30 40 50 60 70 80 }");
+}
+
+TEST_CASE("PMAP falls back to serial for impure programs", "[list][parallel]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("4 PWORKERS 0 'acc' STO"));
+    REQUIRE(ctx.exec("{ 1 2 3 4 5 6 7 8 } << DUP acc + 'acc' STO >> PMAP"));
+    REQUIRE(ctx.repr_at(1) == "{ 1 2 3 4 5 6 7 8 }");
+    REQUIRE(ctx.exec("acc"));
+    REQUIRE(ctx.repr_at(1) == "36");
+    // Programs leaving extra items behave exactly like MAP
+    REQUIRE(ctx.exec("CLEAR { 1 2 3 4 5 6 7 8 } << DUP >> PMAP"));
+    REQUIRE(ctx.depth() == 9);
+}
+
+TEST_CASE("Programs using the CAS are not parallel-safe", "[list][parallel]") {
+    auto ctx = make_ctx();
+    for (const char* body : {"'X' DIFF", "'X' INTEGRATE", "'X' SOLVE", "SIMPLIFY", "EXPAND",
+                             "FACTOR", "'X' 2 SUBST", "{ X } JACOBIAN", "{ X } GRADIENT"}) {
+        INFO(body);
+        REQUIRE_FALSE(is_parallel_safe(parse(body), ctx));
+    }
+    REQUIRE(is_parallel_safe(parse("SQ 1 +"), ctx));
+}
+
+TEST_CASE("Programs changing settings are not parallel-safe", "[list][parallel]") {
+    auto ctx = make_ctx();
+    for (const char* body : {"64 CALLMEM", "20 PREC", "1000 CASLIMIT"}) {
+        INFO(body);
+        REQUIRE_FALSE(is_parallel_safe(parse(body), ctx));
+    }
+}
+
+TEST_CASE("PMAP errors match MAP", "[list][parallel]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("4 PWORKERS"));
+    REQUIRE_FALSE(ctx.exec("{ 1 2 3 4 5 6 7 \"x\" } << 1 + INV >> PMAP"));
+    REQUIRE_FALSE(ctx.exec("{ 1 2 } 3 PMAP"));
+}
+
 // ==================== Set Operations ====================
 
 TEST_CASE("UNION", "[list][set]") {
@@ -268,6 +392,20 @@ TEST_CASE("DIFFERENCE", "[list][set]") {
     REQUIRE(ctx.repr_at(1) == "{ 1 }");
 }
 
+TEST_CASE("Set operations compare structurally", "[list][set]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("{ 1 { 2 3 } \"a\" } { { 2 3 } 1. \"a\" 1 } UNION"));
+    REQUIRE(ctx.repr_at(1) == "{ 1 { 2 3 } \"a\" 1. }");
+    REQUIRE(ctx.exec("{ 1 1 2 { 3 } } { { 3 } 1 } INTERSECT"));
+    REQUIRE(ctx.repr_at(1) == "{ 1 1 { 3 } }");
+    REQUIRE(ctx.exec("{ 1 1 2 { 3 } } { { 3 } 1 } DIFFERENCE"));
+    REQUIRE(ctx.repr_at(1) == "{ 2 }");
+    REQUIRE(ctx.exec("{ 1 { 2 3 } 4 } { 2 3 } POS"));
+    REQUIRE(ctx.repr_at(1) == "2");
+    REQUIRE(ctx.exec("{ 1 { 2 } } { 1 { 2 } } SAME"));
+    REQUIRE(ctx.repr_at(1) == "1");
+}
+
 // ==================== Matrix/Vector Commands ====================
 
 TEST_CASE("->V2", "[matrix][commands]") {
@@ -10,8 +10,8 @@ TEST_CASE("Push and resolve local variable", "[locals]") {
     ctx.push_locals(frame);
     auto val = ctx.resolve_local("X");
     REQUIRE(val.has_value());
-    REQUIRE(std::holds_alternative<Integer>(*val));
-    REQUIRE(std::get<Integer>(*val) == 42);
+    REQUIRE(holds_alternative<Integer>(*val));
+    REQUIRE(get<Integer>(*val) == 42);
     ctx.pop_locals();
 }
 
@@ -33,12 +33,12 @@ TEST_CASE("Nested scopes shadow outer bindings", "[locals]") {
 
     auto val = ctx.resolve_local("X");
     REQUIRE(val.has_value());
-    REQUIRE(std::get<Integer>(*val) == 2);
+    REQUIRE(get<Integer>(*val) == 2);
 
     ctx.pop_locals();
     val = ctx.resolve_local("X");
     REQUIRE(val.has_value());
-    REQUIRE(std::get<Integer>(*val) == 1);
+    REQUIRE(get<Integer>(*val) == 1);
 
     ctx.pop_locals();
     val = ctx.resolve_local("X");
@@ -59,9 +59,24 @@ TEST_CASE("Inner scope can see outer scope variables", "[locals]") {
     auto y = ctx.resolve_local("Y");
     REQUIRE(x.has_value());
     REQUIRE(y.has_value());
-    REQUIRE(std::get<Integer>(*x) == 10);
-    REQUIRE(std::get<Integer>(*y) == 20);
+    REQUIRE(get<Integer>(*x) == 10);
+    REQUIRE(get<Integer>(*y) == 20);
 
     ctx.pop_locals();
     ctx.pop_locals();
 }
+
+TEST_CASE("FOR loop variable is rebound each pass and scoped to the loop", "[locals][arena]") {
+    Context ctx(nullptr);
+    REQUIRE(ctx.exec("0 1 5 FOR I << I >> EVAL + NEXT"));
+    REQUIRE(ctx.repr_at(1) == "15");
+    REQUIRE(ctx.local_scopes().empty());
+    REQUIRE(!ctx.resolve_local("I").has_value());
+
+    // Native-function temporaries come from the exec arena, which is
+    // recycled between passes and released when the exec returns
+    REQUIRE(ctx.exec("1 500 FOR I I 7 MOD DROP 'I*2' EVAL DROP NEXT"));
+    REQUIRE(ctx.arena().allocations() > 0);
+    REQUIRE(ctx.arena().blocks() == 1);
+    REQUIRE(ctx.arena().resets() >= 2);
+}
@@ -0,0 +1,102 @@
+#include <catch2/catch_test_macros.hpp>
+#include "core/context.hpp"
+#include "core/number_theory.hpp"
+#include <string>
+
+using namespace lpr;
+
+static Context make_ctx() { return Context(nullptr); }
+
+static Integer big(const char* digits) { return Integer(digits); }
+
+// ---- Kernels ----
+
+TEST_CASE("Primality agrees with a sieve below 10000", "[number_theory]") {
+    std::vector<bool> composite(10000, false);
+    int mismatches = 0;
+    for (int i = 2; i < 10000; ++i) {
+        if (!composite[i])
+            for (int j = i * i; j < 10000; j += i) composite[j] = true;
+        if (is_probable_prime(Integer(i)) == composite[i]) ++mismatches;
+    }
+    REQUIRE(mismatches == 0);
+    REQUIRE_FALSE(is_probable_prime(Integer(1)));
+    REQUIRE_FALSE(is_probable_prime(Integer(-7)));
+}
+
+TEST_CASE("Primality rejects pseudoprimes", "[number_theory]") {
+    // Carmichael numbers and strong pseudoprimes to base 2
+    for (const char* n : {"561", "41041", "825265", "2047", "3215031751", "3825123056546413051",
+                          "318665857834031151167461"}) {
+        REQUIRE_FALSE(is_probable_prime(big(n)));
+    }
+    REQUIRE(is_probable_prime(big("18446744073709551557")));                    // largest 64-bit prime
+    REQUIRE(is_probable_prime(big("170141183460469231731687303715884105727")));  // 2^127-1
+    REQUIRE_FALSE(is_probable_prime(big("340282366920938463463374607431768211457"))); // 2^128+1
+}
+
+TEST_CASE("Next and previous prime", "[number_theory]") {
+    REQUIRE(next_prime(Integer(-5)) == 2);
+    REQUIRE(next_prime(Integer(2)) == 3);
+    REQUIRE(next_prime(Integer(7919)) == 7927);
+    REQUIRE(next_prime(big("18446744073709551557")) == big("18446744073709551629"));
+    REQUIRE(prev_prime(Integer(3)) == 2);
+    REQUIRE(prev_prime(Integer(7927)) == 7919);
+    REQUIRE_THROWS(prev_prime(Integer(2)));
+}
+
+TEST_CASE("Factorization by rho and ECM", "[number_theory]") {
+    using Factors = std::vector<std::pair<Integer, unsigned>>;
+    REQUIRE(factorize(Integer(1)).empty());
+    REQUIRE(factorize(Integer(-360)) == Factors{{2, 3}, {3, 2}, {5, 1}});
+    // 64-bit semiprime: two 32-bit primes
+    REQUIRE(factorize(big("18446743979220271189")) ==
+            Factors{{big("4294967279"), 1}, {big("4294967291"), 1}});
+    // 2^128+1: 59649589127497217 * 5704689200685129054721
+    REQUIRE(factorize(big("340282366920938463463374607431768211457")) ==
+            Factors{{big("59649589127497217"), 1}, {big("5704689200685129054721"), 1}});
+    REQUIRE_THROWS(factorize(Integer(0)));
+}
+
+TEST_CASE("GCD, LCM and modular arithmetic", "[number_theory]") {
+    REQUIRE(gcd_binary(Integer(-48), Integer(180)) == 12);
+    REQUIRE(gcd_binary(Integer(0), Integer(-5)) == 5);
+    REQUIRE(gcd_binary(big("340282366920938463463374607431768211457"), big("59649589127497217") * 3) ==
+            big("59649589127497217"));
+    REQUIRE(lcm_binary(Integer(4), Integer(-6)) == 12);
+    REQUIRE(lcm_binary(Integer(0), Integer(6)) == 0);
+    REQUIRE(pow_mod(Integer(2), Integer(10), Integer(1000)) == 24);
+    REQUIRE(pow_mod(Integer(-2), Integer(3), Integer(7)) == 6);
+    REQUIRE(pow_mod(Integer(3), Integer(-1), Integer(7)) == 5);
+    REQUIRE(pow_mod(Integer(2), big("170141183460469231731687303715884105726"),
+                    big("170141183460469231731687303715884105727")) == 1);
+    REQUIRE(inv_mod(Integer(3), Integer(7)) == 5);
+    REQUIRE(inv_mod(Integer(-3), Integer(7)) == 2);
+    REQUIRE_THROWS(inv_mod(Integer(4), Integer(8)));
+    REQUIRE_THROWS(pow_mod(Integer(2), Integer(3), Integer(0)));
+}
+
+// ---- Commands ----
+
+TEST_CASE("Number-theory commands", "[number_theory]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("97 ISPRIME? 561 ISPRIME?"));
+    REQUIRE(ctx.repr_at(2) == "1");
+    REQUIRE(ctx.repr_at(1) == "0");
+    REQUIRE(ctx.exec("CLEAR 100 NEXTPRIME 100 PREVPRIME"));
+    REQUIRE(ctx.repr_at(2) == "101");
+    REQUIRE(ctx.repr_at(1) == "97");
+    REQUIRE(ctx.exec("CLEAR 360 FACTORS"));
+    REQUIRE(ctx.repr_at(1) == "{ 2 3 3 2 5 1 }");
+    REQUIRE(ctx.exec("CLEAR 1 FACTORS"));
+    REQUIRE(ctx.repr_at(1) == "{  }");
+    REQUIRE(ctx.exec("CLEAR 12 18 GCD 4 6 LCM"));
+    REQUIRE(ctx.repr_at(2) == "6");
+    REQUIRE(ctx.repr_at(1) == "12");
+    REQUIRE(ctx.exec("CLEAR 4 13 497 POWMOD 3 7 INVMOD"));
+    REQUIRE(ctx.repr_at(2) == "445");
+    REQUIRE(ctx.repr_at(1) == "5");
+    REQUIRE_FALSE(ctx.exec("CLEAR 2. 3 GCD"));
+    REQUIRE_FALSE(ctx.exec("CLEAR 4 8 INVMOD"));
+    REQUIRE_FALSE(ctx.exec("CLEAR 0 FACTORS"));
+}
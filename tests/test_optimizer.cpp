@@ -0,0 +1,88 @@
+#include <catch2/catch_test_macros.hpp>
+#include "core/context.hpp"
+
+using namespace lpr;
+
+namespace {
+
+// The stored form of `program` with the optimize flag set
+std::string stored(const std::string& program) {
+    Context ctx(nullptr);
+    REQUIRE(ctx.exec("'optimize' SF"));
+    REQUIRE(ctx.exec(program + " 'P' STO 'P' RCL"));
+    return ctx.repr_at(1);
+}
+
+std::vector<std::string> stack_of(Context& ctx) {
+    std::vector<std::string> out;
+    for (int level = ctx.depth(); level >= 1; --level) out.push_back(ctx.repr_at(level));
+    return out;
+}
+
+} // namespace
+
+TEST_CASE("STO folds constant arithmetic when the optimize flag is set", "[optimizer]") {
+    std::string deg = stored("<< 2 PI * 360 / * >>");
+    REQUIRE(deg.rfind("\xC2\xAB 0.01745329251994329", 0) == 0);
+    REQUIRE(deg.find("PI") == std::string::npos);
+    REQUIRE(stored("<< 2 3 + 4 * >>") == "\xC2\xAB 20 \xC2\xBB");
+    REQUIRE(stored("<< X 1 2 + * >>") == "\xC2\xAB X 3 * \xC2\xBB");
+    REQUIRE(stored("<< 3 4 < 2 NEG >>") == "\xC2\xAB 1 -2 \xC2\xBB");
+    REQUIRE(stored("<< 1 3 / >>") == "\xC2\xAB 1/3 \xC2\xBB");
+
+    // Without the flag programs are stored as written
+    Context ctx(nullptr);
+    REQUIRE(ctx.exec("<< 2 3 + >> 'P' STO 'P' RCL"));
+    REQUIRE(ctx.repr_at(1) == "\xC2\xAB 2 3 + \xC2\xBB");
+}
+
+TEST_CASE("Optimizer never folds mode-dependent or failing commands", "[optimizer]") {
+    REQUIRE(stored("<< 30 SIN >>") == "\xC2\xAB 30 SIN \xC2\xBB");
+    REQUIRE(stored("<< 2 LN >>") == "\xC2\xAB 2 LN \xC2\xBB");
+    REQUIRE(stored("<< 1 0 / >>") == "\xC2\xAB 1 0 / \xC2\xBB");
+    REQUIRE(stored("<< \"a\" 1 + >>") == "\xC2\xAB \"a\" 1 + \xC2\xBB");
+    // Programs pushed as data keep their text
+    REQUIRE(stored("<< << 1 2 + >> >>") == "\xC2\xAB \xC2\xAB 1 2 + \xC2\xBB \xC2\xBB");
+}
+
+TEST_CASE("Optimizer removes dead branches and identity frames", "[optimizer]") {
+    REQUIRE(stored("<< IF 1 THEN 10 ELSE 20 END >>") == "\xC2\xAB 10 \xC2\xBB");
+    REQUIRE(stored("<< IF 2 1 < THEN 10 ELSE 20 END >>") == "\xC2\xAB 20 \xC2\xBB");
+    REQUIRE(stored("<< 0 IF THEN 10 END 5 >>") == "\xC2\xAB 5 \xC2\xBB");
+    REQUIRE(stored("<< IF X THEN 1 1 + END >>") == "\xC2\xAB IF X THEN 2 END \xC2\xBB");
+    REQUIRE(stored("<< WHILE 0 REPEAT 1 END 5 >>") == "\xC2\xAB 5 \xC2\xBB");
+    REQUIRE(stored("<< 5 -> x << x >> 1 + >>") == "\xC2\xAB 6 \xC2\xBB");
+    // With nothing known on the stack the frame still checks for its value
+    REQUIRE(stored("<< -> x << x >> >>") == "\xC2\xAB -> x \xC2\xAB x \xC2\xBB \xC2\xBB");
+    std::string body = stored("<< -> r << 2 PI * r * >> >>");
+    REQUIRE(body.rfind("\xC2\xAB -> r \xC2\xAB 6.283185307179586", 0) == 0);
+    REQUIRE(body.find("PI") == std::string::npos);
+}
+
+TEST_CASE("Optimized and unoptimized programs give the same results", "[optimizer]") {
+    const char* programs[] = {
+        "<< 2 PI * 360 / * >>",
+        "<< -> n << 1 1 n FOR k k * NEXT >> >>",
+        "<< IF 1 THEN 10 ELSE 20 END + >>",
+        "<< 0 IF THEN 1 ELSE 2 END + >>",
+        "<< WHILE 0 REPEAT 1 END 1 + >>",
+        "<< 5 -> x << x >> + >>",
+        "<< -> x << x >> >>",
+        "<< 1 0 / >>",
+        "<< DUP 2 3 ^ MOD 4 SQ SQRT + >>",
+        "<< IF DUP 3 2 > THEN 1 + ELSE 1 - END >>",
+        "<< 1 2 3 -> a b c << a b c >> + + >>",
+    };
+    for (const char* program : programs) {
+        for (const char* args : {"", "7", "2.5 4"}) {
+            Context plain(nullptr), optimized(nullptr);
+            REQUIRE(optimized.exec("'optimize' SF"));
+            std::string setup = std::string(program) + " 'P' STO " + args;
+            REQUIRE(plain.exec(setup));
+            REQUIRE(optimized.exec(setup));
+            INFO(program << " with " << args);
+            REQUIRE(plain.exec("P") == optimized.exec("P"));
+            REQUIRE(stack_of(plain) == stack_of(optimized));
+        }
+    }
+}
@@ -1,4 +1,5 @@
 #include <catch2/catch_test_macros.hpp>
+#include "core/context.hpp"
 #include "core/parser.hpp"
 
 using namespace lpr;
@@ -7,62 +8,70 @@ TEST_CASE("Parse integer literals", "[parser]") {
     auto tokens = parse("42");
     REQUIRE(tokens.size() == 1);
     REQUIRE(tokens[0].kind == Token::Literal);
-    REQUIRE(std::holds_alternative<Integer>(tokens[0].literal));
-    REQUIRE(std::get<Integer>(tokens[0].literal) == 42);
+    REQUIRE(holds_alternative<Integer>(tokens[0].literal));
+    REQUIRE(get<Integer>(tokens[0].literal) == 42);
 }
 
 TEST_CASE("Parse negative integer", "[parser]") {
     auto tokens = parse("-7");
     REQUIRE(tokens.size() == 1);
-    REQUIRE(std::holds_alternative<Integer>(tokens[0].literal));
-    REQUIRE(std::get<Integer>(tokens[0].literal) == -7);
+    REQUIRE(holds_alternative<Integer>(tokens[0].literal));
+    REQUIRE(get<Integer>(tokens[0].literal) == -7);
 }
 
 TEST_CASE("Parse real literals", "[parser]") {
     auto tokens = parse("3.14159");
     REQUIRE(tokens.size() == 1);
     REQUIRE(tokens[0].kind == Token::Literal);
-    REQUIRE(std::holds_alternative<Real>(tokens[0].literal));
+    REQUIRE(holds_alternative<Real>(tokens[0].literal));
 }
 
 TEST_CASE("Parse scientific notation", "[parser]") {
     auto tokens = parse("1.5E-10");
     REQUIRE(tokens.size() == 1);
-    REQUIRE(std::holds_alternative<Real>(tokens[0].literal));
+    REQUIRE(holds_alternative<Real>(tokens[0].literal));
+}
+
+TEST_CASE("Parse rational literals", "[parser]") {
+    auto tokens = parse("-11/2 4/2 1/0");
+    REQUIRE(tokens.size() == 3);
+    REQUIRE(holds_alternative<Rational>(tokens[0].literal));
+    REQUIRE(holds_alternative<Integer>(tokens[1].literal));
+    REQUIRE(tokens[2].kind != Token::Literal);
 }
 
 TEST_CASE("Parse complex literal", "[parser]") {
     auto tokens = parse("(3.0, 4.0)");
     REQUIRE(tokens.size() == 1);
-    REQUIRE(std::holds_alternative<Complex>(tokens[0].literal));
+    REQUIRE(holds_alternative<Complex>(tokens[0].literal));
 }
 
 TEST_CASE("Parse string literal", "[parser]") {
     auto tokens = parse("\"hello\"");
     REQUIRE(tokens.size() == 1);
-    REQUIRE(std::holds_alternative<String>(tokens[0].literal));
-    REQUIRE(std::get<String>(tokens[0].literal).value == "hello");
+    REQUIRE(holds_alternative<String>(tokens[0].literal));
+    REQUIRE(get<String>(tokens[0].literal).value == "hello");
 }
 
 TEST_CASE("Parse quoted name", "[parser]") {
     auto tokens = parse("'myvar'");
     REQUIRE(tokens.size() == 1);
-    REQUIRE(std::holds_alternative<Name>(tokens[0].literal));
-    REQUIRE(std::get<Name>(tokens[0].literal).value == "myvar");
+    REQUIRE(holds_alternative<Name>(tokens[0].literal));
+    REQUIRE(get<Name>(tokens[0].literal).value == "myvar");
 }
 
 TEST_CASE("Parse quoted expression (Symbol)", "[parser]") {
     auto tokens = parse("'X^2 + 1'");
     REQUIRE(tokens.size() == 1);
-    REQUIRE(std::holds_alternative<Symbol>(tokens[0].literal));
-    REQUIRE(std::get<Symbol>(tokens[0].literal).value == "X^2 + 1");
+    REQUIRE(holds_alternative<Symbol>(tokens[0].literal));
+    REQUIRE(get<Symbol>(tokens[0].literal).value() == "X^2 + 1");
 }
 
 TEST_CASE("Parse program literal", "[parser]") {
     auto tokens = parse("\xC2\xAB DUP * \xC2\xBB");
     REQUIRE(tokens.size() == 1);
-    REQUIRE(std::holds_alternative<Program>(tokens[0].literal));
-    auto& prog = std::get<Program>(tokens[0].literal);
+    REQUIRE(holds_alternative<Program>(tokens[0].literal));
+    auto& prog = get<Program>(tokens[0].literal);
     REQUIRE(prog.tokens.size() == 2);
     REQUIRE(prog.tokens[0].command == "DUP");
     REQUIRE(prog.tokens[1].command == "*");
@@ -71,9 +80,9 @@ TEST_CASE("Parse program literal", "[parser]") {
 TEST_CASE("Parse nested programs", "[parser]") {
     auto tokens = parse("\xC2\xAB 1 \xC2\xAB 2 3 + \xC2\xBB EVAL \xC2\xBB");
     REQUIRE(tokens.size() == 1);
-    auto& prog = std::get<Program>(tokens[0].literal);
+    auto& prog = get<Program>(tokens[0].literal);
     REQUIRE(prog.tokens.size() == 3); // 1, inner_prog, EVAL
-    REQUIRE(std::holds_alternative<Program>(prog.tokens[1].literal));
+    REQUIRE(holds_alternative<Program>(prog.tokens[1].literal));
 }
 
 TEST_CASE("Parse command names preserve case", "[parser]") {
@@ -87,8 +96,116 @@ TEST_CASE("Parse command names preserve case", "[parser]") {
 TEST_CASE("Parse simple expression", "[parser]") {
     auto tokens = parse("3 4 +");
     REQUIRE(tokens.size() == 3);
-    REQUIRE(std::holds_alternative<Integer>(tokens[0].literal));
-    REQUIRE(std::holds_alternative<Integer>(tokens[1].literal));
+    REQUIRE(holds_alternative<Integer>(tokens[0].literal));
+    REQUIRE(holds_alternative<Integer>(tokens[1].literal));
     REQUIRE(tokens[2].kind == Token::Command);
     REQUIRE(tokens[2].command == "+");
 }
+
+TEST_CASE("Delimiters inside strings and quotes do not close programs or lists", "[parser]") {
+    auto tokens = parse("<< \"a >> b\" 'X}Y' >> { \"}\" 1 }");
+    REQUIRE(tokens.size() == 2);
+    auto& prog = get<Program>(tokens[0].literal);
+    REQUIRE(prog.tokens.size() == 2);
+    REQUIRE(get<String>(prog.tokens[0].literal).value == "a >> b");
+    REQUIRE(get<Name>(prog.tokens[1].literal).value == "X}Y");
+    auto& list = get<List>(tokens[1].literal);
+    REQUIRE(list.items.size() == 2);
+    REQUIRE(get<String>(list.items[0]).value == "}");
+}
+
+TEST_CASE("Parse deeply nested programs and stray closers", "[parser]") {
+    std::string input;
+    for (int d = 0; d < 500; ++d) input += "<< ";
+    input += "7";
+    for (int d = 0; d < 500; ++d) input += " >>";
+    auto tokens = parse(input);
+    REQUIRE(tokens.size() == 1);
+    const Object* inner = &tokens[0].literal;
+    for (int d = 0; d < 500; ++d) {
+        auto& body = get<Program>(*inner).tokens;
+        REQUIRE(body.size() == 1);
+        inner = &body[0].literal;
+    }
+    REQUIRE(get<Integer>(*inner) == 7);
+
+    // A closer with nothing to close is a word; unterminated bodies end with the input
+    tokens = parse("} 1 >> { 2 << 3");
+    REQUIRE(tokens.size() == 4);
+    REQUIRE(tokens[0].command == "}");
+    REQUIRE(tokens[2].command == ">>");
+    REQUIRE(get<List>(tokens[3].literal).items.size() == 2);
+}
+
+TEST_CASE("Command words are interned", "[parser]") {
+    Context ctx(nullptr);  // registers the command set
+    auto tokens = parse("DUP 1 DUP dup");
+    REQUIRE(tokens[0].command == tokens[2].command);
+    REQUIRE(&tokens[0].command.str() == &tokens[2].command.str());
+    REQUIRE(tokens[0].command != tokens[3].command);
+    REQUIRE(tokens[0].command == Atom("DUP"));
+}
+
+TEST_CASE("Other words are not interned", "[parser]") {
+    Context ctx(nullptr);
+    size_t before = Atom::table_size();
+    for (int i = 0; i < 100; ++i) parse("word" + std::to_string(i) + " DUP");
+    REQUIRE(Atom::table_size() == before);
+
+    auto tokens = parse("myvar 1 myvar");
+    REQUIRE(tokens[0].command == tokens[2].command);
+    REQUIRE(&tokens[0].command.str() != &tokens[2].command.str());
+    Atom copy = tokens[0].command;
+    REQUIRE(copy == "myvar");
+}
+
+TEST_CASE("ParseCache shares tokens and evicts least recently used", "[parser][cache]") {
+    ParseCache cache(2);
+    auto a = cache.get("1 2 +");
+    REQUIRE(a->size() == 3);
+    REQUIRE(cache.get("1 2 +") == a);
+    REQUIRE(cache.hits() == 1);
+    REQUIRE(cache.misses() == 1);
+
+    cache.get("DUP");
+    cache.get("1 2 +");   // refresh
+    cache.get("SWAP");    // evicts DUP
+    REQUIRE(cache.evictions() == 1);
+    REQUIRE(cache.size() == 2);
+    cache.get("DUP");
+    REQUIRE(cache.misses() == 4);
+    REQUIRE(a->size() == 3); // still valid for its holder
+
+    ParseCache small(8, 4);
+    small.get("1 2 3 +");
+    REQUIRE(small.size() == 0);
+}
+
+TEST_CASE("exec, STR-> and recalled programs go through the parse cache", "[parser][cache]") {
+    Context ctx(nullptr);
+    REQUIRE(ctx.exec("<< 1 + >> 'INC' STO"));
+    REQUIRE(ctx.exec("5 INC"));
+    REQUIRE(ctx.exec("INC"));
+    REQUIRE(ctx.repr_at(1) == "7");
+    uint64_t hits = ctx.parse_cache().hits();
+    REQUIRE(ctx.exec("INC \"INC\" STR\xe2\x86\x92"));
+    REQUIRE(ctx.repr_at(1) == "9");
+    // INC as exec input, INC again via STR->, and its stored body each time
+    REQUIRE(ctx.parse_cache().hits() >= hits + 3);
+    REQUIRE(ctx.exec("PERFSTATS"));
+    REQUIRE(ctx.repr_at(1).find("\"parse_cache_hits\"") != std::string::npos);
+}
+
+TEST_CASE("StreamSplitter cuts only at top-level line breaks", "[parser][stream]") {
+    StreamSplitter splitter;
+    splitter.feed("1 2\n<< 3\n");
+    REQUIRE(splitter.take() == "1 2\n");
+    // Line breaks inside a program or string are not cuts
+    splitter.feed("4 >> \"a\nb\" (1,");
+    REQUIRE(splitter.take().empty());
+    splitter.feed("\n");
+    REQUIRE(splitter.take() == "<< 3\n4 >> \"a\nb\" (1,\n");
+    splitter.feed("'X\nY' 5");
+    REQUIRE(splitter.take().empty());
+    REQUIRE(splitter.finish() == "'X\nY' 5");
+}
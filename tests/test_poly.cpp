@@ -0,0 +1,167 @@
+#include <catch2/catch_test_macros.hpp>
+#include "core/context.hpp"
+#include "core/poly.hpp"
+#include <string>
+#include <vector>
+
+using namespace lpr;
+
+static Context make_ctx() { return Context(nullptr); }
+
+static ExactPoly exact(std::vector<long> low_first) {
+    std::vector<Rational> c;
+    for (long v : low_first) c.push_back(Rational(v));
+    return ExactPoly(std::move(c));
+}
+
+// ---- Kernels ----
+
+TEST_CASE("Poly trims leading zeros and evaluates by Horner", "[poly]") {
+    ExactPoly p = exact({2, -3, 1, 0, 0});
+    REQUIRE(p.degree() == 2);
+    REQUIRE(p(Rational(5)) == 12);
+    REQUIRE(ExactPoly().degree() == -1);
+    REQUIRE(exact({0, 0}).is_zero());
+}
+
+TEST_CASE("Karatsuba products match the schoolbook product", "[poly]") {
+    // Long enough to recurse, lopsided enough to take the sliced path
+    std::vector<long> a, b;
+    for (long i = 0; i < 150; ++i) a.push_back((i * 37) % 23 - 11);
+    for (long i = 0; i < 70; ++i) b.push_back((i * 19) % 17 - 8);
+    ExactPoly pa = exact(a), pb = exact(b);
+    ExactPoly fast = pa * pb;
+
+    std::vector<Rational> slow(a.size() + b.size() - 1);
+    for (size_t i = 0; i < a.size(); ++i)
+        for (size_t j = 0; j < b.size(); ++j) slow[i + j] += Rational(a[i] * b[j]);
+    REQUIRE(fast.coeffs() == ExactPoly(slow).coeffs());
+    REQUIRE((pb * pa).coeffs() == fast.coeffs());
+}
+
+TEST_CASE("divmod and gcd", "[poly]") {
+    ExactPoly a = exact({-6, 11, -6, 1}); // (x-1)(x-2)(x-3)
+    ExactPoly b = exact({3, -4, 1});      // (x-1)(x-3)
+    ExactPoly q, r;
+    ExactPoly::divmod(a, b, q, r);
+    REQUIRE(q.coeffs() == exact({-2, 1}).coeffs());
+    REQUIRE(r.is_zero());
+    REQUIRE(gcd(a * exact({5}), exact({-4, 0, 1})).coeffs() == exact({-2, 1}).coeffs());
+    REQUIRE_THROWS(ExactPoly::divmod(a, ExactPoly(), q, r));
+
+    RealPoly ra({Real(-2), Real(0), Real(1)}), rb({Real("1.4142135623730950488016887242096980785697"), Real(1)});
+    RealPoly rq, rr;
+    RealPoly::divmod(ra, rb, rq, rr);
+    REQUIRE(rq.degree() == 1);
+}
+
+TEST_CASE("poly_roots keeps repeated and rational roots exact", "[poly]") {
+    // (x-1)^3 (2x+1) x
+    ExactPoly p = exact({-1, 3, -3, 1}) * exact({1, 2}) * exact({0, 1});
+    auto roots = poly_roots(p);
+    REQUIRE(roots.size() == 5);
+    List l{roots};
+    REQUIRE(repr(Object(l)) == "{ -1/2 0 1 1 1 }");
+}
+
+TEST_CASE("poly_roots of a degree-7 polynomial", "[poly]") {
+    // Roots 1..7: beyond what the closed-form solver handles
+    ExactPoly p = exact({1});
+    for (long k = 1; k <= 7; ++k) p = p * exact({-k, 1});
+    auto roots = poly_roots(p);
+    REQUIRE(roots.size() == 7);
+    REQUIRE(repr(Object(List{roots})) == "{ 1 2 3 4 5 6 7 }");
+
+    // Irrational and complex roots of x^4 - 2 come back inexact
+    auto quartic = poly_roots(exact({-2, 0, 0, 0, 1}));
+    REQUIRE(quartic.size() == 4);
+    REQUIRE(holds_alternative<Real>(quartic[0]));
+    REQUIRE(holds_alternative<Complex>(quartic[1]));
+    Real r = get<Real>(quartic[3]);
+    REQUIRE(boost::multiprecision::abs(r * r * r * r - 2) < Real("1e-40"));
+}
+
+// ---- Commands ----
+
+TEST_CASE("PEVAL evaluates exactly, numerically and symbolically", "[poly]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("{ 1 -3 2 } 5 PEVAL"));
+    REQUIRE(ctx.repr_at(1) == "12");
+    REQUIRE(ctx.exec("CLEAR { 1 0 -2 } 1 2 / PEVAL"));
+    REQUIRE(ctx.repr_at(1) == "-7/4");
+    REQUIRE(ctx.exec("CLEAR { 1 -3 2 } { 0 1 2 } PEVAL"));
+    REQUIRE(ctx.repr_at(1) == "{ 2 0 0 }");
+    REQUIRE(ctx.exec("CLEAR { 1 -3 2 } 'A' PEVAL"));
+    REQUIRE(ctx.repr_at(1) == "'A^2-3*A+2'");
+    REQUIRE(ctx.exec("CLEAR { 1 0 1 } (0., 1.) PEVAL"));
+    REQUIRE(ctx.repr_at(1) == "(0., 0.)");
+    REQUIRE_FALSE(ctx.exec("CLEAR { 1 \"A\" } 2 PEVAL"));
+}
+
+TEST_CASE("PROOT and PCOEF are inverses", "[poly]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("{ 1 -6 11 -6 } PROOT"));
+    REQUIRE(ctx.repr_at(1) == "{ 1 2 3 }");
+    REQUIRE(ctx.exec("PCOEF"));
+    REQUIRE(ctx.repr_at(1) == "{ 1 -6 11 -6 }");
+    REQUIRE(ctx.exec("CLEAR { 1 0 1 } PROOT"));
+    REQUIRE(ctx.repr_at(1) == "{ (0., -1.) (0., 1.) }");
+    REQUIRE(ctx.exec("PCOEF"));
+    REQUIRE(ctx.repr_at(1) == "{ 1. 0. 1. }");
+    REQUIRE_FALSE(ctx.exec("CLEAR { 0 } PROOT"));
+}
+
+TEST_CASE("PROOT splits off repeated roots of Real polynomials", "[poly]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("{ 1. -3 3 -1 } PROOT"));
+    REQUIRE(ctx.repr_at(1) == "{ 1. 1. 1. }");
+    REQUIRE(ctx.exec("CLEAR { 1. 0 2 0 1 } PROOT"));
+    REQUIRE(ctx.repr_at(1) == "{ (0., -1.) (0., -1.) (0., 1.) (0., 1.) }");
+    REQUIRE(ctx.exec("CLEAR { 1. -5 8 -4 } PROOT"));
+    REQUIRE(ctx.repr_at(1) == "{ 1. 2. 2. }");
+}
+
+TEST_CASE("PDIV, PMUL and PGCD", "[poly]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("{ 1 -3 2 } { 1 -1 } PMUL"));
+    REQUIRE(ctx.repr_at(1) == "{ 1 -4 5 -2 }");
+    REQUIRE(ctx.exec("{ 1 -1 } PDIV"));
+    REQUIRE(ctx.repr_at(2) == "{ 1 -3 2 }");
+    REQUIRE(ctx.repr_at(1) == "{ 0 }");
+    REQUIRE(ctx.exec("CLEAR { 1 0 1 } { 1 1 } PDIV"));
+    REQUIRE(ctx.repr_at(2) == "{ 1 -1 }");
+    REQUIRE(ctx.repr_at(1) == "{ 2 }");
+    REQUIRE(ctx.exec("CLEAR { 1 -3 2 } { 1 -4 3 } PGCD"));
+    REQUIRE(ctx.repr_at(1) == "{ 1 -1 }");
+    REQUIRE_FALSE(ctx.exec("CLEAR { 1 2 } { 0 } PDIV"));
+}
+
+TEST_CASE("->POLY and POLY-> convert to and from Symbols", "[poly]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("'(X-1)^2*3+X/2' 'X' ->POLY"));
+    REQUIRE(ctx.repr_at(1) == "{ 3 -11/2 3 }");
+    REQUIRE(ctx.exec("CLEAR '2.5*X^2-1' 'X' ->POLY"));
+    REQUIRE(ctx.repr_at(1) == "{ 2.5 0. -1. }");
+    REQUIRE(ctx.exec("CLEAR { -1 0 3 -1 } 'X' POLY->"));
+    REQUIRE(ctx.repr_at(1) == "'-(X^3)+3*X-1'");
+    REQUIRE(ctx.exec("CLEAR { 0 } 'X' POLY->"));
+    REQUIRE(ctx.repr_at(1) == "'0'");
+    REQUIRE_FALSE(ctx.exec("CLEAR 'SIN(X)' 'X' ->POLY"));
+    REQUIRE_FALSE(ctx.exec("CLEAR 'X*Y' 'X' ->POLY"));
+    REQUIRE_FALSE(ctx.exec("CLEAR 'X^(1/2)' 'X' ->POLY"));
+}
+
+TEST_CASE("Rational coefficients survive the stack", "[poly]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("'(X-1)^2*3+X/2' 'X' ->POLY"));
+    Object coeffs = ctx.store().peek(1);
+    REQUIRE(holds_alternative<Rational>(get<List>(coeffs).items[1]));
+    REQUIRE(ctx.exec("'X' POLY->"));
+    REQUIRE(ctx.repr_at(1) == "'3*X^2-11/2*X+3'");
+    REQUIRE(ctx.exec("CLEAR '(X-1)^2*3+X/2' 'X' ->POLY 2 PEVAL"));
+    REQUIRE(ctx.repr_at(1) == "4");
+    REQUIRE(ctx.exec("CLEAR 'X^2/4-1' 'X' ->POLY"));
+    REQUIRE(ctx.repr_at(1) == "{ 1/4 0 -1 }");
+    REQUIRE(ctx.exec("PROOT"));
+    REQUIRE(ctx.repr_at(1) == "{ -2 2 }");
+}
@@ -3,6 +3,22 @@
 
 using namespace lpr;
 
+namespace {
+
+int64_t stat(Context& ctx, const std::string& name) {
+    for (const auto& [key, value] : ctx.perf_stats()) {
+        if (key == name) return value;
+    }
+    FAIL("no counter " << name);
+    return -1;
+}
+
+// Sum of 1..n, recursing before the addition (not a tail call)
+const char* kSumTo =
+    "\xC2\xAB \xE2\x86\x92 n \xC2\xAB IF n 0 == THEN 0 ELSE n 1 - SUMTO n + END \xC2\xBB \xC2\xBB 'SUMTO' STO";
+
+} // namespace
+
 TEST_CASE("Program push onto stack", "[programs]") {
     Context ctx(nullptr);
     REQUIRE(ctx.exec("\xC2\xAB 2 3 + \xC2\xBB"));
@@ -60,3 +76,107 @@ TEST_CASE("IFTE false branch", "[programs]") {
     REQUIRE(ctx.depth() == 1);
     REQUIRE(ctx.repr_at(1) == "\"no\"");
 }
+
+TEST_CASE("Deep recursion does not use the native stack", "[programs][calls]") {
+    Context ctx(nullptr);
+    REQUIRE(ctx.exec(kSumTo));
+    REQUIRE(ctx.exec("10000 SUMTO"));
+    REQUIRE(ctx.repr_at(1) == "50005000");
+    REQUIRE(stat(ctx, "call_frames_peak") > 10000);
+    REQUIRE(ctx.local_scopes().empty());
+}
+
+TEST_CASE("Stored programs and EVAL in tail position run in constant space", "[programs][calls]") {
+    Context ctx(nullptr);
+    REQUIRE(ctx.exec("\xC2\xAB IF DUP 0 > THEN 1 - DOWN END \xC2\xBB 'DOWN' STO"));
+    REQUIRE(ctx.exec("5000 DOWN"));
+    REQUIRE(ctx.repr_at(1) == "0");
+    REQUIRE(stat(ctx, "call_frames_peak") < 8);
+
+    Context ev(nullptr);
+    REQUIRE(ev.exec("\xC2\xAB WHILE DUP 100 > REPEAT 2 - END IF DUP 0 > THEN 1 - 'DOWN' EVAL END \xC2\xBB 'DOWN' STO"));
+    REQUIRE(ev.exec("5000 DOWN"));
+    REQUIRE(ev.repr_at(1) == "0");
+    REQUIRE(ev.exec("5 \xC2\xAB DOWN \xC2\xBB EVAL"));
+    REQUIRE(ev.repr_at(1) == "0");
+    REQUIRE(stat(ev, "call_frames_peak") < 8);
+}
+
+TEST_CASE("Tail recursion through -> runs in constant memory", "[programs][calls]") {
+    Context ctx(nullptr);
+    REQUIRE(ctx.exec("\xC2\xAB \xE2\x86\x92 n acc \xC2\xAB IF n 0 == THEN acc "
+                     "ELSE n 1 - acc n + ACC END \xC2\xBB \xC2\xBB 'ACC' STO"));
+    REQUIRE(ctx.exec("64 CALLMEM 100000 0 ACC"));
+    REQUIRE(ctx.repr_at(1) == "5000050000");
+    REQUIRE(stat(ctx, "call_frames_peak") < 8);
+    REQUIRE(ctx.local_scopes().empty());
+}
+
+TEST_CASE("Stored programs in tail position see the caller's locals", "[programs][calls]") {
+    Context ctx(nullptr);
+    REQUIRE(ctx.exec("\xC2\xAB a b + \xC2\xBB 'ABSUM' STO \xC2\xAB a \xC2\xBB 'GETA' STO"));
+    REQUIRE(ctx.exec("1 \xE2\x86\x92 a \xC2\xAB 2 \xE2\x86\x92 b \xC2\xAB ABSUM 10 * \xC2\xBB \xC2\xBB"));
+    REQUIRE(ctx.repr_at(1) == "30");
+    REQUIRE(ctx.exec("1 \xE2\x86\x92 a \xC2\xAB 2 \xE2\x86\x92 b \xC2\xAB ABSUM \xC2\xBB \xC2\xBB"));
+    REQUIRE(ctx.repr_at(1) == "3");
+    REQUIRE(ctx.exec("5 \xE2\x86\x92 a \xC2\xAB GETA \xC2\xBB"));
+    REQUIRE(ctx.repr_at(1) == "5");
+    REQUIRE(ctx.exec("7 \xE2\x86\x92 a \xC2\xAB 'GETA' EVAL \xC2\xBB"));
+    REQUIRE(ctx.repr_at(1) == "7");
+    // A rebinding of only some names keeps the older scope
+    REQUIRE(ctx.exec("\xC2\xAB \xE2\x86\x92 b \xC2\xAB a b + \xC2\xBB \xC2\xBB 'ADDB' STO"));
+    REQUIRE(ctx.exec("1 2 \xE2\x86\x92 a b \xC2\xAB 10 ADDB \xC2\xBB"));
+    REQUIRE(ctx.repr_at(1) == "11");
+    REQUIRE(ctx.local_scopes().empty());
+}
+
+TEST_CASE("IFT/IFTE and STR-> bodies run as frames", "[programs][calls]") {
+    Context ctx(nullptr);
+    REQUIRE(ctx.exec("\xC2\xAB \xC2\xAB 1 - DN2 \xC2\xBB OVER 0 > IFT \xC2\xBB 'DN2' STO"));
+    REQUIRE(ctx.exec("10000 DN2"));
+    REQUIRE(ctx.repr_at(1) == "0");
+    REQUIRE(stat(ctx, "call_frames_peak") < 8);
+
+    // Not a tail call: each level waits for the next one's result
+    REQUIRE(ctx.exec("\xC2\xAB DUP \xC2\xAB \xC2\xBB \xC2\xAB DUP 1 - TRI + \xC2\xBB ROT 0 > IFTE \xC2\xBB 'TRI' STO"));
+    REQUIRE(ctx.exec("10000 TRI"));
+    REQUIRE(ctx.repr_at(1) == "50005000");
+
+    REQUIRE(ctx.exec("\xC2\xAB IF DUP 0 > THEN 1 - \"DN3\" STR-> END \xC2\xBB 'DN3' STO 10000 DN3"));
+    REQUIRE(ctx.repr_at(1) == "0");
+}
+
+TEST_CASE("Native recursion fails with Insufficient Memory", "[programs][calls]") {
+    Context ctx(nullptr);
+    // MAP runs its program nested on the native stack
+    REQUIRE(ctx.exec("\xC2\xAB IF DUP 0 > THEN 1 - { 0 } \xC2\xAB DROP NEST \xC2\xBB MAP LIST-> DROP END \xC2\xBB 'NEST' STO"));
+    REQUIRE(ctx.exec("50 NEST"));
+    REQUIRE(ctx.repr_at(1) == "0");
+    REQUIRE_FALSE(ctx.exec("1000000 NEST"));
+    REQUIRE(ctx.repr_at(1).find("Insufficient Memory") != std::string::npos);
+    REQUIRE(ctx.local_scopes().empty());
+    REQUIRE(ctx.exec("5 NEST"));
+    REQUIRE(ctx.repr_at(1) == "0");
+}
+
+TEST_CASE("CALLMEM bounds the memory for pending calls", "[programs][calls]") {
+    Context ctx(nullptr);
+    REQUIRE(ctx.exec(kSumTo));
+    REQUIRE(ctx.exec("\xC2\xAB IF DUP 0 > THEN 1 - DOWN END \xC2\xBB 'DOWN' STO"));
+    REQUIRE(ctx.exec("64 CALLMEM"));
+    REQUIRE(ctx.call_memory() == 64 * 1024);
+    REQUIRE(ctx.exec("100 SUMTO 2000 DOWN"));
+    REQUIRE(ctx.repr_at(2) == "5050");
+    REQUIRE(ctx.repr_at(1) == "0");
+
+    REQUIRE_FALSE(ctx.exec("2000 SUMTO"));
+    REQUIRE(ctx.repr_at(1).find("Insufficient Memory") != std::string::npos);
+    REQUIRE(ctx.local_scopes().empty());
+
+    // The setting persists; a bad size is rejected
+    ctx.set_call_memory(Context::kDefaultCallMemory);
+    REQUIRE_FALSE(ctx.exec("2000 SUMTO"));
+    REQUIRE_FALSE(ctx.exec("0 CALLMEM"));
+    REQUIRE(ctx.exec("CLEAR 65536 CALLMEM 2000 SUMTO"));
+    REQUIRE(ctx.repr_at(1) == "2001000");
+}
@@ -11,15 +11,15 @@ TEST_CASE("Push and pop", "[stack]") {
     store.push(Integer(42));
     REQUIRE(store.depth() == 1);
     Object obj = store.pop();
-    REQUIRE(std::holds_alternative<Integer>(obj));
-    REQUIRE(std::get<Integer>(obj) == 42);
+    REQUIRE(holds_alternative<Integer>(obj));
+    REQUIRE(get<Integer>(obj) == 42);
     REQUIRE(store.depth() == 0);
 }
 
 TEST_CASE("Pop empty stack returns error", "[stack]") {
     Store store(nullptr);
     Object obj = store.pop();
-    REQUIRE(std::holds_alternative<Error>(obj));
+    REQUIRE(holds_alternative<Error>(obj));
 }
 
 TEST_CASE("Peek at arbitrary level", "[stack]") {
@@ -30,13 +30,13 @@ TEST_CASE("Peek at arbitrary level", "[stack]") {
 
     // Level 1 = top = 3, level 2 = 2, level 3 = 1
     Object top = store.peek(1);
-    REQUIRE(std::get<Integer>(top) == 3);
+    REQUIRE(get<Integer>(top) == 3);
 
     Object mid = store.peek(2);
-    REQUIRE(std::get<Integer>(mid) == 2);
+    REQUIRE(get<Integer>(mid) == 2);
 
     Object bot = store.peek(3);
-    REQUIRE(std::get<Integer>(bot) == 1);
+    REQUIRE(get<Integer>(bot) == 1);
 
     // Stack unmodified
     REQUIRE(store.depth() == 3);
@@ -68,7 +68,7 @@ TEST_CASE("Snapshot and restore", "[stack]") {
     store.restore_stack(seq);
     REQUIRE(store.depth() == 1);
     Object obj = store.peek(1);
-    REQUIRE(std::get<Integer>(obj) == 42);
+    REQUIRE(get<Integer>(obj) == 42);
 }
 
 // ---- Stack Command Integration Tests ----
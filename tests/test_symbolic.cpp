@@ -1,6 +1,11 @@
 #include <catch2/catch_test_macros.hpp>
 #include "core/context.hpp"
 #include "core/expression.hpp"
+#include "core/expr_tree.hpp"
+#include "core/lambdify.hpp"
+#include "core/plot.hpp"
+#include "lpr/lpr.h"
+#include <cmath>
 
 using namespace lpr;
 
@@ -168,7 +173,7 @@ TEST_CASE("Stash push/pop round-trip", "[symbolic][stash]") {
     REQUIRE(ctx.store().stash_depth() == 1);
     auto group = ctx.store().stash_pop();
     REQUIRE(group.size() == 1);
-    REQUIRE(std::get<Integer>(group[0]) == 42);
+    REQUIRE(get<Integer>(group[0]) == 42);
     REQUIRE(ctx.store().stash_depth() == 0);
     ctx.store().commit();
 }
@@ -179,9 +184,9 @@ TEST_CASE("Stash LIFO ordering", "[symbolic][stash]") {
     ctx.store().stash_push({Integer(1)});
     ctx.store().stash_push({Integer(2)});
     auto g1 = ctx.store().stash_pop();
-    REQUIRE(std::get<Integer>(g1[0]) == 2);
+    REQUIRE(get<Integer>(g1[0]) == 2);
     auto g2 = ctx.store().stash_pop();
-    REQUIRE(std::get<Integer>(g2[0]) == 1);
+    REQUIRE(get<Integer>(g2[0]) == 1);
     ctx.store().commit();
 }
 
@@ -192,9 +197,9 @@ TEST_CASE("Stash multi-item group", "[symbolic][stash]") {
     REQUIRE(ctx.store().stash_depth() == 1);
     auto group = ctx.store().stash_pop();
     REQUIRE(group.size() == 3);
-    REQUIRE(std::get<Integer>(group[0]) == 10);
-    REQUIRE(std::get<Integer>(group[1]) == 20);
-    REQUIRE(std::get<Integer>(group[2]) == 30);
+    REQUIRE(get<Integer>(group[0]) == 10);
+    REQUIRE(get<Integer>(group[1]) == 20);
+    REQUIRE(get<Integer>(group[2]) == 30);
     ctx.store().commit();
 }
 
@@ -383,3 +388,208 @@ TEST_CASE("E2E: SQ(X)+3 -> EXPLODE -> STASHN -> EXPLODE -> STASH -> DROP -> ASSE
     REQUIRE(ctx.depth() == 1);
     REQUIRE(ctx.repr_at(1) == "'(Y+1)^2+3'");
 }
+
+// ============================================================
+// Expression trees
+// ============================================================
+
+TEST_CASE("Expression trees are hash-consed", "[symbolic][tree]") {
+    Symbol a{"X^2 + 1"};
+    Symbol b{"X^2+1"};
+    REQUIRE(a.tree() == b.tree());            // same node, different source text
+    REQUIRE(a.value() == "X^2 + 1");          // source text kept verbatim
+    REQUIRE(a.tree()->kids[0] == parse_expr_tree("X^2"));
+    Symbol built{make_binary("+", make_binary("^", make_name("X"), make_number("2")),
+                             make_number("1"))};
+    REQUIRE(built.tree() == a.tree());
+    REQUIRE(built.value() == "X^2+1");        // text rendered on demand
+}
+
+TEST_CASE("Rendering adds only the parentheses precedence needs", "[symbolic][tree]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("'A*B' 2 ^"));
+    REQUIRE(ctx.repr_at(1) == "'(A*B)^2'");
+    REQUIRE(ctx.exec("CLEAR 'A' 'B-C' -"));
+    REQUIRE(ctx.repr_at(1) == "'A-(B-C)'");
+    REQUIRE(ctx.exec("CLEAR 'A' 'B-C' +"));
+    REQUIRE(ctx.repr_at(1) == "'A+B-C'");
+    REQUIRE(ctx.exec("CLEAR 'X' -3 *"));
+    REQUIRE(ctx.repr_at(1) == "'X*(-3)'");
+}
+
+TEST_CASE("SUBST shares untouched subtrees", "[symbolic][tree]") {
+    Symbol expr{"SIN(Y)*X+COS(Y)"};
+    ExprPtr out = expr_substitute(expr.tree(), "X", make_name("Z"));
+    REQUIRE(render_expr(out) == "SIN(Y)*Z+COS(Y)");
+    REQUIRE(out->kids[1] == expr.tree()->kids[1]);
+    REQUIRE(out->kids[0]->kids[0] == expr.tree()->kids[0]->kids[0]);
+}
+
+TEST_CASE("EXPLODE leading negation operand", "[symbolic][explode]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("'-A+B' EXPLODE"));
+    REQUIRE(ctx.repr_at(3) == "'-A'");
+    REQUIRE(ctx.repr_at(2) == "'B'");
+    REQUIRE(ctx.repr_at(1) == "« + »");
+}
+
+TEST_CASE("Long expression chains build and release without recursion", "[symbolic][tree]") {
+    ExprPtr e = make_name("X");
+    for (int i = 0; i < 200000; ++i) e = make_binary("+", e, make_number("1"));
+    Symbol sym{e};
+    REQUIRE(sym.value().size() == 1 + 2 * 200000);
+    size_t before = expr_node_count();
+    e.reset();
+    sym = Symbol{"Y"};
+    REQUIRE(expr_node_count() < before);
+}
+
+TEST_CASE("Symbols read back from the stack keep their tree", "[symbolic][tree]") {
+    auto ctx = make_ctx();
+    auto symbol_hits = [&] {
+        for (const auto& [key, value] : ctx.perf_stats()) {
+            if (key == "parse_cache_symbol_hits") return value;
+        }
+        return int64_t(-1);
+    };
+    int64_t before = symbol_hits();
+    REQUIRE(ctx.exec("'X' 1 200 FOR I 'X' * I + NEXT"));
+    // Each * and + takes the expression back off the stack
+    REQUIRE(symbol_hits() - before >= 399);
+    std::string r = ctx.repr_at(1);
+    REQUIRE(r.substr(r.size() - 7) == "*X+200'");
+
+    // The tree is the one the last step built, not a parse of the text
+    REQUIRE(ctx.exec("DUP"));
+    Object a = ctx.store().peek(1);
+    Object b = ctx.store().peek(2);
+    REQUIRE(get<Symbol>(a).tree() == get<Symbol>(b).tree());
+}
+
+TEST_CASE("Deeply nested parentheses are kept verbatim", "[symbolic][tree]") {
+    auto ctx = make_ctx();
+    std::string text = std::string(60000, '(') + "X" + std::string(60000, ')');
+    REQUIRE(ctx.exec("'" + text + "'"));
+    REQUIRE(ctx.repr_at(1) == "'" + text + "'");
+    REQUIRE(ctx.exec("1 +"));
+    REQUIRE(ctx.repr_at(1) == "'" + text + "+1'");
+    Symbol sym{text};
+    REQUIRE(sym.tree()->kind == ExprNode::Kind::Opaque);
+}
+
+TEST_CASE("TABULATE evaluates a Symbol over a list of points", "[symbolic][tabulate]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("'X^2+1' 'X' { 0 1 2 3 } TABULATE"));
+    REQUIRE(ctx.repr_at(1) == "{ 1. 2. 5. 10. }");
+    // Several variables: one List per point
+    REQUIRE(ctx.exec("CLEAR 'X*Y-Z' { X Y Z } { { 1 2 3 } { 4 5 6 } } TABULATE"));
+    REQUIRE(ctx.repr_at(1) == "{ -1. 14. }");
+}
+
+TEST_CASE("TABULATE over a Matrix keeps its shape for one variable", "[symbolic][tabulate]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("'2*X' 'X' [[ 1 2 ][ 3 4 ]] TABULATE"));
+    REQUIRE(ctx.repr_at(1) == "[[ 2. 4. ][ 6. 8. ]]");
+    // With two variables each row is a point
+    REQUIRE(ctx.exec("CLEAR 'X+Y' { X Y } [[ 1 2 ][ 3 4 ]] TABULATE"));
+    REQUIRE(ctx.repr_at(1) == "{ 3. 7. }");
+}
+
+TEST_CASE("TABULATE binds other names and follows the angle mode", "[symbolic][tabulate]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("10 'K' STO 'K*X+SIN(90)' 'X' { 1 } DEG TABULATE"));
+    REQUIRE(ctx.repr_at(1) == "{ 11. }");
+    REQUIRE(ctx.exec("CLEAR << -> K << 'K*X' 'X' { 2 } TABULATE >> >> 3 SWAP EVAL"));
+    REQUIRE(ctx.repr_at(1) == "{ 6. }");
+}
+
+TEST_CASE("TABULATE errors", "[symbolic][tabulate]") {
+    auto ctx = make_ctx();
+    REQUIRE_FALSE(ctx.exec("'X+Q' 'X' { 1 } TABULATE"));   // unbound name
+    REQUIRE_FALSE(ctx.exec("'LN(X)' 'X' { 0 } TABULATE")); // undefined point
+    REQUIRE_FALSE(ctx.exec("'X+Y' { X Y } { { 1 } } TABULATE"));
+    REQUIRE_FALSE(ctx.exec("'MOD(X, 2)' 'X' { 1 } TABULATE"));
+}
+
+TEST_CASE("lambdify folds constant subtrees", "[symbolic][tabulate]") {
+    auto ctx = make_ctx();
+    auto fn = lambdify(parse_expr_tree("X*(2+3)^2+SQRT(16)"), {"X"}, ctx);
+    REQUIRE(fn.size() == 5); // X 25 * 4 +
+    double x = 2;
+    REQUIRE(fn(&x) == 54.0);
+}
+
+TEST_CASE("sample_plot refines only where the curve bends", "[symbolic][plot]") {
+    auto line = sample_plot([](double x) { return 3 * x + 1; }, 0, 1);
+    REQUIRE(line.size() == 2 * 65);
+
+    auto steep = sample_plot([](double x) { return std::exp(10 * x); }, 0, 1);
+    REQUIRE(steep.size() > 2 * 65);
+    size_t right = 0;
+    for (size_t i = 0; i < steep.size(); i += 2) {
+        REQUIRE(steep[i + 1] == std::exp(10 * steep[i]));
+        if (i > 0) REQUIRE(steep[i] > steep[i - 2]);
+        if (steep[i] > 0.5) ++right;
+    }
+    REQUIRE(right > steep.size() / 4); // most of the extra points are on the right
+}
+
+TEST_CASE("sample_plot leaves gaps at poles and undefined stretches", "[symbolic][plot]") {
+    auto gaps = [](const std::vector<double>& xy) {
+        std::vector<double> at;
+        for (size_t i = 0; i < xy.size(); i += 2) {
+            if (std::isnan(xy[i + 1])) at.push_back(xy[i]);
+        }
+        return at;
+    };
+    auto tan = sample_plot([](double x) { return std::tan(x); }, 0, 3);
+    auto tan_gaps = gaps(tan);
+    REQUIRE(tan_gaps.size() == 1);
+    REQUIRE(std::fabs(tan_gaps[0] - std::acos(-1.0) / 2) < 1e-3);
+
+    auto root = sample_plot([](double x) { return std::sqrt(x); }, -1, 1);
+    REQUIRE(gaps(root).empty());
+    REQUIRE(root[0] >= 0);
+    REQUIRE(root[0] < 1e-3);
+}
+
+TEST_CASE("PLOTDATA returns one Matrix per continuous segment", "[symbolic][plot]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("'1/X' 'X' -1 1 PLOTDATA SIZE"));
+    REQUIRE(ctx.repr_at(1) == "2");
+    REQUIRE(ctx.exec("CLEAR << X SQ >> 'X' 0 1 PLOTDATA 1 GET SIZE"));
+    REQUIRE(ctx.repr_at(1) == "{ 65 2 }");
+    REQUIRE_FALSE(ctx.exec("CLEAR 'X' 'X' 1 0 PLOTDATA"));
+}
+
+TEST_CASE("lpr_plot_data - packed samples", "[api][plot]") {
+    lpr_ctx* ctx = lpr_open(nullptr);
+    REQUIRE(ctx != nullptr);
+    int count = 0;
+    double* xy = lpr_plot_data(ctx, "'X^2'", "X", -2, 2, 0, &count);
+    REQUIRE(xy != nullptr);
+    REQUIRE(count >= 65);
+    REQUIRE(xy[0] == -2.0);
+    REQUIRE(xy[1] == 4.0);
+    REQUIRE(xy[2 * count - 2] == 2.0);
+    lpr_free(xy);
+
+    // Programs run without leaving anything behind
+    xy = lpr_plot_data(ctx, "<< X 1 + 'Y' STO X >>", "X", 0, 1, 0, &count);
+    REQUIRE(xy != nullptr);
+    lpr_free(xy);
+    REQUIRE(lpr_depth(ctx) == 0);
+    REQUIRE(lpr_dir_contents(ctx) == nullptr);
+
+    REQUIRE(lpr_plot_data(ctx, "'X+'", "X", 0, 1, 0, &count) == nullptr);
+    REQUIRE(count == 0);
+    lpr_close(ctx);
+}
+
+TEST_CASE("SUBST over a List or Matrix substitutes each element", "[symbolic][subst]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("{ 'X+1' 'X*Y' 3 } 'X' 'A+B' SUBST"));
+    REQUIRE(ctx.repr_at(1) == "{ 'A+B+1' '(A+B)*Y' 3 }");
+    REQUIRE(ctx.exec("CLEAR [[ 'X' 'Y' ]] 'X' 2 SUBST"));
+    REQUIRE(ctx.repr_at(1) == "[[ '2' 'Y' ]]");
+}
@@ -1,5 +1,6 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
+#include "core/combinatorics.hpp"
 #include "core/context.hpp"
 #include "lpr/lpr.h"
 #include <cmath>
@@ -12,10 +13,10 @@ static Context make_ctx() { return Context(nullptr); }
 // Helper: get top of stack as double
 static double top_as_double(Context& ctx) {
     Object obj = ctx.store().peek(1);
-    if (std::holds_alternative<Real>(obj))
-        return std::get<Real>(obj).convert_to<double>();
-    if (std::holds_alternative<Integer>(obj))
-        return std::get<Integer>(obj).convert_to<double>();
+    if (holds_alternative<Real>(obj))
+        return get<Real>(obj).convert_to<double>();
+    if (holds_alternative<Integer>(obj))
+        return get<Integer>(obj).convert_to<double>();
     return 0.0;
 }
 
@@ -197,6 +198,41 @@ TEST_CASE("SQ 7 = 49", "[transcendental]") {
     REQUIRE(ctx.repr_at(1) == "49");
 }
 
+// --- Working precision (PREC) ---
+
+TEST_CASE("Transcendentals are accurate to 50 digits by default", "[transcendental]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("1 SIN"));
+    REQUIRE(ctx.repr_at(1) == "0.84147098480789650665250232163029899962256306079837");
+    REQUIRE(ctx.exec("CLEAR 2 LN"));
+    REQUIRE(ctx.repr_at(1) == "0.69314718055994530941723212145817656807550013436026");
+    REQUIRE(ctx.exec("CLEAR 1 ATAN 4 * PI -"));
+    REQUIRE(std::abs(top_as_double(ctx)) < 1e-48);
+    REQUIRE(ctx.exec("CLEAR 1000 LOG 3 ALOG"));
+    REQUIRE(ctx.repr_at(2) == "3.");
+    REQUIRE(ctx.repr_at(1) == "1000.");
+}
+
+TEST_CASE("PREC 16 takes the double fast path", "[transcendental]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("16 PREC 1 SIN"));
+    REQUIRE(ctx.repr_at(1) == "0.8414709848078965");
+    REQUIRE(ctx.exec("CLEAR DEG -1 ACOS"));
+    REQUIRE(ctx.repr_at(1) == "180.");
+    REQUIRE(ctx.exec("CLEAR RAD"));
+    REQUIRE(ctx.store().get_meta("precision") == "16");
+    REQUIRE(ctx.exec("CLEAR 30 PREC 0.5 EXP 0.5 EXP LN"));
+    REQUIRE_THAT(top_as_double(ctx), Catch::Matchers::WithinAbs(0.5, 1e-15));
+}
+
+TEST_CASE("PREC validates its argument", "[transcendental]") {
+    auto ctx = make_ctx();
+    REQUIRE_FALSE(ctx.exec("0 PREC"));
+    REQUIRE_FALSE(ctx.exec("51 PREC"));
+    REQUIRE_FALSE(ctx.exec("20. PREC"));
+    REQUIRE_FALSE(ctx.exec("2 ASIN"));
+}
+
 // --- Constants ---
 
 TEST_CASE("PI constant", "[transcendental]") {
@@ -307,6 +343,52 @@ TEST_CASE("PERM(5,2) = 20", "[transcendental]") {
     REQUIRE(ctx.repr_at(1) == "20");
 }
 
+TEST_CASE("Combinatoric kernels match the naive products", "[transcendental]") {
+    Integer naive = 1;
+    for (int i = 2; i <= 1000; ++i) naive *= i;
+    REQUIRE(factorial(1000) == naive);
+    // Wilson's theorem: (p-1)! = -1 mod p
+    REQUIRE(factorial(100002) % 100003 == 100002);
+
+    std::vector<Integer> row{1};
+    for (int n = 1; n <= 200; ++n) {
+        std::vector<Integer> next(n + 1, 1);
+        for (int k = 1; k < n; ++k) next[k] = row[k - 1] + row[k];
+        row = std::move(next);
+    }
+    for (int k = 0; k <= 200; ++k) REQUIRE(binomial(200, k) == row[k]);
+    REQUIRE(binomial(Integer(1) << 80, 3) ==
+            (Integer(1) << 80) * ((Integer(1) << 80) - 1) * ((Integer(1) << 80) - 2) / 6);
+    REQUIRE(falling_factorial(1000, 1000) == naive);
+    REQUIRE(multinomial({2, 3, 4}) == 1260);
+}
+
+TEST_CASE("COMB and PERM on large arguments", "[transcendental]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("100 50 COMB"));
+    REQUIRE(ctx.repr_at(1) == "100891344545564193334812497256");
+    REQUIRE(ctx.exec("CLEAR 10 0 PERM 10 10 PERM"));
+    REQUIRE(ctx.repr_at(2) == "1");
+    REQUIRE(ctx.repr_at(1) == "3628800");
+    REQUIRE(ctx.exec("CLEAR { 1 2 3 } MULTINOM"));
+    REQUIRE(ctx.repr_at(1) == "60");
+    REQUIRE_FALSE(ctx.exec("CLEAR 3 5 COMB"));
+    REQUIRE_FALSE(ctx.exec("CLEAR -1 !"));
+}
+
+TEST_CASE("Factorial of a Real uses the gamma function", "[transcendental]") {
+    auto ctx = make_ctx();
+    REQUIRE(ctx.exec("0.5 ! 2 * SQ PI ->NUM /"));
+    REQUIRE(std::abs(top_as_double(ctx) - 1.0) < 1e-12); // (1/2)! = SQRT(PI)/2
+    REQUIRE(ctx.exec("CLEAR 5 GAMMA"));
+    REQUIRE(std::abs(top_as_double(ctx) - 24.0) < 1e-12);
+    REQUIRE(ctx.exec("CLEAR 5. !"));
+    REQUIRE(std::abs(top_as_double(ctx) - 120.0) < 1e-12);
+    REQUIRE(ctx.exec("CLEAR 4.5 2 COMB"));
+    REQUIRE(std::abs(top_as_double(ctx) - 7.875) < 1e-12);
+    REQUIRE_FALSE(ctx.exec("CLEAR -2. !"));
+}
+
 // --- Percentage ---
 
 TEST_CASE("% - 200 15% = 30", "[transcendental]") {
@@ -134,3 +134,50 @@ TEST_CASE("Serialize/deserialize Symbol roundtrip", "[types]") {
     Object restored = deserialize(tag, data);
     REQUIRE(repr(restored) == "'X^2 + 1'");
 }
+
+TEST_CASE("Structural equality and hash", "[types]") {
+    Object a = List{{Integer(1), String{"x"}, List{{Real("2.5")}}}};
+    Object b = List{{Integer(1), String{"x"}, List{{Real("2.5")}}}};
+    Object c = List{{Integer(1), String{"x"}, List{{Real("2.6")}}}};
+    REQUIRE(objects_equal(a, b));
+    REQUIRE(object_hash(a) == object_hash(b));
+    REQUIRE_FALSE(objects_equal(a, c));
+    // Same value, different type
+    REQUIRE_FALSE(objects_equal(Integer(1), Real(1)));
+    REQUIRE(objects_equal(Rational(Integer(2), Integer(4)), Rational(Integer(1), Integer(2))));
+    REQUIRE(object_hash(Integer("123456789012345678901234567890")) ==
+            object_hash(Integer("123456789012345678901234567890")));
+    REQUIRE(object_hash(Real("-0")) == object_hash(Real("0")));
+}
+
+TEST_CASE("Boxed alternatives copy deeply and keep Object compact", "[types]") {
+    static_assert(sizeof(Object) <= 48, "large alternatives must stay boxed");
+    Object a = Complex{Real(1), Real(2)};
+    Object b = a;
+    get<Complex>(b).first = 5;
+    REQUIRE(repr(a) == "(1., 2.)");
+    REQUIRE(repr(b) == "(5., 2.)");
+    REQUIRE(holds_alternative<Complex>(a));
+    REQUIRE(get_if<Real>(&a) == nullptr);
+    b = Real("2.5");
+    REQUIRE(get_if<Real>(&b) != nullptr);
+    REQUIRE(*get_if<Real>(&b) == Real("2.5"));
+    a = b;
+    REQUIRE(objects_equal(a, b));
+    Object moved = std::move(b);
+    REQUIRE(get<Real>(moved) == Real("2.5"));
+}
+
+TEST_CASE("Copying a moved-from Boxed gives an empty one", "[types]") {
+    Boxed<Real> a(Real("2.5"));
+    Boxed<Real> moved = std::move(a);
+    Boxed<Real> copy(a);
+    Boxed<Real> assigned(Real(1));
+    assigned = a;
+    // Empty boxes are usable again once assigned a value
+    copy = moved;
+    assigned = Boxed<Real>(Real(3));
+    REQUIRE(*copy == Real("2.5"));
+    REQUIRE(*assigned == Real(3));
+    REQUIRE(*moved == Real("2.5"));
+}
@@ -1,6 +1,9 @@
 #include <catch2/catch_test_macros.hpp>
 #include "core/context.hpp"
 #include "lpr/lpr.h"
+#include <algorithm>
+#include <memory>
+#include <unistd.h>
 
 using namespace lpr;
 
@@ -84,3 +87,76 @@ TEST_CASE("lpr_get_state tracks undo/redo levels", "[undo]") {
 
     lpr_close(ctx);
 }
+
+namespace {
+
+// Serves text in fixed-size pieces so tokens straddle read boundaries
+Context::ReadFn chunked_reader(const std::string& text, size_t piece) {
+    auto offset = std::make_shared<size_t>(0);
+    return [text, piece, offset](char* buf, size_t cap) -> long {
+        size_t n = std::min({piece, cap, text.size() - *offset});
+        std::copy_n(text.data() + *offset, n, buf);
+        *offset += n;
+        return static_cast<long>(n);
+    };
+}
+
+} // namespace
+
+TEST_CASE("exec_stream runs input read in small pieces", "[undo][stream]") {
+    Context ctx(nullptr);
+    std::string script = "1 2 +\n<< DUP\n* >> 'SQ' STO\n\"two\nlines\" SIZE\n";
+    for (int i = 0; i < 50; ++i) script += "3 SQ DROP\n";
+    script += "(1, 2) 7 SQ";
+    REQUIRE(ctx.exec_stream(chunked_reader(script, 3)));
+    REQUIRE(ctx.depth() == 4);
+    REQUIRE(ctx.repr_at(4) == "3");
+    REQUIRE(ctx.repr_at(3) == "9");
+    REQUIRE(ctx.repr_at(2) == "(1., 2.)");
+    REQUIRE(ctx.repr_at(1) == "49");
+}
+
+TEST_CASE("exec_stream commits at checkpoints and rolls back to the last one", "[undo][stream]") {
+    Context ctx(nullptr);
+    std::string script;
+    for (int i = 1; i <= 20; ++i) script += std::to_string(i) + "\n";
+    script += "CLEAR DROP\n21\n";
+    // Checkpoints every 10 bytes: the error rolls back only the last stretch
+    REQUIRE_FALSE(ctx.exec_stream(chunked_reader(script, 5), 10));
+    REQUIRE(ctx.depth() > 1);
+    REQUIRE(ctx.repr_at(1).find("Too few arguments") != std::string::npos);
+    REQUIRE(ctx.repr_at(2) != "21");
+
+    // The whole stream is one undo step, whatever the checkpoints
+    Context ctx2(nullptr);
+    REQUIRE(ctx2.exec("0"));
+    REQUIRE(ctx2.exec_stream(chunked_reader("1\n2\n3\n4\n", 2), 2));
+    REQUIRE(ctx2.depth() == 5);
+    REQUIRE(ctx2.undo());
+    REQUIRE(ctx2.depth() == 1);
+    REQUIRE(ctx2.redo());
+    REQUIRE(ctx2.depth() == 5);
+
+    // An error after a checkpoint still leaves one undo step back to the start
+    Context ctx3(nullptr);
+    REQUIRE(ctx3.exec("0"));
+    REQUIRE_FALSE(ctx3.exec_stream(chunked_reader("1\n2\n3\nCLEAR DROP\n", 2), 2));
+    REQUIRE(ctx3.depth() == 5);
+    REQUIRE(ctx3.undo());
+    REQUIRE(ctx3.depth() == 1);
+}
+
+TEST_CASE("lpr_exec_fd reads a file descriptor to the end", "[undo][stream]") {
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    const char script[] = "6 7\n*\n";
+    REQUIRE(write(fds[1], script, sizeof(script) - 1) == static_cast<ssize_t>(sizeof(script) - 1));
+    close(fds[1]);
+    lpr_ctx* ctx = lpr_open(nullptr);
+    REQUIRE(lpr_exec_fd(ctx, fds[0], 0).ok == 1);
+    close(fds[0]);
+    char* top = lpr_repr(ctx, 1);
+    REQUIRE(std::string(top) == "42");
+    lpr_free(top);
+    lpr_close(ctx);
+}